@@ -1,24 +1,10 @@
-QT += core gui multimedia
-
-greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
-
-CONFIG += c++17
+include(phonecore.pri)
 
 TARGET = SmartphoneSimulator
 TEMPLATE = app
 
 SOURCES += \
-    main.cpp \
-    camera.cpp \
-    musicplayer.cpp \
-    smartphone.cpp \
-    mainwindow.cpp
-
-HEADERS += \
-    camera.h \
-    musicplayer.h \
-    smartphone.h \
-    mainwindow.h
+    main.cpp
 
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
@@ -0,0 +1,337 @@
+#include "activitylogmodel.h"
+#include <QBrush>
+#include <QColor>
+#include <QDateTime>
+#include <QMetaObject>
+#include <QMutexLocker>
+
+ActivityLogModel::ActivityLogModel(int capacity, QObject *parent)
+    : QAbstractListModel(parent), cap(qMax(1, capacity)), head(0), tail(0), evicted(0), messageBytes(0),
+      levels(AllLogLevels), sourceFilterId(-1), flushScheduled(false)
+{
+}
+
+void ActivityLogModel::setCapacity(int capacity)
+{
+    capacity = qMax(1, capacity);
+    if (capacity == cap) {
+        return;
+    }
+    flush();
+
+    beginResetModel();
+    quint64 keep = qMin<quint64>(tail - head, quint64(capacity));
+    std::vector<StoredEntry> reordered(size_t(capacity));
+    for (quint64 seq = tail - keep; seq < tail; ++seq) {
+        reordered[size_t(seq % quint64(capacity))] = std::move(ring[size_t(seq % quint64(cap))]);
+    }
+    evicted += (tail - head) - keep;
+    head = tail - keep;
+    ring.swap(reordered);
+    cap = capacity;
+    messageBytes = 0;
+    for (const StoredEntry &entry : ring) {
+        messageBytes += entry.message.size() * qint64(sizeof(QChar));
+    }
+    rebuildFilter();
+    endResetModel();
+}
+
+int ActivityLogModel::capacity() const
+{
+    return cap;
+}
+
+void ActivityLogModel::append(LogEntry::Level level, const QString &source, const QString &message)
+{
+    LogEntry entry;
+    entry.timestamp = QDateTime::currentMSecsSinceEpoch();
+    entry.level = level;
+    entry.source = source;
+    entry.message = message;
+    append(entry);
+}
+
+void ActivityLogModel::append(const LogEntry &entry)
+{
+    {
+        QMutexLocker lock(&pendingMutex);
+        pending.append(entry);
+    }
+    scheduleFlush();
+}
+
+void ActivityLogModel::append(const QVector<LogEntry> &entries)
+{
+    if (entries.isEmpty()) {
+        return;
+    }
+    {
+        QMutexLocker lock(&pendingMutex);
+        pending.append(entries);
+    }
+    scheduleFlush();
+}
+
+void ActivityLogModel::scheduleFlush()
+{
+    // One queued flush per batch, however many threads are appending
+    if (!flushScheduled.exchange(true, std::memory_order_acq_rel)) {
+        QMetaObject::invokeMethod(this, [this]() { flush(); }, Qt::QueuedConnection);
+    }
+}
+
+void ActivityLogModel::flush()
+{
+    QVector<LogEntry> batch;
+    {
+        QMutexLocker lock(&pendingMutex);
+        batch.swap(pending);
+        flushScheduled.store(false, std::memory_order_release);
+    }
+    if (batch.isEmpty()) {
+        return;
+    }
+
+    // Entries that would be overwritten within this same batch are never stored
+    int skipped = qMax(0, int(batch.size()) - cap);
+    int incoming = int(batch.size()) - skipped;
+    quint64 storedBefore = tail - head;
+    quint64 evicting = qMin(storedBefore, quint64(qMax<qint64>(0, qint64(storedBefore) + incoming - cap)));
+
+    int removedRows;
+    if (isFiltered()) {
+        removedRows = 0;
+        while (size_t(removedRows) < visible.size() && visible[size_t(removedRows)] < head + evicting) {
+            ++removedRows;
+        }
+    } else {
+        removedRows = int(evicting);
+    }
+    if (removedRows > 0) {
+        beginRemoveRows(QModelIndex(), 0, removedRows - 1);
+        head += evicting;
+        if (isFiltered()) {
+            // Unfiltered rows come straight from the ring; visible is empty
+            visible.erase(visible.begin(), visible.begin() + removedRows);
+        }
+        endRemoveRows();
+    } else {
+        head += evicting;
+    }
+    evicted += evicting + quint64(skipped);
+    tail += quint64(skipped);
+    if (skipped > 0) {
+        head = tail;
+    }
+
+    // Fill the free slots past the last row; views cannot see them until tail moves
+    int matched = 0;
+    for (int i = skipped; i < batch.size(); ++i) {
+        const LogEntry &entry = batch[i];
+        quint64 seq = tail + quint64(i - skipped);
+        size_t slot = size_t(seq % quint64(cap));
+        if (ring.size() <= slot) {
+            ring.resize(slot + 1);
+        }
+        StoredEntry &target = ring[slot];
+        messageBytes += (entry.message.size() - target.message.size()) * qint64(sizeof(QChar));
+        target.timestamp = entry.timestamp;
+        target.source = internSource(entry.source);
+        target.level = entry.level;
+        target.message = entry.message;
+        if (matches(target)) {
+            ++matched;
+        }
+    }
+
+    if (matched == 0) {
+        tail += quint64(incoming);
+        return;
+    }
+
+    int firstRow = rowCount();
+    beginInsertRows(QModelIndex(), firstRow, firstRow + matched - 1);
+    if (isFiltered()) {
+        for (quint64 seq = tail; seq < tail + quint64(incoming); ++seq) {
+            if (matches(stored(seq))) {
+                visible.push_back(seq);
+            }
+        }
+    }
+    tail += quint64(incoming);
+    endInsertRows();
+}
+
+void ActivityLogModel::clear()
+{
+    flush();
+    beginResetModel();
+    evicted += tail - head;
+    head = tail;
+    ring.clear();
+    messageBytes = 0;
+    visible.clear();
+    endResetModel();
+}
+
+void ActivityLogModel::setFilter(LevelMask levelMask, const QString &source)
+{
+    int sourceId = source.isEmpty() ? -1 : internSource(source);
+    levelMask &= AllLogLevels;
+    if (levelMask == levels && sourceId == sourceFilterId) {
+        return;
+    }
+    beginResetModel();
+    levels = levelMask;
+    sourceFilterId = sourceId;
+    rebuildFilter();
+    endResetModel();
+}
+
+LevelMask ActivityLogModel::levelFilter() const
+{
+    return levels;
+}
+
+QString ActivityLogModel::sourceFilter() const
+{
+    return sourceFilterId < 0 ? QString() : sourceNames.at(sourceFilterId);
+}
+
+bool ActivityLogModel::isFiltered() const
+{
+    return levels != AllLogLevels || sourceFilterId >= 0;
+}
+
+void ActivityLogModel::rebuildFilter()
+{
+    visible.clear();
+    if (!isFiltered()) {
+        return;
+    }
+    // A linear pass over integer fields; no strings are touched
+    for (quint64 seq = head; seq < tail; ++seq) {
+        if (matches(stored(seq))) {
+            visible.push_back(seq);
+        }
+    }
+}
+
+bool ActivityLogModel::matches(const StoredEntry &entry) const
+{
+    return (levels & levelBit(entry.level))
+           && (sourceFilterId < 0 || entry.source == quint16(sourceFilterId));
+}
+
+quint16 ActivityLogModel::internSource(const QString &source)
+{
+    auto it = sourceIds.constFind(source);
+    if (it != sourceIds.constEnd()) {
+        return it.value();
+    }
+    quint16 id = quint16(sourceNames.size());
+    sourceNames.append(source);
+    sourceIds.insert(source, id);
+    emit sourceAdded(source);
+    return id;
+}
+
+const ActivityLogModel::StoredEntry &ActivityLogModel::stored(quint64 sequence) const
+{
+    return ring[size_t(sequence % quint64(cap))];
+}
+
+quint64 ActivityLogModel::sequenceForRow(int row) const
+{
+    return isFiltered() ? visible[size_t(row)] : head + quint64(row);
+}
+
+LogEntry ActivityLogModel::entryAt(int row) const
+{
+    LogEntry entry;
+    if (row < 0 || row >= rowCount()) {
+        return entry;
+    }
+    const StoredEntry &source = stored(sequenceForRow(row));
+    entry.timestamp = source.timestamp;
+    entry.level = source.level;
+    entry.source = sourceNames.at(source.source);
+    entry.message = source.message;
+    return entry;
+}
+
+QStringList ActivityLogModel::sources() const
+{
+    return sourceNames;
+}
+
+int ActivityLogModel::storedCount() const
+{
+    return int(tail - head);
+}
+
+quint64 ActivityLogModel::appendedCount() const
+{
+    return tail;
+}
+
+quint64 ActivityLogModel::evictedCount() const
+{
+    return evicted;
+}
+
+qint64 ActivityLogModel::memoryUsage() const
+{
+    return qint64(ring.capacity() * sizeof(StoredEntry)) + qint64(visible.size() * sizeof(quint64))
+           + messageBytes;
+}
+
+int ActivityLogModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return isFiltered() ? int(visible.size()) : int(tail - head);
+}
+
+// Rows are formatted on demand, so only the rows a view paints cost anything
+QVariant ActivityLogModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= rowCount()) {
+        return QVariant();
+    }
+    const StoredEntry &entry = stored(sequenceForRow(index.row()));
+
+    switch (role) {
+    case Qt::DisplayRole: {
+        // Uniform row heights: multi-line messages are folded onto one line
+        QString message = entry.message;
+        message.replace('\n', QLatin1String("  "));
+        return QString("%1 %2 %3: %4")
+            .arg(QDateTime::fromMSecsSinceEpoch(entry.timestamp).toString("hh:mm:ss.zzz"),
+                 LogEntry::levelName(entry.level).leftJustified(5),
+                 sourceNames.at(entry.source),
+                 message);
+    }
+    case Qt::ToolTipRole:
+    case MessageRole:
+        return entry.message;
+    case Qt::ForegroundRole:
+        switch (entry.level) {
+        case LogEntry::Error:   return QBrush(QColor("#cc0000"));
+        case LogEntry::Warning: return QBrush(QColor("#b36b00"));
+        case LogEntry::Success: return QBrush(QColor("#006600"));
+        case LogEntry::Debug:   return QBrush(QColor("#666666"));
+        default:                return QVariant();
+        }
+    case LevelRole:
+        return int(entry.level);
+    case SourceRole:
+        return sourceNames.at(entry.source);
+    case TimestampRole:
+        return entry.timestamp;
+    default:
+        return QVariant();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,101 @@
+#ifndef ACTIVITYLOGMODEL_H
+#define ACTIVITYLOGMODEL_H
+
+#include "phonelog.h"
+#include <QAbstractListModel>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <atomic>
+#include <deque>
+#include <vector>
+
+using LevelMask = quint32;
+constexpr LevelMask levelBit(LogEntry::Level level) { return LevelMask(1) << level; }
+constexpr LevelMask AllLogLevels = (LevelMask(1) << LogEntry::LevelCount) - 1;
+
+// Activity log kept in a fixed-size ring of structured entries. The oldest
+// entries are overwritten once the cap is reached, so memory stays bounded
+// no matter how long a session or replay runs. append() may be called from
+// any thread; entries are buffered and inserted on the model's thread in
+// one batch per event-loop pass. Views only ask for the rows they show.
+class ActivityLogModel : public QAbstractListModel
+{
+    Q_OBJECT
+public:
+    enum Role { LevelRole = Qt::UserRole + 1, SourceRole, TimestampRole, MessageRole };
+
+    explicit ActivityLogModel(int capacity = DefaultCapacity, QObject *parent = nullptr);
+
+    // Keeps the newest entries that still fit
+    void setCapacity(int capacity);
+    int capacity() const;
+
+    void append(LogEntry::Level level, const QString &source, const QString &message);
+    void append(const LogEntry &entry);
+    void append(const QVector<LogEntry> &entries);
+    // Insert everything buffered so far; must run on the model's thread
+    void flush();
+    void clear();
+
+    // Empty source shows every source
+    void setFilter(LevelMask levels, const QString &source = QString());
+    LevelMask levelFilter() const;
+    QString sourceFilter() const;
+    bool isFiltered() const;
+
+    LogEntry entryAt(int row) const;
+    QStringList sources() const;
+    int storedCount() const;
+    quint64 appendedCount() const;
+    quint64 evictedCount() const;
+    // Ring, filter index and message text, in bytes
+    qint64 memoryUsage() const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    static constexpr int DefaultCapacity = 100000;
+
+signals:
+    void sourceAdded(const QString &source);
+
+private:
+    // Sources are interned so filtering compares integers, not strings
+    struct StoredEntry
+    {
+        qint64 timestamp;
+        quint16 source;
+        LogEntry::Level level;
+        QString message;
+    };
+
+    const StoredEntry &stored(quint64 sequence) const;
+    quint64 sequenceForRow(int row) const;
+    bool matches(const StoredEntry &entry) const;
+    quint16 internSource(const QString &source);
+    void scheduleFlush();
+    void rebuildFilter();
+
+    std::vector<StoredEntry> ring;
+    int cap;
+    quint64 head;       // sequence number of the oldest stored entry
+    quint64 tail;       // sequence number the next entry will get
+    quint64 evicted;
+    qint64 messageBytes;
+
+    LevelMask levels;
+    int sourceFilterId;             // -1: every source
+    std::deque<quint64> visible;    // sequence numbers passing the filter, oldest first
+
+    QStringList sourceNames;
+    QHash<QString, quint16> sourceIds;
+
+    QMutex pendingMutex;
+    QVector<LogEntry> pending;
+    std::atomic<bool> flushScheduled;
+};
+
+#endif // ACTIVITYLOGMODEL_H
\ No newline at end of file
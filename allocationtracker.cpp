@@ -0,0 +1,233 @@
+#include "allocationtracker.h"
+#include <algorithm>
+
+#if defined(PHONE_ALLOC_TRACKING) && defined(__GLIBC__)
+#define ALLOC_INTERPOSE 1
+#include <cerrno>
+#include <malloc.h>
+#endif
+
+namespace {
+
+// Plain thread_local integers live in static TLS: touching them from
+// inside malloc never allocates
+struct ThreadHeap
+{
+    quint64 allocations;
+    quint64 bytes;
+    qint64 live;        // net bytes allocated minus freed by this thread
+    qint64 peak;        // high-water mark of live since the innermost measurement began
+};
+
+thread_local ThreadHeap heap;
+
+std::atomic<AllocationSite *> siteList{nullptr};
+
+template <typename T>
+void raiseTo(std::atomic<T> &target, T value)
+{
+    T current = target.load(std::memory_order_relaxed);
+    while (value > current && !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace
+
+#ifdef ALLOC_INTERPOSE
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+void *__libc_memalign(size_t alignment, size_t size);
+void __libc_free(void *pointer);
+}
+
+namespace {
+
+inline void *allocated(void *pointer)
+{
+    if (pointer) {
+        qint64 size = qint64(malloc_usable_size(pointer));
+        heap.allocations++;
+        heap.bytes += quint64(size);
+        heap.live += size;
+        if (heap.live > heap.peak) {
+            heap.peak = heap.live;
+        }
+    }
+    return pointer;
+}
+
+} // namespace
+
+extern "C" void *malloc(size_t size)
+{
+    return allocated(__libc_malloc(size));
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+    return allocated(__libc_calloc(count, size));
+}
+
+extern "C" void *realloc(void *pointer, size_t size)
+{
+    qint64 oldSize = pointer ? qint64(malloc_usable_size(pointer)) : 0;
+    void *moved = __libc_realloc(pointer, size);
+    if (moved || size == 0) {
+        heap.live -= oldSize;
+    }
+    return allocated(moved);
+}
+
+extern "C" void free(void *pointer)
+{
+    if (pointer) {
+        heap.live -= qint64(malloc_usable_size(pointer));
+        __libc_free(pointer);
+    }
+}
+
+extern "C" void *memalign(size_t alignment, size_t size)
+{
+    return allocated(__libc_memalign(alignment, size));
+}
+
+extern "C" void *aligned_alloc(size_t alignment, size_t size)
+{
+    return allocated(__libc_memalign(alignment, size));
+}
+
+extern "C" int posix_memalign(void **result, size_t alignment, size_t size)
+{
+    if (alignment % sizeof(void *) != 0 || (alignment & (alignment - 1)) != 0) {
+        return EINVAL;
+    }
+    void *pointer = allocated(__libc_memalign(alignment, size));
+    if (!pointer) {
+        return ENOMEM;
+    }
+    *result = pointer;
+    return 0;
+}
+
+#endif // ALLOC_INTERPOSE
+
+std::atomic<bool> AllocationTracker::enabled{false};
+
+AllocationTracker::Measurement::Measurement()
+    : startAllocations(heap.allocations), startBytes(heap.bytes), startLive(heap.live), outerPeak(heap.peak)
+{
+    heap.peak = heap.live;
+}
+
+AllocationTracker::Usage AllocationTracker::Measurement::stop()
+{
+    Usage usage;
+    usage.allocations = heap.allocations - startAllocations;
+    usage.bytes = heap.bytes - startBytes;
+    usage.peakBytes = qMax<qint64>(0, heap.peak - startLive);
+    heap.peak = qMax(outerPeak, heap.peak);
+    return usage;
+}
+
+void AllocationSite::record(const AllocationTracker::Usage &usage)
+{
+    if (!registered.exchange(true, std::memory_order_acq_rel)) {
+        AllocationSite *head = siteList.load(std::memory_order_relaxed);
+        do {
+            next = head;
+        } while (!siteList.compare_exchange_weak(head, this, std::memory_order_release, std::memory_order_relaxed));
+    }
+    calls.fetch_add(1, std::memory_order_relaxed);
+    allocations.fetch_add(usage.allocations, std::memory_order_relaxed);
+    bytes.fetch_add(usage.bytes, std::memory_order_relaxed);
+    raiseTo(maxPeakBytes, usage.peakBytes);
+    raiseTo(maxAllocations, usage.allocations);
+}
+
+bool AllocationTracker::isSupported()
+{
+#ifdef ALLOC_INTERPOSE
+    return true;
+#else
+    return false;
+#endif
+}
+
+void AllocationTracker::setEnabled(bool on)
+{
+    enabled.store(on, std::memory_order_relaxed);
+}
+
+AllocationTracker::Usage AllocationTracker::threadUsage()
+{
+    Usage usage;
+    usage.allocations = heap.allocations;
+    usage.bytes = heap.bytes;
+    usage.peakBytes = heap.peak;
+    return usage;
+}
+
+QVector<AllocationTracker::SiteReport> AllocationTracker::sites()
+{
+    QVector<SiteReport> reports;
+    for (AllocationSite *site = siteList.load(std::memory_order_acquire); site; site = site->next) {
+        SiteReport report;
+        report.name = QString::fromUtf8(site->name);
+        report.subsystem = QString::fromUtf8(site->subsystem);
+        report.calls = site->calls.load(std::memory_order_relaxed);
+        report.allocations = site->allocations.load(std::memory_order_relaxed);
+        report.bytes = site->bytes.load(std::memory_order_relaxed);
+        report.maxPeakBytes = site->maxPeakBytes.load(std::memory_order_relaxed);
+        report.maxAllocations = site->maxAllocations.load(std::memory_order_relaxed);
+        reports.append(report);
+    }
+    std::sort(reports.begin(), reports.end(), [](const SiteReport &a, const SiteReport &b) {
+        return a.subsystem != b.subsystem ? a.subsystem < b.subsystem : a.name < b.name;
+    });
+    return reports;
+}
+
+QString AllocationTracker::report()
+{
+    if (!isSupported()) {
+        return "Allocation tracking is not built in (qmake CONFIG+=alloc_tracking, glibc only)";
+    }
+    QVector<SiteReport> reports = sites();
+    int width = 9;
+    for (const SiteReport &site : reports) {
+        width = qMax(width, int(site.name.size()));
+    }
+
+    QString text = QString("%1 %2 %3 %4 %5 %6\n")
+                       .arg("operation", -width).arg("calls", 9).arg("allocs/op", 10)
+                       .arg("bytes/op", 10).arg("max allocs", 10).arg("max peak", 10);
+    QString subsystem;
+    for (const SiteReport &site : reports) {
+        if (site.subsystem != subsystem) {
+            subsystem = site.subsystem;
+            text += "[" + subsystem + "]\n";
+        }
+        double calls = qMax<quint64>(1, site.calls);
+        text += QString("%1 %2 %3 %4 %5 %6\n")
+                    .arg(site.name, -width).arg(site.calls, 9)
+                    .arg(site.allocations / calls, 10, 'f', 1).arg(site.bytes / calls, 10, 'f', 0)
+                    .arg(site.maxAllocations, 10).arg(site.maxPeakBytes, 10);
+    }
+    Usage thread = threadUsage();
+    text += QString("this thread: %1 allocations, %2 bytes since start").arg(thread.allocations).arg(thread.bytes);
+    return text;
+}
+
+void AllocationTracker::reset()
+{
+    for (AllocationSite *site = siteList.load(std::memory_order_acquire); site; site = site->next) {
+        site->calls.store(0, std::memory_order_relaxed);
+        site->allocations.store(0, std::memory_order_relaxed);
+        site->bytes.store(0, std::memory_order_relaxed);
+        site->maxPeakBytes.store(0, std::memory_order_relaxed);
+        site->maxAllocations.store(0, std::memory_order_relaxed);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+#ifndef ALLOCATIONTRACKER_H
+#define ALLOCATIONTRACKER_H
+
+#include <QString>
+#include <QVector>
+#include <atomic>
+
+// Heap profiling by operation. Built with CONFIG+=alloc_tracking (which
+// defines PHONE_ALLOC_TRACKING) on glibc, malloc and friends are
+// interposed for the whole process, Qt included, and every thread keeps
+// running totals. An ALLOC_SCOPE(name, subsystem) measures what the
+// calling thread allocates while it is open: count, bytes and the peak of
+// bytes still held. Scopes are inclusive, so nested operations are counted
+// in their callers too. Without the build flag scopes compile to nothing.
+// Names and subsystems must be string literals.
+class AllocationTracker
+{
+public:
+    // Allocation activity of one thread over an interval
+    struct Usage
+    {
+        quint64 allocations = 0;
+        quint64 bytes = 0;          // usable size handed out
+        qint64 peakBytes = 0;       // highest net growth while the interval was open
+    };
+
+    // Totals for one ALLOC_SCOPE call site
+    struct SiteReport
+    {
+        QString name;
+        QString subsystem;
+        quint64 calls;
+        quint64 allocations;
+        quint64 bytes;
+        qint64 maxPeakBytes;        // worst single call
+        quint64 maxAllocations;     // worst single call
+    };
+
+    // Measures the calling thread between construction and stop()
+    class Measurement
+    {
+    public:
+        Measurement();
+        Usage stop();
+
+    private:
+        quint64 startAllocations;
+        quint64 startBytes;
+        qint64 startLive;
+        qint64 outerPeak;
+    };
+
+    static bool isSupported();
+    // Scopes record nothing until enabled; the thread totals always run
+    static void setEnabled(bool enabled);
+    static bool isEnabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    // Since the thread started
+    static Usage threadUsage();
+
+    static QVector<SiteReport> sites();
+    static QString report();
+    static void reset();
+
+private:
+    AllocationTracker() = delete;
+
+    static std::atomic<bool> enabled;
+};
+
+// One per ALLOC_SCOPE call site. Constant-initialized and linked into a
+// global list on first use, so registering never allocates.
+struct AllocationSite
+{
+    const char *name;
+    const char *subsystem;
+    std::atomic<bool> registered{false};
+    AllocationSite *next = nullptr;
+    std::atomic<quint64> calls{0};
+    std::atomic<quint64> allocations{0};
+    std::atomic<quint64> bytes{0};
+    std::atomic<qint64> maxPeakBytes{0};
+    std::atomic<quint64> maxAllocations{0};
+
+    constexpr AllocationSite(const char *name, const char *subsystem) : name(name), subsystem(subsystem) {}
+    void record(const AllocationTracker::Usage &usage);
+};
+
+class AllocationScope
+{
+public:
+    explicit AllocationScope(AllocationSite &site) : site(site), active(AllocationTracker::isEnabled()) {}
+
+    // Always stopped, so an enclosing measurement gets its peak back
+    ~AllocationScope()
+    {
+        AllocationTracker::Usage usage = measurement.stop();
+        if (active) {
+            site.record(usage);
+        }
+    }
+
+    AllocationScope(const AllocationScope &) = delete;
+    AllocationScope &operator=(const AllocationScope &) = delete;
+
+private:
+    AllocationSite &site;
+    const bool active;
+    AllocationTracker::Measurement measurement;
+};
+
+#define ALLOC_SCOPE_CONCAT2(a, b) a##b
+#define ALLOC_SCOPE_CONCAT(a, b) ALLOC_SCOPE_CONCAT2(a, b)
+#ifdef PHONE_ALLOC_TRACKING
+#define ALLOC_SCOPE(name, subsystem)                                                            \
+    static AllocationSite ALLOC_SCOPE_CONCAT(allocationSite, __LINE__)(name, subsystem);         \
+    AllocationScope ALLOC_SCOPE_CONCAT(allocationScope, __LINE__)(ALLOC_SCOPE_CONCAT(allocationSite, __LINE__))
+#else
+#define ALLOC_SCOPE(name, subsystem) do {} while (false)
+#endif
+
+#endif // ALLOCATIONTRACKER_H
\ No newline at end of file
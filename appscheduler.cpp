@@ -0,0 +1,313 @@
+#include "appscheduler.h"
+#include "workstealingexecutor.h"
+#include "tracing.h"
+#include <QJsonArray>
+#include <algorithm>
+
+namespace {
+
+// Stand-in for real app work: a dependent integer chain the optimizer cannot drop
+void burnHostCpu(qint64 iterations)
+{
+    volatile quint32 sink = 0;
+    quint32 x = 2463534242u;
+    for (qint64 i = 0; i < iterations; ++i) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+    }
+    sink = x;
+    (void)sink;
+}
+
+} // namespace
+
+AppScheduler::AppScheduler(SimulationClock *clock, int coreCount, qint64 timeSliceMs,
+                           WorkStealingExecutor *executor)
+    : clock(clock), pool(executor ? executor : &WorkStealingExecutor::shared()),
+      cores(qMax(1, coreCount)), sliceMs(qMax<qint64>(1, timeSliceMs)),
+      foregroundPid(-1), tickEvent(0), ticks(0), hostWorkPerMs(0), hostDroppedUs(0),
+      hostWork(std::make_shared<HostWork>())
+{
+}
+
+AppScheduler::~AppScheduler()
+{
+    clock->cancel(tickEvent);
+    // Work functions may use whatever owns the scheduler
+    std::unique_lock<std::mutex> lock(hostWork->mutex);
+    hostWork->idle.wait(lock, [this]() { return hostWork->inFlight == 0; });
+}
+
+AppScheduler::ProcessId AppScheduler::spawn(const QString &name, int priority, WorkFunction work)
+{
+    Process process;
+    process.name = name;
+    process.priority = priority;
+    process.work = std::move(work);
+    process.remainingUs = 0;
+    process.readySince = 0;
+    process.lastRun = 0;
+    process.dispatched = false;
+    process.cpuUsedUs = 0;
+    process.hostPendingUs = 0;
+    process.onHost = std::make_shared<std::atomic<bool>>(false);
+    processes.append(process);
+    return processes.size() - 1;
+}
+
+void AppScheduler::setForeground(ProcessId pid)
+{
+    if (pid >= -1 && pid < processes.size()) {
+        foregroundPid = pid;
+    }
+}
+
+AppScheduler::ProcessId AppScheduler::foreground() const
+{
+    return foregroundPid;
+}
+
+void AppScheduler::wake(ProcessId pid, qint64 cpuUs)
+{
+    if (pid < 0 || pid >= processes.size() || cpuUs <= 0) {
+        return;
+    }
+
+    Process &process = processes[pid];
+    if (process.remainingUs == 0) {
+        process.readySince = clock->now();
+        process.dispatched = false;
+    }
+    process.remainingUs += cpuUs;
+    ensureTick();
+}
+
+int AppScheduler::runnableCount() const
+{
+    return int(std::count_if(processes.cbegin(), processes.cend(),
+                             [](const Process &p) { return p.remainingUs > 0; }));
+}
+
+void AppScheduler::setThrottleSource(std::function<double()> source)
+{
+    throttle = std::move(source);
+}
+
+void AppScheduler::setUtilizationSink(std::function<void(double)> sink)
+{
+    utilization = std::move(sink);
+}
+
+void AppScheduler::setHostWorkPerMs(int iterations)
+{
+    hostWorkPerMs = qMax(0, iterations);
+}
+
+int AppScheduler::hostSlicesInFlight() const
+{
+    std::lock_guard<std::mutex> lock(hostWork->mutex);
+    return hostWork->inFlight;
+}
+
+qint64 AppScheduler::hostWorkDroppedUs() const
+{
+    return hostDroppedUs;
+}
+
+int AppScheduler::coreCount() const
+{
+    return cores;
+}
+
+quint64 AppScheduler::tickCount() const
+{
+    return ticks;
+}
+
+const LatencyHistogram &AppScheduler::foregroundLatency() const
+{
+    return fgLatency;
+}
+
+const LatencyHistogram &AppScheduler::backgroundLatency() const
+{
+    return bgLatency;
+}
+
+QString AppScheduler::latencyReport() const
+{
+    QString report = QString("⚙️ Scheduling latency (%1 cores, %2 ms slice, %3 ticks, %4 ms host work dropped)\n")
+                         .arg(cores).arg(sliceMs).arg(ticks).arg(hostDroppedUs / 1000);
+    report += "  foreground: " + fgLatency.summary("ms") + "\n";
+    report += "  background: " + bgLatency.summary("ms");
+    for (const Process &process : processes) {
+        report += QString("\n  %1 (prio %2, cpu %3 ms): %4")
+                      .arg(process.name)
+                      .arg(process.priority)
+                      .arg(process.cpuUsedUs / 1000)
+                      .arg(process.latency.summary("ms"));
+    }
+    return report;
+}
+
+QJsonObject AppScheduler::toJson() const
+{
+    QJsonArray perProcess;
+    for (const Process &process : processes) {
+        QJsonObject entry = process.latency.toJson();
+        entry["name"] = process.name;
+        entry["priority"] = process.priority;
+        entry["cpuUsedUs"] = double(process.cpuUsedUs);
+        perProcess.append(entry);
+    }
+
+    QJsonObject json;
+    json["cores"] = cores;
+    json["sliceMs"] = double(sliceMs);
+    json["ticks"] = double(ticks);
+    json["hostDroppedUs"] = double(hostDroppedUs);
+    json["unit"] = "ms";
+    json["foreground"] = fgLatency.toJson();
+    json["background"] = bgLatency.toJson();
+    json["processes"] = perProcess;
+    return json;
+}
+
+void AppScheduler::ensureTick()
+{
+    if (tickEvent == 0) {
+        tickEvent = clock->scheduleAfter(0, [this]() { tick(); });
+    }
+}
+
+int AppScheduler::effectivePriority(ProcessId pid) const
+{
+    return processes[pid].priority + (pid == foregroundPid ? ForegroundBoost : 0);
+}
+
+void AppScheduler::tick()
+{
+    TRACE_SPAN("AppScheduler::tick", "scheduler");
+    tickEvent = 0;
+    ++ticks;
+    const qint64 now = clock->now();
+
+    QVector<ProcessId> runnable;
+    for (ProcessId pid = 0; pid < processes.size(); ++pid) {
+        if (processes[pid].remainingUs > 0) {
+            runnable.append(pid);
+        }
+    }
+
+    // Highest effective priority first; within a level, whoever waited longest
+    std::sort(runnable.begin(), runnable.end(), [this](ProcessId a, ProcessId b) {
+        int pa = effectivePriority(a);
+        int pb = effectivePriority(b);
+        if (pa != pb) {
+            return pa > pb;
+        }
+        const Process &x = processes[a];
+        const Process &y = processes[b];
+        qint64 waitA = x.dispatched ? x.lastRun : x.readySince;
+        qint64 waitB = y.dispatched ? y.lastRun : y.readySince;
+        return waitA < waitB;
+    });
+
+    double factor = throttle ? qBound(0.05, throttle(), 1.0) : 1.0;
+    qint64 capacityUs = qMax<qint64>(1, qint64(double(sliceMs * 1000) * factor));
+    int busy = qMin(cores, int(runnable.size()));
+
+    for (int i = 0; i < busy; ++i) {
+        ProcessId pid = runnable[i];
+        Process &process = processes[pid];
+        if (!process.dispatched) {
+            qint64 waited = now - process.readySince;
+            process.latency.record(waited);
+            (pid == foregroundPid ? fgLatency : bgLatency).record(waited);
+            process.dispatched = true;
+        }
+
+        qint64 granted = qMin(process.remainingUs, capacityUs);
+        process.remainingUs -= granted;
+        process.cpuUsedUs += granted;
+        process.lastRun = now;
+        if (process.remainingUs == 0) {
+            process.dispatched = false;
+        }
+
+        submitHostWork(process, granted);
+    }
+    // Host work left over from slices granted while earlier ones still ran
+    bool hostBehind = false;
+    for (ProcessId pid = 0; pid < processes.size(); ++pid) {
+        Process &process = processes[pid];
+        if (process.hostPendingUs > 0 && process.remainingUs == 0) {
+            submitHostWork(process, 0);
+        }
+        hostBehind = hostBehind || process.hostPendingUs > 0;
+    }
+
+    if (utilization) {
+        utilization(double(busy) / double(cores));
+    }
+    if (runnable.size() > busy || std::any_of(runnable.cbegin(), runnable.cbegin() + busy,
+            [this](ProcessId pid) { return processes[pid].remainingUs > 0; })) {
+        tickEvent = clock->scheduleAfter(sliceMs, [this]() { tick(); });
+    } else {
+        if (utilization) {
+            utilization(0.0);
+        }
+        if (hostBehind) {
+            tickEvent = clock->scheduleAfter(sliceMs, [this]() { tick(); });
+        }
+    }
+}
+
+void AppScheduler::submitHostWork(Process &process, qint64 grantedUs)
+{
+    WorkFunction work = process.work;
+    if (!work && hostWorkPerMs > 0) {
+        qint64 perMs = hostWorkPerMs;
+        work = [perMs](qint64 sliceUs) { burnHostCpu(perMs * sliceUs / 1000); };
+    }
+    if (!work) {
+        return;
+    }
+
+    process.hostPendingUs += grantedUs;
+    if (process.onHost->exchange(true)) {
+        // Still running its last slice; this one joins the next, within limits
+        const qint64 limit = hostBacklogLimitUs();
+        if (process.hostPendingUs > limit) {
+            hostDroppedUs += process.hostPendingUs - limit;
+            process.hostPendingUs = limit;
+        }
+        return;
+    }
+    const qint64 sliceUs = process.hostPendingUs;
+    process.hostPendingUs = 0;
+    {
+        std::lock_guard<std::mutex> lock(hostWork->mutex);
+        hostWork->inFlight++;
+    }
+    pool->submit([work, sliceUs, onHost = process.onHost, state = hostWork]() {
+        work(sliceUs);
+        onHost->store(false);
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (--state->inFlight == 0) {
+            state->idle.notify_all();
+        }
+    });
+}
+
+// Ahead of real time the host cannot keep up by design, so only the slice
+// already running is done; keeping a backlog would make host work grow with
+// simulated time
+qint64 AppScheduler::hostBacklogLimitUs() const
+{
+    if (clock->mode() != SimulationClock::Mode::RealTime || clock->timeScale() > 1.0) {
+        return 0;
+    }
+    return HostBacklogSlices * sliceMs * 1000;
+}
\ No newline at end of file
@@ -0,0 +1,114 @@
+#ifndef APPSCHEDULER_H
+#define APPSCHEDULER_H
+
+#include "simulationclock.h"
+#include "latencyhistogram.h"
+#include <QString>
+#include <QVector>
+#include <QJsonObject>
+#include <condition_variable>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+class WorkStealingExecutor;
+
+// Simulated app processes scheduled on simulated CPU cores. Each tick
+// picks the highest effective priority runnable processes (the foreground
+// app gets a boost), charges them one time slice and hands their host-side
+// work to a work-stealing executor so load spreads over real cores. The
+// clock thread never waits for that work: a process has at most one slice
+// on the host at a time, and simulated time granted while it runs is added
+// to its next slice, up to HostBacklogSlices; the rest is dropped. A clock
+// running faster than real time keeps no backlog, so host work never grows
+// with simulated time. Wake-to-dispatch latency is recorded per process.
+class AppScheduler
+{
+public:
+    enum Priority { Background = 0, Normal = 10, Interactive = 20 };
+    using ProcessId = int;
+    // Host work for one slice; receives the simulated CPU time granted in us
+    using WorkFunction = std::function<void(qint64 sliceUs)>;
+
+    AppScheduler(SimulationClock *clock, int coreCount = 4, qint64 timeSliceMs = 5,
+                 WorkStealingExecutor *executor = nullptr);
+    // Waits for host work still running
+    ~AppScheduler();
+
+    ProcessId spawn(const QString &name, int priority, WorkFunction work = WorkFunction());
+    void setForeground(ProcessId pid);
+    ProcessId foreground() const;
+    // Make a process runnable with cpuUs of work (added to any outstanding work)
+    void wake(ProcessId pid, qint64 cpuUs);
+    int runnableCount() const;
+
+    // Throughput multiplier in (0, 1], e.g. from thermal throttling
+    void setThrottleSource(std::function<double()> source);
+    // Receives busy cores / total cores after every tick
+    void setUtilizationSink(std::function<void(double)> sink);
+    // Busy-loop iterations per simulated CPU ms when a process has no work function
+    void setHostWorkPerMs(int iterations);
+    // Slices submitted to the executor and not finished yet
+    int hostSlicesInFlight() const;
+    // Simulated CPU time whose host work was dropped because the host fell behind
+    qint64 hostWorkDroppedUs() const;
+
+    int coreCount() const;
+    quint64 tickCount() const;
+    const LatencyHistogram &foregroundLatency() const;
+    const LatencyHistogram &backgroundLatency() const;
+    QString latencyReport() const;
+    QJsonObject toJson() const;
+
+    static constexpr int ForegroundBoost = 15;
+    static constexpr int HostBacklogSlices = 4;
+
+private:
+    struct Process
+    {
+        QString name;
+        int priority;
+        WorkFunction work;
+        qint64 remainingUs;
+        qint64 readySince;
+        qint64 lastRun;
+        bool dispatched;
+        qint64 cpuUsedUs;
+        qint64 hostPendingUs;       // granted while its last slice was still on the host
+        std::shared_ptr<std::atomic<bool>> onHost;
+        LatencyHistogram latency;   // ms of simulated time
+    };
+
+    // Outstanding host slices; shared with the tasks so the destructor can wait
+    struct HostWork
+    {
+        std::mutex mutex;
+        std::condition_variable idle;
+        int inFlight = 0;
+    };
+
+    void ensureTick();
+    void tick();
+    int effectivePriority(ProcessId pid) const;
+    void submitHostWork(Process &process, qint64 grantedUs);
+    qint64 hostBacklogLimitUs() const;
+
+    SimulationClock *clock;
+    WorkStealingExecutor *pool;
+    int cores;
+    qint64 sliceMs;
+    QVector<Process> processes;
+    ProcessId foregroundPid;
+    SimulationClock::EventId tickEvent;
+    quint64 ticks;
+    int hostWorkPerMs;
+    qint64 hostDroppedUs;
+    std::function<double()> throttle;
+    std::function<void(double)> utilization;
+    LatencyHistogram fgLatency;
+    LatencyHistogram bgLatency;
+    std::shared_ptr<HostWork> hostWork;
+};
+
+#endif // APPSCHEDULER_H
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "asyncphone.h"
+#include "smartphone.h"
+#include "tracing.h"
+#include <QMetaObject>
+#include <QThread>
+
+AsyncPhone::AsyncPhone(Smartphone *phone, QObject *parent)
+    : QObject(parent), phone(phone), thread(new QThread(this)),
+      pending(0), peak(0), completed(0), canceled(0)
+{
+    thread->setObjectName("phone");
+    phone->moveToThread(thread);
+    thread->start();
+    run([](Smartphone &) { Tracer::setThreadName("phone"); });
+}
+
+AsyncPhone::~AsyncPhone()
+{
+    shutdown();
+}
+
+QFuture<bool> AsyncPhone::unlockPhone(const QString &password)
+{
+    return run([password](Smartphone &p) { return p.unlockPhone(password); });
+}
+
+QFuture<void> AsyncPhone::lockPhone()
+{
+    return run([](Smartphone &p) { p.lockPhone(); });
+}
+
+QFuture<bool> AsyncPhone::takePhoto()
+{
+    return run([](Smartphone &p) { return p.takePhoto(); });
+}
+
+QFuture<bool> AsyncPhone::loadMusicFile(const QString &filePath)
+{
+    return run([filePath](Smartphone &p) { return p.loadMusicFile(filePath); });
+}
+
+QFuture<bool> AsyncPhone::playMusic()
+{
+    return run([](Smartphone &p) { return p.playMusic(); });
+}
+
+QFuture<void> AsyncPhone::stopMusic()
+{
+    return run([](Smartphone &p) { p.stopMusic(); });
+}
+
+QFuture<QString> AsyncPhone::getStorageInfo()
+{
+    return run([](Smartphone &p) { return p.getStorageInfo(); });
+}
+
+QFuture<bool> AsyncPhone::startVoiceMemo(AudioEncoder::Format format)
+{
+    return run([format](Smartphone &p) { return p.startVoiceMemo(format); });
+}
+
+QFuture<VoiceRecorder::Summary> AsyncPhone::stopVoiceMemo()
+{
+    return run([](Smartphone &p) { return p.stopVoiceMemo(); });
+}
+
+QFuture<bool> AsyncPhone::startViewfinder(int analysisThreads)
+{
+    return run([analysisThreads](Smartphone &p) { return p.startViewfinder(analysisThreads); });
+}
+
+QFuture<void> AsyncPhone::stopViewfinder()
+{
+    return run([](Smartphone &p) { p.stopViewfinder(); });
+}
+
+void AsyncPhone::waitForIdle()
+{
+    if (!isRunning()) {
+        return;
+    }
+    // The queue is FIFO: once this no-op has run, so has everything before it
+    run([](Smartphone &) {}).waitForFinished();
+}
+
+void AsyncPhone::shutdown()
+{
+    if (!isRunning()) {
+        return;
+    }
+    // Only the phone's own thread may push it to another thread
+    QThread *home = QThread::currentThread();
+    run([home](Smartphone &p) { p.moveToThread(home); }).waitForFinished();
+    thread->quit();
+    thread->wait();
+}
+
+bool AsyncPhone::isRunning() const
+{
+    return thread->isRunning();
+}
+
+int AsyncPhone::inFlight() const
+{
+    return pending.load(std::memory_order_relaxed);
+}
+
+int AsyncPhone::peakInFlight() const
+{
+    return peak.load(std::memory_order_relaxed);
+}
+
+quint64 AsyncPhone::completedCount() const
+{
+    return completed.load(std::memory_order_relaxed);
+}
+
+quint64 AsyncPhone::canceledCount() const
+{
+    return canceled.load(std::memory_order_relaxed);
+}
+
+void AsyncPhone::post(std::function<void()> task)
+{
+    int depth = pending.fetch_add(1, std::memory_order_relaxed) + 1;
+    int highest = peak.load(std::memory_order_relaxed);
+    while (depth > highest && !peak.compare_exchange_weak(highest, depth, std::memory_order_relaxed)) {
+    }
+    // Queued events to the phone keep submission order
+    QMetaObject::invokeMethod(phone, std::move(task), Qt::QueuedConnection);
+}
+
+void AsyncPhone::settle(bool wasCanceled)
+{
+    pending.fetch_sub(1, std::memory_order_relaxed);
+    if (wasCanceled) {
+        canceled.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        completed.fetch_add(1, std::memory_order_relaxed);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#ifndef ASYNCPHONE_H
+#define ASYNCPHONE_H
+
+#include <QFuture>
+#include <QPromise>
+#include <QObject>
+#include <QString>
+#include "voicerecorder.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <type_traits>
+
+class QThread;
+class Smartphone;
+
+// Asynchronous front end for a Smartphone. The phone (with its clock and
+// media backend) is moved to a dedicated thread and every operation is
+// queued there in submission order, so callers never block and operations
+// never race. Results come back as QFutures: chain .then(context, ...) to
+// get the completion on the caller's thread, and cancel() a future to skip
+// an operation that has not started yet.
+class AsyncPhone : public QObject
+{
+    Q_OBJECT
+public:
+    // The phone must not have a parent; it is not owned
+    explicit AsyncPhone(Smartphone *phone, QObject *parent = nullptr);
+    ~AsyncPhone();
+
+    QFuture<bool> unlockPhone(const QString &password);
+    QFuture<void> lockPhone();
+    QFuture<bool> takePhoto();
+    QFuture<bool> loadMusicFile(const QString &filePath);
+    QFuture<bool> playMusic();
+    QFuture<void> stopMusic();
+    QFuture<QString> getStorageInfo();
+    QFuture<bool> startVoiceMemo(AudioEncoder::Format format);
+    QFuture<VoiceRecorder::Summary> stopVoiceMemo();
+    QFuture<bool> startViewfinder(int analysisThreads);
+    QFuture<void> stopViewfinder();
+
+    // Run any operation against the phone on its thread
+    template <typename F>
+    auto run(F &&operation) -> QFuture<std::invoke_result_t<F, Smartphone &>>;
+
+    // Block until everything submitted so far has finished; not from the phone's thread
+    void waitForIdle();
+    // Finish queued work, stop the thread and hand the phone back to the calling thread
+    void shutdown();
+    bool isRunning() const;
+
+    int inFlight() const;
+    int peakInFlight() const;
+    quint64 completedCount() const;
+    quint64 canceledCount() const;
+
+private:
+    void post(std::function<void()> task);
+    void settle(bool wasCanceled);
+
+    Smartphone *phone;
+    QThread *thread;
+    std::atomic<int> pending;
+    std::atomic<int> peak;
+    std::atomic<quint64> completed;
+    std::atomic<quint64> canceled;
+};
+
+template <typename F>
+auto AsyncPhone::run(F &&operation) -> QFuture<std::invoke_result_t<F, Smartphone &>>
+{
+    using Result = std::invoke_result_t<F, Smartphone &>;
+    auto promise = std::make_shared<QPromise<Result>>();
+    QFuture<Result> future = promise->future();
+    post([this, promise, operation = std::forward<F>(operation)]() mutable {
+        promise->start();
+        bool wasCanceled = promise->isCanceled();
+        if (!wasCanceled) {
+            if constexpr (std::is_void_v<Result>) {
+                operation(*phone);
+            } else {
+                promise->addResult(operation(*phone));
+            }
+        }
+        promise->finish();
+        settle(wasCanceled);
+    });
+    return future;
+}
+
+#endif // ASYNCPHONE_H
\ No newline at end of file
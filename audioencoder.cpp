@@ -0,0 +1,460 @@
+#include "audioencoder.h"
+#include <QCryptographicHash>
+#include <QtEndian>
+#include <array>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr int BitsPerSample = 16;
+
+// ---- WAV ----------------------------------------------------------------
+
+class WavEncoder : public AudioEncoder
+{
+public:
+    WavEncoder(int sampleRate, int channels) : AudioEncoder(sampleRate, channels) {}
+
+    void begin(QByteArray &out) override
+    {
+        out += header();
+    }
+
+    void encode(const qint16 *samples, int count, QByteArray &out) override
+    {
+        qsizetype values = qsizetype(count) * channels;
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        out.append(reinterpret_cast<const char *>(samples), values * qsizetype(sizeof(qint16)));
+#else
+        qsizetype start = out.size();
+        out.resize(start + values * qsizetype(sizeof(qint16)));
+        qToLittleEndian<qint16>(samples, values, out.data() + start);
+#endif
+        frames += quint64(count);
+    }
+
+    QByteArray header() const override
+    {
+        // The RIFF sizes are 32-bit; past 4 GB they stay saturated
+        quint64 dataBytes = frames * quint64(channels) * sizeof(qint16);
+        quint32 dataSize = dataBytes > 0xFFFFFFFFull - 36 ? 0xFFFFFFFFu - 36 : quint32(dataBytes);
+        int blockAlign = channels * int(sizeof(qint16));
+
+        QByteArray header(44, '\0');
+        char *h = header.data();
+        std::memcpy(h, "RIFF", 4);
+        qToLittleEndian<quint32>(36 + dataSize, h + 4);
+        std::memcpy(h + 8, "WAVEfmt ", 8);
+        qToLittleEndian<quint32>(16, h + 16);
+        qToLittleEndian<quint16>(1, h + 20);        // PCM
+        qToLittleEndian<quint16>(quint16(channels), h + 22);
+        qToLittleEndian<quint32>(quint32(rate), h + 24);
+        qToLittleEndian<quint32>(quint32(rate * blockAlign), h + 28);
+        qToLittleEndian<quint16>(quint16(blockAlign), h + 32);
+        qToLittleEndian<quint16>(BitsPerSample, h + 34);
+        std::memcpy(h + 36, "data", 4);
+        qToLittleEndian<quint32>(dataSize, h + 40);
+        return header;
+    }
+};
+
+// ---- FLAC ---------------------------------------------------------------
+
+std::array<quint8, 256> makeCrc8Table()
+{
+    std::array<quint8, 256> table{};
+    for (int i = 0; i < 256; ++i) {
+        quint8 crc = quint8(i);
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = quint8((crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+std::array<quint16, 256> makeCrc16Table()
+{
+    std::array<quint16, 256> table{};
+    for (int i = 0; i < 256; ++i) {
+        quint16 crc = quint16(i << 8);
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = quint16((crc & 0x8000) ? (crc << 1) ^ 0x8005 : crc << 1);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+const std::array<quint8, 256> Crc8Table = makeCrc8Table();
+const std::array<quint16, 256> Crc16Table = makeCrc16Table();
+
+quint8 crc8(const uchar *data, size_t length)
+{
+    quint8 crc = 0;
+    for (size_t i = 0; i < length; ++i) {
+        crc = Crc8Table[crc ^ data[i]];
+    }
+    return crc;
+}
+
+quint16 crc16(const uchar *data, size_t length)
+{
+    quint16 crc = 0;
+    for (size_t i = 0; i < length; ++i) {
+        crc = quint16((crc << 8) ^ Crc16Table[(crc >> 8) ^ data[i]]);
+    }
+    return crc;
+}
+
+// MSB-first bit packing into a buffer the caller has sized for the worst case
+class BitWriter
+{
+public:
+    explicit BitWriter(uchar *out) : out(out), pos(0), accumulator(0), pending(0) {}
+
+    void put(quint32 value, int count)     // count <= 32
+    {
+        quint64 masked = count == 32 ? value : value & ((quint32(1) << count) - 1);
+        accumulator = (accumulator << count) | masked;
+        pending += count;
+        while (pending >= 8) {
+            pending -= 8;
+            out[pos++] = uchar(accumulator >> pending);
+        }
+    }
+
+    // q zeros, then a one
+    void unary(quint32 q)
+    {
+        while (q >= 32) {
+            put(0, 32);
+            q -= 32;
+        }
+        put(1, int(q) + 1);
+    }
+
+    void alignToByte()
+    {
+        if (pending > 0) {
+            put(0, 8 - pending);
+        }
+    }
+
+    size_t bytes() const { return pos; }
+
+private:
+    uchar *out;
+    size_t pos;
+    quint64 accumulator;
+    int pending;
+};
+
+// Verbatim, constant or fixed-predictor subframes with Rice-coded residuals,
+// as the FLAC reference encoder does at its fastest settings. Channels are
+// coded independently and every block but the last has MaxBlockFrames frames.
+class FlacEncoder : public AudioEncoder
+{
+public:
+    static constexpr int MaxPartitionOrder = 8;
+    static constexpr int MaxRiceParameter = 14;     // 15 is the escape code
+
+    FlacEncoder(int sampleRate, int channels)
+        : AudioEncoder(sampleRate, channels), frameNumber(0), minFrameBytes(0), maxFrameBytes(0),
+          md5(QCryptographicHash::Md5),
+          // A verbatim frame is the largest one ever written
+          frame(32 + size_t(channels) * (8 + size_t(MaxBlockFrames) * sizeof(qint16))),
+          signal(MaxBlockFrames), residual(MaxBlockFrames)
+    {
+    }
+
+    void begin(QByteArray &out) override
+    {
+        out += header();
+    }
+
+    void encode(const qint16 *samples, int count, QByteArray &out) override
+    {
+        if (count <= 0) {
+            return;
+        }
+        count = qMin(count, int(MaxBlockFrames));
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        md5.addData(QByteArrayView(reinterpret_cast<const char *>(samples),
+                                   qsizetype(count) * channels * qsizetype(sizeof(qint16))));
+#endif
+
+        BitWriter bits(frame.data());
+        writeFrameHeader(bits, count);
+        for (int c = 0; c < channels; ++c) {
+            for (int i = 0; i < count; ++i) {
+                signal[i] = samples[i * channels + c];
+            }
+            writeSubframe(bits, count);
+        }
+        bits.alignToByte();
+        quint16 crc = crc16(frame.data(), bits.bytes());
+        bits.put(crc, 16);
+
+        quint32 size = quint32(bits.bytes());
+        minFrameBytes = minFrameBytes == 0 ? size : qMin(minFrameBytes, size);
+        maxFrameBytes = qMax(maxFrameBytes, size);
+        out.append(reinterpret_cast<const char *>(frame.data()), qsizetype(size));
+        frames += quint64(count);
+        ++frameNumber;
+    }
+
+    QByteArray header() const override
+    {
+        QByteArray header(42, '\0');
+        uchar *h = reinterpret_cast<uchar *>(header.data());
+        std::memcpy(h, "fLaC", 4);
+        h[4] = 0x80;    // last metadata block, STREAMINFO
+        h[7] = 34;
+
+        BitWriter info(h + 8);
+        info.put(MaxBlockFrames, 16);
+        info.put(MaxBlockFrames, 16);
+        info.put(minFrameBytes, 24);
+        info.put(maxFrameBytes, 24);
+        info.put(quint32(rate), 20);
+        info.put(quint32(channels - 1), 3);
+        info.put(BitsPerSample - 1, 5);
+        info.put(quint32(frames >> 32) & 0xF, 4);
+        info.put(quint32(frames), 32);
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        // An all-zero signature means "not computed", which is what big-endian hosts leave
+        if (frames > 0) {
+            QByteArray signature = md5.result();
+            std::memcpy(h + 26, signature.constData(), 16);
+        }
+#endif
+        return header;
+    }
+
+private:
+    static int sampleRateCode(int rate)
+    {
+        switch (rate) {
+        case 8000:  return 4;
+        case 16000: return 5;
+        case 22050: return 6;
+        case 24000: return 7;
+        case 32000: return 8;
+        case 44100: return 9;
+        case 48000: return 10;
+        case 96000: return 11;
+        default:    return 0;   // taken from STREAMINFO
+        }
+    }
+
+    void writeFrameHeader(BitWriter &bits, int count)
+    {
+        bits.put(0x3FFE, 14);       // sync code
+        bits.put(0, 1);
+        bits.put(0, 1);             // fixed block size
+        bool fullBlock = count == MaxBlockFrames;
+        bits.put(fullBlock ? 12 : 7, 4);    // 4096, or 16-bit size below
+        bits.put(quint32(sampleRateCode(rate)), 4);
+        bits.put(quint32(channels - 1), 4); // independent channels
+        bits.put(4, 3);             // 16 bits per sample
+        bits.put(0, 1);
+
+        // Frame number in the extended UTF-8 coding, up to 36 bits
+        quint64 n = frameNumber;
+        if (n < 0x80) {
+            bits.put(quint32(n), 8);
+        } else {
+            int extra = 1;
+            while (extra < 6 && n >= (quint64(1) << (6 + 5 * extra))) {
+                ++extra;
+            }
+            quint32 lead = (0xFF00u >> (extra + 1)) & 0xFF;
+            bits.put(lead | quint32(n >> (6 * extra)), 8);
+            for (int i = extra - 1; i >= 0; --i) {
+                bits.put(0x80 | (quint32(n >> (6 * i)) & 0x3F), 8);
+            }
+        }
+        if (!fullBlock) {
+            bits.put(quint32(count - 1), 16);
+        }
+        bits.put(crc8(frame.data(), bits.bytes()), 8);
+    }
+
+    void writeSubframe(BitWriter &bits, int count)
+    {
+        bool constant = true;
+        for (int i = 1; i < count && constant; ++i) {
+            constant = signal[i] == signal[0];
+        }
+        if (constant) {
+            bits.put(0, 8);
+            bits.put(quint32(signal[0]), BitsPerSample);
+            return;
+        }
+
+        int order = count > 4 ? bestFixedOrder(count) : -1;
+        if (order >= 0) {
+            Partitioning plan = planResidual(count, order);
+            if (plan.bits < quint64(count - order) * BitsPerSample) {
+                bits.put(quint32(8 + order) << 1, 8);
+                for (int i = 0; i < order; ++i) {
+                    bits.put(quint32(signal[i]), BitsPerSample);
+                }
+                writeResidual(bits, count, order, plan);
+                return;
+            }
+        }
+
+        bits.put(1 << 1, 8);        // verbatim
+        for (int i = 0; i < count; ++i) {
+            bits.put(quint32(signal[i]), BitsPerSample);
+        }
+    }
+
+    // The order whose residual has the smallest total magnitude
+    int bestFixedOrder(int count)
+    {
+        quint64 totals[5] = {0, 0, 0, 0, 0};
+        for (int i = 4; i < count; ++i) {
+            qint32 e0 = signal[i];
+            qint32 e1 = e0 - signal[i - 1];
+            qint32 e2 = e1 - (signal[i - 1] - signal[i - 2]);
+            qint32 e3 = e2 - (signal[i - 1] - 2 * signal[i - 2] + signal[i - 3]);
+            qint32 e4 = e3 - (signal[i - 1] - 3 * signal[i - 2] + 3 * signal[i - 3] - signal[i - 4]);
+            totals[0] += quint32(qAbs(e0));
+            totals[1] += quint32(qAbs(e1));
+            totals[2] += quint32(qAbs(e2));
+            totals[3] += quint32(qAbs(e3));
+            totals[4] += quint32(qAbs(e4));
+        }
+        int best = 0;
+        for (int order = 1; order <= 4; ++order) {
+            if (totals[order] < totals[best]) {
+                best = order;
+            }
+        }
+
+        for (int i = best; i < count; ++i) {
+            qint32 e;
+            switch (best) {
+            case 0:  e = signal[i]; break;
+            case 1:  e = signal[i] - signal[i - 1]; break;
+            case 2:  e = signal[i] - 2 * signal[i - 1] + signal[i - 2]; break;
+            case 3:  e = signal[i] - 3 * signal[i - 1] + 3 * signal[i - 2] - signal[i - 3]; break;
+            default: e = signal[i] - 4 * signal[i - 1] + 6 * signal[i - 2] - 4 * signal[i - 3] + signal[i - 4]; break;
+            }
+            residual[i] = (quint32(e) << 1) ^ quint32(e >> 31);     // zigzag
+        }
+        return best;
+    }
+
+    struct Partitioning
+    {
+        int order = 0;
+        int parameters[1 << MaxPartitionOrder] = {};
+        quint64 bits = 0;
+    };
+
+    static int riceParameter(quint64 sum, quint64 count)
+    {
+        int k = 0;
+        while (k < MaxRiceParameter && (count << (k + 1)) <= sum) {
+            ++k;
+        }
+        return k;
+    }
+
+    // Tries every partition order the block allows and keeps the cheapest
+    Partitioning planResidual(int count, int order)
+    {
+        Partitioning best;
+        best.bits = ~quint64(0);
+        for (int p = 0; p <= MaxPartitionOrder; ++p) {
+            if (p > 0 && (count % (1 << p) != 0 || (count >> p) <= order)) {
+                break;
+            }
+            Partitioning plan;
+            plan.order = p;
+            plan.bits = 6;
+            int partitionSize = count >> p;
+            for (int part = 0; part < (1 << p); ++part) {
+                int begin = part == 0 ? order : part * partitionSize;
+                int end = (part + 1) * partitionSize;
+                quint64 sum = 0;
+                for (int i = begin; i < end; ++i) {
+                    sum += residual[i];
+                }
+                int k = riceParameter(sum, quint64(end - begin));
+                plan.parameters[part] = k;
+                quint64 quotients = 0;
+                for (int i = begin; i < end; ++i) {
+                    quotients += residual[i] >> k;
+                }
+                plan.bits += 4 + quotients + quint64(end - begin) * quint64(k + 1);
+            }
+            if (plan.bits < best.bits) {
+                best = plan;
+            }
+        }
+        return best;
+    }
+
+    void writeResidual(BitWriter &bits, int count, int order, const Partitioning &plan)
+    {
+        bits.put(0, 2);             // 4-bit Rice parameters
+        bits.put(quint32(plan.order), 4);
+        int partitionSize = count >> plan.order;
+        for (int part = 0; part < (1 << plan.order); ++part) {
+            int k = plan.parameters[part];
+            bits.put(quint32(k), 4);
+            int begin = part == 0 ? order : part * partitionSize;
+            int end = (part + 1) * partitionSize;
+            for (int i = begin; i < end; ++i) {
+                bits.unary(residual[i] >> k);
+                if (k > 0) {
+                    bits.put(residual[i], k);
+                }
+            }
+        }
+    }
+
+    quint64 frameNumber;
+    quint32 minFrameBytes;
+    quint32 maxFrameBytes;
+    QCryptographicHash md5;
+    std::vector<uchar> frame;
+    std::vector<qint32> signal;
+    std::vector<quint32> residual;
+};
+
+} // namespace
+
+std::unique_ptr<AudioEncoder> AudioEncoder::create(Format format, int sampleRate, int channels)
+{
+    if (sampleRate <= 0 || sampleRate >= (1 << 20) || channels < 1 || channels > MaxChannels) {
+        return nullptr;
+    }
+    if (format == Format::Flac) {
+        return std::make_unique<FlacEncoder>(sampleRate, channels);
+    }
+    return std::make_unique<WavEncoder>(sampleRate, channels);
+}
+
+QString AudioEncoder::formatName(Format format)
+{
+    return format == Format::Flac ? "flac" : "wav";
+}
+
+bool AudioEncoder::formatFromName(const QString &name, Format &format)
+{
+    if (name.compare("flac", Qt::CaseInsensitive) == 0) {
+        format = Format::Flac;
+    } else if (name.compare("wav", Qt::CaseInsensitive) == 0) {
+        format = Format::Wav;
+    } else {
+        return false;
+    }
+    return true;
+}
\ No newline at end of file
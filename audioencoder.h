@@ -0,0 +1,42 @@
+#ifndef AUDIOENCODER_H
+#define AUDIOENCODER_H
+
+#include <QByteArray>
+#include <QString>
+#include <memory>
+
+// Incremental encoder for interleaved 16-bit PCM. begin() emits a header
+// with placeholder sizes, encode() appends the bytes for one block of
+// frames, and header() returns the final header (same length as the one
+// from begin()) to be written back over it once the stream has ended.
+class AudioEncoder
+{
+public:
+    enum class Format { Wav, Flac };
+
+    static constexpr int MaxBlockFrames = 4096;     // largest block encode() accepts
+    static constexpr int MaxChannels = 2;
+
+    virtual ~AudioEncoder() = default;
+
+    static std::unique_ptr<AudioEncoder> create(Format format, int sampleRate, int channels);
+    static QString formatName(Format format);
+    static bool formatFromName(const QString &name, Format &format);
+
+    virtual void begin(QByteArray &out) = 0;
+    virtual void encode(const qint16 *samples, int frames, QByteArray &out) = 0;
+    virtual QByteArray header() const = 0;
+
+    int sampleRate() const { return rate; }
+    int channelCount() const { return channels; }
+    quint64 encodedFrames() const { return frames; }
+
+protected:
+    AudioEncoder(int sampleRate, int channels) : rate(sampleRate), channels(channels), frames(0) {}
+
+    const int rate;
+    const int channels;
+    quint64 frames;
+};
+
+#endif // AUDIOENCODER_H
\ No newline at end of file
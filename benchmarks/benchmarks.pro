@@ -0,0 +1,6 @@
+# Build every benchmark: qmake benchmarks.pro && make
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    eventbus \
+    phonebench
\ No newline at end of file
@@ -0,0 +1,17 @@
+QT = core
+
+CONFIG += console c++17
+CONFIG -= app_bundle
+
+TARGET = eventbus_bench
+TEMPLATE = app
+
+INCLUDEPATH += ../..
+
+SOURCES += \
+    main.cpp \
+    ../../eventbus.cpp
+
+HEADERS += \
+    ../../eventbus.h \
+    ../../lockfreequeue.h
\ No newline at end of file
@@ -0,0 +1,83 @@
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QTextStream>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "eventbus.h"
+
+// Event bus throughput: N producer threads publish into the bus while one
+// consumer thread per subscriber drains its queue in batches.
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QStringList args = app.arguments();
+    int producers = args.value(1, "4").toInt();
+    qint64 eventsPerProducer = args.value(2, "1000000").toLongLong();
+    int subscribers = args.value(3, "2").toInt();
+
+    EventBus bus(4096);
+    std::vector<std::atomic<qint64>> received(subscribers);
+    std::vector<EventBus::SubscriberId> ids;
+    for (int s = 0; s < subscribers; ++s) {
+        received[s].store(0);
+        ids.push_back(bus.subscribe(AllPhoneEvents, nullptr, [&received, s](const QVector<PhoneEvent> &batch) {
+            // A batch after an overflow ends with EventsDropped, which is not a published event
+            const bool gap = batch.constLast().type == PhoneEvent::EventsDropped;
+            received[s].fetch_add(batch.size() - (gap ? 1 : 0), std::memory_order_relaxed);
+        }));
+    }
+
+    const qint64 total = producers * eventsPerProducer;
+    std::atomic<bool> producing(true);
+    QElapsedTimer timer;
+    timer.start();
+
+    std::vector<std::thread> consumers;
+    for (int s = 0; s < subscribers; ++s) {
+        consumers.emplace_back([&, s]() {
+            while (producing.load(std::memory_order_acquire)) {
+                if (bus.drain(ids[s]) == 0) {
+                    std::this_thread::yield();
+                }
+            }
+            while (bus.drain(ids[s]) > 0) {
+            }
+        });
+    }
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&bus, eventsPerProducer, p]() {
+            PhoneEvent event;
+            event.type = PhoneEvent::PhotoCaptured;
+            for (qint64 i = 0; i < eventsPerProducer; ++i) {
+                event.timestamp = i;
+                event.value = p;
+                bus.publish(event);
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    producing.store(false, std::memory_order_release);
+    for (std::thread &thread : consumers) {
+        thread.join();
+    }
+
+    double seconds = timer.nsecsElapsed() / 1e9;
+    qint64 delivered = 0;
+    for (int s = 0; s < subscribers; ++s) {
+        delivered += received[s].load();
+    }
+
+    QTextStream out(stdout);
+    out << "producers=" << producers << " subscribers=" << subscribers
+        << " published=" << total << " delivered=" << delivered
+        << " dropped=" << bus.droppedCount() << "\n";
+    out << "publish throughput: " << qint64(total / seconds) << " events/s\n";
+    out << "delivery throughput: " << qint64(delivered / seconds) << " events/s\n";
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,218 @@
+#include "benchharness.h"
+#include "allocationtracker.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QSysInfo>
+#include <QTextStream>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+double percentileOf(const QVector<double> &sorted, double p)
+{
+    double position = p / 100.0 * (sorted.size() - 1);
+    int lower = int(position);
+    int upper = qMin(lower + 1, int(sorted.size()) - 1);
+    double fraction = position - lower;
+    return sorted[lower] + (sorted[upper] - sorted[lower]) * fraction;
+}
+
+} // namespace
+
+SampleStats SampleStats::of(QVector<double> samples)
+{
+    SampleStats stats;
+    if (samples.isEmpty()) {
+        return stats;
+    }
+    std::sort(samples.begin(), samples.end());
+
+    stats.count = samples.size();
+    double sum = 0.0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    stats.mean = sum / stats.count;
+    double squares = 0.0;
+    for (double sample : samples) {
+        squares += (sample - stats.mean) * (sample - stats.mean);
+    }
+    stats.stddev = stats.count > 1 ? std::sqrt(squares / (stats.count - 1)) : 0.0;
+    stats.min = samples.first();
+    stats.max = samples.last();
+    stats.median = percentileOf(samples, 50);
+    stats.p90 = percentileOf(samples, 90);
+    stats.p99 = percentileOf(samples, 99);
+    return stats;
+}
+
+QJsonObject SampleStats::toJson() const
+{
+    QJsonObject json;
+    json["samples"] = count;
+    json["mean"] = mean;
+    json["stddev"] = stddev;
+    json["min"] = min;
+    json["max"] = max;
+    json["median"] = median;
+    json["p90"] = p90;
+    json["p99"] = p99;
+    return json;
+}
+
+QJsonObject BenchmarkSuite::Result::toJson() const
+{
+    QJsonObject json = stats.toJson();
+    json["name"] = name;
+    json["kind"] = kind == Kind::Micro ? "micro" : "macro";
+    json["batch"] = batch;
+    json["unit"] = "ns";
+    json["allocations"] = allocations;
+    json["allocatedBytes"] = allocatedBytes;
+    json["peakBytes"] = peakBytes;
+    QJsonArray raw;
+    for (double sample : samples) {
+        raw.append(sample);
+    }
+    json["raw"] = raw;
+    return json;
+}
+
+QString BenchmarkSuite::formatNs(double ns)
+{
+    if (ns < 1e3) {
+        return QString("%1 ns").arg(ns, 0, 'f', 1);
+    } else if (ns < 1e6) {
+        return QString("%1 us").arg(ns / 1e3, 0, 'f', 2);
+    }
+    return QString("%1 ms").arg(ns / 1e6, 0, 'f', 2);
+}
+
+void BenchmarkSuite::add(const QString &name, Kind kind, Operation operation, Operation setup,
+                         int operationsPerCall)
+{
+    benchmarks.append(Benchmark{name, kind, std::move(operation), std::move(setup), qMax(1, operationsPerCall)});
+}
+
+QStringList BenchmarkSuite::names() const
+{
+    QStringList list;
+    for (const Benchmark &benchmark : benchmarks) {
+        list.append(benchmark.name);
+    }
+    return list;
+}
+
+qint64 BenchmarkSuite::timeBatch(const Benchmark &benchmark, int batch, AllocationTracker::Usage *usage)
+{
+    if (benchmark.setup) {
+        benchmark.setup();
+    }
+    AllocationTracker::Measurement measurement;
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < batch; ++i) {
+        benchmark.operation();
+    }
+    qint64 elapsed = timer.nsecsElapsed();
+    AllocationTracker::Usage batchUsage = measurement.stop();
+    if (usage) {
+        usage->allocations += batchUsage.allocations;
+        usage->bytes += batchUsage.bytes;
+        usage->peakBytes = qMax(usage->peakBytes, batchUsage.peakBytes);
+    }
+    return elapsed;
+}
+
+QVector<BenchmarkSuite::Result> BenchmarkSuite::run(const Options &options, QTextStream &progress) const
+{
+    QVector<Result> results;
+    for (const Benchmark &benchmark : benchmarks) {
+        if (!options.filter.pattern().isEmpty() && !options.filter.match(benchmark.name).hasMatch()) {
+            continue;
+        }
+        progress << "running " << benchmark.name << "..." << Qt::endl;
+
+        // Grow the batch until one sample is long enough to time reliably
+        int batch = 1;
+        if (benchmark.kind == Kind::Micro) {
+            while (batch < (1 << 24) && timeBatch(benchmark, batch) < options.minSampleNs) {
+                batch *= 2;
+            }
+        }
+        for (int i = 0; i < options.warmup; ++i) {
+            timeBatch(benchmark, batch);
+        }
+
+        Result result;
+        result.name = benchmark.name;
+        result.kind = benchmark.kind;
+        result.batch = batch * benchmark.operationsPerCall;
+        result.samples.reserve(options.repetitions);
+        AllocationTracker::Usage usage;
+        for (int i = 0; i < options.repetitions; ++i) {
+            result.samples.append(double(timeBatch(benchmark, batch, &usage)) / result.batch);
+        }
+        double operations = double(options.repetitions) * result.batch;
+        result.allocations = usage.allocations / operations;
+        result.allocatedBytes = usage.bytes / operations;
+        result.peakBytes = usage.peakBytes;
+        result.stats = SampleStats::of(result.samples);
+        results.append(result);
+    }
+    return results;
+}
+
+QString BenchmarkSuite::table(const QVector<Result> &results)
+{
+    int width = 9;
+    for (const Result &result : results) {
+        width = qMax(width, int(result.name.size()));
+    }
+
+    QString text = QString("%1  %2 %3 %4 %5 %6 %7 %8 %9\n")
+                       .arg("benchmark", -width).arg("batch", 8).arg("median", 11).arg("p90", 11)
+                       .arg("p99", 11).arg("min", 11).arg("stddev", 8).arg("allocs", 8).arg("bytes", 10);
+    for (const Result &result : results) {
+        const SampleStats &s = result.stats;
+        double relative = s.mean > 0 ? 100.0 * s.stddev / s.mean : 0.0;
+        text += QString("%1  %2 %3 %4 %5 %6 %7 %8 %9\n")
+                    .arg(result.name, -width).arg(result.batch, 8)
+                    .arg(formatNs(s.median), 11).arg(formatNs(s.p90), 11)
+                    .arg(formatNs(s.p99), 11).arg(formatNs(s.min), 11)
+                    .arg(QString("%1%").arg(relative, 0, 'f', 1), 8)
+                    .arg(result.allocations, 8, 'f', 1)
+                    .arg(result.allocatedBytes, 10, 'f', 0);
+    }
+    return text;
+}
+
+QJsonObject BenchmarkSuite::toJson(const QVector<Result> &results, const Options &options)
+{
+    QJsonObject machine;
+    machine["os"] = QSysInfo::prettyProductName();
+    machine["cpu"] = QSysInfo::currentCpuArchitecture();
+    machine["host"] = QSysInfo::machineHostName();
+    machine["qt"] = qVersion();
+
+    QJsonObject settings;
+    settings["warmup"] = options.warmup;
+    settings["repetitions"] = options.repetitions;
+    settings["minSampleNs"] = options.minSampleNs;
+    settings["filter"] = options.filter.pattern();
+
+    QJsonArray list;
+    for (const Result &result : results) {
+        list.append(result.toJson());
+    }
+
+    QJsonObject json;
+    json["suite"] = "phonebench";
+    json["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    json["machine"] = machine;
+    json["options"] = settings;
+    json["benchmarks"] = list;
+    return json;
+}
\ No newline at end of file
@@ -0,0 +1,92 @@
+#ifndef BENCHHARNESS_H
+#define BENCHHARNESS_H
+
+#include "allocationtracker.h"
+#include <QJsonObject>
+#include <QRegularExpression>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+class QTextStream;
+
+// Summary statistics over one benchmark's samples (ns per operation).
+// Percentiles interpolate between the two nearest ranks.
+struct SampleStats
+{
+    int count = 0;
+    double mean = 0.0;
+    double stddev = 0.0;    // sample standard deviation
+    double min = 0.0;
+    double max = 0.0;
+    double median = 0.0;
+    double p90 = 0.0;
+    double p99 = 0.0;
+
+    static SampleStats of(QVector<double> samples);
+    QJsonObject toJson() const;
+};
+
+// Runs registered benchmarks with warmup and repetitions. A microbenchmark
+// repeats its operation in batches sized so one sample takes at least
+// minSampleNs, which keeps timer overhead out of the result; a
+// macrobenchmark times every call on its own.
+class BenchmarkSuite
+{
+public:
+    enum class Kind { Micro, Macro };
+
+    struct Options
+    {
+        int warmup = 5;             // samples taken and thrown away
+        int repetitions = 30;       // samples kept
+        qint64 minSampleNs = 200000;
+        QRegularExpression filter;  // empty matches everything
+    };
+
+    struct Result
+    {
+        QString name;
+        Kind kind;
+        int batch;                  // operations per sample
+        QVector<double> samples;    // ns per operation
+        SampleStats stats;
+        // Heap use by this thread only, measured around the timed operations
+        double allocations;         // per operation
+        double allocatedBytes;      // per operation
+        qint64 peakBytes;           // highest net growth within one sample
+
+        QJsonObject toJson() const;
+    };
+
+    using Operation = std::function<void()>;
+
+    // setup, if given, runs untimed before every sample. An operation that
+    // does operationsPerCall things at once is reported per thing.
+    void add(const QString &name, Kind kind, Operation operation, Operation setup = {},
+             int operationsPerCall = 1);
+    QStringList names() const;
+
+    QVector<Result> run(const Options &options, QTextStream &progress) const;
+
+    static QString table(const QVector<Result> &results);
+    static QString formatNs(double ns);
+    static QJsonObject toJson(const QVector<Result> &results, const Options &options);
+
+private:
+    struct Benchmark
+    {
+        QString name;
+        Kind kind;
+        Operation operation;
+        Operation setup;
+        int operationsPerCall;
+    };
+
+    // Heap use of the timed operations (not the setup) is added to *usage
+    static qint64 timeBatch(const Benchmark &benchmark, int batch, AllocationTracker::Usage *usage = nullptr);
+
+    QVector<Benchmark> benchmarks;
+};
+
+#endif // BENCHHARNESS_H
\ No newline at end of file
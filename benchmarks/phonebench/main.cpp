@@ -0,0 +1,444 @@
+#include <QApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include "benchharness.h"
+#include "regressiongate.h"
+#include "camera.h"
+#include "musicplayer.h"
+#include "smartphone.h"
+#include "mainwindow.h"
+#include "phonelog.h"
+#include "allocationtracker.h"
+#include "scratcharena.h"
+#include "voicerecorder.h"
+#include "searchindex.h"
+#include "kvstore.h"
+#include "networkstack.h"
+#include "contentserver.h"
+#include "photobackup.h"
+
+namespace {
+
+using Kind = BenchmarkSuite::Kind;
+
+constexpr int RecordingSeconds = 10;
+constexpr int SearchDocuments = 10000;
+constexpr int StateRecoveryRecords = 10000;
+constexpr int BackupPhotos = 8;
+
+// Smallest valid WAV file: a header and no samples
+bool writeSilentWav(const QString &path)
+{
+    static const char header[44] = {
+        'R', 'I', 'F', 'F', 36, 0, 0, 0, 'W', 'A', 'V', 'E',
+        'f', 'm', 't', ' ', 16, 0, 0, 0, 1, 0, 1, 0, 0x44, char(0xAC), 0, 0,
+        char(0x88), 0x58, 0x01, 0, 2, 0, 16, 0, 'd', 'a', 't', 'a', 0, 0, 0, 0
+    };
+    QFile file(path);
+    return file.open(QIODevice::WriteOnly) && file.write(header, sizeof(header)) == sizeof(header);
+}
+
+// Long-lived objects, so every sample hits a warm instance; owned by
+// main() so they are gone before the QApplication is
+struct Fixture
+{
+    QString audioPath;
+    QString recordingDir;
+    QVector<qint16> voice;      // RecordingSeconds of 48 kHz stereo
+    QImage viewfinderFrame;     // 640x480, one QR code and one barcode
+    SearchIndex search;         // SearchDocuments of searchCorpus
+    QStringList searchCorpus;
+    int searchNext = 0;
+    QString stateDir;
+    KeyValueStore state;        // open in stateDir once a state benchmark runs
+    qint64 stateNext = 0;
+    Camera camera;
+    MusicPlayer player;
+    Smartphone phone;
+    std::unique_ptr<MainWindow> window;
+    PhoneViewModel::Snapshot windowState;   // read on the window's phone thread
+};
+
+void addPhoneBenchmarks(BenchmarkSuite &suite, Fixture &f)
+{
+    auto unlock = [&f]() { f.phone.unlockPhone("1234"); };
+
+    suite.add("camera.takePhoto", Kind::Micro, [&f]() { f.camera.takePhoto(); });
+    suite.add("music.loadMusic", Kind::Micro, [&f]() { f.player.loadMusic(f.audioPath); });
+    suite.add("phone.unlockPhone", Kind::Micro, unlock);
+    suite.add("phone.unlockPhone.wrong", Kind::Micro, [&f]() { f.phone.unlockPhone("0000"); });
+    suite.add("phone.getStorageInfo", Kind::Micro, [&f]() { f.phone.getStorageInfo(); }, unlock);
+    suite.add("scratch.format", Kind::Micro, []() {
+        ScratchScope scratch;
+        ScratchString text;
+        text << u"photo_" << 2024 << QChar(u'-') << u"unlocked after " << qint64(1234567) << u" ms";
+    });
+
+    suite.add("phone.construct", Kind::Macro, []() { Smartphone fresh; });
+    suite.add("music.loadMusic.cold", Kind::Macro, [&f]() {
+        MusicPlayer fresh;
+        fresh.loadMusic(f.audioPath);
+    });
+}
+
+// One viewfinder frame through every analysis stage; at 30 fps the budget
+// is 33 ms per frame
+void addFrameBenchmarks(BenchmarkSuite &suite, Fixture &f)
+{
+    for (int threads : {2, 1}) {
+        auto prepare = [&f, threads]() {
+            if (f.viewfinderFrame.isNull()) {
+                f.viewfinderFrame = SimulatedViewfinder().nextFrame();
+            }
+            f.camera.setFrameAnalysisThreads(threads);
+        };
+        QString name = threads == 2 ? QString("camera.analyzeFrame") : QString("camera.analyzeFrame.1thread");
+        suite.add(name, Kind::Macro, [&f]() { f.camera.analyzeFrame(f.viewfinderFrame); }, prepare);
+    }
+}
+
+// Log-like messages from a small vocabulary, plus a number each, so
+// words repeat the way they do in a real activity log
+QStringList makeSearchCorpus(int count)
+{
+    static const char *const words[] = {
+        "phone", "unlocked", "locked", "photo", "saved", "music", "playing", "stopped", "storage",
+        "battery", "alarm", "memo", "recording", "viewfinder", "code", "detected", "failed", "loaded",
+        "track", "session", "restored", "sunset", "beach", "holiday", "concert", "birthday"
+    };
+    const int vocabulary = int(sizeof(words) / sizeof(words[0]));
+    QStringList corpus;
+    quint32 seed = 7;
+    for (int i = 0; i < count; ++i) {
+        QString message;
+        for (int w = 0; w < 5; ++w) {
+            seed = seed * 1664525u + 1013904223u;
+            message += QLatin1String(words[(seed >> 16) % vocabulary]) + ' ';
+        }
+        corpus.append(message + QString::number(i));
+    }
+    return corpus;
+}
+
+void fillSearchIndex(SearchIndex &index, const QStringList &corpus)
+{
+    for (int i = 0; i < corpus.size(); ++i) {
+        // One item in ten is a photo and one a track, as on a phone in use
+        SearchIndex::Kind kind = i % 10 == 0 ? SearchIndex::Kind::Photo
+                                 : i % 10 == 1 ? SearchIndex::Kind::Track : SearchIndex::Kind::Activity;
+        index.add(kind, i, corpus[i], QStringLiteral("bench"));
+    }
+}
+
+// Building the index for SearchDocuments items, queries against it, and
+// adding one more item: its bytes per operation approximate the memory per
+// indexed item
+void addSearchBenchmarks(BenchmarkSuite &suite, Fixture &f)
+{
+    auto ensureIndex = [&f]() {
+        if (f.searchCorpus.isEmpty()) {
+            f.searchCorpus = makeSearchCorpus(SearchDocuments);
+            fillSearchIndex(f.search, f.searchCorpus);
+        }
+    };
+
+    suite.add("search.build", Kind::Macro, [&f]() {
+        SearchIndex fresh;
+        fillSearchIndex(fresh, f.searchCorpus);
+    }, ensureIndex);
+    suite.add("search.query", Kind::Micro, [&f]() { f.search.search(QStringLiteral("sunset beach")); }, ensureIndex);
+    suite.add("search.query.prefix", Kind::Micro, [&f]() { f.search.search(QStringLiteral("pho")); }, ensureIndex);
+    suite.add("search.add", Kind::Micro, [&f]() {
+        const QString &message = f.searchCorpus[f.searchNext++ % SearchDocuments];
+        f.search.add(SearchIndex::Kind::Activity, f.searchNext, message, QStringLiteral("bench"));
+    }, ensureIndex);
+}
+
+// One change to the state store: the in-memory update and the queued log
+// record, which is what a Smartphone state change pays; sync waits for its
+// fsync as well. Recovery reopens a store whose log holds
+// StateRecoveryRecords changes.
+void addStateBenchmarks(BenchmarkSuite &suite, Fixture &f)
+{
+    auto ensureStore = [&f]() {
+        if (!f.state.isOpen()) {
+            f.state.open(f.stateDir + "/live");
+        }
+    };
+    auto ensureLog = [&f]() {
+        QString directory = f.stateDir + "/recover";
+        if (!QFile::exists(directory + "/state.wal")) {
+            KeyValueStore store;
+            store.open(directory);
+            for (int i = 0; i < StateRecoveryRecords; ++i) {
+                store.putInt(QString("key/%1").arg(i), i);
+            }
+        }
+    };
+
+    suite.add("state.put", Kind::Micro, [&f]() {
+        f.state.putInt(QStringLiteral("storage/usedMB"), f.stateNext++);
+    }, ensureStore);
+    suite.add("state.sync", Kind::Macro, [&f]() {
+        f.state.putInt(QStringLiteral("security/unlocked"), f.stateNext++ & 1);
+        f.state.sync();
+    }, ensureStore);
+    suite.add("state.recover", Kind::Macro, [&f]() {
+        KeyValueStore store;
+        store.open(f.stateDir + "/recover");
+    }, ensureLog);
+}
+
+// Simulated transfers: host time to move a whole package through the
+// network model, for one phone and for a fleet sharing one server, and
+// to back up a handful of photos
+void addNetworkBenchmarks(BenchmarkSuite &suite)
+{
+    suite.add("network.install", Kind::Macro, []() {
+        SimulationClock clock;
+        clock.setMode(SimulationClock::Mode::AsFastAsPossible);
+        ContentServer server;
+        NetworkStack stack(&clock, &server);
+        stack.setProfile(NetworkProfile::lte());
+        qint64 received = 0;
+        stack.download(QStringLiteral("notes"), [&received](QByteArrayView chunk) { received += chunk.size(); });
+        while (stack.activeTransfers() > 0) {
+            clock.advanceBy(1000);
+        }
+    });
+    suite.add("network.fleetInstall", Kind::Macro, []() {
+        NetworkFleet fleet(100, NetworkProfile::lte());
+        fleet.installAll(QStringLiteral("notes"));
+        fleet.run();
+    });
+    const QByteArray photo(int(Camera::PhotoSizeKB * 1024), char(0x5A));
+    suite.add("network.photoBackup", Kind::Macro, [photo]() {
+        SimulationClock clock;
+        clock.setMode(SimulationClock::Mode::AsFastAsPossible);
+        ContentServer server;
+        NetworkStack stack(&clock, &server);
+        PhotoBackup backup(&clock, &stack, &server);
+        for (int i = 0; i < BackupPhotos; ++i) {
+            backup.enqueue(QString("photo_%1.jpg").arg(i), photo);
+        }
+        while (backup.queueDepth() > 0) {
+            clock.advanceBy(1000);
+        }
+    });
+}
+
+// Capture-to-file for a fixed clip: ring, encoder thread and file writes.
+// Real-time factor is RecordingSeconds divided by the time per operation.
+void addRecorderBenchmarks(BenchmarkSuite &suite, Fixture &f)
+{
+    auto generate = [&f]() {
+        if (f.voice.isEmpty()) {
+            SimulatedMicrophone microphone(48000, 2);
+            f.voice.resize(48000 * 2 * RecordingSeconds);
+            microphone.read(f.voice.data(), 48000 * RecordingSeconds);
+        }
+    };
+    for (AudioEncoder::Format format : {AudioEncoder::Format::Wav, AudioEncoder::Format::Flac}) {
+        QString name = AudioEncoder::formatName(format);
+        suite.add("recorder." + name, Kind::Macro, [&f, format, name]() {
+            VoiceRecorder recorder;
+            recorder.start(f.recordingDir + "/bench." + name, format, 48000, 2);
+            recorder.write(f.voice.constData(), 48000 * RecordingSeconds, true);
+            recorder.stop();
+        }, generate);
+    }
+}
+
+// The caller's side of PHONE_LOG_*. A sample is one burst that fits in the
+// thread's ring without waking the writer, so every write is kept rather
+// than dropped; the ring is emptied before each sample.
+void addLogBenchmarks(BenchmarkSuite &suite)
+{
+    const int burst = PhoneLog::ThreadBufferCapacity / 4;
+    suite.add("log.write", Kind::Macro, [burst]() {
+        static const QString name = QStringLiteral("photo_0001.jpg");
+        for (int i = 0; i < burst; ++i) {
+            PHONE_LOG_INFO("bench", "📷 Saved %1 (%2 KB)", name, i);
+        }
+    }, []() {
+        PhoneLog::setLevel(LogEntry::Debug);
+        PhoneLog::flush();
+    }, burst);
+    // Leaves the level at Info, so it is registered last
+    suite.add("log.write.filtered", Kind::Micro, []() {
+        PHONE_LOG_DEBUG("bench", "📷 Saved %1 (%2 KB)", 1, 3072);
+    }, []() { PhoneLog::setLevel(LogEntry::Info); });
+}
+
+void addWindowBenchmarks(BenchmarkSuite &suite, Fixture &f)
+{
+    auto ensureWindow = [&f]() {
+        if (!f.window) {
+            f.window.reset(new MainWindow);
+            f.window->show();
+        }
+        // Let queued phone events and deferred setup settle outside the timed region
+        QCoreApplication::processEvents();
+    };
+
+    // The phone lives on its own thread, so its state is read there once and
+    // only the view update is timed. updateUI is a private slot; the
+    // meta-object still reaches it.
+    auto captureWindowState = [&f, ensureWindow]() {
+        ensureWindow();
+        f.windowState = f.window->asyncPhone()->run([](Smartphone &p) {
+            return PhoneViewModel::capture(p);
+        }).result();
+    };
+    suite.add("mainwindow.updateUI", Kind::Macro, [&f]() {
+        QMetaObject::invokeMethod(f.window.get(), "updateUI", Qt::DirectConnection,
+                                  Q_ARG(PhoneViewModel::Snapshot, f.windowState));
+    }, captureWindowState);
+    suite.add("mainwindow.startup", Kind::Macro, []() {
+        MainWindow fresh;
+        fresh.show();
+        QCoreApplication::processEvents();
+    });
+    // A second phone beside a running one: its bytes column is the cost of
+    // each phone added to the process once the shared resources exist
+    suite.add("mainwindow.addPhone", Kind::Macro, []() {
+        MainWindow added(2);
+        added.show();
+        QCoreApplication::processEvents();
+    }, ensureWindow);
+}
+
+} // namespace
+
+// Micro- and macrobenchmarks for the phone and its window. Without a
+// display the window renders through the offscreen platform plugin.
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+    // Keep the session snapshot and pictures path away from the user's own
+    QStandardPaths::setTestModeEnabled(true);
+    PhoneLog::setConsoleOutput(false);
+    AllocationTracker::setEnabled(true);
+
+    BenchmarkSuite::Options options;
+    RegressionGate::Thresholds thresholds;
+    QString baselinePath = QStringLiteral(PHONEBENCH_BASELINES);
+    const char *jsonPath = nullptr;
+    bool listOnly = false;
+    bool check = false;
+    bool updateBaseline = false;
+    bool allocationReport = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            options.warmup = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc) {
+            options.repetitions = qMax(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--min-sample-us") == 0 && i + 1 < argc) {
+            options.minSampleNs = std::atoll(argv[++i]) * 1000;
+        } else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            options.filter.setPattern(QString::fromLocal8Bit(argv[++i]));
+        } else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--list") == 0) {
+            listOnly = true;
+        } else if (std::strcmp(argv[i], "--alloc-report") == 0) {
+            allocationReport = true;
+        } else if (std::strcmp(argv[i], "--check") == 0) {
+            check = true;
+        } else if (std::strcmp(argv[i], "--update-baseline") == 0) {
+            updateBaseline = true;
+        } else if (std::strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baselinePath = QString::fromLocal8Bit(argv[++i]);
+        } else if (std::strcmp(argv[i], "--alpha") == 0 && i + 1 < argc) {
+            thresholds.alpha = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+            thresholds.medianTolerance = std::atof(argv[++i]) / 100.0;
+        }
+    }
+
+    QTemporaryDir scratch;
+    Fixture fixture;
+    fixture.audioPath = scratch.filePath("silence.wav");
+    fixture.recordingDir = scratch.path();
+    fixture.stateDir = scratch.filePath("state");
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+    if (!scratch.isValid() || !writeSilentWav(fixture.audioPath)) {
+        err << "cannot create a scratch audio file\n";
+        return 2;
+    }
+
+    BenchmarkSuite suite;
+    addPhoneBenchmarks(suite, fixture);
+    addFrameBenchmarks(suite, fixture);
+    addSearchBenchmarks(suite, fixture);
+    addStateBenchmarks(suite, fixture);
+    addNetworkBenchmarks(suite);
+    addRecorderBenchmarks(suite, fixture);
+    addWindowBenchmarks(suite, fixture);
+    addLogBenchmarks(suite);
+    if (listOnly) {
+        out << suite.names().join('\n') << "\n";
+        return 0;
+    }
+
+    RegressionGate gate;
+    if ((check || updateBaseline) && !gate.load(baselinePath)) {
+        err << "cannot read baselines from " << baselinePath << "\n";
+        return 2;
+    }
+
+    QVector<BenchmarkSuite::Result> results = suite.run(options, err);
+    bool regressed = false;
+    if (check) {
+        QVector<RegressionGate::Comparison> comparisons = gate.compare(results, thresholds);
+        out << RegressionGate::table(comparisons);
+        regressed = RegressionGate::hasRegression(comparisons);
+        out << (regressed ? "\nRegressions found against " : "\nNo regressions against ") << baselinePath << "\n";
+        int untimed = int(std::count_if(comparisons.begin(), comparisons.end(), [](const RegressionGate::Comparison &c) {
+            return c.verdict == RegressionGate::Verdict::New;
+        }));
+        if (untimed > 0) {
+            out << untimed << " of " << comparisons.size()
+                << " benchmarks have no stored timings, so only their budgets were checked;"
+                   " run --update-baseline on the reference machine\n";
+        }
+    } else {
+        out << BenchmarkSuite::table(results);
+    }
+    if (allocationReport) {
+        out << "\n" << AllocationTracker::report() << "\n";
+    }
+    if (updateBaseline) {
+        if (!gate.save(baselinePath, results)) {
+            err << "cannot write baselines to " << baselinePath << "\n";
+            return 2;
+        }
+        out << "Baselines updated: " << baselinePath << "\n";
+    }
+
+    if (jsonPath) {
+        QByteArray json = QJsonDocument(BenchmarkSuite::toJson(results, options)).toJson();
+        if (std::strcmp(jsonPath, "-") == 0) {
+            out << json;
+        } else {
+            QFile file(QString::fromLocal8Bit(jsonPath));
+            if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size()) {
+                err << "cannot write " << jsonPath << "\n";
+                return 2;
+            }
+        }
+    }
+    PhoneLog::shutdown();
+    return regressed ? 1 : 0;
+}
\ No newline at end of file
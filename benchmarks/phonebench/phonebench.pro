@@ -0,0 +1,22 @@
+# Counts allocations per operation and per subsystem
+CONFIG += alloc_tracking
+
+include(../../phonecore.pri)
+
+CONFIG += console
+CONFIG -= app_bundle
+
+TARGET = phonebench
+TEMPLATE = app
+
+# Baselines for --check and --update-baseline live next to the sources
+DEFINES += PHONEBENCH_BASELINES=\\\"$$PWD/baselines.json\\\"
+
+SOURCES += \
+    main.cpp \
+    benchharness.cpp \
+    regressiongate.cpp
+
+HEADERS += \
+    benchharness.h \
+    regressiongate.h
\ No newline at end of file
@@ -0,0 +1,295 @@
+#include "regressiongate.h"
+#include <QDateTime>
+#include <QFile>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QSysInfo>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Continued fraction for the regularized incomplete beta function
+// (modified Lentz), valid for x < (a + 1) / (a + b + 2)
+double betaFraction(double a, double b, double x)
+{
+    const double tiny = 1e-300;
+    double c = 1.0;
+    double d = 1.0 - (a + b) * x / (a + 1.0);
+    d = 1.0 / (std::fabs(d) < tiny ? tiny : d);
+    double h = d;
+    for (int m = 1; m <= 300; ++m) {
+        double m2 = 2.0 * m;
+        double numerator = m * (b - m) * x / ((a + m2 - 1.0) * (a + m2));
+        d = 1.0 + numerator * d;
+        d = 1.0 / (std::fabs(d) < tiny ? tiny : d);
+        c = 1.0 + numerator / c;
+        c = std::fabs(c) < tiny ? tiny : c;
+        h *= d * c;
+
+        numerator = -(a + m) * (a + b + m) * x / ((a + m2) * (a + m2 + 1.0));
+        d = 1.0 + numerator * d;
+        d = 1.0 / (std::fabs(d) < tiny ? tiny : d);
+        c = 1.0 + numerator / c;
+        c = std::fabs(c) < tiny ? tiny : c;
+        double delta = d * c;
+        h *= delta;
+        if (std::fabs(delta - 1.0) < 1e-12) {
+            break;
+        }
+    }
+    return h;
+}
+
+double incompleteBeta(double a, double b, double x)
+{
+    if (x <= 0.0) {
+        return 0.0;
+    } else if (x >= 1.0) {
+        return 1.0;
+    }
+    double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b)
+                            + a * std::log(x) + b * std::log(1.0 - x));
+    if (x < (a + 1.0) / (a + b + 2.0)) {
+        return front * betaFraction(a, b, x) / a;
+    }
+    return 1.0 - front * betaFraction(b, a, 1.0 - x) / b;
+}
+
+// P(T > t) for Student's t with df degrees of freedom
+double studentUpperTail(double t, double df)
+{
+    double tail = 0.5 * incompleteBeta(df / 2.0, 0.5, df / (df + t * t));
+    return t > 0 ? tail : 1.0 - tail;
+}
+
+QString change(double before, double after)
+{
+    if (before <= 0.0) {
+        return "";
+    }
+    return QString("%1%2%").arg(after >= before ? "+" : "").arg(100.0 * (after - before) / before, 0, 'f', 1);
+}
+
+QString verdictName(RegressionGate::Verdict verdict)
+{
+    switch (verdict) {
+    case RegressionGate::Verdict::New:
+        return "new";
+    case RegressionGate::Verdict::Unchanged:
+        return "ok";
+    case RegressionGate::Verdict::Faster:
+        return "faster";
+    case RegressionGate::Verdict::Slower:
+        return "SLOWER";
+    }
+    return QString();
+}
+
+} // namespace
+
+RegressionGate::Baseline RegressionGate::Baseline::of(const BenchmarkSuite::Result &result)
+{
+    Baseline baseline;
+    baseline.median = result.stats.median;
+    baseline.p99 = result.stats.p99;
+    baseline.mean = result.stats.mean;
+    baseline.stddev = result.stats.stddev;
+    baseline.samples = result.stats.count;
+    baseline.allocations = result.allocations;
+    return baseline;
+}
+
+RegressionGate::Baseline RegressionGate::Baseline::fromJson(const QJsonObject &json)
+{
+    Baseline baseline;
+    baseline.median = json["median"].toDouble();
+    baseline.p99 = json["p99"].toDouble();
+    baseline.mean = json["mean"].toDouble();
+    baseline.stddev = json["stddev"].toDouble();
+    baseline.samples = json["samples"].toInt();
+    baseline.allocations = json["allocations"].toDouble();
+    baseline.budget = json["budget"].toDouble(-1.0);
+    return baseline;
+}
+
+QJsonObject RegressionGate::Baseline::toJson() const
+{
+    QJsonObject json;
+    json["median"] = median;
+    json["p99"] = p99;
+    json["mean"] = mean;
+    json["stddev"] = stddev;
+    json["samples"] = samples;
+    json["allocations"] = allocations;
+    if (budget >= 0) {
+        json["budget"] = budget;
+    }
+    return json;
+}
+
+bool RegressionGate::load(const QString &path)
+{
+    baselines.clear();
+    QFile file(path);
+    if (!file.exists()) {
+        return true;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    QJsonParseError error;
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError || !document.isObject()) {
+        return false;
+    }
+    QJsonObject stored = document.object()["benchmarks"].toObject();
+    for (auto it = stored.constBegin(); it != stored.constEnd(); ++it) {
+        baselines.insert(it.key(), Baseline::fromJson(it.value().toObject()));
+    }
+    return true;
+}
+
+bool RegressionGate::save(const QString &path, const QVector<BenchmarkSuite::Result> &results)
+{
+    for (const BenchmarkSuite::Result &result : results) {
+        Baseline updated = Baseline::of(result);
+        updated.budget = baselines.value(result.name).budget;
+        baselines.insert(result.name, updated);
+    }
+
+    // QJsonObject keeps keys sorted, so the file diffs cleanly
+    QJsonObject stored;
+    for (auto it = baselines.constBegin(); it != baselines.constEnd(); ++it) {
+        stored[it.key()] = it.value().toJson();
+    }
+    QJsonObject json;
+    json["updated"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    json["machine"] = QString("%1 %2").arg(QSysInfo::prettyProductName(), QSysInfo::currentCpuArchitecture());
+    json["benchmarks"] = stored;
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(QJsonDocument(json).toJson());
+    return file.commit();
+}
+
+QVector<RegressionGate::Comparison> RegressionGate::compare(const QVector<BenchmarkSuite::Result> &results,
+                                                            const Thresholds &thresholds) const
+{
+    QVector<Comparison> comparisons;
+    for (const BenchmarkSuite::Result &result : results) {
+        Comparison comparison;
+        comparison.name = result.name;
+        comparison.current = Baseline::of(result);
+        comparison.pValue = 1.0;
+        auto stored = baselines.constFind(result.name);
+        const Baseline &now = comparison.current;
+        // An entry with a budget but no samples yet caps allocations before the first --update-baseline
+        if (stored == baselines.constEnd() || stored->samples == 0) {
+            comparison.verdict = Verdict::New;
+            if (stored != baselines.constEnd() && stored->budget >= 0 && now.allocations > stored->budget) {
+                comparison.reasons << QString("over budget of %1 allocations").arg(stored->budget);
+            }
+            comparisons.append(comparison);
+            continue;
+        }
+        const Baseline &before = *stored;
+        comparison.baseline = before;
+        comparison.verdict = Verdict::Unchanged;
+
+        double slowerP = welchPValue(before.mean, before.stddev, before.samples,
+                                     now.mean, now.stddev, now.samples);
+        double fasterP = welchPValue(now.mean, now.stddev, now.samples,
+                                     before.mean, before.stddev, before.samples);
+        if (now.median > before.median * (1.0 + thresholds.medianTolerance) && slowerP < thresholds.alpha) {
+            comparison.verdict = Verdict::Slower;
+            comparison.pValue = slowerP;
+            comparison.reasons << QString("median %1").arg(change(before.median, now.median));
+        } else if (now.median < before.median * (1.0 - thresholds.medianTolerance)
+                   && fasterP < thresholds.alpha) {
+            comparison.verdict = Verdict::Faster;
+            comparison.pValue = fasterP;
+        } else {
+            comparison.pValue = std::min(slowerP, fasterP);
+        }
+
+        if (now.p99 > before.p99 * (1.0 + thresholds.p99Tolerance) && slowerP < thresholds.alpha) {
+            comparison.verdict = Verdict::Slower;
+            comparison.reasons << QString("p99 %1").arg(change(before.p99, now.p99));
+        }
+        if (before.budget >= 0 && now.allocations > before.budget) {
+            comparison.verdict = Verdict::Slower;
+            comparison.reasons << QString("over budget of %1 allocations").arg(before.budget);
+        } else if (now.allocations > before.allocations + thresholds.allocationSlack) {
+            comparison.verdict = Verdict::Slower;
+            comparison.reasons << QString("allocations %1 -> %2")
+                                      .arg(before.allocations, 0, 'f', 1).arg(now.allocations, 0, 'f', 1);
+        }
+        comparisons.append(comparison);
+    }
+    return comparisons;
+}
+
+bool RegressionGate::hasRegression(const QVector<Comparison> &comparisons)
+{
+    return std::any_of(comparisons.begin(), comparisons.end(),
+                       [](const Comparison &comparison) { return !comparison.reasons.isEmpty(); });
+}
+
+QString RegressionGate::table(const QVector<Comparison> &comparisons)
+{
+    int width = 9;
+    for (const Comparison &comparison : comparisons) {
+        width = qMax(width, int(comparison.name.size()));
+    }
+
+    QString text = QString("%1  %2 %3 %4  %5 %6 %7  %8 %9  %10\n")
+                       .arg("benchmark", -width)
+                       .arg("median", 11).arg("baseline", 11).arg("change", 8)
+                       .arg("p99", 11).arg("baseline", 11).arg("change", 8)
+                       .arg("allocs", 13).arg("p", 7).arg("verdict");
+    for (const Comparison &c : comparisons) {
+        bool known = c.verdict != Verdict::New;
+        QString allocations = known ? QString("%1 -> %2").arg(c.baseline.allocations, 0, 'f', 1)
+                                                           .arg(c.current.allocations, 0, 'f', 1)
+                                    : QString::number(c.current.allocations, 'f', 1);
+        QString verdict = verdictName(c.verdict);
+        if (!c.reasons.isEmpty()) {
+            verdict = "REGRESSION (" + c.reasons.join(", ") + ")";
+        }
+        text += QString("%1  %2 %3 %4  %5 %6 %7  %8 %9  %10\n")
+                    .arg(c.name, -width)
+                    .arg(BenchmarkSuite::formatNs(c.current.median), 11)
+                    .arg(known ? BenchmarkSuite::formatNs(c.baseline.median) : "-", 11)
+                    .arg(known ? change(c.baseline.median, c.current.median) : "", 8)
+                    .arg(BenchmarkSuite::formatNs(c.current.p99), 11)
+                    .arg(known ? BenchmarkSuite::formatNs(c.baseline.p99) : "-", 11)
+                    .arg(known ? change(c.baseline.p99, c.current.p99) : "", 8)
+                    .arg(allocations, 13)
+                    .arg(known ? QString::number(c.pValue, 'g', 2) : "", 7)
+                    .arg(verdict);
+    }
+    return text;
+}
+
+double RegressionGate::welchPValue(double meanA, double stddevA, int countA,
+                                   double meanB, double stddevB, int countB)
+{
+    if (countA < 2 || countB < 2) {
+        return 1.0;
+    }
+    double varianceA = stddevA * stddevA / countA;
+    double varianceB = stddevB * stddevB / countB;
+    double standardError = std::sqrt(varianceA + varianceB);
+    if (standardError == 0.0) {
+        return meanB > meanA ? 0.0 : 1.0;
+    }
+    double t = (meanB - meanA) / standardError;
+    double df = (varianceA + varianceB) * (varianceA + varianceB)
+                / (varianceA * varianceA / (countA - 1) + varianceB * varianceB / (countB - 1));
+    return studentUpperTail(t, df);
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#ifndef REGRESSIONGATE_H
+#define REGRESSIONGATE_H
+
+#include "benchharness.h"
+#include <QHash>
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+
+// Compares a run against stored per-benchmark baselines. A benchmark is
+// slower (or faster) only if its median moved by more than the tolerance
+// AND Welch's t-test says the shift in means is significant, so ordinary
+// run-to-run noise never fails the gate. Allocations are deterministic
+// enough to compare directly, and a hand-set "budget" in the baselines
+// file caps them outright for hot paths.
+class RegressionGate
+{
+public:
+    struct Baseline
+    {
+        double median = 0.0;
+        double p99 = 0.0;
+        double mean = 0.0;
+        double stddev = 0.0;
+        int samples = 0;
+        double allocations = 0.0;
+        double budget = -1.0;           // allocations per operation allowed; -1: none
+
+        static Baseline of(const BenchmarkSuite::Result &result);
+        static Baseline fromJson(const QJsonObject &json);
+        QJsonObject toJson() const;
+    };
+
+    struct Thresholds
+    {
+        double alpha = 0.01;                // significance level, one-sided
+        double medianTolerance = 0.05;      // relative
+        double p99Tolerance = 0.50;         // relative; the tail is noisy
+        double allocationSlack = 0.5;       // absolute, per operation
+    };
+
+    enum class Verdict { New, Unchanged, Faster, Slower };
+
+    struct Comparison
+    {
+        QString name;
+        Verdict verdict;
+        Baseline baseline;
+        Baseline current;
+        double pValue;          // chance of a shift this large with no real change
+        QStringList reasons;    // why it counts as a regression; empty otherwise
+    };
+
+    // A missing file is an empty baseline set, not an error
+    bool load(const QString &path);
+    // Merges the results into the loaded baselines (keeping their budgets) and writes all of them
+    bool save(const QString &path, const QVector<BenchmarkSuite::Result> &results);
+
+    QVector<Comparison> compare(const QVector<BenchmarkSuite::Result> &results,
+                                const Thresholds &thresholds) const;
+
+    static bool hasRegression(const QVector<Comparison> &comparisons);
+    static QString table(const QVector<Comparison> &comparisons);
+
+    // One-sided p-value that the second sample's mean is not really greater
+    static double welchPValue(double meanA, double stddevA, int countA,
+                              double meanB, double stddevB, int countB);
+
+private:
+    QHash<QString, Baseline> baselines;
+};
+
+#endif // REGRESSIONGATE_H
\ No newline at end of file
@@ -1,21 +1,23 @@
 #include "camera.h"
-#include <QDebug>
-#include <QDate>
-#include <QTime>
+#include "phonelog.h"
+#include "tracing.h"
+#include "allocationtracker.h"
+#include "scratcharena.h"
 #include <QDir>
 #include <QStandardPaths>
 
-Camera::Camera() : photoCount(0), cameraAvailable(true)
+Camera::Camera() : photoCount(0), cameraAvailable(true), frameAnalyzer(nullptr), frameAnalysisThreads(2)
 {
     // Check if camera hardware is available (simplified check)
     // In a real app, you'd use platform-specific APIs
     cameraAvailable = true; // Assume camera is available
-    qDebug() << "Camera initialized - Available: " << cameraAvailable;
+    PHONE_LOG_DEBUG("camera", "Camera initialized - Available: %1", cameraAvailable);
 }
 
 Camera::~Camera()
 {
-    qDebug() << "Camera destroyed";
+    delete frameAnalyzer;
+    PHONE_LOG_DEBUG("camera", "Camera destroyed");
 }
 
 bool Camera::isCameraAvailable() const
@@ -25,25 +27,28 @@ bool Camera::isCameraAvailable() const
 
 bool Camera::takePhoto()
 {
+    TRACE_SPAN("Camera::takePhoto", "camera");
+    ALLOC_SCOPE("Camera::takePhoto", "Camera");
+    ScratchScope scratch;
     if (!cameraAvailable) {
-        qDebug() << "❌ Camera not available!";
+        PHONE_LOG_ERROR("camera", "❌ Camera not available!");
         return false;
     }
     
     photoCount++;
     
-    // Create a photo filename with timestamp
-    QString timestamp = QDate::currentDate().toString("yyyy-MM-dd") + "_" + 
-                       QTime::currentTime().toString("hh-mm-ss");
-    QString photoFilename = QString("photo_%1_%2.jpg").arg(timestamp).arg(photoCount);
+    PhotoRecord record;
+    record.capturedAt = currentDateTime().toMSecsSinceEpoch();
+    record.number = quint32(photoCount);
+    record.sizeKB = PhotoSizeKB;
+    photoIndex.append(record);
     
-    // Save photo to Pictures directory
-    QString picturesPath = QStandardPaths::writableLocation(QStandardPaths::PicturesLocation);
-    QString photoPath = picturesPath + "/" + photoFilename;
-    
-    lastPhotoPath = photoPath;
-    qDebug() << "📷 Photo taken! Total photos: " << photoCount;
-    qDebug() << "📸 Photo saved to: " << photoPath;
+    // Built in scratch memory. The path outlives the call (the event bus and
+    // the log share it), so it always gets a buffer of its own.
+    ScratchString photoPath(picturesPath.size() + 48);
+    writePhotoPath(photoPath, record);
+    lastPhotoPath = photoPath.toString();
+    PHONE_LOG_INFO("camera", "📷 Photo taken! Total photos: %1, saved to: %2", photoCount, lastPhotoPath);
     
     return true;
 }
@@ -51,4 +56,82 @@ bool Camera::takePhoto()
 QString Camera::getLastPhotoPath() const
 {
     return lastPhotoPath;
+}
+
+const QVector<PhotoRecord> &Camera::getPhotoIndex() const
+{
+    return photoIndex;
+}
+
+FrameAnalysis Camera::analyzeFrame(const QImage &frame)
+{
+    if (!cameraAvailable) {
+        return FrameAnalysis();
+    }
+    if (!frameAnalyzer) {
+        frameAnalyzer = new FrameAnalyzer(frameAnalysisThreads);
+        PHONE_LOG_DEBUG("camera", "Frame analysis on %1 thread(s), %2", frameAnalysisThreads,
+                        FrameAnalyzer::simdName());
+    }
+    return frameAnalyzer->analyze(frame);
+}
+
+FrameAnalysis::Timings Camera::frameAnalysisTimings() const
+{
+    return frameAnalyzer ? frameAnalyzer->averageTimings() : FrameAnalysis::Timings();
+}
+
+quint64 Camera::analyzedFrameCount() const
+{
+    return frameAnalyzer ? frameAnalyzer->frameCount() : 0;
+}
+
+void Camera::setFrameAnalysisThreads(int threads)
+{
+    threads = qBound(1, threads, 8);
+    if (threads == frameAnalysisThreads && frameAnalyzer) {
+        return;
+    }
+    frameAnalysisThreads = threads;
+    delete frameAnalyzer;
+    frameAnalyzer = nullptr;
+}
+
+int Camera::frameAnalysisThreadCount() const
+{
+    return frameAnalysisThreads;
+}
+
+QString Camera::photoPathFor(const PhotoRecord &record)
+{
+    ScratchScope scratch;
+    ScratchString path;
+    writePhotoPath(path, record);
+    return path.toString();
+}
+
+// <Pictures>/photo_yyyy-MM-dd_hh-mm-ss_<number>.jpg, without QString temporaries
+void Camera::writePhotoPath(ScratchString &out, const PhotoRecord &record)
+{
+    // Save photo to Pictures directory (looked up once, on first use)
+    if (picturesPath.isEmpty()) {
+        picturesPath = QStandardPaths::writableLocation(QStandardPaths::PicturesLocation);
+    }
+    
+    QDateTime captured = QDateTime::fromMSecsSinceEpoch(record.capturedAt);
+    QDate date = captured.date();
+    QTime time = captured.time();
+    out << picturesPath << u"/photo_";
+    out.appendNumber(date.year(), 4) << QChar(u'-');
+    out.appendNumber(date.month(), 2) << QChar(u'-');
+    out.appendNumber(date.day(), 2) << QChar(u'_');
+    out.appendNumber(time.hour(), 2) << QChar(u'-');
+    out.appendNumber(time.minute(), 2) << QChar(u'-');
+    out.appendNumber(time.second(), 2) << QChar(u'_');
+    out << qint64(record.number) << u".jpg";
+}
+
+QDateTime Camera::currentDateTime() const
+{
+    return QDateTime::currentDateTime();
 }
\ No newline at end of file
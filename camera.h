@@ -1,22 +1,58 @@
 #ifndef CAMERA_H
 #define CAMERA_H
 
+#include "frameanalyzer.h"
 #include <QString>
+#include <QDateTime>
+#include <QVector>
+
+class ScratchString;
+
+// One entry of the photo index; fixed size so it can be stored verbatim
+struct PhotoRecord
+{
+    qint64 capturedAt;  // ms since epoch
+    quint32 number;
+    quint32 sizeKB;
+};
 
 class Camera
 {
 public:
+    static constexpr quint32 PhotoSizeKB = 3072;
+    
     Camera();
     virtual ~Camera();
     
     bool isCameraAvailable() const;
     bool takePhoto();
     QString getLastPhotoPath() const;
+    const QVector<PhotoRecord> &getPhotoIndex() const;
+    
+    // Looks for QR codes and barcodes in a viewfinder frame
+    FrameAnalysis analyzeFrame(const QImage &frame);
+    // Mean stage timings over every frame analysed so far
+    FrameAnalysis::Timings frameAnalysisTimings() const;
+    quint64 analyzedFrameCount() const;
+    // Threads for the analysis, the calling one included; resets the timings
+    void setFrameAnalysisThreads(int threads);
+    int frameAnalysisThreadCount() const;
 
 protected:
+    QString photoPathFor(const PhotoRecord &record);
+    void writePhotoPath(ScratchString &out, const PhotoRecord &record);
+    
+
+    // Capture timestamps come from here so a simulated clock can drive them
+    virtual QDateTime currentDateTime() const;
+
     int photoCount;
+    QVector<PhotoRecord> photoIndex;
     QString lastPhotoPath;
+    QString picturesPath;   // resolved on first capture
     bool cameraAvailable;
+    FrameAnalyzer *frameAnalyzer;   // created on first frame
+    int frameAnalysisThreads;
 };
 
 #endif // CAMERA_H
\ No newline at end of file
@@ -0,0 +1,186 @@
+#include "contentserver.h"
+#include "tracing.h"
+#include <QCryptographicHash>
+
+namespace {
+
+struct CatalogEntry
+{
+    const char *name;
+    qint64 bytes;
+};
+
+// App store packages
+const CatalogEntry DefaultCatalog[] = {
+    {"notes", 4 * 1024 * 1024},
+    {"podcasts", 12 * 1024 * 1024},
+    {"camera-plus", 24 * 1024 * 1024},
+    {"maps", 64 * 1024 * 1024},
+};
+
+constexpr qint64 SyncManifestBytes = 64 * 1024;
+
+// Pseudo-random bytes (xorshift32), generated once per process
+const QByteArray &syntheticBlock()
+{
+    static const QByteArray block = []() {
+        QByteArray bytes(ContentServer::BlockBytes, Qt::Uninitialized);
+        quint32 state = 0x2545F491u;
+        for (qsizetype i = 0; i < bytes.size(); ++i) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            bytes[i] = char(state >> 24);
+        }
+        return bytes;
+    }();
+    return block;
+}
+
+} // namespace
+
+const QString ContentServer::SyncManifest = QStringLiteral("sync/manifest");
+
+QString ContentServer::Stats::describe() const
+{
+    return QString("%1 objects, %2 reads (%3 MB served); %4 of %5 uploads complete (%6 MB received, "
+                   "%7 chunks rejected)")
+        .arg(objects)
+        .arg(reads)
+        .arg(bytesServed / (1024.0 * 1024.0), 0, 'f', 1)
+        .arg(completedUploads)
+        .arg(uploads)
+        .arg(bytesReceived / (1024.0 * 1024.0), 0, 'f', 1)
+        .arg(rejectedChunks);
+}
+
+ContentServer::ContentServer()
+{
+    for (const CatalogEntry &entry : DefaultCatalog) {
+        publish(QString::fromLatin1(entry.name), entry.bytes);
+    }
+    publish(SyncManifest, SyncManifestBytes);
+}
+
+void ContentServer::publish(const QString &name, qint64 bytes)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    // Objects start at different places in the block so they differ
+    objects.insert(name, Object{qMax<qint64>(0, bytes), qint64(qHash(name) % quint64(BlockBytes)), QByteArray()});
+    counters.objects = int(objects.size());
+}
+
+bool ContentServer::contains(const QString &name) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return objects.contains(name);
+}
+
+qint64 ContentServer::size(const QString &name) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = objects.constFind(name);
+    return it != objects.cend() ? it->size : -1;
+}
+
+QStringList ContentServer::catalog() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    QStringList names;
+    for (const CatalogEntry &entry : DefaultCatalog) {
+        if (objects.contains(QString::fromLatin1(entry.name))) {
+            names.append(QString::fromLatin1(entry.name));
+        }
+    }
+    return names;
+}
+
+QByteArrayView ContentServer::read(const QString &name, qint64 offset, qint64 maxBytes)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = objects.constFind(name);
+    if (it == objects.cend() || offset < 0 || offset >= it->size || maxBytes <= 0) {
+        return QByteArrayView();
+    }
+    const qint64 position = (it->start + offset) % BlockBytes;
+    const qint64 length = qMin(qMin(maxBytes, it->size - offset), BlockBytes - position);
+    counters.reads++;
+    counters.bytesServed += length;
+    return QByteArrayView(syntheticBlock().constData() + position, length);
+}
+
+QByteArray ContentServer::digest(const QString &name)
+{
+    qint64 bytes;
+    qint64 start;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = objects.constFind(name);
+        if (it == objects.cend()) {
+            return QByteArray();
+        }
+        if (!it->sha256.isEmpty()) {
+            return it->sha256;
+        }
+        bytes = it->size;
+        start = it->start;
+    }
+
+    // Hashed outside the lock: a large package takes a while
+    TRACE_SPAN("ContentServer::digest", "network");
+    const QByteArray &block = syntheticBlock();
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    for (qint64 offset = 0; offset < bytes;) {
+        const qint64 position = (start + offset) % BlockBytes;
+        const qint64 length = qMin(bytes - offset, BlockBytes - position);
+        hash.addData(QByteArrayView(block.constData() + position, length));
+        offset += length;
+    }
+    QByteArray result = hash.result();
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = objects.find(name);
+    if (it != objects.end() && it->size == bytes) {
+        it->sha256 = result;
+    }
+    return result;
+}
+
+qint64 ContentServer::receivedBytes(const QString &name) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return uploads.value(name).received;
+}
+
+bool ContentServer::receive(const QString &name, qint64 offset, QByteArrayView chunk, qint64 totalBytes)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = uploads.find(name);
+    if (it == uploads.end()) {
+        it = uploads.insert(name, Upload());
+        counters.uploads++;
+    }
+    if (it->complete || offset != it->received || offset + chunk.size() > totalBytes) {
+        counters.rejectedChunks++;
+        return false;
+    }
+    it->received += chunk.size();
+    counters.bytesReceived += chunk.size();
+    if (it->received == totalBytes) {
+        it->complete = true;
+        counters.completedUploads++;
+    }
+    return true;
+}
+
+bool ContentServer::isUploaded(const QString &name) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return uploads.value(name).complete;
+}
+
+ContentServer::Stats ContentServer::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
\ No newline at end of file
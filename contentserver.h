@@ -0,0 +1,84 @@
+#ifndef CONTENTSERVER_H
+#define CONTENTSERVER_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <mutex>
+
+// In-process stand-in for the app store and the photo backup service.
+// Published objects are synthetic: their bytes are views into one block of
+// pseudo-random data shared by every server in the process, so a catalogue
+// of large packages costs no memory and a read never copies. Uploads are
+// not kept, only how much of each has arrived, so a whole fleet can back
+// up to one server. An upload must arrive in order and may stop and later
+// resume where the server's copy ends. Thread-safe.
+class ContentServer
+{
+public:
+    struct Stats
+    {
+        int objects = 0;
+        quint64 reads = 0;
+        qint64 bytesServed = 0;
+        int uploads = 0;                // started
+        int completedUploads = 0;
+        qint64 bytesReceived = 0;
+        quint64 rejectedChunks = 0;     // not continuing the server's copy
+
+        QString describe() const;
+    };
+
+    // Size of the shared block; a read never crosses its end, so a view is at most this long
+    static constexpr qint64 BlockBytes = 1024 * 1024;
+    // Small object fetched by the phone's background sync
+    static const QString SyncManifest;
+
+    // Starts with the app catalogue (see catalog())
+    ContentServer();
+
+    ContentServer(const ContentServer &) = delete;
+    ContentServer &operator=(const ContentServer &) = delete;
+
+    void publish(const QString &name, qint64 bytes);
+    bool contains(const QString &name) const;
+    qint64 size(const QString &name) const;     // -1 when unknown
+    QStringList catalog() const;
+    // Up to maxBytes of the object from offset, empty past its end or when
+    // unknown. Views stay valid for the life of the process.
+    QByteArrayView read(const QString &name, qint64 offset, qint64 maxBytes);
+    // SHA-256 of the whole object, computed on first request
+    QByteArray digest(const QString &name);
+
+    // Bytes of an upload the server holds; a transfer resumes from here
+    qint64 receivedBytes(const QString &name) const;
+    // Accepts chunk only if it starts where the server's copy ends; the
+    // upload is complete once totalBytes have arrived
+    bool receive(const QString &name, qint64 offset, QByteArrayView chunk, qint64 totalBytes);
+    bool isUploaded(const QString &name) const;
+
+    Stats stats() const;
+
+private:
+    struct Object
+    {
+        qint64 size;
+        qint64 start;       // offset of byte 0 in the block
+        QByteArray sha256;  // empty until asked for
+    };
+
+    struct Upload
+    {
+        qint64 received = 0;
+        bool complete = false;
+    };
+
+    mutable std::mutex mutex;
+    QHash<QString, Object> objects;
+    QHash<QString, Upload> uploads;
+    Stats counters;
+};
+
+#endif // CONTENTSERVER_H
\ No newline at end of file
@@ -0,0 +1,174 @@
+#include "eventbus.h"
+#include <QDebug>
+#include <QMetaObject>
+#include <thread>
+
+QString PhoneEvent::typeName(Type type)
+{
+    switch (type) {
+    case PhoneLocked:     return "PhoneLocked";
+    case PhoneUnlocked:   return "PhoneUnlocked";
+    case UnlockFailed:    return "UnlockFailed";
+    case PhotoCaptured:   return "PhotoCaptured";
+    case TrackChanged:    return "TrackChanged";
+    case PlaybackChanged: return "PlaybackChanged";
+    case StorageChanged:  return "StorageChanged";
+    case BatteryChanged:  return "BatteryChanged";
+    case AlarmFired:      return "AlarmFired";
+    case CodeDetected:    return "CodeDetected";
+    case EventsDropped:   return "EventsDropped";
+    case TypeCount:       break;
+    }
+    return "Unknown";
+}
+
+EventBus::EventBus(int queueCapacity)
+    : capacity(qMax(2, queueCapacity)), published(0), dropped(0)
+{
+    for (std::atomic<Subscriber *> &slot : slots) {
+        slot.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+EventBus::~EventBus()
+{
+    // Deliveries still queued hold their subscriber and find it dead
+    for (const std::shared_ptr<Subscriber> &subscriber : owners) {
+        if (subscriber) {
+            subscriber->alive.store(false);
+        }
+    }
+}
+
+EventBus::SubscriberId EventBus::subscribe(EventMask mask, QObject *context, BatchHandler handler)
+{
+    auto subscriber = std::make_shared<Subscriber>(size_t(capacity));
+    subscriber->mask = mask;
+    subscriber->context = context;
+    subscriber->handler = std::move(handler);
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (int id = 0; id < MaxSubscribers; ++id) {
+        if (!owners[id]) {
+            owners[id] = subscriber;
+            slots[id].store(subscriber.get(), std::memory_order_release);
+            return id;
+        }
+    }
+
+    qDebug() << "❌ Event bus subscriber limit reached";
+    return -1;
+}
+
+void EventBus::unsubscribe(SubscriberId id)
+{
+    if (id < 0 || id >= MaxSubscribers) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(registryMutex);
+    std::shared_ptr<Subscriber> subscriber = std::move(owners[id]);
+    if (!subscriber) {
+        return;
+    }
+    slots[id].store(nullptr, std::memory_order_release);
+
+    // Pairs with publish(): a publisher that saw it alive is counted here
+    subscriber->alive.store(false);
+    while (subscriber->publishers.load() != 0) {
+        std::this_thread::yield();
+    }
+    // A publisher may have loaded the slot and not yet looked at the flag
+    retired.append(std::move(subscriber));
+}
+
+void EventBus::publish(const PhoneEvent &event)
+{
+    published.fetch_add(1, std::memory_order_relaxed);
+    const EventMask bit = eventBit(event.type);
+
+    for (std::atomic<Subscriber *> &slot : slots) {
+        Subscriber *subscriber = slot.load(std::memory_order_acquire);
+        if (!subscriber || !(subscriber->mask & bit)) {
+            continue;
+        }
+        subscriber->publishers.fetch_add(1);
+        if (subscriber->alive.load()) {
+            publishTo(*subscriber, event);
+        }
+        subscriber->publishers.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void EventBus::publishTo(Subscriber &subscriber, const PhoneEvent &event)
+{
+    if (!subscriber.queue.tryPush(event)) {
+        // Delivered as EventsDropped; the delivery below makes sure one happens
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        subscriber.lost.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Only the first event of a batch posts a delivery to the subscriber's thread
+    if (subscriber.context && !subscriber.deliveryPending.exchange(true, std::memory_order_acq_rel)) {
+        std::shared_ptr<Subscriber> target = subscriber.shared_from_this();
+        QMetaObject::invokeMethod(subscriber.context, [target]() {
+            if (target->alive.load(std::memory_order_acquire)) {
+                deliver(*target);
+            }
+        }, Qt::QueuedConnection);
+    }
+}
+
+void EventBus::publish(PhoneEvent::Type type, qint64 timestamp, qint64 value, const QString &text)
+{
+    PhoneEvent event;
+    event.type = type;
+    event.timestamp = timestamp;
+    event.value = value;
+    event.text = text;
+    publish(event);
+}
+
+int EventBus::drain(SubscriberId id)
+{
+    if (id < 0 || id >= MaxSubscribers) {
+        return 0;
+    }
+    Subscriber *subscriber = slots[id].load(std::memory_order_acquire);
+    return subscriber ? deliver(*subscriber) : 0;
+}
+
+quint64 EventBus::publishedCount() const
+{
+    return published.load(std::memory_order_relaxed);
+}
+
+quint64 EventBus::droppedCount() const
+{
+    return dropped.load(std::memory_order_relaxed);
+}
+
+int EventBus::deliver(Subscriber &subscriber)
+{
+    // Clear the flag first so events published while we drain schedule a new delivery
+    subscriber.deliveryPending.store(false, std::memory_order_release);
+
+    PhoneEvent event;
+    while (subscriber.queue.tryPop(event)) {
+        subscriber.batch.append(std::move(event));
+    }
+    const quint64 lost = subscriber.lost.exchange(0, std::memory_order_relaxed);
+    if (lost > 0) {
+        PhoneEvent gap;
+        gap.type = PhoneEvent::EventsDropped;
+        gap.timestamp = subscriber.batch.isEmpty() ? 0 : subscriber.batch.constLast().timestamp;
+        gap.value = qint64(lost);
+        subscriber.batch.append(gap);
+    }
+
+    int delivered = subscriber.batch.size();
+    if (delivered > 0 && subscriber.handler) {
+        subscriber.handler(subscriber.batch);
+    }
+    subscriber.batch.clear();
+    return delivered;
+}
\ No newline at end of file
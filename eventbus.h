@@ -0,0 +1,113 @@
+#ifndef EVENTBUS_H
+#define EVENTBUS_H
+
+#include "lockfreequeue.h"
+#include <QString>
+#include <QVector>
+#include <QObject>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+struct PhoneEvent
+{
+    enum Type : quint8 {
+        PhoneLocked,
+        PhoneUnlocked,
+        UnlockFailed,
+        PhotoCaptured,      // value: photo number, text: photo path
+        TrackChanged,       // text: song name
+        PlaybackChanged,    // value: 1 playing, 0 stopped
+        StorageChanged,     // value: MB used
+        BatteryChanged,     // value: whole percent
+        AlarmFired,         // text: alarm label
+        CodeDetected,       // value: codes in view, text: what they are
+        EventsDropped,      // value: events lost to a full queue; ends a batch, ignores masks
+        TypeCount
+    };
+
+    Type type = PhoneLocked;
+    qint64 timestamp = 0;   // simulation time, ms since epoch
+    qint64 value = 0;
+    QString text;
+
+    static QString typeName(Type type);
+};
+
+using EventMask = quint32;
+constexpr EventMask eventBit(PhoneEvent::Type type) { return EventMask(1) << type; }
+constexpr EventMask AllPhoneEvents = (EventMask(1) << PhoneEvent::TypeCount) - 1;
+
+// Typed publish/subscribe inside one phone. Every subscriber owns a bounded
+// lock-free queue, so producers on any thread publish without taking locks.
+// Subscribers with a context object get their events in batches on the
+// context's thread: one queued call per batch, not per event. A full queue
+// drops events, and the subscriber's next batch ends with EventsDropped so
+// it can resync the state it tracks. subscribe() and unsubscribe() may be
+// called from any thread; a context must outlive its subscription.
+class EventBus
+{
+public:
+    using SubscriberId = int;
+    using BatchHandler = std::function<void(const QVector<PhoneEvent> &batch)>;
+
+    static constexpr int MaxSubscribers = 32;
+
+    explicit EventBus(int queueCapacity = 4096);
+    ~EventBus();
+
+    EventBus(const EventBus &) = delete;
+    EventBus &operator=(const EventBus &) = delete;
+
+    // With a null context, events wait until drain() is called
+    SubscriberId subscribe(EventMask mask, QObject *context, BatchHandler handler);
+    // Returns once no publisher is using the subscription; batches already
+    // queued for the context are discarded
+    void unsubscribe(SubscriberId id);
+
+    void publish(const PhoneEvent &event);
+    void publish(PhoneEvent::Type type, qint64 timestamp, qint64 value = 0,
+                 const QString &text = QString());
+
+    // Deliver everything queued for one subscriber on the calling thread
+    int drain(SubscriberId id);
+
+    quint64 publishedCount() const;
+    quint64 droppedCount() const;
+
+private:
+    // Shared with queued deliveries, which may outlive the subscription
+    struct Subscriber : std::enable_shared_from_this<Subscriber>
+    {
+        explicit Subscriber(size_t capacity)
+            : queue(capacity), context(nullptr), alive(true), publishers(0), deliveryPending(false), lost(0)
+        {
+        }
+
+        EventMask mask;
+        BoundedMpmcQueue<PhoneEvent> queue;
+        QObject *context;           // resolved once in subscribe()
+        BatchHandler handler;
+        std::atomic<bool> alive;    // cleared by unsubscribe(); checked before every delivery
+        std::atomic<int> publishers;    // inside publish() with this subscriber
+        std::atomic<bool> deliveryPending;
+        std::atomic<quint64> lost;  // dropped since the last delivery
+        QVector<PhoneEvent> batch;  // consumer side only, reused between deliveries
+    };
+
+    static int deliver(Subscriber &subscriber);
+    void publishTo(Subscriber &subscriber, const PhoneEvent &event);
+
+    int capacity;
+    std::atomic<Subscriber *> slots[MaxSubscribers];
+    // Owners of the slots' subscribers, and unsubscribed ones a publisher
+    // may still hold, until the bus dies; guarded by registryMutex
+    std::shared_ptr<Subscriber> owners[MaxSubscribers];
+    QVector<std::shared_ptr<Subscriber>> retired;
+    std::mutex registryMutex;
+    std::atomic<quint64> published;
+    std::atomic<quint64> dropped;
+};
+
+#endif // EVENTBUS_H
\ No newline at end of file
@@ -0,0 +1,767 @@
+#include "frameanalyzer.h"
+#include "workstealingexecutor.h"
+#include "tracing.h"
+#include <QElapsedTimer>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+
+#if (defined(__SSE2__) || defined(_M_X64)) && !defined(PHONE_NO_SIMD)
+#include <emmintrin.h>
+#define FRAME_SIMD_SSE2
+#elif defined(__ARM_NEON) && Q_BYTE_ORDER == Q_LITTLE_ENDIAN && !defined(PHONE_NO_SIMD)
+#include <arm_neon.h>
+#define FRAME_SIMD_NEON
+#endif
+
+namespace {
+
+constexpr int ThresholdPercent = 15;    // dark: this far below the local mean
+constexpr int BarcodeCell = 16;         // pixels per barcode grid cell
+constexpr int MinBarGradient = 24;      // mean |d/dx| of a barcode window
+constexpr int BarDominance = 3;         // |d/dx| over |d/dy| in a barcode window
+
+// Keyed by worker count; one set of threads serves every phone in the process
+SharedCache<int, WorkStealingExecutor> &analysisPools()
+{
+    static SharedCache<int, WorkStealingExecutor> pools;
+    return pools;
+}
+
+// Y = 0.30 R + 0.59 G + 0.11 B in 8-bit fixed point
+void grayscaleRow(const quint32 *in, quint8 *out, int count)
+{
+    int x = 0;
+#if defined(FRAME_SIMD_SSE2)
+    // 16 pixels per step; every product and their sum fit the low 16 bits of a 32-bit lane
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    const __m128i weightR = _mm_set1_epi32(77);
+    const __m128i weightG = _mm_set1_epi32(150);
+    const __m128i weightB = _mm_set1_epi32(29);
+    for (; x + 16 <= count; x += 16) {
+        __m128i luma[4];
+        for (int i = 0; i < 4; ++i) {
+            __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + x + 4 * i));
+            __m128i b = _mm_and_si128(pixels, mask);
+            __m128i g = _mm_and_si128(_mm_srli_epi32(pixels, 8), mask);
+            __m128i r = _mm_and_si128(_mm_srli_epi32(pixels, 16), mask);
+            __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(r, weightR), _mm_mullo_epi16(g, weightG)),
+                                        _mm_mullo_epi16(b, weightB));
+            luma[i] = _mm_srli_epi32(sum, 8);
+        }
+        __m128i low = _mm_packs_epi32(luma[0], luma[1]);
+        __m128i high = _mm_packs_epi32(luma[2], luma[3]);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), _mm_packus_epi16(low, high));
+    }
+#elif defined(FRAME_SIMD_NEON)
+    for (; x + 8 <= count; x += 8) {
+        uint8x8x4_t pixels = vld4_u8(reinterpret_cast<const uint8_t *>(in + x));   // B, G, R, A planes
+        uint16x8_t sum = vmull_u8(pixels.val[2], vdup_n_u8(77));
+        sum = vmlal_u8(sum, pixels.val[1], vdup_n_u8(150));
+        sum = vmlal_u8(sum, pixels.val[0], vdup_n_u8(29));
+        vst1_u8(out + x, vshrn_n_u16(sum, 8));
+    }
+#endif
+    for (; x < count; ++x) {
+        quint32 p = in[x];
+        out[x] = quint8((qRed(p) * 77 + qGreen(p) * 150 + qBlue(p) * 29) >> 8);
+    }
+}
+
+// Turns a row of running sums into integral-image sums
+void addRowAbove(quint32 *row, const quint32 *above, int count)
+{
+    int x = 0;
+#if defined(FRAME_SIMD_SSE2)
+    for (; x + 4 <= count; x += 4) {
+        __m128i sum = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(row + x)),
+                                    _mm_loadu_si128(reinterpret_cast<const __m128i *>(above + x)));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(row + x), sum);
+    }
+#elif defined(FRAME_SIMD_NEON)
+    for (; x + 4 <= count; x += 4) {
+        vst1q_u32(row + x, vaddq_u32(vld1q_u32(row + x), vld1q_u32(above + x)));
+    }
+#endif
+    for (; x < count; ++x) {
+        row[x] += above[x];
+    }
+}
+
+inline quint32 boxSum(const std::vector<quint32> &table, int stride, int x0, int y0, int x1, int y1)
+{
+    return table[size_t(y1) * stride + x1] - table[size_t(y0) * stride + x1]
+           - table[size_t(y1) * stride + x0] + table[size_t(y0) * stride + x0];
+}
+
+// Runs of dark, light, dark, light, dark in the ratio 1:1:3:1:1
+bool isFinderRatio(const int counts[5])
+{
+    int total = 0;
+    for (int i = 0; i < 5; ++i) {
+        if (counts[i] == 0) {
+            return false;
+        }
+        total += counts[i];
+    }
+    if (total < 7) {
+        return false;
+    }
+    double module = total / 7.0;
+    double variance = module / 2.0;
+    return std::abs(module - counts[0]) < variance && std::abs(module - counts[1]) < variance
+           && std::abs(3.0 * module - counts[2]) < 3.0 * variance
+           && std::abs(module - counts[3]) < variance && std::abs(module - counts[4]) < variance;
+}
+
+// Re-measures a finder pattern across the first scan, from its centre
+// outwards; dark(i) reads position i along the cross-check line
+template <typename Dark>
+bool crossCheck(Dark dark, int start, int length, int maxCount, int originalTotal, double &center)
+{
+    int counts[5] = {0, 0, 0, 0, 0};
+    int i = start;
+    while (i >= 0 && dark(i)) {
+        counts[2]++;
+        i--;
+    }
+    while (i >= 0 && !dark(i) && counts[1] <= maxCount) {
+        counts[1]++;
+        i--;
+    }
+    if (i < 0 || counts[1] > maxCount) {
+        return false;
+    }
+    while (i >= 0 && dark(i) && counts[0] <= maxCount) {
+        counts[0]++;
+        i--;
+    }
+    if (counts[0] > maxCount) {
+        return false;
+    }
+
+    i = start + 1;
+    while (i < length && dark(i)) {
+        counts[2]++;
+        i++;
+    }
+    while (i < length && !dark(i) && counts[3] < maxCount) {
+        counts[3]++;
+        i++;
+    }
+    if (i == length || counts[3] >= maxCount) {
+        return false;
+    }
+    while (i < length && dark(i) && counts[4] < maxCount) {
+        counts[4]++;
+        i++;
+    }
+    if (counts[4] >= maxCount) {
+        return false;
+    }
+
+    int total = counts[0] + counts[1] + counts[2] + counts[3] + counts[4];
+    if (5 * std::abs(total - originalTotal) >= 2 * originalTotal || !isFinderRatio(counts)) {
+        return false;
+    }
+    center = i - counts[4] - counts[3] - counts[2] / 2.0;
+    return true;
+}
+
+double distance(const QPointF &a, const QPointF &b)
+{
+    return std::hypot(a.x() - b.x(), a.y() - b.y());
+}
+
+QString milliseconds(qint64 ns)
+{
+    return QString::number(ns / 1e6, 'f', 2) + " ms";
+}
+
+} // namespace
+
+QString DetectedCode::describe() const
+{
+    if (kind == Barcode) {
+        return QString("Barcode at %1,%2 (%3x%4 px)")
+            .arg(bounds.x(), 0, 'f', 0).arg(bounds.y(), 0, 'f', 0)
+            .arg(bounds.width(), 0, 'f', 0).arg(bounds.height(), 0, 'f', 0);
+    }
+    return QString("QR code, ~%1x%1 modules of %2 px, at %3,%4 (%5x%6 px)")
+        .arg(dimension).arg(moduleSize, 0, 'f', 1)
+        .arg(bounds.x(), 0, 'f', 0).arg(bounds.y(), 0, 'f', 0)
+        .arg(bounds.width(), 0, 'f', 0).arg(bounds.height(), 0, 'f', 0);
+}
+
+QString FrameAnalysis::Timings::describe() const
+{
+    QString text = QString("grayscale %1, integrals %2, threshold %3, finders %4, barcodes %5, total %6")
+                       .arg(milliseconds(grayscaleNs), milliseconds(integralNs), milliseconds(thresholdNs),
+                            milliseconds(finderNs), milliseconds(barcodeNs), milliseconds(totalNs));
+    if (totalNs > 0) {
+        text += QString(" (up to %1 fps)").arg(1e9 / totalNs, 0, 'f', 0);
+    }
+    return text;
+}
+
+FrameAnalyzer::FrameAnalyzer(int threads)
+    : threads(qMax(1, threads)), bands(this->threads == 1 ? 1 : this->threads * 4),
+      width(0), height(0), bandCandidates(bands), frames(0)
+{
+    // The calling thread takes bands too, so the pool is one thread short
+    if (this->threads > 1) {
+        const int workers = this->threads - 1;
+        pool = analysisPools().acquire(workers, [workers]() { return new WorkStealingExecutor(workers); });
+    }
+}
+
+FrameAnalyzer::~FrameAnalyzer()
+{
+}
+
+FrameAnalysis FrameAnalyzer::analyze(const QImage &frame)
+{
+    TRACE_SPAN("FrameAnalyzer::analyze", "camera");
+    FrameAnalysis result;
+    if (frame.isNull()) {
+        return result;
+    }
+
+    QElapsedTimer total;
+    QElapsedTimer stage;
+    total.start();
+    stage.start();
+    toGrayscale(frame);
+    result.timings.grayscaleNs = stage.nsecsElapsed();
+
+    stage.start();
+    buildIntegrals();
+    result.timings.integralNs = stage.nsecsElapsed();
+
+    stage.start();
+    forEachBand([this](int, int y0, int y1) { thresholdRows(y0, y1); });
+    result.timings.thresholdNs = stage.nsecsElapsed();
+
+    stage.start();
+    forEachBand([this](int band, int y0, int y1) {
+        bandCandidates[band].clear();
+        scanFinderRows(y0, y1, bandCandidates[band]);
+    });
+    std::vector<FinderCandidate> candidates;
+    for (const std::vector<FinderCandidate> &found : bandCandidates) {
+        for (const FinderCandidate &candidate : found) {
+            mergeCandidate(candidates, candidate);
+        }
+    }
+    result.codes = groupFinders(candidates);
+    result.timings.finderNs = stage.nsecsElapsed();
+
+    stage.start();
+    result.codes += findBarcodes();
+    result.timings.barcodeNs = stage.nsecsElapsed();
+    result.timings.totalNs = total.nsecsElapsed();
+
+    frames++;
+    totals.grayscaleNs += result.timings.grayscaleNs;
+    totals.integralNs += result.timings.integralNs;
+    totals.thresholdNs += result.timings.thresholdNs;
+    totals.finderNs += result.timings.finderNs;
+    totals.barcodeNs += result.timings.barcodeNs;
+    totals.totalNs += result.timings.totalNs;
+    return result;
+}
+
+int FrameAnalyzer::threadCount() const
+{
+    return threads;
+}
+
+quint64 FrameAnalyzer::frameCount() const
+{
+    return frames;
+}
+
+FrameAnalysis::Timings FrameAnalyzer::averageTimings() const
+{
+    FrameAnalysis::Timings mean;
+    if (frames == 0) {
+        return mean;
+    }
+    qint64 n = qint64(frames);
+    mean.grayscaleNs = totals.grayscaleNs / n;
+    mean.integralNs = totals.integralNs / n;
+    mean.thresholdNs = totals.thresholdNs / n;
+    mean.finderNs = totals.finderNs / n;
+    mean.barcodeNs = totals.barcodeNs / n;
+    mean.totalNs = totals.totalNs / n;
+    return mean;
+}
+
+const char *FrameAnalyzer::simdName()
+{
+#if defined(FRAME_SIMD_SSE2)
+    return "SSE2";
+#elif defined(FRAME_SIMD_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+SharedCache<int, WorkStealingExecutor>::Stats FrameAnalyzer::poolStats()
+{
+    return analysisPools().stats();
+}
+
+void FrameAnalyzer::toGrayscale(const QImage &frame)
+{
+    QImage converted;
+    const QImage *source = &frame;
+    QImage::Format format = frame.format();
+    if (format != QImage::Format_RGB32 && format != QImage::Format_ARGB32
+        && format != QImage::Format_ARGB32_Premultiplied) {
+        converted = frame.convertToFormat(QImage::Format_RGB32);
+        source = &converted;
+    }
+
+    if (source->width() != width || source->height() != height) {
+        width = source->width();
+        height = source->height();
+        size_t pixels = size_t(width) * size_t(height);
+        size_t cells = size_t(width + 1) * size_t(height + 1);
+        gray.assign(pixels, 0);
+        binary.assign(pixels, 0);
+        // The zero first row and column are never written again
+        integral.assign(cells, 0);
+        gradientX.assign(cells, 0);
+        gradientY.assign(cells, 0);
+    }
+    for (int y = 0; y < height; ++y) {
+        grayscaleRow(reinterpret_cast<const quint32 *>(source->constScanLine(y)), &gray[size_t(y) * width], width);
+    }
+}
+
+void FrameAnalyzer::buildIntegrals()
+{
+    const int stride = width + 1;
+    for (int y = 0; y < height; ++y) {
+        const quint8 *row = &gray[size_t(y) * width];
+        const quint8 *up = y > 0 ? row - width : row;
+        const quint8 *down = y + 1 < height ? row + width : row;
+        quint32 *sum = &integral[size_t(y + 1) * stride];
+        quint32 *dx = &gradientX[size_t(y + 1) * stride];
+        quint32 *dy = &gradientY[size_t(y + 1) * stride];
+
+        // Running sums along the row are serial; adding the row above is not
+        quint32 runningSum = 0;
+        quint32 runningDx = 0;
+        quint32 runningDy = 0;
+        for (int x = 0; x < width; ++x) {
+            int left = row[x > 0 ? x - 1 : x];
+            int right = row[x + 1 < width ? x + 1 : x];
+            runningSum += row[x];
+            runningDx += quint32(std::abs(right - left));
+            runningDy += quint32(std::abs(int(down[x]) - int(up[x])));
+            sum[x + 1] = runningSum;
+            dx[x + 1] = runningDx;
+            dy[x + 1] = runningDy;
+        }
+        addRowAbove(sum + 1, sum + 1 - stride, width);
+        addRowAbove(dx + 1, dx + 1 - stride, width);
+        addRowAbove(dy + 1, dy + 1 - stride, width);
+    }
+}
+
+// Local-mean (Bradley) threshold over a window of an eighth of the frame width
+void FrameAnalyzer::thresholdRows(int y0, int y1)
+{
+    const int stride = width + 1;
+    const int half = qMax(8, width / 16);
+    for (int y = y0; y < y1; ++y) {
+        int top = qMax(0, y - half);
+        int bottom = qMin(height, y + half + 1);
+        const quint32 *above = &integral[size_t(top) * stride];
+        const quint32 *below = &integral[size_t(bottom) * stride];
+        const quint8 *in = &gray[size_t(y) * width];
+        quint8 *out = &binary[size_t(y) * width];
+        for (int x = 0; x < width; ++x) {
+            int left = qMax(0, x - half);
+            int right = qMin(width, x + half + 1);
+            quint32 sum = below[right] - above[right] - below[left] + above[left];
+            quint64 count = quint64(right - left) * quint64(bottom - top);
+            out[x] = quint64(in[x]) * count * 100 < quint64(sum) * (100 - ThresholdPercent) ? 1 : 0;
+        }
+    }
+}
+
+// Scans each row for the 1:1:3:1:1 run pattern of a QR finder, then
+// confirms it vertically and horizontally through its centre
+void FrameAnalyzer::scanFinderRows(int y0, int y1, std::vector<FinderCandidate> &found) const
+{
+    auto darkInColumn = [this](int x) {
+        return [this, x](int y) { return binary[size_t(y) * width + x] != 0; };
+    };
+    auto darkInRow = [this](int y) {
+        return [this, y](int x) { return binary[size_t(y) * width + x] != 0; };
+    };
+
+    for (int y = y0; y < y1; ++y) {
+        const quint8 *row = &binary[size_t(y) * width];
+        int counts[5] = {0, 0, 0, 0, 0};
+        int state = 0;      // index into counts: even states are dark runs
+        for (int x = 0; x <= width; ++x) {
+            bool dark = x < width && row[x] != 0;
+            if (dark) {
+                if (state & 1) {
+                    state++;
+                }
+                counts[state]++;
+                continue;
+            }
+            if (state & 1) {
+                counts[state]++;
+                continue;
+            }
+            if (state < 4) {
+                state++;
+                counts[state]++;
+                continue;
+            }
+
+            // Five runs ended at x
+            bool confirmed = false;
+            if (isFinderRatio(counts)) {
+                int total = counts[0] + counts[1] + counts[2] + counts[3] + counts[4];
+                double centerX = x - counts[4] - counts[3] - counts[2] / 2.0;
+                double centerY;
+                double refinedX;
+                if (crossCheck(darkInColumn(int(centerX)), y, height, counts[2], total, centerY)
+                    && crossCheck(darkInRow(int(centerY)), int(centerX), width, counts[2], total, refinedX)) {
+                    mergeCandidate(found, FinderCandidate{refinedX, centerY, total / 7.0, 1});
+                    confirmed = true;
+                }
+            }
+            if (confirmed) {
+                std::fill(counts, counts + 5, 0);
+                state = 1;
+                counts[1] = 1;
+            } else {
+                // Slide by one pair of runs; this light pixel starts the new fourth run
+                counts[0] = counts[2];
+                counts[1] = counts[3];
+                counts[2] = counts[4];
+                counts[3] = 1;
+                counts[4] = 0;
+                state = 3;
+            }
+        }
+    }
+}
+
+// The same pattern seen on several rows, or from neighbouring bands, is one finder
+void FrameAnalyzer::mergeCandidate(std::vector<FinderCandidate> &found, const FinderCandidate &candidate)
+{
+    for (FinderCandidate &existing : found) {
+        if (std::abs(existing.x - candidate.x) <= existing.moduleSize
+            && std::abs(existing.y - candidate.y) <= existing.moduleSize
+            && std::abs(existing.moduleSize - candidate.moduleSize) <= qMax(1.0, existing.moduleSize / 2.0)) {
+            int hits = existing.hits + candidate.hits;
+            existing.x = (existing.x * existing.hits + candidate.x * candidate.hits) / hits;
+            existing.y = (existing.y * existing.hits + candidate.y * candidate.hits) / hits;
+            existing.moduleSize = (existing.moduleSize * existing.hits + candidate.moduleSize * candidate.hits) / hits;
+            existing.hits = hits;
+            return;
+        }
+    }
+    found.push_back(candidate);
+}
+
+// Three finders of similar size at the corners of a right isosceles
+// triangle make a QR symbol; the right angle is its top-left corner
+QVector<DetectedCode> FrameAnalyzer::groupFinders(std::vector<FinderCandidate> &candidates) const
+{
+    QVector<DetectedCode> codes;
+    candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                    [](const FinderCandidate &c) { return c.hits < 2; }),
+                     candidates.end());
+    std::sort(candidates.begin(), candidates.end(),
+              [](const FinderCandidate &a, const FinderCandidate &b) { return a.hits > b.hits; });
+    if (candidates.size() > 12) {
+        candidates.resize(12);
+    }
+
+    const int n = int(candidates.size());
+    std::vector<bool> used(size_t(n), false);
+    for (int i = 0; i < n; ++i) {
+        for (int j = i + 1; j < n && !used[i]; ++j) {
+            for (int k = j + 1; k < n && !used[i] && !used[j]; ++k) {
+                if (used[k]) {
+                    continue;
+                }
+                const FinderCandidate *trio[3] = {&candidates[i], &candidates[j], &candidates[k]};
+                double smallest = qMin(trio[0]->moduleSize, qMin(trio[1]->moduleSize, trio[2]->moduleSize));
+                double largest = qMax(trio[0]->moduleSize, qMax(trio[1]->moduleSize, trio[2]->moduleSize));
+                if (largest > smallest * 1.4) {
+                    continue;
+                }
+
+                QPointF points[3];
+                for (int p = 0; p < 3; ++p) {
+                    points[p] = QPointF(trio[p]->x, trio[p]->y);
+                }
+                // The corner is the point opposite the longest side
+                double sides[3] = {distance(points[1], points[2]), distance(points[0], points[2]),
+                                   distance(points[0], points[1])};
+                int corner = int(std::max_element(sides, sides + 3) - sides);
+                QPointF topLeft = points[corner];
+                QPointF topRight = points[(corner + 1) % 3];
+                QPointF bottomLeft = points[(corner + 2) % 3];
+                double legA = distance(topLeft, topRight);
+                double legB = distance(topLeft, bottomLeft);
+                double hypotenuse = sides[corner];
+                if (std::abs(legA - legB) > 0.2 * qMax(legA, legB)
+                    || std::abs(hypotenuse - std::hypot(legA, legB)) > 0.15 * hypotenuse) {
+                    continue;
+                }
+                // With y pointing down, top-right is clockwise from bottom-left
+                QPointF toRight = topRight - topLeft;
+                QPointF toBottom = bottomLeft - topLeft;
+                if (toRight.x() * toBottom.y() - toRight.y() * toBottom.x() < 0) {
+                    std::swap(topRight, bottomLeft);
+                }
+
+                double module = (trio[0]->moduleSize + trio[1]->moduleSize + trio[2]->moduleSize) / 3.0;
+                double legModules = (legA + legB) / 2.0 / module;
+                if (legModules < 10.0) {
+                    continue;   // finders of a version 1 symbol are 14 modules apart
+                }
+                int version = qBound(1, qRound((legModules + 7.0 - 17.0) / 4.0), 40);
+
+                DetectedCode code;
+                code.kind = DetectedCode::QrCode;
+                code.finders[0] = topLeft;
+                code.finders[1] = topRight;
+                code.finders[2] = bottomLeft;
+                code.moduleSize = module;
+                code.dimension = 17 + 4 * version;
+                // Finder centres sit 3.5 modules in from the symbol's edges
+                QPointF bottomRight = topRight + bottomLeft - topLeft;
+                double left = qMin(qMin(topLeft.x(), topRight.x()), qMin(bottomLeft.x(), bottomRight.x()));
+                double right = qMax(qMax(topLeft.x(), topRight.x()), qMax(bottomLeft.x(), bottomRight.x()));
+                double top = qMin(qMin(topLeft.y(), topRight.y()), qMin(bottomLeft.y(), bottomRight.y()));
+                double bottom = qMax(qMax(topLeft.y(), topRight.y()), qMax(bottomLeft.y(), bottomRight.y()));
+                double margin = 3.5 * module;
+                code.bounds = QRectF(QPointF(left - margin, top - margin), QPointF(right + margin, bottom + margin));
+                codes.append(code);
+                used[i] = used[j] = used[k] = true;
+            }
+        }
+    }
+    return codes;
+}
+
+// Bars make strong horizontal gradient and almost no vertical gradient;
+// windows like that, read from the gradient integrals, are joined into regions
+QVector<DetectedCode> FrameAnalyzer::findBarcodes() const
+{
+    QVector<DetectedCode> codes;
+    const int stride = width + 1;
+    const int columns = width / BarcodeCell;
+    const int rows = height / BarcodeCell;
+    std::vector<quint8> bar(size_t(columns) * size_t(rows), 0);
+    for (int cy = 0; cy < rows; ++cy) {
+        for (int cx = 0; cx < columns; ++cx) {
+            // A window of two cells around this one
+            int x0 = qMax(0, cx * BarcodeCell - BarcodeCell / 2);
+            int y0 = qMax(0, cy * BarcodeCell - BarcodeCell / 2);
+            int x1 = qMin(width, x0 + 2 * BarcodeCell);
+            int y1 = qMin(height, y0 + 2 * BarcodeCell);
+            quint64 area = quint64(x1 - x0) * quint64(y1 - y0);
+            quint64 sumX = boxSum(gradientX, stride, x0, y0, x1, y1);
+            quint64 sumY = boxSum(gradientY, stride, x0, y0, x1, y1);
+            bar[size_t(cy) * columns + cx] = sumX >= area * MinBarGradient && sumX > sumY * BarDominance;
+        }
+    }
+
+    std::vector<int> stack;
+    for (int start = 0; start < columns * rows; ++start) {
+        if (bar[size_t(start)] != 1) {
+            continue;
+        }
+        int minX = columns, maxX = -1, minY = rows, maxY = -1, cells = 0;
+        bar[size_t(start)] = 2;
+        stack.push_back(start);
+        while (!stack.empty()) {
+            int cell = stack.back();
+            stack.pop_back();
+            int cx = cell % columns;
+            int cy = cell / columns;
+            minX = qMin(minX, cx);
+            maxX = qMax(maxX, cx);
+            minY = qMin(minY, cy);
+            maxY = qMax(maxY, cy);
+            cells++;
+            const int neighbours[4][2] = {{cx - 1, cy}, {cx + 1, cy}, {cx, cy - 1}, {cx, cy + 1}};
+            for (const auto &next : neighbours) {
+                if (next[0] >= 0 && next[0] < columns && next[1] >= 0 && next[1] < rows
+                    && bar[size_t(next[1]) * columns + next[0]] == 1) {
+                    bar[size_t(next[1]) * columns + next[0]] = 2;
+                    stack.push_back(next[1] * columns + next[0]);
+                }
+            }
+        }
+        // A barcode is wide: at least four cells across and two down
+        if (maxX - minX + 1 >= 4 && maxY - minY + 1 >= 2 && cells >= 6) {
+            DetectedCode code;
+            code.kind = DetectedCode::Barcode;
+            code.bounds = QRectF(minX * BarcodeCell, minY * BarcodeCell,
+                                 (maxX - minX + 1) * BarcodeCell, (maxY - minY + 1) * BarcodeCell);
+            codes.append(code);
+        }
+    }
+    return codes;
+}
+
+void FrameAnalyzer::forEachBand(const std::function<void(int, int, int)> &work)
+{
+    const int rowsPerBand = (height + bands - 1) / bands;
+    std::atomic<int> next{0};
+    // Every thread, the caller included, takes the next band until none are left
+    auto drain = [&]() {
+        for (int band = next++; band < bands; band = next++) {
+            int y0 = band * rowsPerBand;
+            int y1 = qMin(height, y0 + rowsPerBand);
+            if (y0 < y1) {
+                work(band, y0, y1);
+            }
+        }
+    };
+    // Other analyzers share the pool, so wait for this call's helpers only
+    std::mutex doneMutex;
+    std::condition_variable done;
+    int helpers = threads - 1;
+    for (int i = 1; i < threads; ++i) {
+        pool->submit([&]() {
+            drain();
+            std::lock_guard<std::mutex> lock(doneMutex);
+            if (--helpers == 0) {
+                done.notify_one();
+            }
+        });
+    }
+    drain();
+    std::unique_lock<std::mutex> lock(doneMutex);
+    done.wait(lock, [&]() { return helpers == 0; });
+}
+
+namespace {
+
+constexpr int QrSize = 25;          // version 2
+constexpr int QrModulePx = 6;
+constexpr int BarModulePx = 3;
+constexpr int BarHeightPx = 110;
+
+} // namespace
+
+SimulatedViewfinder::SimulatedViewfinder(int width, int height)
+    : frame(width, height, QImage::Format_RGB32), number(0), qrModules(size_t(QrSize) * QrSize, 0),
+      noise(0x9E3779B9u)
+{
+    quint32 seed = 12345;
+    auto random = [&seed]() {
+        seed = seed * 1664525u + 1013904223u;
+        return seed >> 16;
+    };
+
+    // Random data, then the three finders with their separators, then the timing patterns
+    for (quint8 &module : qrModules) {
+        module = random() & 1;
+    }
+    auto finder = [this](int left, int top) {
+        for (int y = -1; y <= 7; ++y) {
+            for (int x = -1; x <= 7; ++x) {
+                int mx = left + x;
+                int my = top + y;
+                if (mx < 0 || my < 0 || mx >= QrSize || my >= QrSize) {
+                    continue;
+                }
+                bool inside = x >= 0 && x <= 6 && y >= 0 && y <= 6;
+                bool ring = x == 0 || x == 6 || y == 0 || y == 6;
+                bool core = x >= 2 && x <= 4 && y >= 2 && y <= 4;
+                qrModules[size_t(my) * QrSize + mx] = inside && (ring || core) ? 1 : 0;
+            }
+        }
+    };
+    finder(0, 0);
+    finder(QrSize - 7, 0);
+    finder(0, QrSize - 7);
+    for (int i = 8; i < QrSize - 8; ++i) {
+        qrModules[size_t(6) * QrSize + i] = i % 2 == 0;
+        qrModules[size_t(i) * QrSize + 6] = i % 2 == 0;
+    }
+
+    // EAN-13 layout: guard bars around two halves of 42 modules in runs of one to four
+    auto runs = [this, &random](int modules, bool dark) {
+        while (modules > 0) {
+            int run = qMin(modules, int(1 + random() % 4));
+            barModules.insert(barModules.end(), size_t(run), quint8(dark));
+            modules -= run;
+            dark = !dark;
+        }
+    };
+    barModules = {1, 0, 1};
+    runs(42, false);
+    barModules.insert(barModules.end(), {0, 1, 0, 1, 0});
+    runs(42, true);
+    barModules.insert(barModules.end(), {1, 0, 1});
+}
+
+QImage SimulatedViewfinder::nextFrame()
+{
+    const int w = frame.width();
+    const int h = frame.height();
+    const double t = double(number);
+    const int qrPx = QrSize * QrModulePx;
+    const int qrQuiet = 4 * QrModulePx;
+    const int qrLeft = int(qrQuiet + 20 + 20 * std::sin(t * 0.05));
+    const int qrTop = int(qrQuiet + 30 + 15 * std::cos(t * 0.04));
+    const int barPx = int(barModules.size()) * BarModulePx;
+    const int barQuiet = 10 * BarModulePx;
+    const int barLeft = int(w - barPx - barQuiet - 20 + 15 * std::sin(t * 0.03));
+    const int barTop = int(h - BarHeightPx - 40 + 10 * std::cos(t * 0.06));
+
+    for (int y = 0; y < h; ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(frame.scanLine(y));
+        for (int x = 0; x < w; ++x) {
+            // Lit from the bottom right; the codes are printed on white labels
+            int level = 110 + x * 60 / w + y * 40 / h;
+            int qx = x - qrLeft;
+            int qy = y - qrTop;
+            int bx = x - barLeft;
+            int by = y - barTop;
+            if (qx >= -qrQuiet && qx < qrPx + qrQuiet && qy >= -qrQuiet && qy < qrPx + qrQuiet) {
+                bool dark = qx >= 0 && qx < qrPx && qy >= 0 && qy < qrPx
+                            && qrModules[size_t(qy / QrModulePx) * QrSize + qx / QrModulePx];
+                level = dark ? 35 : 220;
+            } else if (bx >= -barQuiet && bx < barPx + barQuiet && by >= -8 && by < BarHeightPx + 8) {
+                bool dark = bx >= 0 && bx < barPx && by >= 0 && by < BarHeightPx
+                            && barModules[size_t(bx / BarModulePx)];
+                level = dark ? 35 : 220;
+            }
+            noise = noise * 1664525u + 1013904223u;
+            level = qBound(0, level + int(noise >> 28) - 8, 255);
+            line[x] = qRgb(level, level, qMin(255, level + 6));
+        }
+    }
+    number++;
+    // Shared with the caller; the next frame detaches if this one is still held
+    return frame;
+}
+
+quint64 SimulatedViewfinder::frameNumber() const
+{
+    return number;
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+#ifndef FRAMEANALYZER_H
+#define FRAMEANALYZER_H
+
+#include <QImage>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+#include <QVector>
+#include "sharedcache.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+class WorkStealingExecutor;
+
+struct DetectedCode
+{
+    enum Kind { QrCode, Barcode };
+
+    Kind kind = QrCode;
+    QRectF bounds;              // frame pixels
+    QPointF finders[3];         // QR only: top-left, top-right and bottom-left finder centres
+    double moduleSize = 0.0;    // QR only, pixels
+    int dimension = 0;          // QR only: estimated modules per side
+
+    QString describe() const;
+};
+
+struct FrameAnalysis
+{
+    // Wall time of each stage
+    struct Timings
+    {
+        qint64 grayscaleNs = 0;
+        qint64 integralNs = 0;
+        qint64 thresholdNs = 0;
+        qint64 finderNs = 0;
+        qint64 barcodeNs = 0;
+        qint64 totalNs = 0;
+
+        QString describe() const;
+    };
+
+    QVector<DetectedCode> codes;
+    Timings timings;
+};
+
+// Finds QR codes and 1D barcodes in viewfinder frames. The stages are
+// grayscale conversion (SSE2 or NEON), integral images of intensity and
+// of horizontal and vertical gradient, an adaptive threshold read from the
+// intensity integral, a finder-pattern search over horizontal bands in
+// parallel, and barcode regions where horizontal gradient dominates.
+// Detection only: codes are located and sized, not decoded. Buffers are
+// kept from frame to frame; worker threads are shared by every analyzer
+// with the same thread count.
+class FrameAnalyzer
+{
+public:
+    // threads includes the caller; 1 analyses on the calling thread only
+    explicit FrameAnalyzer(int threads = 2);
+    ~FrameAnalyzer();
+
+    FrameAnalyzer(const FrameAnalyzer &) = delete;
+    FrameAnalyzer &operator=(const FrameAnalyzer &) = delete;
+
+    FrameAnalysis analyze(const QImage &frame);
+
+    int threadCount() const;
+    quint64 frameCount() const;
+    // Mean per frame over every frame analysed so far
+    FrameAnalysis::Timings averageTimings() const;
+    static const char *simdName();
+    // Worker pools alive in the process and the analyzers using them
+    static SharedCache<int, WorkStealingExecutor>::Stats poolStats();
+
+private:
+    struct FinderCandidate
+    {
+        double x;
+        double y;
+        double moduleSize;
+        int hits;
+    };
+
+    void toGrayscale(const QImage &frame);
+    void buildIntegrals();
+    void thresholdRows(int y0, int y1);
+    void scanFinderRows(int y0, int y1, std::vector<FinderCandidate> &found) const;
+    static void mergeCandidate(std::vector<FinderCandidate> &found, const FinderCandidate &candidate);
+    QVector<DetectedCode> groupFinders(std::vector<FinderCandidate> &candidates) const;
+    QVector<DetectedCode> findBarcodes() const;
+    // Runs work(band, firstRow, endRow) for every band, spread over the threads
+    void forEachBand(const std::function<void(int, int, int)> &work);
+
+    int threads;
+    int bands;
+    std::shared_ptr<WorkStealingExecutor> pool;     // null with one thread
+    int width;
+    int height;
+    std::vector<quint8> gray;
+    std::vector<quint8> binary;         // 1 = dark
+    std::vector<quint32> integral;      // (width + 1) x (height + 1), zero first row and column
+    std::vector<quint32> gradientX;     // same layout, sums of |d/dx|
+    std::vector<quint32> gradientY;     // ... and of |d/dy|
+    std::vector<std::vector<FinderCandidate>> bandCandidates;
+    quint64 frames;
+    FrameAnalysis::Timings totals;
+};
+
+// Synthetic viewfinder: a lit, noisy scene with a QR-style symbol and an
+// EAN-style barcode that drift a little from frame to frame
+class SimulatedViewfinder
+{
+public:
+    explicit SimulatedViewfinder(int width = 640, int height = 480);
+
+    QImage nextFrame();
+    quint64 frameNumber() const;
+
+private:
+    QImage frame;
+    quint64 number;
+    std::vector<quint8> qrModules;      // QrSize x QrSize, 1 = dark
+    std::vector<quint8> barModules;     // 1 = dark
+    quint32 noise;
+};
+
+#endif // FRAMEANALYZER_H
\ No newline at end of file
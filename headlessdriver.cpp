@@ -0,0 +1,431 @@
+#include "headlessdriver.h"
+#include "smartphone.h"
+#include "replayengine.h"
+#include "tracing.h"
+#include "allocationtracker.h"
+#include "asyncphone.h"
+#include <QTextStream>
+#include <QDebug>
+#include <QFuture>
+#include <functional>
+
+HeadlessDriver::HeadlessDriver(Smartphone *target)
+    : echo(false), replayPassword(QString::fromLatin1(Smartphone::DefaultPassword)), operations(0), failures(0)
+{
+    target->simulationClock()->setMode(SimulationClock::Mode::AsFastAsPossible);
+    logSink = PhoneLog::addSink([target](const QVector<LogEntry> &batch) { target->indexActivity(batch); });
+    phone = new AsyncPhone(target);
+    wallClock.start();
+}
+
+HeadlessDriver::~HeadlessDriver()
+{
+    // Hands the phone back to the caller's thread
+    delete phone;
+    PhoneLog::removeSink(logSink);
+}
+
+void HeadlessDriver::setEcho(bool enabled)
+{
+    echo = enabled;
+}
+
+void HeadlessDriver::setReplayPassword(const QString &password)
+{
+    replayPassword = password;
+}
+
+int HeadlessDriver::run(QTextStream &input, QTextStream &output)
+{
+    QString line;
+    while (input.readLineInto(&line)) {
+        if (!execute(line, output)) {
+            break;
+        }
+    }
+    return failures;
+}
+
+// Returns false when the stream asked to quit
+bool HeadlessDriver::execute(const QString &line, QTextStream &output)
+{
+    QString trimmed = line.trimmed();
+    if (trimmed.isEmpty() || trimmed.startsWith('#')) {
+        return true;
+    }
+
+    QStringList args = trimmed.split(' ', Qt::SkipEmptyParts);
+    QString command = args.takeFirst().toLower();
+    if (command == "quit" || command == "exit") {
+        return false;
+    }
+    if (echo) {
+        output << "> " << trimmed << "\n";
+    }
+
+    if (!dispatch(command, args, output)) {
+        failures++;
+    }
+    return true;
+}
+
+namespace {
+
+std::function<bool(Smartphone &)> phoneOperation(const QString &name, const QString &argument)
+{
+    if (name == "photo") {
+        return [](Smartphone &p) { return p.takePhoto(); };
+    } else if (name == "unlock") {
+        return [argument](Smartphone &p) { return p.unlockPhone(argument); };
+    } else if (name == "lock") {
+        return [](Smartphone &p) { p.lockPhone(); return true; };
+    } else if (name == "storage") {
+        return [](Smartphone &p) { p.getStorageInfo(); return p.isPhoneUnlocked(); };
+    }
+    return {};
+}
+
+} // namespace
+
+bool HeadlessDriver::dispatch(const QString &command, const QStringList &args, QTextStream &output)
+{
+    QElapsedTimer timer;
+    bool ok = true;
+
+    if (command == "unlock") {
+        timer.start();
+        ok = phone->unlockPhone(args.value(0)).result();
+    } else if (command == "lock") {
+        timer.start();
+        phone->lockPhone().waitForFinished();
+    } else if (command == "photo") {
+        // Each photo is timed on its own so the histogram shows per-call latency
+        int count = qMax(1, args.value(0, "1").toInt());
+        LatencyHistogram &histogram = latency["photo"];
+        for (int i = 0; i < count && ok; ++i) {
+            timer.start();
+            ok = phone->takePhoto().result();
+            histogram.record(timer.nsecsElapsed());
+            operations++;
+        }
+        return ok;
+    } else if (command == "load") {
+        timer.start();
+        ok = phone->loadMusicFile(args.join(' ')).result();
+    } else if (command == "play") {
+        timer.start();
+        ok = phone->playMusic().result();
+    } else if (command == "stop") {
+        timer.start();
+        phone->stopMusic().waitForFinished();
+    } else if (command == "storage") {
+        timer.start();
+        QPair<bool, QString> result = phone->run([](Smartphone &p) {
+            return qMakePair(p.isPhoneUnlocked(), p.getStorageInfo());
+        }).result();
+        ok = result.first;
+        if (echo) {
+            output << result.second << "\n";
+        }
+    } else if (command == "battery") {
+        output << phone->run([](Smartphone &p) { return p.getBatteryInfo(); }).result() << "\n";
+        return true;
+    } else if (command == "advance") {
+        timer.start();
+        qint64 ms = args.value(0).toLongLong();
+        phone->run([ms](Smartphone &p) { p.simulationClock()->advanceBy(ms); }).waitForFinished();
+    } else if (command == "replay") {
+        InteractionTrace trace;
+        if (!trace.load(args.join(' '))) {
+            return false;
+        }
+        // The whole replay runs on the phone's thread
+        std::pair<int, LatencyHistogram> replayed = phone->run([&trace, this](Smartphone &p) {
+            ReplayEngine engine(ReplayEngine::phoneDispatcher(&p, replayPassword));
+            engine.runBlocking(trace);
+            return std::make_pair(engine.replayedCount(), engine.dispatchLatency());
+        }).result();
+        latency["replay"].merge(replayed.second);
+        operations += quint64(replayed.first);
+        return true;
+    } else if (command == "memo") {
+        // Simulated microphone input; "advance" sets how much audio is captured
+        QString mode = args.value(0);
+        AudioEncoder::Format format = AudioEncoder::Format::Flac;
+        if (mode == "start" && (args.size() < 2 || AudioEncoder::formatFromName(args.value(1), format))) {
+            timer.start();
+            ok = phone->startVoiceMemo(format).result();
+        } else if (mode == "stop") {
+            timer.start();
+            VoiceRecorder::Summary memo = phone->stopVoiceMemo().result();
+            ok = memo.ok;
+            if (echo && ok) {
+                output << "🎙️ " << memo.describe() << "\n";
+            }
+        } else {
+            output << "❌ Usage: memo start [wav|flac] | memo stop\n";
+            return false;
+        }
+    } else if (command == "viewfinder") {
+        // Frames arrive on the simulation clock; "advance" sets how many are analysed
+        QString mode = args.value(0);
+        if (mode == "on") {
+            int threads = args.size() > 1 ? args.value(1).toInt() : 2;
+            timer.start();
+            ok = threads > 0 && phone->startViewfinder(threads).result();
+        } else if (mode == "off") {
+            timer.start();
+            auto summary = phone->run([](Smartphone &p) {
+                bool running = p.isViewfinderRunning();
+                p.stopViewfinder();
+                return qMakePair(running, QString("%1 frames on %2 thread(s), %3; per frame: %4")
+                                              .arg(p.analyzedFrameCount())
+                                              .arg(p.frameAnalysisThreadCount())
+                                              .arg(FrameAnalyzer::simdName())
+                                              .arg(p.frameAnalysisTimings().describe()));
+            }).result();
+            ok = summary.first;
+            if (echo && ok) {
+                output << "🔳 " << summary.second << "\n";
+            }
+        } else {
+            output << "❌ Usage: viewfinder on [threads] | viewfinder off\n";
+            return false;
+        }
+    } else if (command == "search") {
+        if (args.isEmpty()) {
+            output << "❌ Usage: search <words>\n";
+            return false;
+        }
+        // Log entries written so far are searchable once the writer has passed them on
+        PhoneLog::flush();
+        QString query = args.join(' ');
+        timer.start();
+        QVector<SearchIndex::Hit> hits = phone->run([query](Smartphone &p) {
+            return p.searchIndex()->search(query);
+        }).result();
+        if (echo) {
+            output << "🔍 " << hits.size() << " result(s)\n";
+            for (const SearchIndex::Hit &hit : hits) {
+                output << "   " << SearchIndex::kindName(hit.kind).leftJustified(9) << hit.title.simplified() << "\n";
+            }
+        }
+    } else if (command == "passwd") {
+        QString current = args.value(0);
+        QString replacement = args.value(1);
+        timer.start();
+        ok = phone->run([current, replacement](Smartphone &p) {
+            return p.changePassword(current, replacement);
+        }).result();
+    } else if (command == "state") {
+        // Password, storage and lock state; "open" restores them from the directory
+        QString mode = args.value(0);
+        QString directory = args.mid(1).join(' ');
+        if (!(mode.isEmpty() || mode == "sync" || mode == "compact" || (mode == "open" && !directory.isEmpty()))) {
+            output << "❌ Usage: state [open <dir>|sync|compact]\n";
+            return false;
+        }
+        timer.start();
+        QPair<bool, QString> result = phone->run([mode, directory](Smartphone &p) {
+            if (mode == "open" && !p.openStateStore(directory)) {
+                return qMakePair(false, QString("cannot open %1").arg(directory));
+            }
+            KeyValueStore *store = p.stateStore();
+            if (!store) {
+                return qMakePair(false, QString("no state store open"));
+            }
+            bool done = mode == "sync" ? store->sync() : mode == "compact" ? store->compact() : true;
+            return qMakePair(done, store->stats().describe());
+        }).result();
+        ok = result.first;
+        if (echo) {
+            output << "💾 " << result.second << "\n";
+        }
+    } else if (command == "net") {
+        // Later transfers use the new profile; "advance" moves them along
+        QString name = args.value(0);
+        timer.start();
+        QPair<bool, QString> result = phone->run([name](Smartphone &p) {
+            bool changed = name.isEmpty() || p.setNetworkProfile(name);
+            return qMakePair(changed, QString("%1; %2").arg(p.network()->profile().describe(),
+                                                            p.network()->stats().describe()));
+        }).result();
+        ok = result.first;
+        if (echo) {
+            output << "📶 " << result.second << "\n";
+        }
+    } else if (command == "install") {
+        QString name = args.value(0);
+        if (name.isEmpty()) {
+            output << "❌ Usage: install <app>\n";
+            return false;
+        }
+        timer.start();
+        ok = phone->run([name](Smartphone &p) { return p.installApp(name); }).result();
+    } else if (command == "backup") {
+        // Photos taken while it is on upload as "advance" moves the clock
+        QString mode = args.value(0);
+        if (!(mode.isEmpty() || mode == "on" || mode == "off")) {
+            output << "❌ Usage: backup [on|off]\n";
+            return false;
+        }
+        timer.start();
+        QString state = phone->run([mode](Smartphone &p) {
+            if (!mode.isEmpty()) {
+                p.setPhotoBackupEnabled(mode == "on");
+            }
+            return p.photoBackupState();
+        }).result();
+        ok = true;
+        if (echo) {
+            output << "☁️ " << state << "\n";
+        }
+    } else if (command == "fleet") {
+        return dispatchFleet(args, output);
+    } else if (command == "apps") {
+        output << phone->run([](Smartphone &p) { return p.appScheduler()->latencyReport(); }).result()
+               << "\n";
+        return true;
+    } else if (command == "trace") {
+        QString mode = args.value(0);
+        if (mode == "on" || mode == "off") {
+            Tracer::setEnabled(mode == "on");
+        } else if (mode == "save" && args.size() > 1) {
+            if (!Tracer::exportChromeTrace(args.mid(1).join(' '))) {
+                return false;
+            }
+            output << "🧭 Trace: " << Tracer::eventCount() << " spans written\n";
+        } else {
+            output << "❌ Usage: trace on|off|save <file>\n";
+            return false;
+        }
+        return true;
+    } else if (command == "async") {
+        return dispatchAsync(args, output);
+    } else if (command == "allocs") {
+        QString mode = args.value(0);
+        if (mode == "on" || mode == "off") {
+            AllocationTracker::setEnabled(mode == "on");
+        } else if (mode == "reset") {
+            AllocationTracker::reset();
+        } else {
+            output << AllocationTracker::report() << "\n";
+        }
+        return true;
+    } else if (command == "stats") {
+        printStats(output);
+        return true;
+    } else {
+        output << "❌ Unknown command: " << command << "\n";
+        return false;
+    }
+
+    latency[command].record(timer.nsecsElapsed());
+    operations++;
+    return ok;
+}
+
+// Submits every operation before waiting for any, so the phone's queue
+// holds up to <count> operations; latency is submit-to-completion
+bool HeadlessDriver::dispatchAsync(const QStringList &args, QTextStream &output)
+{
+    int count = qMax(1, args.value(0).toInt());
+    QString name = args.value(1).toLower();
+    std::function<bool(Smartphone &)> operation = phoneOperation(name, args.mid(2).join(' '));
+    if (!operation) {
+        output << "❌ Unknown async operation: " << name << "\n";
+        return false;
+    }
+
+    QVector<qint64> completionNs(count);
+    QVector<QFuture<bool>> results;
+    results.reserve(count);
+    QElapsedTimer batch;
+    batch.start();
+    for (int i = 0; i < count; ++i) {
+        qint64 submittedNs = batch.nsecsElapsed();
+        qint64 *slot = &completionNs[i];
+        results.append(phone->run([operation, &batch, slot, submittedNs](Smartphone &p) {
+            bool ok = operation(p);
+            *slot = batch.nsecsElapsed() - submittedNs;
+            return ok;
+        }));
+    }
+
+    bool ok = true;
+    for (QFuture<bool> &result : results) {
+        ok = result.result() && ok;
+    }
+    LatencyHistogram &histogram = latency["async " + name];
+    for (qint64 ns : completionNs) {
+        histogram.record(ns);
+    }
+    operations += quint64(count);
+    if (echo) {
+        output << "   " << count << " x " << name << " in "
+               << QString::number(batch.nsecsElapsed() / 1e6, 'f', 1) << " ms, peak "
+               << phone->peakInFlight() << " in flight\n";
+    }
+    return ok;
+}
+
+// Many phones on a clock of their own; the driven phone takes no part
+bool HeadlessDriver::dispatchFleet(const QStringList &args, QTextStream &output)
+{
+    int phones = args.value(0).toInt();
+    QString mode = args.value(1);
+    NetworkProfile profile = NetworkProfile::lte();
+    if (phones <= 0 || (mode != "install" && mode != "backup") || args.size() < 3
+        || (args.size() > 3 && !NetworkProfile::fromName(args.value(3), profile))) {
+        output << "❌ Usage: fleet <phones> install <app>|backup <photos> [wifi|lte|3g|offline]\n";
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    NetworkFleet fleet(phones, profile);
+    if (mode == "install" && !fleet.installAll(args.value(2))) {
+        output << "❌ No app called " << args.value(2) << "\n";
+        return false;
+    } else if (mode == "backup") {
+        fleet.backupAll(qMax(1, args.value(2).toInt()), qint64(Camera::PhotoSizeKB) * 1024);
+    }
+    fleet.run();
+    latency["fleet"].record(timer.nsecsElapsed());
+    operations++;
+    output << "🌐 " << fleet.report() << "\n";
+    return fleet.stats().failed == 0;
+}
+
+void HeadlessDriver::printStats(QTextStream &output) const
+{
+    double seconds = wallClock.nsecsElapsed() / 1e9;
+    output << "📈 Headless run: " << operations << " operations in "
+           << QString::number(seconds, 'f', 3) << " s ("
+           << QString::number(seconds > 0 ? operations / seconds : 0.0, 'f', 0) << " ops/s), "
+           << failures << " failed\n";
+    QPair<QString, quint64> clockState = phone->run([](Smartphone &p) {
+        return qMakePair(p.simulationClock()->currentDateTime().toString(Qt::ISODate),
+                         p.simulationClock()->processedEvents());
+    }).result();
+    output << "   simulated time: " << clockState.first << ", " << clockState.second << " clock events\n";
+    output << "   search index: " << phone->run([](Smartphone &p) {
+        return p.searchIndex()->stats().describe();
+    }).result() << "\n";
+    QString stateStats = phone->run([](Smartphone &p) {
+        return p.stateStore() ? p.stateStore()->stats().describe() : QString();
+    }).result();
+    if (!stateStats.isEmpty()) {
+        output << "   state store: " << stateStats << "\n";
+    }
+    QString backupStats = phone->run([](Smartphone &p) {
+        return p.isPhotoBackupEnabled() ? p.photoBackupState() : QString();
+    }).result();
+    if (!backupStats.isEmpty()) {
+        output << "   photo backup: " << backupStats << "\n";
+    }
+    for (auto it = latency.cbegin(); it != latency.cend(); ++it) {
+        output << "   " << it.key().leftJustified(8) << " " << it.value().summary("ns") << "\n";
+    }
+    output.flush();
+}
\ No newline at end of file
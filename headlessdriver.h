@@ -0,0 +1,59 @@
+#ifndef HEADLESSDRIVER_H
+#define HEADLESSDRIVER_H
+
+#include <QString>
+#include <QStringList>
+#include <QMap>
+#include <QElapsedTimer>
+#include "latencyhistogram.h"
+#include "phonelog.h"
+
+class QTextStream;
+class Smartphone;
+class AsyncPhone;
+
+// Drives a Smartphone from a command stream without any widgets:
+//   unlock <password> | lock | photo [count] | load <file> | play | stop
+//   storage | battery | advance <ms> | replay <trace> | apps | stats | quit
+//   trace on|off|save <file> | async <count> photo|unlock <pw>|lock|storage
+//   allocs [on|off|reset] | memo start [wav|flac] | memo stop
+//   viewfinder on [threads] | viewfinder off | search <words>
+//   passwd <old> <new> | state [open <dir>|sync|compact]
+//   net [wifi|lte|3g|offline] | install <app> | backup [on|off]
+//   fleet <phones> install <app>|backup <photos> [wifi|lte|3g|offline]
+// Lines starting with '#' are comments. The simulation clock runs as fast
+// as possible, so "advance" jumps simulated time instantly. The phone runs
+// on its own thread behind an AsyncPhone; commands wait for their result,
+// except "async", which keeps all <count> operations in flight at once.
+class HeadlessDriver
+{
+public:
+    explicit HeadlessDriver(Smartphone *phone);
+    ~HeadlessDriver();
+
+    // Returns the number of commands that failed
+    int run(QTextStream &input, QTextStream &output);
+    bool execute(const QString &line, QTextStream &output);
+    void printStats(QTextStream &output) const;
+
+    void setEcho(bool enabled);
+    // What recorded unlocks that succeeded are replayed with
+    void setReplayPassword(const QString &password);
+
+private:
+    bool dispatch(const QString &command, const QStringList &args, QTextStream &output);
+
+    bool dispatchAsync(const QStringList &args, QTextStream &output);
+    bool dispatchFleet(const QStringList &args, QTextStream &output);
+
+    AsyncPhone *phone;
+    PhoneLog::SinkId logSink;   // makes the phone's log searchable
+    bool echo;
+    QString replayPassword;
+    QElapsedTimer wallClock;
+    quint64 operations;
+    int failures;
+    QMap<QString, LatencyHistogram> latency;    // ns per command
+};
+
+#endif // HEADLESSDRIVER_H
\ No newline at end of file
@@ -0,0 +1,229 @@
+#include "interactiontrace.h"
+#include "phonelog.h"
+#include <QFile>
+#include <QSaveFile>
+#include <QByteArray>
+#include <cstring>
+
+namespace {
+
+constexpr char Magic[4] = {'S', 'P', 'I', 'T'};
+
+void writeVarint(QByteArray &out, quint64 value)
+{
+    while (value >= 0x80) {
+        out.append(char((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.append(char(value));
+}
+
+bool readVarint(const QByteArray &in, qsizetype &pos, quint64 &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64 && pos < in.size(); shift += 7) {
+        quint8 byte = quint8(in.at(pos++));
+        value |= quint64(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+QString Interaction::actionName(Action action)
+{
+    switch (action) {
+    case Unlock:      return "unlock";
+    case Lock:        return "lock";
+    case TakePhoto:   return "photo";
+    case PlayMusic:   return "play";
+    case StopMusic:   return "stop";
+    case LoadMusic:   return "load";
+    case GetStorage:  return "storage";
+    case VoiceMemo:   return "memo";
+    case ScanCodes:   return "scan";
+    case ActionCount: break;
+    }
+    return "unknown";
+}
+
+bool Interaction::actionFromName(const QString &name, Action &action)
+{
+    for (int i = 0; i < ActionCount; ++i) {
+        if (actionName(Action(i)) == name) {
+            action = Action(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void InteractionTrace::append(const Interaction &interaction)
+{
+    items.append(interaction);
+}
+
+void InteractionTrace::setArgument(int index, const QString &argument)
+{
+    items[index].argument = argument;
+}
+
+void InteractionTrace::clear()
+{
+    items.clear();
+}
+
+int InteractionTrace::size() const
+{
+    return items.size();
+}
+
+bool InteractionTrace::isEmpty() const
+{
+    return items.isEmpty();
+}
+
+const Interaction &InteractionTrace::at(int index) const
+{
+    return items.at(index);
+}
+
+const QVector<Interaction> &InteractionTrace::entries() const
+{
+    return items;
+}
+
+qint64 InteractionTrace::durationUs() const
+{
+    return items.isEmpty() ? 0 : items.last().offsetUs;
+}
+
+bool InteractionTrace::save(const QString &path) const
+{
+    QByteArray out;
+    out.reserve(16 + items.size() * 4);
+    out.append(Magic, sizeof(Magic));
+    writeVarint(out, FormatVersion);
+    writeVarint(out, quint64(items.size()));
+
+    qint64 previous = 0;
+    for (const Interaction &item : items) {
+        writeVarint(out, quint64(qMax<qint64>(0, item.offsetUs - previous)));
+        previous = qMax(previous, item.offsetUs);
+        out.append(char(item.action));
+        QByteArray argument = item.argument.toUtf8();
+        writeVarint(out, quint64(argument.size()));
+        out.append(argument);
+    }
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        PHONE_LOG_ERROR("trace", "❌ Cannot write interaction trace: %1", path);
+        return false;
+    }
+    file.write(out);
+    return file.commit();
+}
+
+bool InteractionTrace::load(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        PHONE_LOG_ERROR("trace", "❌ Cannot open interaction trace: %1", path);
+        return false;
+    }
+    QByteArray in = file.readAll();
+    if (in.size() < qsizetype(sizeof(Magic)) || std::memcmp(in.constData(), Magic, sizeof(Magic)) != 0) {
+        PHONE_LOG_ERROR("trace", "❌ Not an interaction trace: %1", path);
+        return false;
+    }
+
+    qsizetype pos = sizeof(Magic);
+    quint64 version = 0;
+    quint64 count = 0;
+    if (!readVarint(in, pos, version) || version != FormatVersion || !readVarint(in, pos, count)) {
+        PHONE_LOG_ERROR("trace", "❌ Unsupported interaction trace version: %1", version);
+        return false;
+    }
+
+    QVector<Interaction> loaded;
+    loaded.reserve(qsizetype(qMin<quint64>(count, quint64(in.size()))));
+    qint64 offset = 0;
+    for (quint64 i = 0; i < count; ++i) {
+        quint64 delta = 0;
+        quint64 length = 0;
+        if (!readVarint(in, pos, delta) || pos >= in.size()) {
+            return false;
+        }
+        quint8 action = quint8(in.at(pos++));
+        if (action >= Interaction::ActionCount || !readVarint(in, pos, length)
+            || length > quint64(in.size() - pos)) {
+            PHONE_LOG_ERROR("trace", "❌ Corrupt interaction trace entry %1", i);
+            return false;
+        }
+
+        Interaction item;
+        offset += qint64(delta);
+        item.offsetUs = offset;
+        item.action = Interaction::Action(action);
+        item.argument = QString::fromUtf8(in.constData() + pos, qsizetype(length));
+        pos += qsizetype(length);
+        loaded.append(item);
+    }
+
+    items = loaded;
+    return true;
+}
+
+InteractionRecorder::InteractionRecorder() : firstId(0), recording(false)
+{
+}
+
+void InteractionRecorder::start()
+{
+    firstId += recorded.size();
+    recorded.clear();
+    timer.start();
+    recording = true;
+}
+
+void InteractionRecorder::stop()
+{
+    recording = false;
+}
+
+bool InteractionRecorder::isRecording() const
+{
+    return recording;
+}
+
+qint64 InteractionRecorder::record(Interaction::Action action, const QString &argument)
+{
+    if (!recording) {
+        return -1;
+    }
+
+    Interaction item;
+    item.action = action;
+    item.offsetUs = timer.nsecsElapsed() / 1000;
+    item.argument = argument;
+    recorded.append(item);
+    return firstId + recorded.size() - 1;
+}
+
+void InteractionRecorder::setArgument(qint64 id, const QString &argument)
+{
+    qint64 index = id - firstId;
+    if (id < 0 || index < 0 || index >= recorded.size()) {
+        return;
+    }
+    recorded.setArgument(int(index), argument);
+}
+
+const InteractionTrace &InteractionRecorder::trace() const
+{
+    return recorded;
+}
\ No newline at end of file
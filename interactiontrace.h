@@ -0,0 +1,77 @@
+#ifndef INTERACTIONTRACE_H
+#define INTERACTIONTRACE_H
+
+#include <QString>
+#include <QVector>
+#include <QElapsedTimer>
+
+struct Interaction
+{
+    enum Action : quint8 {
+        Unlock,         // argument: "1" if it succeeded, "0" if not; never the password
+        Lock,
+        TakePhoto,
+        PlayMusic,
+        StopMusic,
+        LoadMusic,      // argument: file path
+        GetStorage,
+        VoiceMemo,      // argument: format to start recording, empty to stop
+        ScanCodes,      // argument: analysis threads to start the viewfinder, empty to stop
+        ActionCount
+    };
+
+    Action action = Lock;
+    qint64 offsetUs = 0;    // time since the start of the recording
+    QString argument;
+
+    static QString actionName(Action action);
+    static bool actionFromName(const QString &name, Action &action);
+};
+
+// Timestamped list of user interactions. The file format is compact:
+// a small header, then per entry a varint time delta, the action byte and
+// an optional length-prefixed UTF-8 argument.
+class InteractionTrace
+{
+public:
+    static constexpr quint32 FormatVersion = 1;
+
+    void append(const Interaction &interaction);
+    void setArgument(int index, const QString &argument);
+    void clear();
+    int size() const;
+    bool isEmpty() const;
+    const Interaction &at(int index) const;
+    const QVector<Interaction> &entries() const;
+    qint64 durationUs() const;
+
+    bool save(const QString &path) const;
+    bool load(const QString &path);
+
+private:
+    QVector<Interaction> items;
+};
+
+class InteractionRecorder
+{
+public:
+    InteractionRecorder();
+
+    void start();
+    void stop();
+    bool isRecording() const;
+    // Returns an id for setArgument(), or -1 when not recording
+    qint64 record(Interaction::Action action, const QString &argument = QString());
+    // Fills in an outcome known only after the entry was recorded. Ids from
+    // an earlier recording are ignored.
+    void setArgument(qint64 id, const QString &argument);
+    const InteractionTrace &trace() const;
+
+private:
+    InteractionTrace recorded;
+    QElapsedTimer timer;
+    qint64 firstId;     // id of the current recording's first entry
+    bool recording;
+};
+
+#endif // INTERACTIONTRACE_H
\ No newline at end of file
@@ -0,0 +1,551 @@
+#include "kvstore.h"
+#include "phonelog.h"
+#include "tracing.h"
+#include "allocationtracker.h"
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSaveFile>
+#include <QtEndian>
+#include <array>
+#include <chrono>
+#include <cstring>
+
+#if defined(Q_OS_UNIX)
+#include <fcntl.h>
+#include <unistd.h>
+#elif defined(Q_OS_WIN)
+#include <io.h>
+#endif
+
+namespace {
+
+const char SnapshotMagic[8] = {'P', 'H', 'K', 'V', 'S', 'N', 'P', '1'};
+const char LogMagic[8] = {'P', 'H', 'K', 'V', 'W', 'A', 'L', '1'};
+constexpr int FileHeaderBytes = 12;         // magic, generation
+
+// Record: payload length and CRC-32 of the payload, then the payload: op,
+// key length, UTF-8 key, value. All integers little-endian.
+constexpr int RecordHeaderBytes = 8;
+constexpr int PayloadHeaderBytes = 3;
+constexpr quint8 OpPut = 1;
+constexpr quint8 OpRemove = 2;
+constexpr int MaxKeyBytes = 0xFFFF;
+constexpr quint32 MaxPayloadBytes = 64 * 1024 * 1024;
+
+std::array<quint32, 256> makeCrc32Table()
+{
+    std::array<quint32, 256> table{};
+    for (quint32 i = 0; i < 256; ++i) {
+        quint32 crc = i;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+const std::array<quint32, 256> Crc32Table = makeCrc32Table();
+
+quint32 crc32(const uchar *data, size_t length)
+{
+    quint32 crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; ++i) {
+        crc = (crc >> 8) ^ Crc32Table[(crc ^ data[i]) & 0xFF];
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void encodeRecord(QByteArray &out, quint8 op, const QByteArray &key, const QByteArray &value)
+{
+    const qsizetype start = out.size();
+    const quint32 payload = quint32(PayloadHeaderBytes + key.size() + value.size());
+    out.resize(start + RecordHeaderBytes + qsizetype(payload));
+    uchar *p = reinterpret_cast<uchar *>(out.data()) + start;
+    uchar *body = p + RecordHeaderBytes;
+    body[0] = op;
+    qToLittleEndian<quint16>(quint16(key.size()), body + 1);
+    std::memcpy(body + PayloadHeaderBytes, key.constData(), size_t(key.size()));
+    if (!value.isEmpty()) {
+        std::memcpy(body + PayloadHeaderBytes + key.size(), value.constData(), size_t(value.size()));
+    }
+    qToLittleEndian<quint32>(payload, p);
+    qToLittleEndian<quint32>(crc32(body, payload), p + 4);
+}
+
+// Size of an entry as written to a snapshot; the log is compared against it
+qint64 encodedSize(const QString &key, const QByteArray &value)
+{
+    return RecordHeaderBytes + PayloadHeaderBytes + key.toUtf8().size() + value.size();
+}
+
+// Applies the records in data from offset on and returns the end of the last
+// intact one; anything after it is torn or corrupt
+qsizetype replay(const QByteArray &data, qsizetype offset, QHash<QString, QByteArray> &entries, int &records)
+{
+    const uchar *base = reinterpret_cast<const uchar *>(data.constData());
+    const qsizetype size = data.size();
+    while (size - offset >= RecordHeaderBytes) {
+        const quint32 payload = qFromLittleEndian<quint32>(base + offset);
+        const quint32 crc = qFromLittleEndian<quint32>(base + offset + 4);
+        const uchar *body = base + offset + RecordHeaderBytes;
+        if (payload < PayloadHeaderBytes || payload > MaxPayloadBytes
+            || qint64(payload) > size - offset - RecordHeaderBytes || crc32(body, payload) != crc) {
+            break;
+        }
+        const quint8 op = body[0];
+        const int keyBytes = qFromLittleEndian<quint16>(body + 1);
+        if (PayloadHeaderBytes + quint32(keyBytes) > payload || (op != OpPut && op != OpRemove)) {
+            break;
+        }
+        QString key = QString::fromUtf8(reinterpret_cast<const char *>(body + PayloadHeaderBytes), keyBytes);
+        if (op == OpPut) {
+            const int valueBytes = int(payload) - PayloadHeaderBytes - keyBytes;
+            entries.insert(key, QByteArray(reinterpret_cast<const char *>(body + PayloadHeaderBytes + keyBytes),
+                                           valueBytes));
+        } else {
+            entries.remove(key);
+        }
+        records++;
+        offset += RecordHeaderBytes + qsizetype(payload);
+    }
+    return offset;
+}
+
+QByteArray fileHeader(const char (&magic)[8], quint32 generation)
+{
+    QByteArray header(FileHeaderBytes, '\0');
+    std::memcpy(header.data(), magic, sizeof(magic));
+    qToLittleEndian<quint32>(generation, header.data() + sizeof(magic));
+    return header;
+}
+
+bool hasHeader(const QByteArray &data, const char (&magic)[8], quint32 &generation)
+{
+    if (data.size() < FileHeaderBytes || std::memcmp(data.constData(), magic, sizeof(magic)) != 0) {
+        return false;
+    }
+    generation = qFromLittleEndian<quint32>(data.constData() + sizeof(magic));
+    return true;
+}
+
+// Written data reaches the disk. fdatasync skips the inode times, which
+// replay does not need; the file size is still synced.
+bool syncToDisk(QFileDevice &file)
+{
+    if (!file.flush()) {
+        return false;
+    }
+#if defined(Q_OS_LINUX)
+    return ::fdatasync(file.handle()) == 0;
+#elif defined(Q_OS_UNIX)
+    return ::fsync(file.handle()) == 0;
+#elif defined(Q_OS_WIN)
+    return ::_commit(file.handle()) == 0;
+#else
+    return true;
+#endif
+}
+
+// A rename is durable only once the directory entry is
+void syncDirectory(const QString &path)
+{
+#if defined(Q_OS_UNIX)
+    int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+#else
+    Q_UNUSED(path);
+#endif
+}
+
+} // namespace
+
+double KeyValueStore::Stats::writesPerCommit() const
+{
+    return commits > 0 ? double(writes) / commits : 0.0;
+}
+
+double KeyValueStore::Stats::meanSyncUs() const
+{
+    return commits > 0 ? syncNs / 1000.0 / commits : 0.0;
+}
+
+QString KeyValueStore::Stats::describe() const
+{
+    return QString("%1 keys (%2 KB); %3 writes in %4 commits (%5 per commit, %6 µs per fsync); "
+                   "log %7 KB, %8 compactions; recovered %9 records in %10 ms, %11 torn bytes dropped")
+        .arg(keys)
+        .arg(liveBytes / 1024.0, 0, 'f', 1)
+        .arg(writes)
+        .arg(commits)
+        .arg(writesPerCommit(), 0, 'f', 1)
+        .arg(meanSyncUs(), 0, 'f', 0)
+        .arg(walBytes / 1024.0, 0, 'f', 1)
+        .arg(compactions)
+        .arg(recoveredRecords)
+        .arg(recoveryNs / 1e6, 0, 'f', 2)
+        .arg(discardedBytes);
+}
+
+KeyValueStore::KeyValueStore()
+    : appended(0), durable(0), generation(0), syncRequested(false), compactRequested(false),
+      closing(false), opened(false), failed(false)
+{
+}
+
+KeyValueStore::~KeyValueStore()
+{
+    close();
+}
+
+bool KeyValueStore::open(const QString &directory)
+{
+    TRACE_SPAN("KeyValueStore::open", "storage");
+    if (opened) {
+        return false;
+    }
+    if (!QDir().mkpath(directory)) {
+        PHONE_LOG_ERROR("storage", "❌ Cannot create %1", directory);
+        return false;
+    }
+    path = directory;
+    entries.clear();
+    pending.clear();
+    counters = Stats();
+    appended = 0;
+    durable = 0;
+    syncRequested = false;
+    compactRequested = false;
+    closing = false;
+    failed = false;
+    if (!recover()) {
+        log.reset();
+        return false;
+    }
+    opened = true;
+    committer = std::thread([this]() { commitLoop(); });
+    return true;
+}
+
+void KeyValueStore::close()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!opened) {
+            return;
+        }
+        closing = true;
+    }
+    wake.notify_one();
+    committer.join();
+    std::lock_guard<std::mutex> lock(mutex);
+    log.reset();
+    opened = false;
+}
+
+bool KeyValueStore::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return opened;
+}
+
+QString KeyValueStore::directory() const
+{
+    return path;
+}
+
+bool KeyValueStore::put(const QString &key, const QByteArray &value)
+{
+    ALLOC_SCOPE("KeyValueStore::put", "KeyValueStore");
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!opened || failed) {
+        return false;
+    }
+    auto it = entries.find(key);
+    if (it != entries.end() && it.value() == value) {
+        return true;    // unchanged, nothing to log
+    }
+    QByteArray keyBytes = key.toUtf8();
+    if (keyBytes.size() > MaxKeyBytes) {
+        return false;
+    }
+    if (it != entries.end()) {
+        counters.liveBytes += value.size() - it.value().size();
+        it.value() = value;
+    } else {
+        counters.liveBytes += RecordHeaderBytes + PayloadHeaderBytes + keyBytes.size() + value.size();
+        entries.insert(key, value);
+    }
+    appendRecord(OpPut, keyBytes, value);
+    return true;
+}
+
+bool KeyValueStore::putInt(const QString &key, qint64 value)
+{
+    char bytes[sizeof(qint64)];
+    qToLittleEndian<qint64>(value, bytes);
+    return put(key, QByteArray(bytes, sizeof(bytes)));
+}
+
+bool KeyValueStore::remove(const QString &key)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!opened || failed) {
+        return false;
+    }
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        return true;
+    }
+    counters.liveBytes -= encodedSize(key, it.value());
+    entries.erase(it);
+    appendRecord(OpRemove, key.toUtf8(), QByteArray());
+    return true;
+}
+
+QByteArray KeyValueStore::value(const QString &key, const QByteArray &fallback) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.value(key, fallback);
+}
+
+qint64 KeyValueStore::intValue(const QString &key, qint64 fallback) const
+{
+    QByteArray bytes = value(key);
+    return bytes.size() == int(sizeof(qint64)) ? qFromLittleEndian<qint64>(bytes.constData()) : fallback;
+}
+
+bool KeyValueStore::contains(const QString &key) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.contains(key);
+}
+
+QStringList KeyValueStore::keys() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.keys();
+}
+
+bool KeyValueStore::sync()
+{
+    TRACE_SPAN("KeyValueStore::sync", "storage");
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!opened) {
+        return false;
+    }
+    const quint64 target = appended;
+    if (durable < target && !failed) {
+        syncRequested = true;
+        wake.notify_one();
+        committed.wait(lock, [this, target]() { return durable >= target || failed; });
+    }
+    return !failed;
+}
+
+bool KeyValueStore::compact()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    if (!opened) {
+        return false;
+    }
+    const int before = counters.compactions;
+    compactRequested = true;
+    wake.notify_one();
+    committed.wait(lock, [this, before]() { return counters.compactions > before || failed; });
+    return !failed;
+}
+
+KeyValueStore::Stats KeyValueStore::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats stats = counters;
+    stats.keys = int(entries.size());
+    return stats;
+}
+
+// Caller holds the mutex. Only the first change of a batch wakes the commit
+// thread; the rest just append.
+void KeyValueStore::appendRecord(quint8 op, const QByteArray &keyBytes, const QByteArray &value)
+{
+    const bool first = pending.isEmpty();
+    encodeRecord(pending, op, keyBytes, value);
+    appended++;
+    counters.writes++;
+    if (first) {
+        wake.notify_one();
+    }
+}
+
+bool KeyValueStore::recover()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    quint32 snapshotGeneration = 0;
+    QFile snapshotFile(path + "/state.snapshot");
+    if (snapshotFile.exists()) {
+        if (!snapshotFile.open(QIODevice::ReadOnly)) {
+            PHONE_LOG_ERROR("storage", "❌ Cannot read %1", snapshotFile.fileName());
+            return false;
+        }
+        QByteArray data = snapshotFile.readAll();
+        int records = 0;
+        // Snapshots are replaced atomically, so a short one is corrupt, not torn
+        if (!hasHeader(data, SnapshotMagic, snapshotGeneration)
+            || replay(data, FileHeaderBytes, entries, records) != data.size()) {
+            PHONE_LOG_ERROR("storage", "❌ Corrupt state snapshot: %1", snapshotFile.fileName());
+            return false;
+        }
+    }
+
+    log.reset(new QFile(path + "/state.wal"));
+    if (!log->open(QIODevice::ReadWrite | QIODevice::Unbuffered)) {
+        PHONE_LOG_ERROR("storage", "❌ Cannot open %1", log->fileName());
+        return false;
+    }
+    QByteArray data = log->readAll();
+    quint32 logGeneration = 0;
+    if (!hasHeader(data, LogMagic, logGeneration) || logGeneration != snapshotGeneration) {
+        // New store, or a crash after a compaction wrote its snapshot but
+        // before it restarted the log: everything in the log is in the snapshot
+        if (!data.isEmpty() && logGeneration < snapshotGeneration) {
+            PHONE_LOG_INFO("storage", "Discarding a log older than the snapshot");
+        } else if (!data.isEmpty()) {
+            PHONE_LOG_WARNING("storage", "⚠️ Unreadable state log, starting a new one: %1", log->fileName());
+        }
+        if (!startLog(snapshotGeneration)) {
+            return false;
+        }
+        generation = snapshotGeneration;
+        counters.walBytes = FileHeaderBytes;
+    } else {
+        const qsizetype end = replay(data, FileHeaderBytes, entries, counters.recoveredRecords);
+        if (end < data.size()) {
+            counters.discardedBytes = data.size() - end;
+            PHONE_LOG_WARNING("storage", "⚠️ Dropped %1 bytes of torn or corrupt log after %2 records",
+                              qint64(counters.discardedBytes), counters.recoveredRecords);
+            if (!log->resize(end) || !syncToDisk(*log)) {
+                PHONE_LOG_ERROR("storage", "❌ Cannot truncate %1", log->fileName());
+                return false;
+            }
+        }
+        log->seek(end);
+        generation = logGeneration;
+        counters.walBytes = end;
+    }
+
+    for (auto it = entries.cbegin(); it != entries.cend(); ++it) {
+        counters.liveBytes += encodedSize(it.key(), it.value());
+    }
+    counters.recoveryNs = timer.nsecsElapsed();
+    PHONE_LOG_INFO("storage", "💾 State store opened: %1 keys, %2 log records replayed in %3 ms",
+                   int(entries.size()), counters.recoveredRecords, counters.recoveryNs / 1e6);
+    return true;
+}
+
+// The snapshot holds generation nextGeneration: only a log started with the
+// same number applies on top of it
+bool KeyValueStore::writeSnapshot(const QHash<QString, QByteArray> &snapshot, quint32 nextGeneration)
+{
+    QByteArray data = fileHeader(SnapshotMagic, nextGeneration);
+    for (auto it = snapshot.cbegin(); it != snapshot.cend(); ++it) {
+        encodeRecord(data, OpPut, it.key().toUtf8(), it.value());
+    }
+    QSaveFile file(path + "/state.snapshot");
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !syncToDisk(file)
+        || !file.commit()) {
+        return false;
+    }
+    syncDirectory(path);
+    return true;
+}
+
+bool KeyValueStore::startLog(quint32 nextGeneration)
+{
+    QByteArray header = fileHeader(LogMagic, nextGeneration);
+    if (!log->resize(0) || !log->seek(0) || log->write(header) != header.size() || !syncToDisk(*log)) {
+        PHONE_LOG_ERROR("storage", "❌ Cannot write %1", log->fileName());
+        return false;
+    }
+    syncDirectory(path);
+    return true;
+}
+
+void KeyValueStore::commitLoop()
+{
+    Tracer::setThreadName("kvstore");
+    QByteArray batch;
+    QElapsedTimer timer;
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        wake.wait(lock, [this]() { return closing || compactRequested || !pending.isEmpty(); });
+        if (!pending.isEmpty() && !closing && !syncRequested && !compactRequested) {
+            // Group commit: changes made while waiting share the write and the fsync
+            wake.wait_for(lock, std::chrono::milliseconds(GroupCommitMs),
+                          [this]() { return closing || syncRequested || compactRequested; });
+        }
+        syncRequested = false;
+        const quint64 batchEnd = appended;
+        const bool compactNow = compactRequested
+                                || counters.walBytes + pending.size()
+                                       > qMax(MinCompactionBytes, 2 * counters.liveBytes);
+
+        bool ok = true;
+        if (compactNow) {
+            // The copy shares its data until the next change; queued records
+            // are already in it
+            QHash<QString, QByteArray> snapshot = entries;
+            pending.clear();
+            const quint32 next = generation + 1;
+            lock.unlock();
+            TRACE_SPAN("KeyValueStore::compact", "storage");
+            ok = writeSnapshot(snapshot, next) && startLog(next);
+            lock.lock();
+            compactRequested = false;
+            if (ok) {
+                generation = next;
+                counters.walBytes = FileHeaderBytes;
+                counters.compactions++;
+            }
+        } else if (!pending.isEmpty()) {
+            batch.swap(pending);
+            lock.unlock();
+            TRACE_SPAN("KeyValueStore::commit", "storage");
+            ok = log->write(batch) == batch.size();
+            timer.start();
+            ok = ok && syncToDisk(*log);
+            const qint64 syncNs = timer.nsecsElapsed();
+            lock.lock();
+            counters.commits++;
+            counters.syncNs += syncNs;
+            counters.walBytes += batch.size();
+            // resize() keeps the capacity for the next swap
+            batch.resize(0);
+        }
+
+        if (ok) {
+            durable = batchEnd;
+        } else {
+            fail(compactNow ? QString("cannot write the snapshot") : log->errorString());
+        }
+        committed.notify_all();
+        if (closing && (pending.isEmpty() || failed)) {
+            break;
+        }
+    }
+}
+
+// Caller holds the mutex. Later changes are refused rather than kept in
+// memory only.
+void KeyValueStore::fail(const QString &message)
+{
+    if (!failed) {
+        failed = true;
+        PHONE_LOG_ERROR("storage", "❌ State store write failed, no longer accepting changes: %1", message);
+    }
+}
\ No newline at end of file
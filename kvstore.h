@@ -0,0 +1,110 @@
+#ifndef KVSTORE_H
+#define KVSTORE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+class QFile;
+
+// Small persistent key-value store for settings and phone state. Every
+// change is applied in memory and appended to a write-ahead log; a commit
+// thread writes whatever has queued up in one write and one fsync, so
+// concurrent or rapid changes share the cost of making them durable. When
+// the log has grown well past the live data it is folded into a snapshot
+// and started again. Opening the store loads the snapshot and replays the
+// log, dropping a torn last record left by a crash mid-write.
+//
+// Directory layout: state.snapshot (all live entries) and state.wal (the
+// changes since). Both carry a generation number; a log whose generation
+// does not match the snapshot's predates it and is ignored.
+class KeyValueStore
+{
+public:
+    struct Stats
+    {
+        qint64 writes = 0;              // records logged since open
+        qint64 commits = 0;             // log writes, one fsync each
+        qint64 syncNs = 0;              // total time in those fsyncs
+        qint64 walBytes = 0;            // current log size
+        qint64 liveBytes = 0;           // live entries, encoded
+        int keys = 0;
+        int compactions = 0;
+        int recoveredRecords = 0;       // replayed from the log at open
+        qint64 recoveryNs = 0;          // time to load the snapshot and replay the log
+        qint64 discardedBytes = 0;      // torn tail cut off at open
+
+        double writesPerCommit() const;
+        double meanSyncUs() const;
+        QString describe() const;
+    };
+
+    // How long the commit thread waits for more changes to join a batch
+    static constexpr int GroupCommitMs = 2;
+    // The log is compacted once it is larger than this and twice the live data
+    static constexpr qint64 MinCompactionBytes = 256 * 1024;
+
+    KeyValueStore();
+    ~KeyValueStore();
+
+    KeyValueStore(const KeyValueStore &) = delete;
+    KeyValueStore &operator=(const KeyValueStore &) = delete;
+
+    // Creates the directory if needed and recovers what is in it
+    bool open(const QString &directory);
+    // Waits for queued changes to reach the disk
+    void close();
+    bool isOpen() const;
+    QString directory() const;
+
+    // Return once the change is visible to readers, before it is durable;
+    // false if the store is closed, the log cannot be written or the key is
+    // longer than 64 KB
+    bool put(const QString &key, const QByteArray &value);
+    bool putInt(const QString &key, qint64 value);
+    bool remove(const QString &key);
+
+    QByteArray value(const QString &key, const QByteArray &fallback = QByteArray()) const;
+    qint64 intValue(const QString &key, qint64 fallback = 0) const;
+    bool contains(const QString &key) const;
+    QStringList keys() const;
+
+    // Blocks until every change made so far is on disk
+    bool sync();
+    // Folds the log into a new snapshot now instead of waiting for it to grow
+    bool compact();
+    Stats stats() const;
+
+private:
+    void appendRecord(quint8 op, const QByteArray &keyBytes, const QByteArray &value);
+    bool recover();
+    bool writeSnapshot(const QHash<QString, QByteArray> &snapshot, quint32 nextGeneration);
+    bool startLog(quint32 nextGeneration);
+    void commitLoop();
+    void fail(const QString &message);
+
+    QString path;
+    std::unique_ptr<QFile> log;             // touched by the commit thread only once open
+    std::thread committer;
+    mutable std::mutex mutex;
+    std::condition_variable wake;           // changes queued, sync or compaction asked, closing
+    std::condition_variable committed;      // durable advanced, or a compaction finished
+    QHash<QString, QByteArray> entries;
+    QByteArray pending;                     // encoded records not yet written
+    quint64 appended;                       // records queued since open
+    quint64 durable;                        // ... of which on disk
+    quint32 generation;
+    bool syncRequested;
+    bool compactRequested;
+    bool closing;
+    bool opened;
+    bool failed;
+    Stats counters;
+};
+
+#endif // KVSTORE_H
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "latencyhistogram.h"
+#include <QtAlgorithms>
+#include <limits>
+
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::record(qint64 value)
+{
+    if (value < 0) {
+        value = 0;
+    }
+    buckets[bucketFor(quint64(value))]++;
+    if (samples == 0 || value < minValue) {
+        minValue = value;
+    }
+    if (samples == 0 || value > maxValue) {
+        maxValue = value;
+    }
+    sum += double(value);
+    samples++;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    if (other.samples == 0) {
+        return;
+    }
+    for (int i = 0; i < BucketCount; ++i) {
+        buckets[i] += other.buckets[i];
+    }
+    minValue = samples == 0 ? other.minValue : qMin(minValue, other.minValue);
+    maxValue = samples == 0 ? other.maxValue : qMax(maxValue, other.maxValue);
+    sum += other.sum;
+    samples += other.samples;
+}
+
+void LatencyHistogram::reset()
+{
+    buckets.fill(0);
+    samples = 0;
+    minValue = 0;
+    maxValue = 0;
+    sum = 0.0;
+}
+
+quint64 LatencyHistogram::count() const
+{
+    return samples;
+}
+
+qint64 LatencyHistogram::min() const
+{
+    return minValue;
+}
+
+qint64 LatencyHistogram::max() const
+{
+    return maxValue;
+}
+
+double LatencyHistogram::mean() const
+{
+    return samples ? sum / double(samples) : 0.0;
+}
+
+qint64 LatencyHistogram::percentile(double p) const
+{
+    if (samples == 0) {
+        return 0;
+    }
+
+    quint64 rank = quint64(qBound(0.0, p, 100.0) / 100.0 * double(samples - 1)) + 1;
+    quint64 seen = 0;
+    for (int i = 0; i < BucketCount; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return qMin(bucketUpperBound(i), maxValue);
+        }
+    }
+    return maxValue;
+}
+
+QString LatencyHistogram::summary(const QString &unit) const
+{
+    return QString("n=%1 min=%2%7 p50=%3%7 p90=%4%7 p99=%5%7 max=%6%7")
+        .arg(samples)
+        .arg(minValue)
+        .arg(percentile(50))
+        .arg(percentile(90))
+        .arg(percentile(99))
+        .arg(maxValue)
+        .arg(unit);
+}
+
+QJsonObject LatencyHistogram::toJson() const
+{
+    QJsonObject json;
+    json["count"] = double(samples);
+    json["min"] = double(minValue);
+    json["mean"] = mean();
+    json["p50"] = double(percentile(50));
+    json["p90"] = double(percentile(90));
+    json["p99"] = double(percentile(99));
+    json["max"] = double(maxValue);
+    return json;
+}
+
+int LatencyHistogram::bucketFor(quint64 value)
+{
+    if (value < SubBuckets) {
+        return int(value);
+    }
+    int msb = 63 - qCountLeadingZeroBits(value);
+    int sub = int((value >> (msb - 2)) & (SubBuckets - 1));
+    return (msb - 1) * SubBuckets + sub;
+}
+
+qint64 LatencyHistogram::bucketUpperBound(int bucket)
+{
+    if (bucket < SubBuckets) {
+        return bucket;
+    }
+    int msb = bucket / SubBuckets + 1;
+    int sub = bucket % SubBuckets;
+    if (msb >= 62) {
+        return std::numeric_limits<qint64>::max();
+    }
+    quint64 width = quint64(1) << (msb - 2);
+    return qint64((SubBuckets + sub) * width + width - 1);
+}
\ No newline at end of file
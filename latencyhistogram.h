@@ -0,0 +1,44 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+#include <QString>
+#include <QJsonObject>
+#include <array>
+
+// Log-linear histogram (4 sub-buckets per power of two, ~19% resolution)
+// for latency samples. Recording is O(1) and allocation free.
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void record(qint64 value);
+    void merge(const LatencyHistogram &other);
+    void reset();
+
+    quint64 count() const;
+    qint64 min() const;
+    qint64 max() const;
+    double mean() const;
+    // Upper bound of the bucket holding the given percentile (0-100)
+    qint64 percentile(double p) const;
+
+    // unit is only used for labels, e.g. "us" or "ms"
+    QString summary(const QString &unit) const;
+    QJsonObject toJson() const;
+
+private:
+    static constexpr int SubBuckets = 4;
+    static constexpr int BucketCount = 64 * SubBuckets;
+
+    static int bucketFor(quint64 value);
+    static qint64 bucketUpperBound(int bucket);
+
+    std::array<quint64, BucketCount> buckets;
+    quint64 samples;
+    qint64 minValue;
+    qint64 maxValue;
+    double sum;
+};
+
+#endif // LATENCYHISTOGRAM_H
\ No newline at end of file
@@ -0,0 +1,212 @@
+#ifndef LOCKFREEQUEUE_H
+#define LOCKFREEQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+// Bounded multi-producer/multi-consumer queue (Vyukov's sequence-per-cell
+// ring). push/pop never block or allocate; a full queue rejects the push.
+// Capacity is rounded up to a power of two.
+template <typename T>
+class BoundedMpmcQueue
+{
+public:
+    explicit BoundedMpmcQueue(size_t capacity)
+        : mask(roundUp(capacity) - 1), cells(new Cell[mask + 1]), head(0), tail(0)
+    {
+        for (size_t i = 0; i <= mask; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedMpmcQueue(const BoundedMpmcQueue &) = delete;
+    BoundedMpmcQueue &operator=(const BoundedMpmcQueue &) = delete;
+
+    template <typename U>
+    bool tryPush(U &&value)
+    {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos);
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;   // full
+            } else {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::forward<U>(value);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T &value)
+    {
+        size_t pos = head.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            size_t seq = cell->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t diff = std::ptrdiff_t(seq) - std::ptrdiff_t(pos + 1);
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;   // empty
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+        value = std::move(cell->value);
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+    // Approximate; exact only while no other thread is pushing or popping
+    size_t sizeApprox() const
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_relaxed);
+        return t >= h ? t - h : 0;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    static size_t roundUp(size_t n)
+    {
+        size_t p = 2;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    const size_t mask;
+    std::unique_ptr<Cell[]> cells;
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+};
+
+// Bounded single-producer/single-consumer ring. Cheaper than the MPMC queue:
+// each side owns one index and caches the other's, so the common case is a
+// plain store plus one release. Capacity is rounded up to a power of two.
+template <typename T>
+class SpscRing
+{
+public:
+    explicit SpscRing(size_t capacity)
+        : mask(roundUp(capacity) - 1), cells(new T[mask + 1]), head(0), cachedTail(0),
+          tail(0), cachedHead(0)
+    {
+    }
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    // Producer side. The slot is written in place; call commit() to publish it.
+    T *reserve()
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead > mask) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead > mask) {
+                return nullptr;   // full
+            }
+        }
+        return &cells[t & mask];
+    }
+
+    void commit()
+    {
+        tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    template <typename U>
+    bool tryPush(U &&value)
+    {
+        T *slot = reserve();
+        if (!slot) {
+            return false;
+        }
+        *slot = std::forward<U>(value);
+        commit();
+        return true;
+    }
+
+    // Consumer side
+    bool tryPop(T &value)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h == cachedTail) {
+                return false;   // empty
+            }
+        }
+        value = std::move(cells[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side, in place: the oldest slot (null if empty); release() frees it
+    T *front()
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h == cachedTail) {
+                return nullptr;
+            }
+        }
+        return &cells[h & mask];
+    }
+
+    void release()
+    {
+        head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    size_t capacity() const { return mask + 1; }
+
+    size_t sizeApprox() const
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_relaxed);
+        return t >= h ? t - h : 0;
+    }
+
+private:
+    static size_t roundUp(size_t n)
+    {
+        size_t p = 2;
+        while (p < n) {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    const size_t mask;
+    std::unique_ptr<T[]> cells;
+    alignas(64) std::atomic<size_t> head;   // consumer
+    size_t cachedTail;                      // consumer's copy of tail
+    alignas(64) std::atomic<size_t> tail;   // producer
+    size_t cachedHead;                      // producer's copy of head
+};
+
+#endif // LOCKFREEQUEUE_H
\ No newline at end of file
@@ -1,12 +1,202 @@
 #include <QApplication>
+#include <QCoreApplication>
+#include <QFile>
+#include <QPointer>
+#include <QTextStream>
+#include <QVector>
+#include <functional>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include "mainwindow.h"
+#include "headlessdriver.h"
+#include "startupprofiler.h"
+#include "phonelog.h"
+#include "tracing.h"
+#include "allocationtracker.h"
 
-int main(int argc, char *argv[])
+namespace {
+
+struct LaunchOptions
+{
+    bool headless = false;
+    bool echo = false;
+    const char *scriptPath = nullptr;
+    const char *recordPath = nullptr;
+    const char *replayPath = nullptr;
+    const char *tracePath = nullptr;
+    ReplayEngine::Speed replaySpeed = ReplayEngine::Speed::RealTime;
+    const char *replayPassword = Smartphone::DefaultPassword;
+    int logCapacity = 0;    // 0 = model default
+    bool showHud = false;
+    int stallThresholdMs = 0;
+    bool allocationProfile = false;
+    int phones = 1;         // windows opened at launch
+};
+
+LogEntry::Level parseLogLevel(const char *name)
+{
+    if (std::strcmp(name, "info") == 0) {
+        return LogEntry::Info;
+    } else if (std::strcmp(name, "warning") == 0) {
+        return LogEntry::Warning;
+    } else if (std::strcmp(name, "error") == 0) {
+        return LogEntry::Error;
+    }
+    return LogEntry::Debug;
+}
+
+LaunchOptions parseOptions(int argc, char *argv[])
+{
+    LaunchOptions options;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--profile-startup") == 0) {
+            StartupProfiler::setEnabled(true);
+        } else if (std::strcmp(argv[i], "--headless") == 0) {
+            options.headless = true;
+        } else if (std::strcmp(argv[i], "--echo") == 0) {
+            options.echo = true;
+        } else if (std::strcmp(argv[i], "--script") == 0 && i + 1 < argc) {
+            options.scriptPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--record-trace") == 0 && i + 1 < argc) {
+            options.recordPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--replay-trace") == 0 && i + 1 < argc) {
+            options.replayPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--replay-speed") == 0 && i + 1 < argc) {
+            options.replaySpeed = std::strcmp(argv[++i], "max") == 0 ? ReplayEngine::Speed::MaxSpeed
+                                                                      : ReplayEngine::Speed::RealTime;
+        } else if (std::strcmp(argv[i], "--replay-password") == 0 && i + 1 < argc) {
+            options.replayPassword = argv[++i];
+        } else if (std::strcmp(argv[i], "--log-capacity") == 0 && i + 1 < argc) {
+            options.logCapacity = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--log-level") == 0 && i + 1 < argc) {
+            PhoneLog::setLevel(parseLogLevel(argv[++i]));
+        } else if (std::strcmp(argv[i], "--log-file") == 0 && i + 1 < argc) {
+            PhoneLog::setLogFile(QString::fromLocal8Bit(argv[++i]));
+        } else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            options.tracePath = argv[++i];
+            Tracer::setEnabled(true);
+        } else if (std::strcmp(argv[i], "--hud") == 0) {
+            options.showHud = true;
+        } else if (std::strcmp(argv[i], "--stall-threshold") == 0 && i + 1 < argc) {
+            options.stallThresholdMs = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--alloc-profile") == 0) {
+            options.allocationProfile = true;
+            AllocationTracker::setEnabled(true);
+        } else if (std::strcmp(argv[i], "--phones") == 0 && i + 1 < argc) {
+            options.phones = qMax(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--quiet") == 0) {
+            PhoneLog::setConsoleOutput(false);
+        }
+    }
+    return options;
+}
+
+// No widgets and no platform plugin: commands come from a script or stdin
+int runHeadless(int argc, char *argv[], const LaunchOptions &options)
+{
+    QCoreApplication app(argc, argv);
+    StartupProfiler::mark("QCoreApplication");
+    
+    Smartphone phone;
+    HeadlessDriver driver(&phone);
+    driver.setEcho(options.echo);
+    driver.setReplayPassword(QString::fromLocal8Bit(options.replayPassword));
+    StartupProfiler::mark("Smartphone");
+    
+    QTextStream output(stdout);
+    if (StartupProfiler::isEnabled()) {
+        output << StartupProfiler::report() << "\n";
+    }
+    
+    QFile script;
+    if (options.scriptPath) {
+        script.setFileName(QString::fromLocal8Bit(options.scriptPath));
+        if (!script.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            output << "❌ Cannot open script: " << script.fileName() << "\n";
+            return 2;
+        }
+    } else {
+        script.open(stdin, QIODevice::ReadOnly | QIODevice::Text);
+    }
+    
+    QTextStream input(&script);
+    if (options.replayPath) {
+        driver.execute(QString("replay ") + QString::fromLocal8Bit(options.replayPath), output);
+    }
+    int failures = driver.run(input, output);
+    driver.printStats(output);
+    return failures == 0 ? 0 : 1;
+}
+
+int runGui(int argc, char *argv[], const LaunchOptions &options)
 {
     QApplication app(argc, argv);
+    StartupProfiler::mark("QApplication");
+    
+    // Every window is one phone; they share the process's stylesheet, worker
+    // pools and logger, so each added phone costs only its own state
+    QVector<QPointer<MainWindow>> windows;
+    std::function<MainWindow *()> openPhone = [&]() {
+        const qint64 residentBefore = PerfMonitor::residentMemoryBytes();
+        MainWindow *window = new MainWindow(int(windows.size()) + 1);
+        window->setAttribute(Qt::WA_DeleteOnClose);
+        if (options.logCapacity > 0) {
+            window->activityLogModel()->setCapacity(options.logCapacity);
+        }
+        if (options.stallThresholdMs > 0) {
+            window->performanceMonitor()->setStallThreshold(options.stallThresholdMs);
+        }
+        window->setPerformanceHudVisible(options.showHud);
+        QObject::connect(window, &MainWindow::newPhoneRequested, &app, [&openPhone]() { openPhone(); });
+        window->show();
+        windows.append(window);
+        if (windows.size() > 1) {
+            PHONE_LOG_INFO("app", "Phone %1 opened, %2 KB more resident memory", window->phoneNumber(),
+                           (PerfMonitor::residentMemoryBytes() - residentBefore) / 1024);
+        }
+        return window;
+    };
+    
+    MainWindow *first = openPhone();
+    StartupProfiler::mark("MainWindow::show");
+    for (int i = 1; i < options.phones; ++i) {
+        openPhone();
+    }
     
-    MainWindow window;
-    window.show();
+    if (options.recordPath) {
+        first->startRecording(QString::fromLocal8Bit(options.recordPath));
+    }
+    if (options.replayPath) {
+        InteractionTrace trace;
+        if (trace.load(QString::fromLocal8Bit(options.replayPath))) {
+            first->startReplay(trace, options.replaySpeed, QString::fromLocal8Bit(options.replayPassword));
+        }
+    }
+    
+    int result = app.exec();
+    // Closed windows are gone already; the rest save their sessions here
+    for (const QPointer<MainWindow> &window : windows) {
+        delete window.data();
+    }
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    LaunchOptions options = parseOptions(argc, argv);
+    StartupProfiler::mark("static init");
     
-    return app.exec();
+    Tracer::setThreadName("main");
+    int result = options.headless ? runHeadless(argc, argv, options) : runGui(argc, argv, options);
+    PhoneLog::shutdown();
+    if (options.tracePath && !Tracer::exportChromeTrace(QString::fromLocal8Bit(options.tracePath))) {
+        std::fprintf(stderr, "❌ Cannot write trace: %s\n", options.tracePath);
+    }
+    if (options.allocationProfile) {
+        std::fprintf(stderr, "%s\n", AllocationTracker::report().toLocal8Bit().constData());
+    }
+    return result;
 }
\ No newline at end of file
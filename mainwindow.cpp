@@ -6,25 +6,183 @@
 #include <QFileDialog>
 #include <QFileInfo>
 #include <QDir>
+#include <QEvent>
+#include <QTimer>
+#include <QStandardPaths>
+#include <QStyle>
+#include <QScrollBar>
+#include <QAction>
+#include <QElapsedTimer>
+#include "startupprofiler.h"
+#include "phonesnapshot.h"
+#include "tracing.h"
+#include "allocationtracker.h"
+#include "perfhud.h"
+#include "workstealingexecutor.h"
+#include "frameanalyzer.h"
+#include "scratcharena.h"
+#include <QPair>
+#include <QApplication>
+#include <algorithm>
+#include <iterator>
 
-MainWindow::MainWindow(QWidget *parent)
-    : QMainWindow(parent)
+namespace {
+
+// Installed on the application once, so every phone window shares the parsed
+// rules; state changes flip dynamic properties instead of replacing stylesheets
+const char *const PhoneStyleSheet =
+    "QLabel#phoneStateLabel { font-size: 14px; font-weight: bold; }"
+    "QLabel#phoneStateLabel[locked=\"true\"] { color: red; }"
+    "QLabel#phoneStateLabel[locked=\"false\"] { color: green; }"
+    "QLabel#cameraStatusLabel { font-size: 12px; color: #0066cc; }"
+    "QLabel#cameraStatusLabel[available=\"false\"] { color: red; }"
+    "QLabel#batteryStatusLabel { font-size: 12px; }"
+    "QLabel#batteryStatusLabel[low=\"true\"] { color: red; }"
+    "QLabel#musicStatusLabel { font-size: 12px; }"
+    "QLabel#musicStatusLabel[musicState=\"playing\"] { color: #006600; font-weight: bold; }"
+    "QLabel#musicStatusLabel[musicState=\"loaded\"] { color: #0066cc; }"
+    "QLabel#musicStatusLabel[musicState=\"none\"] { color: #666666; }"
+    "QLabel#photoPreviewLabel { background-color: #f0f0f0; padding: 10px; border: 1px solid #ccc;"
+    " font-size: 11px; color: #000000; font-weight: bold; }"
+    "QListView#logView { background-color: #f0f0f0; font-family: Courier; color: #000; }"
+    "QLabel#infoLabel { font-size: 11px; }";
+
+// Activity log sources; literals, so logging them never allocates
+const QString SessionSource = QStringLiteral("session");
+const QString TraceSource = QStringLiteral("trace");
+const QString ClockSource = QStringLiteral("clock");
+const QString CameraSource = QStringLiteral("camera");
+const QString MusicSource = QStringLiteral("music");
+const QString SecuritySource = QStringLiteral("security");
+const QString StorageSource = QStringLiteral("storage");
+const QString RecorderSource = QStringLiteral("recorder");
+
+// Code scanning keeps up with the viewfinder on two cores
+constexpr int ScanThreads = 2;
+
+constexpr int SearchResultLimit = 50;
+
+// The battery label turns red at or below this
+constexpr int LowBatteryPercent = 20;
+
+QString searchIcon(SearchIndex::Kind kind)
+{
+    switch (kind) {
+    case SearchIndex::Kind::Photo: return QStringLiteral("📷");
+    case SearchIndex::Kind::Track: return QStringLiteral("🎵");
+    default:                       return QStringLiteral("📝");
+    }
+}
+
+} // namespace
+
+MainWindow::MainWindow(int phoneNumber, QWidget *parent)
+    : QMainWindow(parent), number(phoneNumber), phone(nullptr), firstFramePresented(false), replayEngine(nullptr),
+      viewModel(new PhoneViewModel(this)), uiWidgetUpdates(0), uiFrames(0),
+      activityLog(new ActivityLogModel(ActivityLogModel::DefaultCapacity, this)), logFollowTail(true),
+      logSink(-1), perfMonitor(new PerfMonitor(this)), perfHud(nullptr), perfHudRequested(false),
+      photoIndexBytes(0), memoRecording(false), scanningCodes(false)
 {
     myPhone = new Smartphone();
+    StartupProfiler::mark("Smartphone");
     
-    setWindowTitle("Smartphone Simulator - Multiple Inheritance & Encapsulation");
-    setGeometry(100, 100, 800, 700);
+    QString title = "Smartphone Simulator - Multiple Inheritance & Encapsulation";
+    if (number > 1) {
+        title += QString(" - Phone %1").arg(number);
+    }
+    setWindowTitle(title);
+    // Later phones cascade so none hides another
+    const int offset = 30 * ((number - 1) % 10);
+    setGeometry(100 + offset, 100 + offset, 800, 700);
     
+    installStyleSheet();
     setupUI();
+    StartupProfiler::mark("MainWindow::setupUI");
     createConnections();
-    updateUI();
+    connect(viewModel, &PhoneViewModel::changed, this, &MainWindow::applyViewModel);
+    myPhone->eventBus()->subscribe(AllPhoneEvents, this, [this](const QVector<PhoneEvent> &events) {
+        onPhoneEvents(events);
+    });
+    // Called on the logger's writer thread; the model batches it onto ours.
+    // Entries from other phones' threads belong to their windows.
+    logSink = PhoneLog::addSink([this](const QVector<LogEntry> &batch) {
+        auto foreign = [this](const LogEntry &entry) { return entry.origin != 0 && entry.origin != number; };
+        if (std::none_of(batch.cbegin(), batch.cend(), foreign)) {
+            activityLog->append(batch);
+            myPhone->indexActivity(batch);
+            return;
+        }
+        QVector<LogEntry> own;
+        own.reserve(batch.size());
+        std::remove_copy_if(batch.cbegin(), batch.cend(), std::back_inserter(own), foreign);
+        activityLog->append(own);
+        myPhone->indexActivity(own);
+    });
+    
+    // Resume the previous session, if any
+    PhoneSnapshot session(sessionSnapshotPath());
+    if (session.isValid() && session.restore(0, *myPhone)) {
+        log(LogEntry::Info, SessionSource, QStringLiteral("↺ Previous session restored"));
+    }
+    // Written as it changes, so it is newer than the snapshot after a crash
+    myPhone->openStateStore(stateStorePath());
+    StartupProfiler::mark("session restore");
+    updateUI(PhoneViewModel::capture(*myPhone));
+    StartupProfiler::mark("MainWindow::updateUI");
+    
+    // From here on the phone lives on its own thread; slots only queue work
+    phone = new AsyncPhone(myPhone, this);
+    const quint16 origin = quint16(number);
+    phone->run([origin](Smartphone &) { PhoneLog::setThreadOrigin(origin); });
+    
+    QAction *newPhone = new QAction("New Phone", this);
+    newPhone->setShortcut(QKeySequence::New);
+    connect(newPhone, &QAction::triggered, this, &MainWindow::newPhoneRequested);
+    addAction(newPhone);
+    
+    // Off until asked for; the phone remembers it when it has a state store
+    QAction *backupPhotos = new QAction("Back Up Photos", this);
+    backupPhotos->setCheckable(true);
+    backupPhotos->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_B));
+    phone->run([](Smartphone &p) { return p.isPhotoBackupEnabled(); })
+        .then(this, [backupPhotos](bool enabled) { backupPhotos->setChecked(enabled); });
+    connect(backupPhotos, &QAction::triggered, this, [this](bool enabled) {
+        phone->run([enabled](Smartphone &p) { p.setPhotoBackupEnabled(enabled); });
+    });
+    addAction(backupPhotos);
 }
 
 MainWindow::~MainWindow()
 {
+    if (recorder.isRecording() && !recordingPath.isEmpty()) {
+        recorder.trace().save(recordingPath);
+        PHONE_LOG_INFO("trace", "Interaction trace saved: %1 entries", recorder.trace().size());
+    }
+    
+    // Drain pending operations and take the phone back before touching it directly
+    phone->shutdown();
+    QString snapshotPath = sessionSnapshotPath();
+    QDir().mkpath(QFileInfo(snapshotPath).absolutePath());
+    PhoneSnapshot::save(snapshotPath, *myPhone);
+    // The sink indexes into the phone; once removed it is no longer running
+    PhoneLog::removeSink(logSink);
     delete myPhone;
 }
 
+int MainWindow::phoneNumber() const
+{
+    return number;
+}
+
+void MainWindow::installStyleSheet()
+{
+    static bool installed = false;
+    if (!installed) {
+        qApp->setStyleSheet(PhoneStyleSheet);
+        installed = true;
+    }
+}
+
 void MainWindow::setupUI()
 {
     QWidget *centralWidget = new QWidget(this);
@@ -34,14 +192,36 @@ void MainWindow::setupUI()
     mainLayout->setSpacing(10);
     mainLayout->setContentsMargins(15, 15, 15, 15);
     
+    // Global search over photos, music and the activity log
+    searchInput = new QLineEdit(this);
+    searchInput->setPlaceholderText("🔍 Search photos, music and activity");
+    searchInput->setClearButtonEnabled(true);
+    searchInput->setEnabled(false);
+    mainLayout->addWidget(searchInput);
+    
+    searchStatusLabel = new QLabel(this);
+    searchStatusLabel->hide();
+    mainLayout->addWidget(searchStatusLabel);
+    
+    searchResults = new QListWidget(this);
+    searchResults->setMaximumHeight(140);
+    searchResults->hide();
+    mainLayout->addWidget(searchResults);
+    
     // Phone Status Section
     QGroupBox *statusGroup = new QGroupBox("Phone Status", this);
     QVBoxLayout *statusLayout = new QVBoxLayout(statusGroup);
     
     phoneStateLabel = new QLabel("Status: 🔒 LOCKED", this);
-    phoneStateLabel->setStyleSheet("font-size: 14px; font-weight: bold; color: red;");
+    phoneStateLabel->setObjectName("phoneStateLabel");
+    phoneStateLabel->setProperty("locked", true);
     statusLayout->addWidget(phoneStateLabel);
     
+    batteryStatusLabel = new QLabel("🔋 Battery: 100%", this);
+    batteryStatusLabel->setObjectName("batteryStatusLabel");
+    batteryStatusLabel->setProperty("low", false);
+    statusLayout->addWidget(batteryStatusLabel);
+    
     mainLayout->addWidget(statusGroup);
     
     // Lock/Unlock Section
@@ -86,14 +266,19 @@ void MainWindow::setupUI()
     QVBoxLayout *cameraLayout = new QVBoxLayout(cameraGroup);
     
     cameraStatusLabel = new QLabel("📹 Camera: Available", this);
-    cameraStatusLabel->setStyleSheet("font-size: 12px; color: #0066cc;");
+    cameraStatusLabel->setObjectName("cameraStatusLabel");
+    cameraStatusLabel->setProperty("available", true);
     cameraLayout->addWidget(cameraStatusLabel);
     
     photoPreviewLabel = new QLabel("No photo taken yet", this);
-    photoPreviewLabel->setStyleSheet("background-color: #f0f0f0; padding: 10px; border: 1px solid #ccc; font-size: 11px; color: #000000; font-weight: bold;");
+    photoPreviewLabel->setObjectName("photoPreviewLabel");
     photoPreviewLabel->setMinimumHeight(40);
     cameraLayout->addWidget(photoPreviewLabel);
     
+    scanCodesButton = new QPushButton("🔳 Scan Codes", this);
+    scanCodesButton->setEnabled(false);
+    cameraLayout->addWidget(scanCodesButton);
+    
     mainLayout->addWidget(cameraGroup);
     
     // Music Player Section
@@ -101,15 +286,19 @@ void MainWindow::setupUI()
     QVBoxLayout *musicLayout = new QVBoxLayout(musicGroup);
     
     musicStatusLabel = new QLabel("🎵 No music loaded", this);
-    musicStatusLabel->setStyleSheet("font-size: 12px; color: #006600;");
+    musicStatusLabel->setObjectName("musicStatusLabel");
+    musicStatusLabel->setProperty("musicState", "none");
     musicLayout->addWidget(musicStatusLabel);
     
     QHBoxLayout *musicButtonLayout = new QHBoxLayout();
     loadMusicButton = new QPushButton("📁 Load MP3 File", this);
     stopMusicButton = new QPushButton("⏹️ Stop Music", this);
     stopMusicButton->setEnabled(false);
+    recordMemoButton = new QPushButton("🎙️ Record Memo", this);
+    recordMemoButton->setEnabled(false);
     musicButtonLayout->addWidget(loadMusicButton);
     musicButtonLayout->addWidget(stopMusicButton);
+    musicButtonLayout->addWidget(recordMemoButton);
     musicLayout->addLayout(musicButtonLayout);
     
     mainLayout->addWidget(musicGroup);
@@ -118,14 +307,64 @@ void MainWindow::setupUI()
     QGroupBox *logGroup = new QGroupBox("Activity Log", this);
     QVBoxLayout *logLayout = new QVBoxLayout(logGroup);
     
-    outputLog = new QTextEdit(this);
-    outputLog->setReadOnly(true);
-    outputLog->setMaximumHeight(120);
-    outputLog->setMinimumHeight(80);
-    outputLog->setStyleSheet("background-color: #f0f0f0; font-family: Courier; color: #000;");
-    logLayout->addWidget(outputLog);
+    QHBoxLayout *logFilterLayout = new QHBoxLayout();
+    logLevelFilter = new QComboBox(this);
+    logLevelFilter->addItem("All levels", QVariant::fromValue(AllLogLevels));
+    logLevelFilter->addItem("Info and above", QVariant::fromValue(AllLogLevels & ~levelBit(LogEntry::Debug)));
+    logLevelFilter->addItem("Warnings and errors", QVariant::fromValue(levelBit(LogEntry::Warning) | levelBit(LogEntry::Error)));
+    logLevelFilter->addItem("Errors only", QVariant::fromValue(levelBit(LogEntry::Error)));
+    logSourceFilter = new QComboBox(this);
+    logSourceFilter->addItem("All sources", QString());
+    logFilterLayout->addWidget(new QLabel("Show:", this));
+    logFilterLayout->addWidget(logLevelFilter);
+    logFilterLayout->addWidget(logSourceFilter);
+    logFilterLayout->addStretch();
+    logLayout->addLayout(logFilterLayout);
+    
+    // Only the visible rows are ever formatted or laid out
+    logView = new QListView(this);
+    logView->setModel(activityLog);
+    logView->setUniformItemSizes(true);
+    logView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    logView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    logView->setMaximumHeight(120);
+    logView->setMinimumHeight(80);
+    logView->setObjectName("logView");
+    logLayout->addWidget(logView);
     
     mainLayout->addWidget(logGroup);
+    mainLayout->addStretch();
+}
+
+bool MainWindow::event(QEvent *event)
+{
+    // The top-level UpdateRequest is the whole frame: layout plus painting every widget
+    const bool isFrame = event->type() == QEvent::UpdateRequest;
+    QElapsedTimer frameTimer;
+    if (isFrame) {
+        frameTimer.start();
+    }
+    bool handled = QMainWindow::event(event);
+    if (isFrame) {
+        perfMonitor->recordFrame(frameTimer.nsecsElapsed());
+    }
+    
+    // The top-level UpdateRequest paints the whole widget tree into the backing store
+    if (!firstFramePresented && event->type() == QEvent::UpdateRequest) {
+        firstFramePresented = true;
+        StartupProfiler::finishFirstFrame();
+        QTimer::singleShot(0, this, &MainWindow::setupDeferredUI);
+    }
+    return handled;
+}
+
+// Sections that are not needed for the first frame are built once it is on screen
+void MainWindow::setupDeferredUI()
+{
+    QVBoxLayout *mainLayout = qobject_cast<QVBoxLayout *>(centralWidget()->layout());
+    if (!mainLayout) {
+        return;
+    }
     
     // Info Section
     QGroupBox *infoGroup = new QGroupBox("About This Program", this);
@@ -139,11 +378,88 @@ void MainWindow::setupUI()
         "Default Password: 1234", this);
     infoLabel->setFont(QFont("Default", 11));
     infoLabel->setPalette(palette());
-    infoLabel->setStyleSheet("font-size: 11px;");
+    infoLabel->setObjectName("infoLabel");
     infoLayout->addWidget(infoLabel);
     
-    mainLayout->addWidget(infoGroup);
-    mainLayout->addStretch();
+    // Keep the trailing stretch last
+    mainLayout->insertWidget(mainLayout->count() - 1, infoGroup);
+    
+    setupPerformanceHud();
+}
+
+void MainWindow::setupPerformanceHud()
+{
+    // Phone-side values are sampled on the phone's thread and shown one refresh late
+    perfMonitor->addMemorySource("photo index", [this]() {
+        phone->run([](Smartphone &p) {
+            return qint64(p.getPhotoIndex().capacity() * sizeof(PhotoRecord));
+        }).then(this, [this](qint64 bytes) { photoIndexBytes = bytes; });
+        return photoIndexBytes;
+    });
+    perfMonitor->addMemorySource("activity log", [this]() { return activityLog->memoryUsage(); });
+    perfMonitor->addMemorySource("trace buffers", []() { return Tracer::memoryUsage(); });
+    perfMonitor->addGauge("Worker pool", []() {
+        WorkStealingExecutor &pool = WorkStealingExecutor::shared();
+        return QString("%1 queued on %2 threads, %3 steals")
+            .arg(pool.queueDepth()).arg(pool.threadCount()).arg(pool.stealCount());
+    });
+    perfMonitor->addGauge("Shared", []() {
+        auto pools = FrameAnalyzer::poolStats();
+        auto watchdogs = PerfMonitor::watchdogStats();
+        return QString("%1 analysis pools serving %2 phones, %3 reuses; %4 stall watchdog(s) for %5 windows")
+            .arg(pools.entries).arg(pools.holders).arg(pools.hits).arg(watchdogs.entries).arg(watchdogs.holders);
+    });
+    perfMonitor->addGauge("Log", [this]() {
+        return QString("%1/%2 entries, %3 dropped by logger")
+            .arg(activityLog->storedCount()).arg(activityLog->capacity()).arg(PhoneLog::droppedCount());
+    });
+    perfMonitor->addGauge("Phone queue", [this]() {
+        return QString("%1 in flight (peak %2), %3 done, %4 canceled")
+            .arg(phone->inFlight()).arg(phone->peakInFlight())
+            .arg(phone->completedCount()).arg(phone->canceledCount());
+    });
+    perfMonitor->addGauge("Media", [this]() {
+        phone->run([](Smartphone &p) { return p.backendState(); })
+            .then(this, [this](const QString &state) { mediaBackendState = state; });
+        return mediaBackendState;
+    });
+    perfMonitor->addGauge("Network", [this]() {
+        phone->run([](Smartphone &p) { return p.networkState(); })
+            .then(this, [this](const QString &state) { networkState = state; });
+        return networkState;
+    });
+    perfMonitor->addGauge("Backup", [this]() {
+        phone->run([](Smartphone &p) { return p.photoBackupState(); })
+            .then(this, [this](const QString &state) { backupState = state; });
+        return backupState;
+    });
+    perfMonitor->start();
+    
+    perfHud = new PerfHud(perfMonitor, this);
+    addDockWidget(Qt::RightDockWidgetArea, perfHud);
+    perfHud->setVisible(perfHudRequested);
+    
+    QAction *toggleHud = perfHud->toggleViewAction();
+    toggleHud->setShortcut(Qt::Key_F12);
+    addAction(toggleHud);
+}
+
+PerfMonitor *MainWindow::performanceMonitor() const
+{
+    return perfMonitor;
+}
+
+AsyncPhone *MainWindow::asyncPhone() const
+{
+    return phone;
+}
+
+void MainWindow::setPerformanceHudVisible(bool visible)
+{
+    perfHudRequested = visible;
+    if (perfHud) {
+        perfHud->setVisible(visible);
+    }
 }
 
 void MainWindow::createConnections()
@@ -155,111 +471,329 @@ void MainWindow::createConnections()
     connect(getStorageButton, &QPushButton::clicked, this, &MainWindow::onGetStorageClicked);
     connect(loadMusicButton, &QPushButton::clicked, this, &MainWindow::onLoadMusicClicked);
     connect(stopMusicButton, &QPushButton::clicked, this, &MainWindow::onStopMusicClicked);
+    connect(recordMemoButton, &QPushButton::clicked, this, &MainWindow::onRecordMemoClicked);
+    connect(scanCodesButton, &QPushButton::clicked, this, &MainWindow::onScanCodesClicked);
+    connect(searchInput, &QLineEdit::textChanged, this, &MainWindow::onSearchTextChanged);
+    
+    connect(logLevelFilter, &QComboBox::currentIndexChanged, this, &MainWindow::applyLogFilter);
+    connect(logSourceFilter, &QComboBox::currentIndexChanged, this, &MainWindow::applyLogFilter);
+    connect(activityLog, &ActivityLogModel::sourceAdded, this, [this](const QString &source) {
+        logSourceFilter->addItem(source, source);
+    });
+    // Follow the tail only while the user is looking at it
+    connect(activityLog, &QAbstractItemModel::rowsAboutToBeInserted, this, [this]() {
+        QScrollBar *bar = logView->verticalScrollBar();
+        logFollowTail = bar->value() == bar->maximum();
+    });
+    connect(activityLog, &QAbstractItemModel::rowsInserted, this, [this]() {
+        if (logFollowTail) {
+            logView->scrollToBottom();
+        }
+    });
+}
+
+void MainWindow::startRecording(const QString &tracePath)
+{
+    recordingPath = tracePath;
+    recorder.start();
+    log(LogEntry::Info, TraceSource, u"⏺ Recording interactions to ", tracePath);
+}
+
+void MainWindow::startReplay(const InteractionTrace &trace, ReplayEngine::Speed speed, const QString &password)
+{
+    replayPassword = password;
+    if (!replayEngine) {
+        replayEngine = new ReplayEngine([this](const Interaction &interaction, qint64) {
+            dispatchInteraction(interaction);
+        }, this);
+        connect(replayEngine, &ReplayEngine::finished, this, [this](int replayed, qint64 elapsedNs) {
+            log(LogEntry::Info, TraceSource, QString("⏹ Replay finished: %1 interactions in %2 ms")
+                                           .arg(replayed).arg(elapsedNs / 1e6, 0, 'f', 1));
+        });
+    }
+    log(LogEntry::Info, TraceSource, QString("▶ Replaying %1 interactions").arg(trace.size()));
+    replayEngine->start(trace, speed);
+}
+
+// Replay goes through the same slots a click would
+void MainWindow::dispatchInteraction(const Interaction &interaction)
+{
+    switch (interaction.action) {
+    case Interaction::Unlock:
+        passwordInput->setText(ReplayEngine::unlockPassword(interaction, replayPassword));
+        onUnlockClicked();
+        break;
+    case Interaction::Lock:       onLockClicked(); break;
+    case Interaction::TakePhoto:  onTakePhotoClicked(); break;
+    case Interaction::PlayMusic:  onPlayMusicClicked(); break;
+    case Interaction::StopMusic:  onStopMusicClicked(); break;
+    case Interaction::LoadMusic:  loadMusicFromPath(interaction.argument); break;
+    case Interaction::GetStorage: onGetStorageClicked(); break;
+    case Interaction::VoiceMemo:
+        // A start while recording (or a stop while not) has nothing to toggle
+        if (interaction.argument.isEmpty() == memoRecording) {
+            onRecordMemoClicked();
+        }
+        break;
+    case Interaction::ScanCodes:
+        if (interaction.argument.isEmpty() == scanningCodes) {
+            onScanCodesClicked();
+        }
+        break;
+    case Interaction::ActionCount: break;
+    }
+}
+
+ActivityLogModel *MainWindow::activityLogModel() const
+{
+    return activityLog;
+}
+
+void MainWindow::log(LogEntry::Level level, const QString &source, const QString &message)
+{
+    activityLog->append(level, source, message);
+    myPhone->searchIndex()->add(SearchIndex::Kind::Activity, QDateTime::currentMSecsSinceEpoch(), message, source);
+}
+
+// The pieces are joined in scratch memory, so the message is the only allocation
+template <typename... Pieces>
+void MainWindow::log(LogEntry::Level level, const QString &source, const Pieces &...pieces)
+{
+    ScratchScope scratch;
+    ScratchString message;
+    (message << ... << pieces);
+    log(level, source, message.toString());
+}
+
+void MainWindow::applyLogFilter()
+{
+    activityLog->setFilter(logLevelFilter->currentData().value<LevelMask>(),
+                           logSourceFilter->currentData().toString());
+    logView->scrollToBottom();
+}
+
+// Phone 1 keeps the names a single-phone process always used
+QString MainWindow::sessionSnapshotPath() const
+{
+    QString name = number > 1 ? QString("/session-%1.snap").arg(number) : QString("/session.snap");
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + name;
+}
+
+QString MainWindow::stateStorePath() const
+{
+    QString name = number > 1 ? QString("/state-%1").arg(number) : QString("/state");
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + name;
+}
+
+// Phone state changes arrive here in batches; the UI is refreshed once per batch
+void MainWindow::onPhoneEvents(const QVector<PhoneEvent> &events)
+{
+    TRACE_SPAN("MainWindow::onPhoneEvents", "ui");
+    ALLOC_SCOPE("MainWindow::onPhoneEvents", "MainWindow");
+    // Only the view model is touched here; widgets follow once per frame
+    for (const PhoneEvent &event : events) {
+        viewModel->apply(event);
+        if (event.type == PhoneEvent::AlarmFired) {
+            log(LogEntry::Warning, ClockSource, u"⏰ Alarm: ", event.text);
+        } else if (event.type == PhoneEvent::CodeDetected) {
+            if (event.value > 0) {
+                log(LogEntry::Success, CameraSource, u"🔳 In view: ", event.text);
+            } else {
+                log(LogEntry::Info, CameraSource, QStringLiteral("🔳 No codes in view"));
+            }
+        } else if (event.type == PhoneEvent::EventsDropped) {
+            // Our queue overflowed, so state changes may be missing; read it all again
+            phone->run([](Smartphone &p) { return PhoneViewModel::capture(p); })
+                .then(this, [this](const PhoneViewModel::Snapshot &snapshot) { viewModel->syncFrom(snapshot); });
+        }
+    }
 }
 
 void MainWindow::onTakePhotoClicked()
 {
-    outputLog->append("→ Take Photo button clicked");
+    TRACE_SPAN("MainWindow::onTakePhotoClicked", "ui");
+    ALLOC_SCOPE("MainWindow::onTakePhotoClicked", "MainWindow");
+    recorder.record(Interaction::TakePhoto);
+    log(LogEntry::Info, CameraSource, QStringLiteral("→ Take Photo button clicked"));
     
     // Check if camera is available
-    if (!myPhone->isCameraAvailable()) {
-        outputLog->append("❌ No camera available on this device!");
-        cameraStatusLabel->setText("📹 Camera: NOT AVAILABLE");
-        cameraStatusLabel->setStyleSheet("font-size: 12px; color: red;");
+    if (!viewModel->isCameraAvailable()) {
+        log(LogEntry::Error, CameraSource, QStringLiteral("❌ No camera available on this device!"));
         return;
     }
     
-    // Take the photo
-    if (myPhone->takePhoto()) {
-        outputLog->append("✓ Photo taken successfully!");
-        QString photoPath = myPhone->getLastPhotoPath();
-        photoPreviewLabel->setText("📷 Last photo: " + photoPath);
-    } else {
-        outputLog->append("❌ Failed to take photo!");
-    }
-    
-    updateUI();
+    // Take the photo on the phone's thread; the result comes back to ours
+    phone->takePhoto().then(this, [this](bool taken) {
+        if (taken) {
+            log(LogEntry::Success, CameraSource, QStringLiteral("✓ Photo taken successfully!"));
+        } else {
+            log(LogEntry::Error, CameraSource, QStringLiteral("❌ Failed to take photo!"));
+        }
+    });
 }
 
 void MainWindow::onPlayMusicClicked()
 {
-    outputLog->append("→ Play Music button clicked");
-    if (myPhone->playMusic()) {
-        outputLog->append("✓ Music playing: " + myPhone->getCurrentSong());
-    } else {
-        outputLog->append("❌ No music file loaded. Load an MP3 file first!");
-    }
-    updateUI();
+    TRACE_SPAN("MainWindow::onPlayMusicClicked", "ui");
+    ALLOC_SCOPE("MainWindow::onPlayMusicClicked", "MainWindow");
+    recorder.record(Interaction::PlayMusic);
+    log(LogEntry::Info, MusicSource, QStringLiteral("→ Play Music button clicked"));
+    phone->run([](Smartphone &p) {
+        return p.playMusic() ? p.getCurrentSong() : QString();
+    }).then(this, [this](const QString &song) {
+        if (!song.isEmpty()) {
+            log(LogEntry::Success, MusicSource, u"✓ Music playing: ", song);
+        } else {
+            log(LogEntry::Error, MusicSource, QStringLiteral("❌ No music file loaded. Load an MP3 file first!"));
+        }
+    });
 }
 
 void MainWindow::onUnlockClicked()
 {
+    TRACE_SPAN("MainWindow::onUnlockClicked", "ui");
+    ALLOC_SCOPE("MainWindow::onUnlockClicked", "MainWindow");
     QString password = passwordInput->text();
     if (password.isEmpty()) {
-        outputLog->append("❌ Please enter a password!");
+        log(LogEntry::Error, SecuritySource, QStringLiteral("❌ Please enter a password!"));
         return;
     }
     
-    outputLog->append("→ Attempting to unlock with password: " + password);
-    bool success = myPhone->unlockPhone(password);
-    if (success) {
-        outputLog->append("✓ Phone unlocked successfully!");
-    } else {
-        outputLog->append("✗ Incorrect password!");
-    }
+    log(LogEntry::Info, SecuritySource, QStringLiteral("→ Attempting to unlock"));
+    // Recorded at the click so it keeps its place among later clicks; only
+    // the outcome is stored, never the password, and it starts as a failure
+    qint64 entry = recorder.record(Interaction::Unlock, QStringLiteral("0"));
+    phone->unlockPhone(password).then(this, [this, entry](bool success) {
+        if (success) {
+            recorder.setArgument(entry, QStringLiteral("1"));
+            log(LogEntry::Success, SecuritySource, QStringLiteral("✓ Phone unlocked successfully!"));
+        } else {
+            log(LogEntry::Error, SecuritySource, QStringLiteral("✗ Incorrect password!"));
+        }
+    });
     passwordInput->clear();
-    updateUI();
 }
 
 void MainWindow::onLockClicked()
 {
-    outputLog->append("→ Lock Phone button clicked");
-    myPhone->lockPhone();
-    updateUI();
+    TRACE_SPAN("MainWindow::onLockClicked", "ui");
+    ALLOC_SCOPE("MainWindow::onLockClicked", "MainWindow");
+    recorder.record(Interaction::Lock);
+    log(LogEntry::Info, SecuritySource, QStringLiteral("→ Lock Phone button clicked"));
+    phone->lockPhone();
 }
 
 void MainWindow::onGetStorageClicked()
 {
-    outputLog->append("→ Get Storage Info button clicked");
-    QString storageInfo = myPhone->getStorageInfo();
-    if (myPhone->isPhoneUnlocked()) {
-        outputLog->append("✓ Storage Info:\n" + storageInfo);
-    } else {
-        outputLog->append("✗ " + storageInfo);
+    TRACE_SPAN("MainWindow::onGetStorageClicked", "ui");
+    ALLOC_SCOPE("MainWindow::onGetStorageClicked", "MainWindow");
+    recorder.record(Interaction::GetStorage);
+    log(LogEntry::Info, StorageSource, QStringLiteral("→ Get Storage Info button clicked"));
+    phone->run([](Smartphone &p) {
+        return qMakePair(p.isPhoneUnlocked(), p.getStorageInfo());
+    }).then(this, [this](const QPair<bool, QString> &result) {
+        if (result.first) {
+            log(LogEntry::Success, StorageSource, u"✓ Storage Info:\n", result.second);
+        } else {
+            log(LogEntry::Error, StorageSource, u"✗ ", result.second);
+        }
+    });
+}
+
+// Full refresh from a snapshot of the phone; only used at startup
+void MainWindow::updateUI(const PhoneViewModel::Snapshot &snapshot)
+{
+    TRACE_SPAN("MainWindow::updateUI", "ui");
+    ALLOC_SCOPE("MainWindow::updateUI", "MainWindow");
+    viewModel->syncFrom(snapshot);
+    viewModel->takeDirty();
+    applyViewModel(PhoneViewModel::AllFields);
+}
+
+// Touches only the widgets behind the changed fields
+void MainWindow::applyViewModel(quint32 fields)
+{
+    TRACE_SPAN("MainWindow::applyViewModel", "ui");
+    ALLOC_SCOPE("MainWindow::applyViewModel", "MainWindow");
+    if (fields & PhoneViewModel::LockField) {
+        bool unlocked = viewModel->isUnlocked();
+        phoneStateLabel->setText(unlocked ? "Status: 🔓 UNLOCKED" : "Status: 🔒 LOCKED");
+        setStyleState(phoneStateLabel, "locked", !unlocked);
+        takePhotoButton->setEnabled(unlocked);
+        playMusicButton->setEnabled(unlocked);
+        getStorageButton->setEnabled(unlocked);
+        recordMemoButton->setEnabled(unlocked || memoRecording);
+        scanCodesButton->setEnabled(unlocked || scanningCodes);
+        // Locking hides whatever was found
+        searchInput->setEnabled(unlocked);
+        if (!unlocked) {
+            searchInput->clear();
+        }
+        uiWidgetUpdates += 7;
     }
-    updateUI();
-}
-
-void MainWindow::updateUI()
-{
-    if (myPhone->isPhoneUnlocked()) {
-        phoneStateLabel->setText("Status: 🔓 UNLOCKED");
-        phoneStateLabel->setStyleSheet("font-size: 14px; font-weight: bold; color: green;");
-        takePhotoButton->setEnabled(true);
-        playMusicButton->setEnabled(true);
-        getStorageButton->setEnabled(true);
-    } else {
-        phoneStateLabel->setText("Status: 🔒 LOCKED");
-        phoneStateLabel->setStyleSheet("font-size: 14px; font-weight: bold; color: red;");
-        takePhotoButton->setEnabled(false);
-        playMusicButton->setEnabled(false);
-        getStorageButton->setEnabled(false);
+    
+    if (fields & PhoneViewModel::MusicField) {
+        switch (viewModel->musicState()) {
+        case PhoneViewModel::MusicState::Playing:
+            musicStatusLabel->setText("🎵 Now playing: " + viewModel->song());
+            setStyleState(musicStatusLabel, "musicState", "playing");
+            stopMusicButton->setEnabled(true);
+            break;
+        case PhoneViewModel::MusicState::Loaded:
+            musicStatusLabel->setText("🎵 Loaded: " + viewModel->song());
+            setStyleState(musicStatusLabel, "musicState", "loaded");
+            stopMusicButton->setEnabled(true);
+            break;
+        case PhoneViewModel::MusicState::NoTrack:
+            musicStatusLabel->setText("🎵 No music loaded");
+            setStyleState(musicStatusLabel, "musicState", "none");
+            stopMusicButton->setEnabled(false);
+            break;
+        }
+        uiWidgetUpdates += 2;
+    }
+    
+    if ((fields & PhoneViewModel::LastPhotoField) && !viewModel->lastPhoto().isEmpty()) {
+        photoPreviewLabel->setText("📷 Last photo: " + viewModel->lastPhoto());
+        uiWidgetUpdates += 1;
     }
     
-    // Update music status
-    if (myPhone->isMusicPlaying()) {
-        musicStatusLabel->setText("🎵 Now playing: " + myPhone->getCurrentSong());
-        musicStatusLabel->setStyleSheet("font-size: 12px; color: #006600; font-weight: bold;");
-        stopMusicButton->setEnabled(true);
-    } else if (myPhone->getCurrentSong() != "None") {
-        musicStatusLabel->setText("🎵 Loaded: " + myPhone->getCurrentSong());
-        musicStatusLabel->setStyleSheet("font-size: 12px; color: #0066cc;");
-        stopMusicButton->setEnabled(true);
-    } else {
-        musicStatusLabel->setText("🎵 No music loaded");
-        musicStatusLabel->setStyleSheet("font-size: 12px; color: #666666;");
-        stopMusicButton->setEnabled(false);
+    if (fields & PhoneViewModel::CameraField) {
+        bool available = viewModel->isCameraAvailable();
+        cameraStatusLabel->setText(available ? "📹 Camera: Available" : "📹 Camera: NOT AVAILABLE");
+        setStyleState(cameraStatusLabel, "available", available);
+        uiWidgetUpdates += 1;
     }
+    
+    if (fields & PhoneViewModel::BatteryField) {
+        int percent = viewModel->batteryPercent();
+        batteryStatusLabel->setText(QString("🔋 Battery: %1%").arg(percent));
+        setStyleState(batteryStatusLabel, "low", percent <= LowBatteryPercent);
+        uiWidgetUpdates += 1;
+    }
+    
+    uiFrames++;
+}
+
+void MainWindow::setStyleState(QWidget *widget, const char *property, const QVariant &value)
+{
+    if (widget->property(property) == value) {
+        return;
+    }
+    // Re-polish just this widget instead of re-parsing a stylesheet
+    widget->setProperty(property, value);
+    widget->style()->unpolish(widget);
+    widget->style()->polish(widget);
+}
+
+quint64 MainWindow::uiUpdateCount() const
+{
+    return uiWidgetUpdates;
+}
+
+quint64 MainWindow::uiFrameCount() const
+{
+    return uiFrames;
 }
 
 void MainWindow::onLoadMusicClicked()
@@ -269,20 +803,129 @@ void MainWindow::onLoadMusicClicked()
         "Audio Files (*.mp3 *.wav *.flac *.ogg);;All Files (*)");
     
     if (!fileName.isEmpty()) {
-        outputLog->append("→ Loading audio file: " + QFileInfo(fileName).fileName());
-        if (myPhone->loadMusicFile(fileName)) {
-            outputLog->append("✓ Audio file loaded successfully!");
-            outputLog->append("  File: " + myPhone->getCurrentSong());
+        loadMusicFromPath(fileName);
+    }
+}
+
+void MainWindow::loadMusicFromPath(const QString &fileName)
+{
+    TRACE_SPAN("MainWindow::loadMusicFromPath", "ui");
+    ALLOC_SCOPE("MainWindow::loadMusicFromPath", "MainWindow");
+    recorder.record(Interaction::LoadMusic, fileName);
+    log(LogEntry::Info, MusicSource, u"→ Loading audio file: ", QFileInfo(fileName).fileName());
+    phone->run([fileName](Smartphone &p) {
+        return p.loadMusicFile(fileName) ? p.getCurrentSong() : QString();
+    }).then(this, [this](const QString &song) {
+        if (!song.isEmpty()) {
+            log(LogEntry::Success, MusicSource, QStringLiteral("✓ Audio file loaded successfully!"));
+            log(LogEntry::Success, MusicSource, u"  File: ", song);
         } else {
-            outputLog->append("❌ Failed to load audio file!");
+            log(LogEntry::Error, MusicSource, QStringLiteral("❌ Failed to load audio file!"));
         }
-        updateUI();
-    }
+    });
 }
 
 void MainWindow::onStopMusicClicked()
 {
-    outputLog->append("→ Stopping music");
-    myPhone->stopMusic();
-    updateUI();
+    TRACE_SPAN("MainWindow::onStopMusicClicked", "ui");
+    ALLOC_SCOPE("MainWindow::onStopMusicClicked", "MainWindow");
+    recorder.record(Interaction::StopMusic);
+    log(LogEntry::Info, MusicSource, QStringLiteral("→ Stopping music"));
+    phone->stopMusic();
+}
+
+// Toggles a voice memo; it is encoded to FLAC while it records
+void MainWindow::onRecordMemoClicked()
+{
+    TRACE_SPAN("MainWindow::onRecordMemoClicked", "ui");
+    ALLOC_SCOPE("MainWindow::onRecordMemoClicked", "MainWindow");
+    if (!memoRecording) {
+        recorder.record(Interaction::VoiceMemo, AudioEncoder::formatName(AudioEncoder::Format::Flac));
+        log(LogEntry::Info, RecorderSource, QStringLiteral("→ Record Memo button clicked"));
+        memoRecording = true;
+        recordMemoButton->setText("⏹️ Stop Memo");
+        phone->startVoiceMemo(AudioEncoder::Format::Flac).then(this, [this](bool started) {
+            if (!started) {
+                log(LogEntry::Error, RecorderSource, QStringLiteral("❌ Could not start recording!"));
+                memoRecording = false;
+                recordMemoButton->setText("🎙️ Record Memo");
+            }
+        });
+        return;
+    }
+    
+    recorder.record(Interaction::VoiceMemo);
+    log(LogEntry::Info, RecorderSource, QStringLiteral("→ Stopping memo"));
+    memoRecording = false;
+    recordMemoButton->setText("🎙️ Record Memo");
+    recordMemoButton->setEnabled(viewModel->isUnlocked());
+    phone->stopVoiceMemo().then(this, [this](const VoiceRecorder::Summary &memo) {
+        if (memo.ok) {
+            log(LogEntry::Success, RecorderSource, u"✓ Memo saved: ", memo.describe());
+        } else if (!memo.path.isEmpty()) {
+            log(LogEntry::Error, RecorderSource, u"❌ Memo incomplete: ", memo.path);
+        }
+    });
+}
+
+// Toggles the viewfinder; codes found in it are reported through the event bus
+void MainWindow::onScanCodesClicked()
+{
+    TRACE_SPAN("MainWindow::onScanCodesClicked", "ui");
+    ALLOC_SCOPE("MainWindow::onScanCodesClicked", "MainWindow");
+    if (!scanningCodes) {
+        recorder.record(Interaction::ScanCodes, QString::number(ScanThreads));
+        log(LogEntry::Info, CameraSource, QStringLiteral("→ Scan Codes button clicked"));
+        scanningCodes = true;
+        scanCodesButton->setText("⏹️ Stop Scanning");
+        phone->startViewfinder(ScanThreads).then(this, [this](bool started) {
+            if (!started) {
+                log(LogEntry::Error, CameraSource, QStringLiteral("❌ Could not open the viewfinder!"));
+                scanningCodes = false;
+                scanCodesButton->setText("🔳 Scan Codes");
+            }
+        });
+        return;
+    }
+    
+    recorder.record(Interaction::ScanCodes);
+    log(LogEntry::Info, CameraSource, QStringLiteral("→ Stopping scan"));
+    scanningCodes = false;
+    scanCodesButton->setText("🔳 Scan Codes");
+    scanCodesButton->setEnabled(viewModel->isUnlocked());
+    phone->run([](Smartphone &p) {
+        p.stopViewfinder();
+        return qMakePair(p.analyzedFrameCount(), p.frameAnalysisTimings().describe());
+    }).then(this, [this](const QPair<quint64, QString> &result) {
+        log(LogEntry::Info, CameraSource, u"  ", qint64(result.first), u" frames analysed; per frame: ", result.second);
+    });
+}
+
+// Runs on every keystroke. The index is thread-safe and answers in well
+// under a millisecond, so it is queried here rather than on the phone's thread.
+void MainWindow::onSearchTextChanged(const QString &text)
+{
+    TRACE_SPAN("MainWindow::onSearchTextChanged", "ui");
+    ALLOC_SCOPE("MainWindow::onSearchTextChanged", "MainWindow");
+    searchResults->clear();
+    if (text.trimmed().isEmpty()) {
+        searchResults->hide();
+        searchStatusLabel->hide();
+        return;
+    }
+    
+    QElapsedTimer timer;
+    timer.start();
+    QVector<SearchIndex::Hit> hits = myPhone->searchIndex()->search(text, SearchResultLimit);
+    qint64 elapsedNs = timer.nsecsElapsed();
+    for (const SearchIndex::Hit &hit : hits) {
+        QString when = QDateTime::fromMSecsSinceEpoch(hit.timestamp).toString("yyyy-MM-dd hh:mm");
+        QString title = hit.title.simplified();
+        QListWidgetItem *item = new QListWidgetItem(searchIcon(hit.kind) + " " + title + "  (" + when + ")");
+        item->setToolTip(hit.detail);
+        searchResults->addItem(item);
+    }
+    searchStatusLabel->setText(QString("%1 result(s) in %2 µs").arg(hits.size()).arg(elapsedNs / 1000.0, 0, 'f', 0));
+    searchStatusLabel->show();
+    searchResults->setVisible(!hits.isEmpty());
 }
\ No newline at end of file
@@ -4,17 +4,55 @@
 #include <QMainWindow>
 #include <QPushButton>
 #include <QLineEdit>
-#include <QTextEdit>
 #include <QLabel>
+#include <QListView>
+#include <QListWidget>
+#include <QComboBox>
 #include "smartphone.h"
+#include "interactiontrace.h"
+#include "replayengine.h"
+#include "phoneviewmodel.h"
+#include "activitylogmodel.h"
+#include "perfmonitor.h"
+#include "asyncphone.h"
+
+class PerfHud;
 
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
 
 public:
-    MainWindow(QWidget *parent = nullptr);
+    // Phones in one process share caches; each keeps its own session and state files
+    MainWindow(int phoneNumber = 1, QWidget *parent = nullptr);
     ~MainWindow();
+    
+    int phoneNumber() const;
+    
+    // Interaction traces: record every slot, replay them through the same slots
+    void startRecording(const QString &tracePath);
+    // Recorded unlocks that succeeded are replayed with password
+    void startReplay(const InteractionTrace &trace, ReplayEngine::Speed speed, const QString &password);
+    
+    // Widget writes done by view-model updates, and the frames they were grouped into
+    quint64 uiUpdateCount() const;
+    quint64 uiFrameCount() const;
+    
+    ActivityLogModel *activityLogModel() const;
+    
+    // Performance HUD (F12); the monitor starts once the first frame is shown
+    PerfMonitor *performanceMonitor() const;
+    
+    // The phone's thread; everything that reads phone state goes through it
+    AsyncPhone *asyncPhone() const;
+    void setPerformanceHudVisible(bool visible);
+
+signals:
+    // Ctrl+N: the application opens another phone window
+    void newPhoneRequested();
+
+protected:
+    bool event(QEvent *event) override;
 
 private slots:
     void onTakePhotoClicked();
@@ -24,30 +62,77 @@ private slots:
     void onGetStorageClicked();
     void onLoadMusicClicked();
     void onStopMusicClicked();
-    void updateUI();
+    void onRecordMemoClicked();
+    void onScanCodesClicked();
+    void onSearchTextChanged(const QString &text);
+    void updateUI(const PhoneViewModel::Snapshot &snapshot);
+    void applyViewModel(quint32 fields);
+    void setupDeferredUI();
+    void setupPerformanceHud();
+    void applyLogFilter();
 
 private:
     void setupUI();
     void createConnections();
+    static void installStyleSheet();
+    void onPhoneEvents(const QVector<PhoneEvent> &events);
+    QString sessionSnapshotPath() const;
+    QString stateStorePath() const;
+    void setStyleState(QWidget *widget, const char *property, const QVariant &value);
+    void loadMusicFromPath(const QString &fileName);
+    void dispatchInteraction(const Interaction &interaction);
+    void log(LogEntry::Level level, const QString &source, const QString &message);
+    // Joins the pieces (text or integers) into the message without temporaries
+    template <typename... Pieces>
+    void log(LogEntry::Level level, const QString &source, const Pieces &...pieces);
     
     // UI Components
-    QLabel *statusLabel;
+    QLineEdit *searchInput;
+    QLabel *searchStatusLabel;
+    QListWidget *searchResults;
     QLineEdit *passwordInput;
     QPushButton *unlockButton;
     QPushButton *lockButton;
     QPushButton *takePhotoButton;
     QPushButton *playMusicButton;
     QPushButton *getStorageButton;
-    QTextEdit *outputLog;
+    QListView *logView;
+    QComboBox *logLevelFilter;
+    QComboBox *logSourceFilter;
     QLabel *phoneStateLabel;
     QLabel *cameraStatusLabel;
+    QLabel *batteryStatusLabel;
     QLabel *photoPreviewLabel;
+    QPushButton *scanCodesButton;
     QPushButton *loadMusicButton;
     QPushButton *stopMusicButton;
+    QPushButton *recordMemoButton;
     QLabel *musicStatusLabel;
     
     // Business Logic
-    Smartphone *myPhone;
+    int number;
+    Smartphone *myPhone;    // owned; only touched directly before and after `phone` runs
+    AsyncPhone *phone;
+    bool firstFramePresented;
+    InteractionRecorder recorder;
+    QString recordingPath;
+    ReplayEngine *replayEngine;
+    QString replayPassword;
+    PhoneViewModel *viewModel;
+    quint64 uiWidgetUpdates;
+    quint64 uiFrames;
+    ActivityLogModel *activityLog;
+    bool logFollowTail;
+    PhoneLog::SinkId logSink;
+    PerfMonitor *perfMonitor;
+    PerfHud *perfHud;
+    bool perfHudRequested;
+    qint64 photoIndexBytes;
+    QString mediaBackendState;
+    QString networkState;
+    QString backupState;
+    bool memoRecording;
+    bool scanningCodes;
 };
 
 #endif // MAINWINDOW_H
\ No newline at end of file
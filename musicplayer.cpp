@@ -1,14 +1,14 @@
 #include "musicplayer.h"
-#include <QDebug>
+#include "phonelog.h"
+#include "tracing.h"
+#include "allocationtracker.h"
 #include <QFileInfo>
 
-MusicPlayer::MusicPlayer(QObject *parent) : QObject(parent), isPlaying(false), currentSong("None")
+MusicPlayer::MusicPlayer(QObject *parent)
+    : QObject(parent), isPlaying(false), currentSong("None"),
+      resumePositionMs(0), sourcePending(false), mediaPlayer(nullptr), audioOutput(nullptr)
 {
-    mediaPlayer = new QMediaPlayer(this);
-    audioOutput = new QAudioOutput(this);
-    mediaPlayer->setAudioOutput(audioOutput);
-    
-    qDebug() << "MusicPlayer initialized with audio support";
+    PHONE_LOG_DEBUG("music", "MusicPlayer initialized (audio backend deferred)");
 }
 
 MusicPlayer::~MusicPlayer()
@@ -20,47 +20,60 @@ MusicPlayer::~MusicPlayer()
     if (audioOutput) {
         delete audioOutput;
     }
-    qDebug() << "MusicPlayer destroyed";
+    PHONE_LOG_DEBUG("music", "MusicPlayer destroyed");
 }
 
 bool MusicPlayer::loadMusic(const QString &filePath)
 {
+    TRACE_SPAN("MusicPlayer::loadMusic", "music");
+    ALLOC_SCOPE("MusicPlayer::loadMusic", "MusicPlayer");
     if (filePath.isEmpty()) {
-        qDebug() << "❌ No file provided";
+        PHONE_LOG_ERROR("music", "❌ No file provided");
         return false;
     }
     
     // Check if file exists and is an audio file
     QFileInfo fileInfo(filePath);
     if (!fileInfo.exists()) {
-        qDebug() << "❌ File not found: " << filePath;
+        PHONE_LOG_ERROR("music", "❌ File not found: %1", filePath);
         return false;
     }
     
     QString suffix = fileInfo.suffix().toLower();
     if (suffix != "mp3" && suffix != "wav" && suffix != "flac" && suffix != "ogg") {
-        qDebug() << "❌ Unsupported audio format: " << suffix;
+        PHONE_LOG_ERROR("music", "❌ Unsupported audio format: %1", suffix);
         return false;
     }
     
+    ensureMediaBackend();
     currentFilePath = filePath;
     currentSong = fileInfo.fileName();
+    resumePositionMs = 0;
+    sourcePending = false;
     mediaPlayer->setSource(QUrl::fromLocalFile(filePath));
     
-    qDebug() << "✓ Audio file loaded: " << currentSong;
+    PHONE_LOG_SUCCESS("music", "✓ Audio file loaded: %1", currentSong);
     return true;
 }
 
 bool MusicPlayer::playMusic()
 {
+    TRACE_SPAN("MusicPlayer::playMusic", "music");
+    ALLOC_SCOPE("MusicPlayer::playMusic", "MusicPlayer");
     if (currentFilePath.isEmpty()) {
-        qDebug() << "❌ No music file loaded";
+        PHONE_LOG_ERROR("music", "❌ No music file loaded");
         return false;
     }
     
+    ensureMediaBackend();
+    if (sourcePending) {
+        sourcePending = false;
+        mediaPlayer->setSource(QUrl::fromLocalFile(currentFilePath));
+        mediaPlayer->setPosition(resumePositionMs);
+    }
     mediaPlayer->play();
     isPlaying = true;
-    qDebug() << "🎵 Now playing: " << currentSong;
+    PHONE_LOG_INFO("music", "🎵 Now playing: %1", currentSong);
     return true;
 }
 
@@ -69,7 +82,7 @@ void MusicPlayer::stopMusic()
     if (mediaPlayer) {
         mediaPlayer->stop();
         isPlaying = false;
-        qDebug() << "⏹️ Music stopped";
+        PHONE_LOG_INFO("music", "⏹️ Music stopped");
     }
 }
 
@@ -81,4 +94,80 @@ bool MusicPlayer::isPlayingNow() const
 QString MusicPlayer::getCurrentSong() const
 {
     return currentSong;
+}
+
+qint64 MusicPlayer::getPlaybackPosition() const
+{
+    if (mediaPlayer && !sourcePending) {
+        return mediaPlayer->position();
+    }
+    return resumePositionMs;
+}
+
+void MusicPlayer::restoreTrack(const QString &filePath, qint64 positionMs)
+{
+    if (filePath.isEmpty()) {
+        return;
+    }
+    
+    if (mediaPlayer) {
+        mediaPlayer->stop();
+    }
+    currentFilePath = filePath;
+    currentSong = QFileInfo(filePath).fileName();
+    resumePositionMs = qMax<qint64>(0, positionMs);
+    sourcePending = true;
+}
+
+void MusicPlayer::playbackStateChanged(bool playing)
+{
+    Q_UNUSED(playing);
+}
+
+void MusicPlayer::ensureMediaBackend()
+{
+    TRACE_SPAN("MusicPlayer::ensureMediaBackend", "music");
+    ALLOC_SCOPE("MusicPlayer::ensureMediaBackend", "MusicPlayer");
+    if (mediaPlayer) {
+        return;
+    }
+    
+    mediaPlayer = new QMediaPlayer(this);
+    audioOutput = new QAudioOutput(this);
+    mediaPlayer->setAudioOutput(audioOutput);
+    connect(mediaPlayer, &QMediaPlayer::playbackStateChanged, this,
+            [this](QMediaPlayer::PlaybackState state) {
+        isPlaying = state == QMediaPlayer::PlayingState;
+        playbackStateChanged(isPlaying);
+    });
+    PHONE_LOG_DEBUG("music", "MusicPlayer audio backend created");
+}
+
+QString MusicPlayer::backendState() const
+{
+    if (!mediaPlayer) {
+        return "not created";
+    }
+    QString playback;
+    switch (mediaPlayer->playbackState()) {
+    case QMediaPlayer::PlayingState: playback = "Playing"; break;
+    case QMediaPlayer::PausedState: playback = "Paused"; break;
+    case QMediaPlayer::StoppedState: playback = "Stopped"; break;
+    }
+    QString media;
+    switch (mediaPlayer->mediaStatus()) {
+    case QMediaPlayer::NoMedia: media = "NoMedia"; break;
+    case QMediaPlayer::LoadingMedia: media = "LoadingMedia"; break;
+    case QMediaPlayer::LoadedMedia: media = "LoadedMedia"; break;
+    case QMediaPlayer::StalledMedia: media = "StalledMedia"; break;
+    case QMediaPlayer::BufferingMedia: media = "BufferingMedia"; break;
+    case QMediaPlayer::BufferedMedia: media = "BufferedMedia"; break;
+    case QMediaPlayer::EndOfMedia: media = "EndOfMedia"; break;
+    case QMediaPlayer::InvalidMedia: media = "InvalidMedia"; break;
+    }
+    QString state = playback + ", " + media;
+    if (mediaPlayer->error() != QMediaPlayer::NoError) {
+        state += ", error: " + mediaPlayer->errorString();
+    }
+    return state;
 }
\ No newline at end of file
@@ -18,11 +18,23 @@ public:
     void stopMusic();
     bool isPlayingNow() const;
     QString getCurrentSong() const;
+    qint64 getPlaybackPosition() const;
+    // Media backend status for diagnostics, e.g. "Playing, LoadedMedia"
+    QString backendState() const;
+    // Remember a track and position without touching the media backend
+    void restoreTrack(const QString &filePath, qint64 positionMs);
 
 protected:
+    // Media backends are created on first use, not at startup
+    void ensureMediaBackend();
+    // Called whenever the backend starts or stops playing (including end of track)
+    virtual void playbackStateChanged(bool playing);
+
     bool isPlaying;
     QString currentSong;
     QString currentFilePath;
+    qint64 resumePositionMs;
+    bool sourcePending;     // currentFilePath not yet handed to the backend
     QMediaPlayer *mediaPlayer;
     QAudioOutput *audioOutput;
 };
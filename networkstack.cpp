@@ -0,0 +1,506 @@
+#include "networkstack.h"
+#include "contentserver.h"
+#include "tracing.h"
+#include <QElapsedTimer>
+#include <algorithm>
+
+namespace {
+
+// Bytes a link of this speed moves in one tick
+qint64 bytesPerTick(qint64 kbps)
+{
+    return kbps * NetworkStack::TickMs / 8;
+}
+
+} // namespace
+
+bool NetworkProfile::isConnected() const
+{
+    return downlinkKbps > 0 && uplinkKbps > 0;
+}
+
+QString NetworkProfile::describe() const
+{
+    if (!isConnected()) {
+        return QString("%1 (no connection)").arg(name);
+    }
+    return QString("%1: %2/%3 Mbit/s down/up, %4 ms ± %5 ms, %6% loss")
+        .arg(name)
+        .arg(downlinkKbps / 1000.0, 0, 'f', 1)
+        .arg(uplinkKbps / 1000.0, 0, 'f', 1)
+        .arg(latencyMs)
+        .arg(jitterMs)
+        .arg(lossRate * 100.0, 0, 'f', 2);
+}
+
+NetworkProfile NetworkProfile::wifi()
+{
+    return NetworkProfile{QStringLiteral("wifi"), 100000, 40000, 5, 2, 0.0005};
+}
+
+NetworkProfile NetworkProfile::lte()
+{
+    return NetworkProfile{QStringLiteral("lte"), 30000, 10000, 35, 10, 0.002};
+}
+
+NetworkProfile NetworkProfile::cellular3g()
+{
+    return NetworkProfile{QStringLiteral("3g"), 2000, 384, 100, 40, 0.01};
+}
+
+NetworkProfile NetworkProfile::offline()
+{
+    return NetworkProfile{QStringLiteral("offline"), 0, 0, 0, 0, 0.0};
+}
+
+QStringList NetworkProfile::names()
+{
+    return {QStringLiteral("wifi"), QStringLiteral("lte"), QStringLiteral("3g"), QStringLiteral("offline")};
+}
+
+bool NetworkProfile::fromName(const QString &name, NetworkProfile &profile)
+{
+    const QString key = name.toLower();
+    if (key == "wifi") {
+        profile = wifi();
+    } else if (key == "lte" || key == "4g") {
+        profile = lte();
+    } else if (key == "3g") {
+        profile = cellular3g();
+    } else if (key == "offline") {
+        profile = offline();
+    } else {
+        return false;
+    }
+    return true;
+}
+
+QString NetworkStack::Stats::describe() const
+{
+    return QString("%1 transfers done, %2 failed, %3 active (peak %4); %5 MB down, %6 MB up; "
+                   "%7 of %8 segments lost")
+        .arg(completed)
+        .arg(failed)
+        .arg(active)
+        .arg(peakActive)
+        .arg(bytesDown / (1024.0 * 1024.0), 0, 'f', 1)
+        .arg(bytesUp / (1024.0 * 1024.0), 0, 'f', 1)
+        .arg(segmentsLost)
+        .arg(segments);
+}
+
+NetworkStack::NetworkStack(SimulationClock *clock, ContentServer *server, quint32 seed)
+    : clock(clock), server(server), link(NetworkProfile::wifi()), random(seed), ticking(false), nextId(1),
+      tickEvent(0), nextTurn(0), busy(false)
+{
+    carry[0] = carry[1] = 0;
+}
+
+NetworkStack::~NetworkStack()
+{
+    clock->cancel(tickEvent);
+    for (SimulationClock::EventId event : reporting) {
+        clock->cancel(event);
+    }
+}
+
+void NetworkStack::setProfile(const NetworkProfile &profile)
+{
+    link = profile;
+    if (link.isConnected()) {
+        return;
+    }
+    // The connection dropped: whatever was in flight is lost
+    for (std::vector<Transfer> *list : {&transfers, &incoming}) {
+        for (Transfer &transfer : *list) {
+            if (transfer.outcome == Outcome::Pending) {
+                transfer.outcome = Outcome::Failed;
+            }
+        }
+    }
+    if (!ticking) {
+        reap();
+    }
+}
+
+const NetworkProfile &NetworkStack::profile() const
+{
+    return link;
+}
+
+NetworkStack::TransferId NetworkStack::download(const QString &object, ChunkSink sink, Finished done,
+                                               Priority priority)
+{
+    const qint64 now = clock->now();
+    Transfer transfer{nextId++, Direction::Down, priority, object, QByteArray(), std::move(sink), std::move(done),
+                      0, -1, -1, 0, now + 2 * delayMs(), now, Outcome::Pending};
+    return start(std::move(transfer));
+}
+
+NetworkStack::TransferId NetworkStack::upload(const QString &object, const QByteArray &data, Finished done,
+                                             Priority priority, qint64 chunkBytes)
+{
+    const qint64 now = clock->now();
+    Transfer transfer{nextId++, Direction::Up, priority, object, data, ChunkSink(), std::move(done),
+                      0, -1, -1, qMax<qint64>(0, chunkBytes), now + 2 * delayMs(), now, Outcome::Pending};
+    return start(std::move(transfer));
+}
+
+bool NetworkStack::cancel(TransferId id)
+{
+    auto report = reporting.find(id);
+    if (report != reporting.end()) {
+        clock->cancel(report.value());
+        reporting.erase(report);
+        return true;
+    }
+    for (std::vector<Transfer> *list : {&transfers, &incoming}) {
+        for (Transfer &transfer : *list) {
+            if (transfer.id == id && transfer.outcome == Outcome::Pending) {
+                transfer.outcome = Outcome::Canceled;
+                if (!ticking) {
+                    reap();
+                }
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int NetworkStack::activeTransfers() const
+{
+    return int(transfers.size() + incoming.size());
+}
+
+NetworkStack::Stats NetworkStack::stats() const
+{
+    Stats stats = counters;
+    stats.active = activeTransfers();
+    return stats;
+}
+
+const LatencyHistogram &NetworkStack::transferTimes() const
+{
+    return durations;
+}
+
+void NetworkStack::setActivitySink(std::function<void(bool busy)> sink)
+{
+    activity = std::move(sink);
+}
+
+NetworkStack::TransferId NetworkStack::start(Transfer transfer)
+{
+    const TransferId id = transfer.id;
+    if (!link.isConnected()) {
+        transfer.outcome = Outcome::Failed;
+    }
+    (ticking ? incoming : transfers).push_back(std::move(transfer));
+    counters.peakActive = qMax(counters.peakActive, activeTransfers());
+    if (!ticking) {
+        reap();
+    }
+    ensureTick();
+    updateActivity();
+    return id;
+}
+
+void NetworkStack::ensureTick()
+{
+    if (tickEvent == 0 && !transfers.empty()) {
+        tickEvent = clock->scheduleEvery(TickMs, [this]() { tick(); });
+    }
+}
+
+void NetworkStack::tick()
+{
+    TRACE_SPAN("NetworkStack::tick", "network");
+    ticking = true;
+    const qint64 now = clock->now();
+    for (Transfer &transfer : transfers) {
+        if (transfer.outcome == Outcome::Pending && transfer.size < 0 && transfer.readyAt <= now) {
+            answer(transfer);
+        }
+    }
+    for (Direction direction : {Direction::Down, Direction::Up}) {
+        qint64 &unspent = carry[int(direction)];
+        const qint64 budget = unspent + bytesPerTick(direction == Direction::Down ? link.downlinkKbps : link.uplinkKbps);
+        unspent = send(direction, Priority::Background, send(direction, Priority::Foreground, budget));
+        // An idle link does not save up bandwidth
+        unspent = qMin<qint64>(unspent, SegmentBytes);
+    }
+    nextTurn++;
+    ticking = false;
+
+    for (Transfer &transfer : incoming) {
+        transfers.push_back(std::move(transfer));
+    }
+    incoming.clear();
+    reap();
+}
+
+// The server's reply to the request: the download's size, or how much of
+// the upload it already has
+void NetworkStack::answer(Transfer &transfer)
+{
+    if (transfer.direction == Direction::Down) {
+        transfer.size = server->size(transfer.object);
+        transfer.end = transfer.size;
+        if (transfer.size < 0) {
+            transfer.outcome = Outcome::Failed;
+        } else if (transfer.size == 0) {
+            transfer.outcome = Outcome::Succeeded;
+        }
+        return;
+    }
+
+    transfer.size = transfer.data.size();
+    transfer.offset = server->receivedBytes(transfer.object);
+    transfer.end = transfer.chunkBytes > 0 ? qMin(transfer.size, transfer.offset + transfer.chunkBytes) : transfer.size;
+    if (server->isUploaded(transfer.object)) {
+        transfer.outcome = transfer.offset == transfer.size ? Outcome::Succeeded : Outcome::Failed;
+    } else if (transfer.offset > transfer.size) {
+        transfer.outcome = Outcome::Failed;
+    } else if (transfer.offset == transfer.size) {
+        // Nothing left to send, but the server still needs to hear it is complete
+        transfer.outcome = server->receive(transfer.object, transfer.offset, QByteArrayView(), transfer.size)
+                               ? Outcome::Succeeded : Outcome::Failed;
+    }
+}
+
+// Rounds of one segment per transfer until the budget runs out, so every
+// transfer gets the same share whatever its size
+qint64 NetworkStack::send(Direction direction, Priority priority, qint64 budget)
+{
+    const size_t count = transfers.size();
+    if (count == 0) {
+        return budget;
+    }
+    const qint64 now = clock->now();
+    const size_t first = nextTurn % count;
+    bool sent = true;
+    while (sent) {
+        sent = false;
+        for (size_t k = 0; k < count; ++k) {
+            Transfer &transfer = transfers[(first + k) % count];
+            if (transfer.direction != direction || transfer.priority != priority
+                || transfer.outcome != Outcome::Pending || transfer.size < 0 || transfer.readyAt > now) {
+                continue;
+            }
+            const qint64 length = qMin<qint64>(SegmentBytes, transfer.end - transfer.offset);
+            if (length > budget) {
+                continue;
+            }
+            budget -= length;
+            sent = true;
+            sendSegment(transfer, length);
+        }
+    }
+    return budget;
+}
+
+void NetworkStack::sendSegment(Transfer &transfer, qint64 length)
+{
+    counters.segments++;
+    if (link.lossRate > 0.0 && random.generateDouble() < link.lossRate) {
+        counters.segmentsLost++;
+        transfer.readyAt = clock->now() + 2 * delayMs();
+        return;
+    }
+
+    if (transfer.direction == Direction::Down) {
+        // Straight from the server's buffer into the sink; a segment may
+        // span two views where the server's data wraps
+        for (qint64 left = length; left > 0;) {
+            QByteArrayView chunk = server->read(transfer.object, transfer.offset, left);
+            if (chunk.isEmpty()) {
+                transfer.outcome = Outcome::Failed;
+                return;
+            }
+            if (transfer.sink) {
+                transfer.sink(chunk);
+            }
+            transfer.offset += chunk.size();
+            left -= chunk.size();
+        }
+        counters.bytesDown += length;
+    } else {
+        QByteArrayView chunk(transfer.data.constData() + transfer.offset, length);
+        if (!server->receive(transfer.object, transfer.offset, chunk, transfer.size)) {
+            transfer.outcome = Outcome::Failed;
+            return;
+        }
+        transfer.offset += length;
+        counters.bytesUp += length;
+    }
+    if (transfer.offset == transfer.end && transfer.outcome == Outcome::Pending) {
+        transfer.outcome = Outcome::Succeeded;
+    }
+}
+
+qint64 NetworkStack::delayMs()
+{
+    const int jitter = link.jitterMs > 0 ? random.bounded(-link.jitterMs, link.jitterMs + 1) : 0;
+    return qMax(0, link.latencyMs + jitter);
+}
+
+void NetworkStack::reap()
+{
+    auto finished = std::stable_partition(transfers.begin(), transfers.end(), [](const Transfer &transfer) {
+        return transfer.outcome == Outcome::Pending;
+    });
+    std::vector<Transfer> done(std::make_move_iterator(finished), std::make_move_iterator(transfers.end()));
+    transfers.erase(finished, transfers.end());
+
+    for (Transfer &transfer : done) {
+        if (transfer.outcome == Outcome::Canceled) {
+            continue;
+        }
+        const bool ok = transfer.outcome == Outcome::Succeeded;
+        (ok ? counters.completed : counters.failed)++;
+        // A success is heard once its last segment has crossed the link
+        const qint64 delay = ok ? delayMs() : 0;
+        durations.record(clock->now() + delay - transfer.requestedAt);
+        if (transfer.done) {
+            // Kept until it runs so cancel() can still stop it
+            const TransferId id = transfer.id;
+            reporting.insert(id, clock->scheduleAfter(delay, [this, id, done = std::move(transfer.done), ok]() {
+                reporting.remove(id);
+                done(ok);
+            }));
+        }
+    }
+
+    if (transfers.empty() && tickEvent != 0) {
+        clock->cancel(tickEvent);
+        tickEvent = 0;
+        carry[0] = carry[1] = 0;
+    }
+    updateActivity();
+}
+
+void NetworkStack::updateActivity()
+{
+    const bool active = activeTransfers() > 0;
+    if (active != busy) {
+        busy = active;
+        if (activity) {
+            activity(busy);
+        }
+    }
+}
+
+NetworkFleet::NetworkFleet(int phones, const NetworkProfile &profile)
+    : server(new ContentServer()), outstanding(size_t(qMax(0, phones)), 0), startedAt(0), elapsedMs(0), hostNs(0)
+{
+    clock.setMode(SimulationClock::Mode::AsFastAsPossible);
+    stacks.reserve(outstanding.size());
+    for (size_t i = 0; i < outstanding.size(); ++i) {
+        stacks.push_back(std::make_unique<NetworkStack>(&clock, server.get(), quint32(i + 1)));
+        stacks.back()->setProfile(profile);
+    }
+    startedAt = clock.now();
+}
+
+NetworkFleet::~NetworkFleet()
+{
+    // The stacks cancel their ticks on a clock that must still exist
+    stacks.clear();
+}
+
+bool NetworkFleet::installAll(const QString &app)
+{
+    if (!server->contains(app)) {
+        return false;
+    }
+    for (int phone = 0; phone < phoneCount(); ++phone) {
+        started(phone);
+        stacks[size_t(phone)]->download(app, NetworkStack::ChunkSink(), [this, phone](bool) { finished(phone); });
+    }
+    return true;
+}
+
+void NetworkFleet::backupAll(int photos, qint64 photoBytes)
+{
+    const QByteArray photo(qsizetype(qMax<qint64>(0, photoBytes)), '\xA5');
+    for (int phone = 0; phone < phoneCount(); ++phone) {
+        for (int i = 0; i < photos; ++i) {
+            started(phone);
+            stacks[size_t(phone)]->upload(QString("backup/%1/photo_%2.jpg").arg(phone).arg(i), photo,
+                                          [this, phone](bool) { finished(phone); });
+        }
+    }
+}
+
+qint64 NetworkFleet::run(qint64 limitMs)
+{
+    TRACE_SPAN("NetworkFleet::run", "network");
+    QElapsedTimer host;
+    host.start();
+    const qint64 begin = clock.now();
+    auto busy = [this]() {
+        return std::any_of(outstanding.cbegin(), outstanding.cend(), [](int count) { return count > 0; });
+    };
+    while (busy() && clock.now() - begin < limitMs) {
+        clock.advanceBy(1000);
+    }
+    hostNs += host.nsecsElapsed();
+    elapsedMs = completions.count() > 0 ? completions.max() : clock.now() - startedAt;
+    return elapsedMs;
+}
+
+int NetworkFleet::phoneCount() const
+{
+    return int(stacks.size());
+}
+
+const LatencyHistogram &NetworkFleet::completionTimes() const
+{
+    return completions;
+}
+
+NetworkStack::Stats NetworkFleet::stats() const
+{
+    NetworkStack::Stats total;
+    for (const std::unique_ptr<NetworkStack> &stack : stacks) {
+        NetworkStack::Stats stats = stack->stats();
+        total.active += stats.active;
+        total.peakActive = qMax(total.peakActive, stats.peakActive);
+        total.completed += stats.completed;
+        total.failed += stats.failed;
+        total.bytesDown += stats.bytesDown;
+        total.bytesUp += stats.bytesUp;
+        total.segments += stats.segments;
+        total.segmentsLost += stats.segmentsLost;
+    }
+    return total;
+}
+
+QString NetworkFleet::report() const
+{
+    QString profile = stacks.empty() ? QString() : stacks.front()->profile().name;
+    return QString("%1 phones on %2: done in %3 s simulated (per phone p50 %4 s, p99 %5 s), "
+                   "%6 ms host time for %7 clock events\n   %8\n   server: %9")
+        .arg(phoneCount())
+        .arg(profile)
+        .arg(elapsedMs / 1000.0, 0, 'f', 1)
+        .arg(completions.percentile(50) / 1000.0, 0, 'f', 1)
+        .arg(completions.percentile(99) / 1000.0, 0, 'f', 1)
+        .arg(hostNs / 1e6, 0, 'f', 0)
+        .arg(clock.processedEvents())
+        .arg(stats().describe())
+        .arg(server->stats().describe());
+}
+
+void NetworkFleet::started(int phone)
+{
+    outstanding[size_t(phone)]++;
+}
+
+void NetworkFleet::finished(int phone)
+{
+    if (--outstanding[size_t(phone)] == 0) {
+        completions.record(clock.now() - startedAt);
+    }
+}
\ No newline at end of file
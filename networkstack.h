@@ -0,0 +1,196 @@
+#ifndef NETWORKSTACK_H
+#define NETWORKSTACK_H
+
+#include "simulationclock.h"
+#include "latencyhistogram.h"
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QHash>
+#include <QRandomGenerator>
+#include <QString>
+#include <QStringList>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class ContentServer;
+
+// Link characteristics of one kind of connection
+struct NetworkProfile
+{
+    QString name;
+    qint64 downlinkKbps = 0;    // 0 = no connection
+    qint64 uplinkKbps = 0;
+    int latencyMs = 0;          // one way
+    int jitterMs = 0;           // each delay is off by up to this much either way
+    double lossRate = 0.0;      // chance that a segment is lost and sent again
+
+    bool isConnected() const;
+    QString describe() const;
+
+    static NetworkProfile wifi();
+    static NetworkProfile lte();
+    static NetworkProfile cellular3g();
+    static NetworkProfile offline();
+    static QStringList names();
+    static bool fromName(const QString &name, NetworkProfile &profile);
+};
+
+// A phone's connection to a ContentServer, simulated on the phone's clock.
+// A transfer waits one round trip for the server's answer, then moves in
+// segments. Every tick each direction of the link gets its bandwidth's
+// worth of bytes, handed out one segment per transfer in turn, so
+// concurrent transfers share the link evenly. Background transfers only
+// get what the foreground ones leave over. A lost segment costs its
+// bandwidth and stalls its transfer for a round trip before it is resent.
+// Downloads go straight from the server's buffer to the caller's sink and
+// uploads straight from the caller's buffer to the server: no copies.
+// Going offline fails every transfer in progress.
+class NetworkStack
+{
+public:
+    using TransferId = quint64;
+    // A view into the server's data, valid during the call only
+    using ChunkSink = std::function<void(QByteArrayView chunk)>;
+    using Finished = std::function<void(bool ok)>;
+
+    enum class Priority { Foreground, Background };
+
+    struct Stats
+    {
+        int active = 0;
+        int peakActive = 0;
+        int completed = 0;
+        int failed = 0;
+        qint64 bytesDown = 0;
+        qint64 bytesUp = 0;
+        quint64 segments = 0;
+        quint64 segmentsLost = 0;
+
+        QString describe() const;
+    };
+
+    static constexpr qint64 TickMs = 10;
+    static constexpr int SegmentBytes = 16 * 1024;
+
+    NetworkStack(SimulationClock *clock, ContentServer *server, quint32 seed = 1);
+    ~NetworkStack();
+
+    NetworkStack(const NetworkStack &) = delete;
+    NetworkStack &operator=(const NetworkStack &) = delete;
+
+    // Starts on WiFi
+    void setProfile(const NetworkProfile &profile);
+    const NetworkProfile &profile() const;
+
+    // An unknown object fails once the server has answered
+    TransferId download(const QString &object, ChunkSink sink, Finished done = Finished(),
+                        Priority priority = Priority::Foreground);
+    // Sends data from wherever the server's copy of object ends, so a
+    // repeated upload resumes an interrupted one. data is shared, not copied.
+    // With chunkBytes set only that much is sent, and done(true) means the
+    // chunk arrived; the server's receivedBytes() says whether more is due.
+    TransferId upload(const QString &object, const QByteArray &data, Finished done = Finished(),
+                      Priority priority = Priority::Foreground, qint64 chunkBytes = 0);
+    // Drops a transfer without calling its done callback, also once it has
+    // finished but its done callback is still on the way
+    bool cancel(TransferId id);
+
+    int activeTransfers() const;
+    Stats stats() const;
+    // Request to done callback, in ms of simulated time
+    const LatencyHistogram &transferTimes() const;
+
+    // Told when the link goes busy or idle, e.g. to charge radio power
+    void setActivitySink(std::function<void(bool busy)> sink);
+
+private:
+    enum class Direction { Down, Up };
+    enum class Outcome { Pending, Succeeded, Failed, Canceled };
+
+    struct Transfer
+    {
+        TransferId id;
+        Direction direction;
+        Priority priority;
+        QString object;
+        QByteArray data;            // uploads
+        ChunkSink sink;             // downloads
+        Finished done;
+        qint64 offset;
+        qint64 size;                // -1 until the server answered
+        qint64 end;                 // done once offset gets here
+        qint64 chunkBytes;          // uploads; 0 = all of it
+        qint64 readyAt;             // waiting for a reply or a resend until then
+        qint64 requestedAt;
+        Outcome outcome;
+    };
+
+    TransferId start(Transfer transfer);
+    void ensureTick();
+    void tick();
+    void answer(Transfer &transfer);
+    // Spends budget bytes on transfers of one class going one way; returns the unspent part
+    qint64 send(Direction direction, Priority priority, qint64 budget);
+    void sendSegment(Transfer &transfer, qint64 length);
+    qint64 delayMs();
+    // Removes finished transfers and reports them
+    void reap();
+    void updateActivity();
+
+    SimulationClock *clock;
+    ContentServer *server;
+    NetworkProfile link;
+    QRandomGenerator random;
+    std::vector<Transfer> transfers;
+    std::vector<Transfer> incoming;     // started by a callback during a tick
+    QHash<TransferId, SimulationClock::EventId> reporting;  // finished; done callback not yet run
+    bool ticking;
+    TransferId nextId;
+    SimulationClock::EventId tickEvent;
+    size_t nextTurn;                    // round-robin start, moves every tick
+    qint64 carry[2];                    // unspent budget per direction, at most one segment
+    Stats counters;
+    LatencyHistogram durations;
+    std::function<void(bool)> activity;
+    bool busy;
+};
+
+// Many phones' network stacks on one clock and one server, for modelling
+// app installs and photo backups across a fleet. Each phone keeps its own
+// link, so the server is never the bottleneck.
+class NetworkFleet
+{
+public:
+    NetworkFleet(int phones, const NetworkProfile &profile);
+    ~NetworkFleet();
+
+    // Every phone downloads the app
+    bool installAll(const QString &app);
+    // Every phone uploads its photos at once, all sharing one buffer
+    void backupAll(int photos, qint64 photoBytes);
+    // Runs simulated time until every transfer is done or limitMs passed;
+    // returns the simulated ms that took
+    qint64 run(qint64 limitMs = 24 * 3600 * 1000);
+
+    int phoneCount() const;
+    // Per phone: ms from the start to its last transfer finishing
+    const LatencyHistogram &completionTimes() const;
+    NetworkStack::Stats stats() const;
+    QString report() const;
+
+private:
+    void started(int phone);
+    void finished(int phone);
+
+    SimulationClock clock;
+    std::unique_ptr<ContentServer> server;
+    std::vector<std::unique_ptr<NetworkStack>> stacks;
+    std::vector<int> outstanding;       // per phone
+    qint64 startedAt;
+    qint64 elapsedMs;
+    qint64 hostNs;
+    LatencyHistogram completions;
+};
+
+#endif // NETWORKSTACK_H
\ No newline at end of file
@@ -0,0 +1,42 @@
+#include "perfhud.h"
+#include "perfmonitor.h"
+#include <QLabel>
+#include <QTimer>
+
+PerfHud::PerfHud(PerfMonitor *monitor, QWidget *parent)
+    : QDockWidget("Performance", parent), monitor(monitor), refreshTimer(new QTimer(this))
+{
+    setObjectName("performanceHud");
+    reportLabel = new QLabel(this);
+    reportLabel->setTextFormat(Qt::PlainText);
+    reportLabel->setAlignment(Qt::AlignTop | Qt::AlignLeft);
+    reportLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+    reportLabel->setStyleSheet("background-color: #202020; color: #9fef00; font-family: Courier; font-size: 11px; padding: 6px;");
+    setWidget(reportLabel);
+
+    refreshTimer->setInterval(RefreshIntervalMs);
+    connect(refreshTimer, &QTimer::timeout, this, &PerfHud::refresh);
+    connect(monitor, &PerfMonitor::stallDetected, this, [this]() {
+        if (isVisible()) {
+            refresh();
+        }
+    });
+}
+
+void PerfHud::showEvent(QShowEvent *event)
+{
+    QDockWidget::showEvent(event);
+    refresh();
+    refreshTimer->start();
+}
+
+void PerfHud::hideEvent(QHideEvent *event)
+{
+    refreshTimer->stop();
+    QDockWidget::hideEvent(event);
+}
+
+void PerfHud::refresh()
+{
+    reportLabel->setText(monitor->takeReport());
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#ifndef PERFHUD_H
+#define PERFHUD_H
+
+#include <QDockWidget>
+
+class QLabel;
+class QTimer;
+class PerfMonitor;
+
+// Dock showing the monitor's report. It only refreshes while visible, so a
+// hidden HUD costs nothing beyond the monitor itself.
+class PerfHud : public QDockWidget
+{
+    Q_OBJECT
+public:
+    explicit PerfHud(PerfMonitor *monitor, QWidget *parent = nullptr);
+
+    static constexpr int RefreshIntervalMs = 500;
+
+protected:
+    void showEvent(QShowEvent *event) override;
+    void hideEvent(QHideEvent *event) override;
+
+private:
+    void refresh();
+
+    PerfMonitor *monitor;
+    QLabel *reportLabel;
+    QTimer *refreshTimer;
+};
+
+#endif // PERFHUD_H
\ No newline at end of file
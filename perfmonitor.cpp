@@ -0,0 +1,386 @@
+#include "perfmonitor.h"
+#include "phonelog.h"
+#include "tracing.h"
+#include <QDateTime>
+#include <QFile>
+#include <QMutexLocker>
+#include <QThread>
+#include <QTimer>
+#include <chrono>
+
+#ifdef Q_OS_LINUX
+#include <execinfo.h>
+#include <signal.h>
+#include <unistd.h>
+#include <cstdlib>
+#endif
+
+namespace {
+
+qint64 steadyNs()
+{
+    return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+
+QString formatBytes(qint64 bytes)
+{
+    if (bytes < 0) {
+        return "n/a";
+    }
+    if (bytes < 1024 * 1024) {
+        return QString("%1 KB").arg(bytes / 1024.0, 0, 'f', 1);
+    }
+    return QString("%1 MB").arg(bytes / (1024.0 * 1024.0), 0, 'f', 1);
+}
+
+#ifdef Q_OS_LINUX
+constexpr int SampleSignal = SIGUSR2;
+constexpr int MaxStackFrames = 48;
+constexpr int SkippedFrames = 2;    // the handler and the signal trampoline
+
+// One sample at a time: the handler writes into these. Each request has a
+// sequence number; a handler claims the open request for its own thread
+// before writing, so a signal that arrives after its sample was abandoned
+// finds nothing to claim and cannot overwrite a later sample.
+std::mutex samplingMutex;
+void *sampledFrames[MaxStackFrames];
+int sampledDepth = 0;
+std::atomic<pthread_t> sampleTarget;
+std::atomic<quint32> sampleRequest{0};     // open request, 0 if none
+std::atomic<quint32> sampleDone{0};        // last request whose frames are written
+quint32 sampleSequence = 0;                 // under samplingMutex
+
+// Runs on the blocked thread. backtrace() is primed before the handler is
+// installed, so it does not need to load anything or allocate here.
+void sampleHandler(int)
+{
+    quint32 request = sampleRequest.load(std::memory_order_acquire);
+    if (request == 0 || !pthread_equal(sampleTarget.load(std::memory_order_relaxed), pthread_self())
+        || !sampleRequest.compare_exchange_strong(request, 0, std::memory_order_acq_rel)) {
+        return;
+    }
+    sampledDepth = backtrace(sampledFrames, MaxStackFrames);
+    sampleDone.store(request, std::memory_order_release);
+}
+
+void installSampleHandler()
+{
+    static std::once_flag installed;
+    std::call_once(installed, []() {
+        void *prime[1];
+        backtrace(prime, 1);
+        struct sigaction action = {};
+        action.sa_handler = sampleHandler;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESTART;
+        sigaction(SampleSignal, &action, nullptr);
+    });
+}
+#endif
+
+SharedCache<QThread *, StallWatchdog> &watchdogs()
+{
+    static SharedCache<QThread *, StallWatchdog> cache;
+    return cache;
+}
+
+} // namespace
+
+// Beats often enough that a healthy loop never looks stalled
+StallWatchdog::StallWatchdog(int thresholdMs)
+    : beatTimer(new QTimer(this)), beatIntervalMs(qBound(5, thresholdMs / 4, 50)), thresholdMs(thresholdMs),
+      expectedBeatNs(0), lastBeatNs(0), stallOpen(false), stallTotal(0), stopping(false)
+{
+#ifdef Q_OS_LINUX
+    watchedThread = pthread_self();
+    installSampleHandler();
+#endif
+
+    qint64 now = steadyNs();
+    lastBeatNs.store(now, std::memory_order_release);
+    expectedBeatNs = now + qint64(beatIntervalMs) * 1000000;
+    beatTimer->setTimerType(Qt::PreciseTimer);
+    connect(beatTimer, &QTimer::timeout, this, &StallWatchdog::heartbeat);
+    beatTimer->start(beatIntervalMs);
+
+    watchdog = std::thread([this]() { watch(); });
+}
+
+StallWatchdog::~StallWatchdog()
+{
+    beatTimer->stop();
+    {
+        std::lock_guard<std::mutex> lock(watchdogMutex);
+        stopping = true;
+    }
+    watchdogWake.notify_all();
+    watchdog.join();
+}
+
+int StallWatchdog::stallThreshold() const
+{
+    return thresholdMs;
+}
+
+QVector<StallWatchdog::Stall> StallWatchdog::stalls() const
+{
+    QMutexLocker lock(&stallMutex);
+    return stallLog;
+}
+
+quint64 StallWatchdog::stallCount() const
+{
+    return stallTotal.load(std::memory_order_relaxed);
+}
+
+void StallWatchdog::heartbeat()
+{
+    qint64 now = steadyNs();
+    qint64 lateUs = qMax<qint64>(0, (now - expectedBeatNs) / 1000);
+    lastBeatNs.store(now, std::memory_order_release);
+    expectedBeatNs = now + qint64(beatIntervalMs) * 1000000;
+    emit beat(lateUs);
+
+    if (stallOpen.load(std::memory_order_acquire)) {
+        // The loop is running again: the lateness of this beat is the stall's length
+        qint64 blockedMs;
+        {
+            QMutexLocker lock(&stallMutex);
+            stallOpen.store(false, std::memory_order_release);
+            Stall &stall = stallLog.last();
+            stall.blockedMs = qMax(stall.blockedMs, lateUs / 1000);
+            blockedMs = stall.blockedMs;
+        }
+        PHONE_LOG_WARNING("perf", "🐢 GUI thread blocked for %1 ms", blockedMs);
+        emit stallEnded(blockedMs);
+    }
+}
+
+void StallWatchdog::watch()
+{
+    Tracer::setThreadName("stall watchdog");
+    const auto checkInterval = std::chrono::milliseconds(qMax(2, beatIntervalMs / 2));
+    const qint64 limitNs = qint64(thresholdMs + beatIntervalMs) * 1000000;
+
+    std::unique_lock<std::mutex> lock(watchdogMutex);
+    while (!stopping) {
+        watchdogWake.wait_for(lock, checkInterval, [this]() { return stopping; });
+        if (stopping) {
+            break;
+        }
+        qint64 silentNs = steadyNs() - lastBeatNs.load(std::memory_order_acquire);
+        if (silentNs < limitNs || stallOpen.load(std::memory_order_acquire)) {
+            continue;
+        }
+
+        // Sample while the thread is still stuck, then publish the stall
+        Stall stall;
+        stall.detectedAt = QDateTime::currentMSecsSinceEpoch();
+        stall.blockedMs = silentNs / 1000000 - beatIntervalMs;
+        stall.stack = sampleStack();
+        Tracer::instant("GUI stall", "perf");
+
+        QMutexLocker stallLock(&stallMutex);
+        stallLog.append(stall);
+        if (stallLog.size() > MaxStoredStalls) {
+            stallLog.removeFirst();
+        }
+        stallTotal.fetch_add(1, std::memory_order_relaxed);
+        stallOpen.store(true, std::memory_order_release);
+    }
+}
+
+QStringList StallWatchdog::sampleStack()
+{
+    QStringList frames;
+#ifdef Q_OS_LINUX
+    std::lock_guard<std::mutex> lock(samplingMutex);
+    if (++sampleSequence == 0) {
+        ++sampleSequence;   // 0 means no request
+    }
+    const quint32 request = sampleSequence;
+    sampleTarget.store(watchedThread, std::memory_order_relaxed);
+    sampleRequest.store(request, std::memory_order_release);
+    if (pthread_kill(watchedThread, SampleSignal) != 0) {
+        sampleRequest.store(0, std::memory_order_release);
+        return frames;
+    }
+    for (int waited = 0; waited < 100 && sampleDone.load(std::memory_order_acquire) != request; ++waited) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (sampleDone.load(std::memory_order_acquire) != request) {
+        // Withdraw the request. If the handler claimed it first, it is
+        // already running and finishes shortly; wait so it cannot write
+        // into the next sample.
+        quint32 open = request;
+        if (sampleRequest.compare_exchange_strong(open, 0, std::memory_order_acq_rel)) {
+            return frames;
+        }
+        while (sampleDone.load(std::memory_order_acquire) != request) {
+            std::this_thread::yield();
+        }
+    }
+    int depth = sampledDepth;
+    if (depth <= SkippedFrames) {
+        return frames;
+    }
+    char **symbols = backtrace_symbols(sampledFrames + SkippedFrames, depth - SkippedFrames);
+    if (symbols) {
+        for (int i = 0; i < depth - SkippedFrames; ++i) {
+            frames.append(QString::fromLocal8Bit(symbols[i]));
+        }
+        std::free(symbols);
+    }
+#endif
+    return frames;
+}
+
+PerfMonitor::PerfMonitor(QObject *parent)
+    : QObject(parent), thresholdMs(DefaultStallThresholdMs), windowStartNs(steadyNs())
+{
+}
+
+PerfMonitor::~PerfMonitor()
+{
+    stop();
+}
+
+void PerfMonitor::setStallThreshold(int ms)
+{
+    thresholdMs = qMax(10, ms);
+}
+
+int PerfMonitor::stallThreshold() const
+{
+    return watchdog ? watchdog->stallThreshold() : thresholdMs;
+}
+
+void PerfMonitor::start()
+{
+    stop();
+    const int threshold = thresholdMs;
+    watchdog = watchdogs().acquire(QThread::currentThread(), [threshold]() {
+        return new StallWatchdog(threshold);
+    });
+    connect(watchdog.get(), &StallWatchdog::beat, this, &PerfMonitor::onBeat);
+    connect(watchdog.get(), &StallWatchdog::stallEnded, this, &PerfMonitor::stallDetected);
+}
+
+void PerfMonitor::stop()
+{
+    if (!watchdog) {
+        return;
+    }
+    disconnect(watchdog.get(), nullptr, this, nullptr);
+    // The last monitor on the thread stops the watchdog
+    watchdog.reset();
+}
+
+bool PerfMonitor::isRunning() const
+{
+    return watchdog != nullptr;
+}
+
+void PerfMonitor::onBeat(qint64 lateUs)
+{
+    loopLatency.record(lateUs);
+    loopWindow.record(lateUs);
+}
+
+void PerfMonitor::recordFrame(qint64 ns)
+{
+    frames.record(ns / 1000);
+    frameWindow.record(ns / 1000);
+}
+
+void PerfMonitor::addMemorySource(const QString &name, std::function<qint64()> bytes)
+{
+    memorySources.append(qMakePair(name, std::move(bytes)));
+}
+
+void PerfMonitor::addGauge(const QString &name, std::function<QString()> value)
+{
+    gauges.append(qMakePair(name, std::move(value)));
+}
+
+const LatencyHistogram &PerfMonitor::eventLoopLatency() const
+{
+    return loopLatency;
+}
+
+const LatencyHistogram &PerfMonitor::frameTimes() const
+{
+    return frames;
+}
+
+QVector<PerfMonitor::Stall> PerfMonitor::stalls() const
+{
+    return watchdog ? watchdog->stalls() : QVector<Stall>();
+}
+
+quint64 PerfMonitor::stallCount() const
+{
+    return watchdog ? watchdog->stallCount() : 0;
+}
+
+QString PerfMonitor::takeReport()
+{
+    qint64 now = steadyNs();
+    double windowSec = qMax<qint64>(1, now - windowStartNs) / 1e9;
+
+    QString text;
+    text += QString("Event loop   p50 %1 us  p99 %2 us  max %3 us\n")
+                .arg(loopWindow.percentile(50)).arg(loopWindow.percentile(99)).arg(loopWindow.max());
+    text += QString("Frames       %1 fps  p50 %2 us  p99 %3 us  max %4 us\n")
+                .arg(frameWindow.count() / windowSec, 0, 'f', 1)
+                .arg(frameWindow.percentile(50)).arg(frameWindow.percentile(99)).arg(frameWindow.max());
+
+    text += QString("Stalls       %1 over %2 ms").arg(stallCount()).arg(stallThreshold());
+    QVector<Stall> recent = stalls();
+    if (!recent.isEmpty()) {
+        const Stall &last = recent.last();
+        text += QString(", last %1 ms at %2")
+                    .arg(last.blockedMs)
+                    .arg(QDateTime::fromMSecsSinceEpoch(last.detectedAt).toString("hh:mm:ss"));
+        if (!last.stack.isEmpty()) {
+            text += "\n  in " + last.stack.first();
+        }
+    }
+    text += "\n";
+
+    text += QString("Memory       RSS %1\n").arg(formatBytes(residentMemoryBytes()));
+    for (const auto &source : memorySources) {
+        text += QString("  %1 %2\n").arg(source.first.leftJustified(14)).arg(formatBytes(source.second()));
+    }
+    for (const auto &gauge : gauges) {
+        text += QString("%1 %2\n").arg(gauge.first.leftJustified(12)).arg(gauge.second());
+    }
+
+    loopWindow.reset();
+    frameWindow.reset();
+    windowStartNs = now;
+    return text.trimmed();
+}
+
+qint64 PerfMonitor::residentMemoryBytes()
+{
+#ifdef Q_OS_LINUX
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly)) {
+        return -1;
+    }
+    // Second field: resident pages
+    QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.size() < 2) {
+        return -1;
+    }
+    return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    return -1;
+#endif
+}
+
+SharedCache<QThread *, StallWatchdog>::Stats PerfMonitor::watchdogStats()
+{
+    return watchdogs().stats();
+}
\ No newline at end of file
@@ -0,0 +1,146 @@
+#ifndef PERFMONITOR_H
+#define PERFMONITOR_H
+
+#include "latencyhistogram.h"
+#include "sharedcache.h"
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QMutex>
+#include <QPair>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#endif
+
+class QThread;
+class QTimer;
+
+// Heartbeat and stall watchdog for one thread. A heartbeat timer measures
+// how late the event loop runs it (event-loop latency); a watchdog thread
+// notices when the heartbeat stops for longer than the stall threshold and
+// samples the thread's stack (Linux) while it is still blocked. Every
+// PerfMonitor started on a thread shares that thread's watchdog, so with
+// several windows one stall is still sampled, logged and counted once.
+class StallWatchdog : public QObject
+{
+    Q_OBJECT
+public:
+    struct Stall
+    {
+        qint64 detectedAt;      // ms since epoch
+        qint64 blockedMs;       // final length once the loop resumed
+        QStringList stack;      // innermost frame first; empty if unsupported
+    };
+
+    // Must be created on the thread to be watched
+    explicit StallWatchdog(int thresholdMs);
+    ~StallWatchdog();
+
+    StallWatchdog(const StallWatchdog &) = delete;
+    StallWatchdog &operator=(const StallWatchdog &) = delete;
+
+    int stallThreshold() const;
+    QVector<Stall> stalls() const;
+    quint64 stallCount() const;
+
+    static constexpr int MaxStoredStalls = 16;
+
+signals:
+    void beat(qint64 lateUs);
+    void stallEnded(qint64 blockedMs);
+
+private:
+    void heartbeat();
+    void watch();
+    QStringList sampleStack();
+
+    QTimer *beatTimer;
+    const int beatIntervalMs;
+    const int thresholdMs;
+    qint64 expectedBeatNs;
+
+    // Shared with the watchdog thread
+    std::atomic<qint64> lastBeatNs;
+    std::atomic<bool> stallOpen;        // detected, loop not yet resumed
+    std::atomic<quint64> stallTotal;
+    mutable QMutex stallMutex;
+    QVector<Stall> stallLog;
+
+    std::thread watchdog;
+    std::mutex watchdogMutex;
+    std::condition_variable watchdogWake;
+    bool stopping;
+#ifdef Q_OS_LINUX
+    pthread_t watchedThread;
+#endif
+};
+
+// Live performance counters for one window on the GUI thread. Event-loop
+// latency and stalls come from the thread's shared StallWatchdog; frame
+// times, memory and gauges are fed in by their owners.
+class PerfMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    using Stall = StallWatchdog::Stall;
+
+    explicit PerfMonitor(QObject *parent = nullptr);
+    ~PerfMonitor();
+
+    // Takes effect on the next start(), unless another monitor on the
+    // same thread already runs the watchdog with its own threshold
+    void setStallThreshold(int ms);
+    int stallThreshold() const;
+    // Must be called on the thread to be watched
+    void start();
+    void stop();
+    bool isRunning() const;
+
+    void recordFrame(qint64 ns);
+    void addMemorySource(const QString &name, std::function<qint64()> bytes);
+    void addGauge(const QString &name, std::function<QString()> value);
+
+    const LatencyHistogram &eventLoopLatency() const;   // us, since start()
+    const LatencyHistogram &frameTimes() const;         // us, whole session
+    QVector<Stall> stalls() const;
+    quint64 stallCount() const;
+
+    // Text for the HUD; window statistics restart after every call
+    QString takeReport();
+
+    static qint64 residentMemoryBytes();
+    // Watchdogs alive in the process and the monitors sharing them
+    static SharedCache<QThread *, StallWatchdog>::Stats watchdogStats();
+
+    static constexpr int DefaultStallThresholdMs = 200;
+    static constexpr int MaxStoredStalls = StallWatchdog::MaxStoredStalls;
+
+signals:
+    void stallDetected(qint64 blockedMs);
+
+private:
+    void onBeat(qint64 lateUs);
+
+    int thresholdMs;
+
+    LatencyHistogram loopLatency;
+    LatencyHistogram loopWindow;
+    LatencyHistogram frames;
+    LatencyHistogram frameWindow;
+    qint64 windowStartNs;
+
+    QVector<QPair<QString, std::function<qint64()>>> memorySources;
+    QVector<QPair<QString, std::function<QString()>>> gauges;
+
+    std::shared_ptr<StallWatchdog> watchdog;
+};
+
+#endif // PERFMONITOR_H
\ No newline at end of file
@@ -0,0 +1,88 @@
+# Everything except main(): shared by the application, the benchmarks and the tests
+QT += core gui multimedia
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+CONFIG += c++17
+
+# Compile out log levels below this one (0 debug ... 4 error)
+DEFINES += PHONE_LOG_MIN_LEVEL=0
+
+# Heap profiling per operation (qmake CONFIG+=alloc_tracking); interposes malloc on glibc
+alloc_tracking: DEFINES += PHONE_ALLOC_TRACKING
+
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+SOURCES += \
+    $$PWD/camera.cpp \
+    $$PWD/musicplayer.cpp \
+    $$PWD/smartphone.cpp \
+    $$PWD/mainwindow.cpp \
+    $$PWD/startupprofiler.cpp \
+    $$PWD/simulationclock.cpp \
+    $$PWD/powermodel.cpp \
+    $$PWD/latencyhistogram.cpp \
+    $$PWD/workstealingexecutor.cpp \
+    $$PWD/appscheduler.cpp \
+    $$PWD/eventbus.cpp \
+    $$PWD/phonesnapshot.cpp \
+    $$PWD/interactiontrace.cpp \
+    $$PWD/replayengine.cpp \
+    $$PWD/headlessdriver.cpp \
+    $$PWD/phoneviewmodel.cpp \
+    $$PWD/activitylogmodel.cpp \
+    $$PWD/phonelog.cpp \
+    $$PWD/tracing.cpp \
+    $$PWD/perfmonitor.cpp \
+    $$PWD/perfhud.cpp \
+    $$PWD/asyncphone.cpp \
+    $$PWD/allocationtracker.cpp \
+    $$PWD/scratcharena.cpp \
+    $$PWD/audioencoder.cpp \
+    $$PWD/voicerecorder.cpp \
+    $$PWD/frameanalyzer.cpp \
+    $$PWD/searchindex.cpp \
+    $$PWD/kvstore.cpp \
+    $$PWD/contentserver.cpp \
+    $$PWD/networkstack.cpp \
+    $$PWD/photobackup.cpp
+
+HEADERS += \
+    $$PWD/camera.h \
+    $$PWD/musicplayer.h \
+    $$PWD/smartphone.h \
+    $$PWD/mainwindow.h \
+    $$PWD/startupprofiler.h \
+    $$PWD/simulationclock.h \
+    $$PWD/powermodel.h \
+    $$PWD/latencyhistogram.h \
+    $$PWD/workstealingexecutor.h \
+    $$PWD/appscheduler.h \
+    $$PWD/eventbus.h \
+    $$PWD/lockfreequeue.h \
+    $$PWD/phonesnapshot.h \
+    $$PWD/interactiontrace.h \
+    $$PWD/replayengine.h \
+    $$PWD/headlessdriver.h \
+    $$PWD/phoneviewmodel.h \
+    $$PWD/activitylogmodel.h \
+    $$PWD/phonelog.h \
+    $$PWD/tracing.h \
+    $$PWD/perfmonitor.h \
+    $$PWD/perfhud.h \
+    $$PWD/asyncphone.h \
+    $$PWD/allocationtracker.h \
+    $$PWD/scratcharena.h \
+    $$PWD/audioencoder.h \
+    $$PWD/voicerecorder.h \
+    $$PWD/frameanalyzer.h \
+    $$PWD/searchindex.h \
+    $$PWD/kvstore.h \
+    $$PWD/sharedcache.h \
+    $$PWD/contentserver.h \
+    $$PWD/networkstack.h \
+    $$PWD/photobackup.h
+
+# Exported symbols let the stall detector name functions in stack samples
+linux: QMAKE_LFLAGS += -rdynamic
\ No newline at end of file
@@ -0,0 +1,384 @@
+#include "phonelog.h"
+#include "lockfreequeue.h"
+#include "tracing.h"
+#include "allocationtracker.h"
+#include <QDateTime>
+#include <QFile>
+#include <QMap>
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int WriterIntervalMs = 20;
+
+struct ThreadBuffer
+{
+    ThreadBuffer() : ring(PhoneLog::ThreadBufferCapacity), orphaned(false) {}
+
+    SpscRing<PhoneLog::Record> ring;
+    std::atomic<bool> orphaned;     // owning thread has exited
+};
+
+class LogWriter
+{
+public:
+    static LogWriter &instance()
+    {
+        static LogWriter writer;
+        return writer;
+    }
+
+    ~LogWriter()
+    {
+        stop();
+    }
+
+    std::shared_ptr<ThreadBuffer> registerThread()
+    {
+        auto buffer = std::make_shared<ThreadBuffer>();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            buffers.push_back(buffer);
+        }
+        ensureRunning();
+        return buffer;
+    }
+
+    void ensureRunning()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!thread.joinable()) {
+            stopping = false;
+            thread = std::thread([this]() { run(); });
+        }
+    }
+
+    void flush()
+    {
+        ensureRunning();
+        std::unique_lock<std::mutex> lock(mutex);
+        quint64 target = ++flushRequested;
+        wake.notify_all();
+        flushed.wait(lock, [&]() { return flushCompleted >= target; });
+    }
+
+    // A thread's ring is filling up; drain now instead of at the next interval
+    void nudge()
+    {
+        nudged.store(true, std::memory_order_release);
+        wake.notify_one();
+    }
+
+    void stop()
+    {
+        std::thread worker;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!thread.joinable()) {
+                return;
+            }
+            stopping = true;
+            worker = std::move(thread);
+        }
+        wake.notify_all();
+        worker.join();
+    }
+
+    bool setLogFile(const QString &path)
+    {
+        std::lock_guard<std::mutex> lock(sinkMutex);
+        file.close();
+        if (path.isEmpty()) {
+            return true;
+        }
+        file.setFileName(path);
+        return file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text);
+    }
+
+    PhoneLog::SinkId addSink(PhoneLog::Sink sink)
+    {
+        std::lock_guard<std::mutex> lock(sinkMutex);
+        PhoneLog::SinkId id = nextSinkId++;
+        sinks.insert(id, std::move(sink));
+        return id;
+    }
+
+    void removeSink(PhoneLog::SinkId id)
+    {
+        std::lock_guard<std::mutex> lock(sinkMutex);
+        sinks.remove(id);
+    }
+
+    std::atomic<bool> console{true};
+    std::atomic<bool> nudged{false};
+    std::atomic<quint64> written{0};
+    std::atomic<quint64> dropped{0};
+
+private:
+    LogWriter()
+    {
+        using namespace std::chrono;
+        epochOffsetNs = duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count()
+                        - steady_clock::now().time_since_epoch().count();
+    }
+
+    void run()
+    {
+        Tracer::setThreadName("log writer");
+        std::vector<PhoneLog::Record> records;
+        QVector<LogEntry> batch;
+        for (;;) {
+            std::vector<std::shared_ptr<ThreadBuffer>> snapshot;
+            quint64 target;
+            bool stop;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait_for(lock, std::chrono::milliseconds(WriterIntervalMs), [&]() {
+                    return stopping || flushRequested > flushCompleted
+                           || nudged.load(std::memory_order_acquire);
+                });
+                nudged.store(false, std::memory_order_relaxed);
+                target = flushRequested;
+                stop = stopping;
+                snapshot = buffers;
+            }
+
+            drain(snapshot, records);
+            if (!records.empty()) {
+                TRACE_SPAN("PhoneLog::writeBatch", "log");
+                ALLOC_SCOPE("PhoneLog::writeBatch", "log");
+                format(records, batch);
+                deliver(batch);
+                written.fetch_add(quint64(batch.size()), std::memory_order_relaxed);
+                records.clear();
+                batch.clear();
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            // Buffers of exited threads go once they are empty
+            buffers.erase(std::remove_if(buffers.begin(), buffers.end(),
+                                         [](const std::shared_ptr<ThreadBuffer> &buffer) {
+                                             return buffer->orphaned.load(std::memory_order_acquire)
+                                                    && buffer->ring.sizeApprox() == 0;
+                                         }),
+                          buffers.end());
+            flushCompleted = target;
+            flushed.notify_all();
+            if (stop) {
+                return;
+            }
+        }
+    }
+
+    void drain(const std::vector<std::shared_ptr<ThreadBuffer>> &snapshot,
+               std::vector<PhoneLog::Record> &records)
+    {
+        PhoneLog::Record record;
+        for (const std::shared_ptr<ThreadBuffer> &buffer : snapshot) {
+            while (buffer->ring.tryPop(record)) {
+                records.push_back(std::move(record));
+            }
+        }
+        // Threads are drained one after another; restore a single timeline
+        std::stable_sort(records.begin(), records.end(),
+                         [](const PhoneLog::Record &a, const PhoneLog::Record &b) {
+                             return a.timeNs < b.timeNs;
+                         });
+    }
+
+    void format(const std::vector<PhoneLog::Record> &records, QVector<LogEntry> &batch)
+    {
+        batch.reserve(int(records.size()));
+        for (const PhoneLog::Record &record : records) {
+            LogEntry entry;
+            entry.timestamp = (record.timeNs + epochOffsetNs) / 1000000;
+            entry.level = record.level;
+            entry.origin = record.origin;
+            entry.source = QString::fromUtf8(record.source);
+            entry.message = QString::fromUtf8(record.format);
+            for (int i = 0; i < record.argCount; ++i) {
+                const LogArg::Value &arg = record.args[i];
+                switch (record.argTypes[i]) {
+                case LogArg::Int:     entry.message = entry.message.arg(arg.i); break;
+                case LogArg::UInt:    entry.message = entry.message.arg(arg.u); break;
+                case LogArg::Double:  entry.message = entry.message.arg(arg.d); break;
+                case LogArg::Literal: entry.message = entry.message.arg(QString::fromUtf8(arg.literal)); break;
+                case LogArg::String:  entry.message = entry.message.arg(record.strings[arg.u]); break;
+                case LogArg::None:    break;
+                }
+            }
+            batch.append(std::move(entry));
+        }
+    }
+
+    void deliver(const QVector<LogEntry> &batch)
+    {
+        std::lock_guard<std::mutex> lock(sinkMutex);
+        bool toConsole = console.load(std::memory_order_relaxed);
+        if (toConsole || file.isOpen()) {
+            QByteArray text;
+            for (const LogEntry &entry : batch) {
+                text += QDateTime::fromMSecsSinceEpoch(entry.timestamp).toString("hh:mm:ss.zzz").toUtf8();
+                text += ' ';
+                text += LogEntry::levelName(entry.level).leftJustified(5).toUtf8();
+                text += ' ';
+                if (entry.origin != 0) {
+                    text += '[' + QByteArray::number(entry.origin) + "] ";
+                }
+                text += entry.source.toUtf8();
+                text += ": ";
+                text += entry.message.toUtf8();
+                text += '\n';
+            }
+            if (toConsole) {
+                std::fwrite(text.constData(), 1, size_t(text.size()), stderr);
+            }
+            if (file.isOpen()) {
+                file.write(text);
+                file.flush();
+            }
+        }
+        for (const PhoneLog::Sink &sink : sinks) {
+            sink(batch);
+        }
+    }
+
+    std::mutex mutex;               // buffers, thread, flush bookkeeping
+    std::condition_variable wake;
+    std::condition_variable flushed;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::thread thread;
+    bool stopping = false;
+    quint64 flushRequested = 0;
+    quint64 flushCompleted = 0;
+    qint64 epochOffsetNs = 0;
+
+    std::mutex sinkMutex;           // file and sinks
+    QFile file;
+    QMap<PhoneLog::SinkId, PhoneLog::Sink> sinks;
+    PhoneLog::SinkId nextSinkId = 0;
+};
+
+// Marks the thread's buffer orphaned when the thread exits
+struct ThreadHandle
+{
+    ~ThreadHandle()
+    {
+        if (buffer) {
+            buffer->orphaned.store(true, std::memory_order_release);
+        }
+    }
+
+    std::shared_ptr<ThreadBuffer> buffer;
+};
+
+thread_local ThreadHandle threadHandle;
+thread_local quint16 threadOriginTag = 0;
+
+} // namespace
+
+std::atomic<LogEntry::Level> PhoneLog::threshold{LogEntry::Debug};
+
+QString LogEntry::levelName(Level level)
+{
+    switch (level) {
+    case Debug:      return "DEBUG";
+    case Info:       return "INFO";
+    case Success:    return "OK";
+    case Warning:    return "WARN";
+    case Error:      return "ERROR";
+    case LevelCount: break;
+    }
+    return "?";
+}
+
+void PhoneLog::setLevel(LogEntry::Level level)
+{
+    threshold.store(level, std::memory_order_relaxed);
+}
+
+LogEntry::Level PhoneLog::level()
+{
+    return threshold.load(std::memory_order_relaxed);
+}
+
+void PhoneLog::setConsoleOutput(bool enabled)
+{
+    LogWriter::instance().console.store(enabled, std::memory_order_relaxed);
+}
+
+bool PhoneLog::setLogFile(const QString &path)
+{
+    return LogWriter::instance().setLogFile(path);
+}
+
+PhoneLog::SinkId PhoneLog::addSink(Sink sink)
+{
+    return LogWriter::instance().addSink(std::move(sink));
+}
+
+void PhoneLog::removeSink(SinkId id)
+{
+    LogWriter::instance().removeSink(id);
+}
+
+void PhoneLog::flush()
+{
+    LogWriter::instance().flush();
+}
+
+void PhoneLog::shutdown()
+{
+    LogWriter::instance().stop();
+}
+
+quint64 PhoneLog::writtenCount()
+{
+    return LogWriter::instance().written.load(std::memory_order_relaxed);
+}
+
+quint64 PhoneLog::droppedCount()
+{
+    return LogWriter::instance().dropped.load(std::memory_order_relaxed);
+}
+
+void PhoneLog::setThreadOrigin(quint16 origin)
+{
+    threadOriginTag = origin;
+}
+
+quint16 PhoneLog::threadOrigin()
+{
+    return threadOriginTag;
+}
+
+PhoneLog::Record *PhoneLog::reserve()
+{
+    ThreadBuffer *buffer = threadHandle.buffer.get();
+    if (!buffer) {
+        threadHandle.buffer = LogWriter::instance().registerThread();
+        buffer = threadHandle.buffer.get();
+    }
+    Record *record = buffer->ring.reserve();
+    if (!record) {
+        LogWriter::instance().dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    record->origin = threadOriginTag;
+    return record;
+}
+
+void PhoneLog::commit()
+{
+    SpscRing<Record> &ring = threadHandle.buffer->ring;
+    ring.commit();
+    if (ring.sizeApprox() == ring.capacity() / 2) {
+        LogWriter::instance().nudge();
+    }
+}
\ No newline at end of file
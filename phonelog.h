@@ -0,0 +1,182 @@
+#ifndef PHONELOG_H
+#define PHONELOG_H
+
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <type_traits>
+
+struct LogEntry
+{
+    enum Level : quint8 { Debug, Info, Success, Warning, Error, LevelCount };
+
+    qint64 timestamp = 0;   // ms since epoch
+    Level level = Info;
+    quint16 origin = 0;     // phone that wrote it (PhoneLog::setThreadOrigin); 0 = none
+    QString source;
+    QString message;
+
+    static QString levelName(Level level);
+};
+
+// Levels below this are compiled out entirely (qmake: DEFINES += PHONE_LOG_MIN_LEVEL=2)
+#ifndef PHONE_LOG_MIN_LEVEL
+#define PHONE_LOG_MIN_LEVEL 0
+#endif
+
+// One captured format argument other than a string. QString arguments go
+// to the record's string slots and are shared, not copied; const char *
+// arguments must outlive the write (string literals).
+struct LogArg
+{
+    enum Type : quint8 { None, Int, UInt, Double, Literal, String };
+    union Value {
+        qint64 i;
+        quint64 u;      // also the string slot of a String
+        double d;
+        const char *literal;
+    };
+
+    Type type;
+    Value value;
+
+    LogArg(bool v) : type(Int) { value.i = v; }
+    LogArg(int v) : type(Int) { value.i = v; }
+    LogArg(long v) : type(Int) { value.i = v; }
+    LogArg(long long v) : type(Int) { value.i = v; }
+    LogArg(unsigned v) : type(UInt) { value.u = v; }
+    LogArg(unsigned long v) : type(UInt) { value.u = v; }
+    LogArg(unsigned long long v) : type(UInt) { value.u = v; }
+    LogArg(double v) : type(Double) { value.d = v; }
+    LogArg(const char *v) : type(Literal) { value.literal = v; }
+};
+
+// Asynchronous structured logger. A write captures the level, a literal
+// source and format and up to MaxArgs arguments (at most MaxStringArgs of
+// them strings) into the calling thread's own lock-free ring; nothing is
+// formatted there. A background writer drains every ring, formats the
+// entries ("%1"-style placeholders) and hands them in batches to the
+// console, a file and any added sinks.
+// Use the PHONE_LOG_* macros: levels below PHONE_LOG_MIN_LEVEL vanish at
+// compile time and levels below the runtime level cost one relaxed load.
+class PhoneLog
+{
+public:
+    using Sink = std::function<void(const QVector<LogEntry> &batch)>;
+    using SinkId = int;
+
+    static constexpr int MaxArgs = 4;
+    static constexpr int MaxStringArgs = 2;
+    // Records per thread; the writer is woken when one is half full
+    static constexpr int ThreadBufferCapacity = 1024;
+
+    static void setLevel(LogEntry::Level level);
+    static LogEntry::Level level();
+    static bool isEnabled(LogEntry::Level level)
+    {
+        return level >= threshold.load(std::memory_order_relaxed);
+    }
+
+    static void setConsoleOutput(bool enabled);
+    // Empty path closes the log file
+    static bool setLogFile(const QString &path);
+    // Called on the writer thread
+    static SinkId addSink(Sink sink);
+    static void removeSink(SinkId id);
+
+    // Block until everything written so far has reached the sinks
+    static void flush();
+    // Flush and stop the writer thread; later writes start it again
+    static void shutdown();
+
+    static quint64 writtenCount();
+    static quint64 droppedCount();
+
+    // Tags the calling thread's later entries with a phone number, so a
+    // process running several phones can tell their logs apart
+    static void setThreadOrigin(quint16 origin);
+    static quint16 threadOrigin();
+
+    template <typename... Args>
+    static void write(LogEntry::Level level, const char *source, const char *format,
+                      const Args &...args)
+    {
+        static_assert(sizeof...(Args) <= MaxArgs, "too many log arguments");
+        static_assert((0 + ... + int(!std::is_convertible_v<const Args &, LogArg>)) <= MaxStringArgs,
+                      "too many string log arguments");
+        Record *record = reserve();
+        if (!record) {
+            return;
+        }
+        record->timeNs = std::chrono::steady_clock::now().time_since_epoch().count();
+        record->level = level;
+        record->source = source;
+        record->format = format;
+        record->argCount = quint8(sizeof...(Args));
+        int index = 0;
+        int strings = 0;
+        (capture(*record, index++, strings, args), ...);
+        Q_UNUSED(index);
+        Q_UNUSED(strings);
+        commit();
+    }
+
+    // Argument types, values and strings are stored apart, so a record
+    // (112 bytes on 64-bit) has no padding per argument
+    struct Record
+    {
+        qint64 timeNs = 0;      // steady clock
+        LogEntry::Level level = LogEntry::Info;
+        quint8 argCount = 0;
+        quint16 origin = 0;
+        LogArg::Type argTypes[MaxArgs] = {};
+        const char *source = nullptr;
+        const char *format = nullptr;
+        LogArg::Value args[MaxArgs] = {};
+        QString strings[MaxStringArgs];
+    };
+
+private:
+    PhoneLog() = delete;
+
+    // Slot in the calling thread's ring, or null when it is full (counted as dropped)
+    static Record *reserve();
+    static void commit();
+
+    static void capture(Record &record, int index, int &, const LogArg &arg)
+    {
+        record.argTypes[index] = arg.type;
+        record.args[index] = arg.value;
+    }
+    static void capture(Record &record, int index, int &strings, const char *arg)
+    {
+        capture(record, index, strings, LogArg(arg));
+    }
+    static void capture(Record &record, int index, int &strings, const QString &arg)
+    {
+        record.argTypes[index] = LogArg::String;
+        record.args[index].u = quint64(strings);
+        record.strings[strings++] = arg;
+    }
+
+    static std::atomic<LogEntry::Level> threshold;
+};
+
+#define PHONE_LOG(level, source, ...)                                           \
+    do {                                                                        \
+        if constexpr (int(level) >= PHONE_LOG_MIN_LEVEL) {                      \
+            if (PhoneLog::isEnabled(level)) {                                   \
+                PhoneLog::write(level, source, __VA_ARGS__);                    \
+            }                                                                   \
+        }                                                                       \
+    } while (false)
+
+#define PHONE_LOG_DEBUG(source, ...)   PHONE_LOG(LogEntry::Debug, source, __VA_ARGS__)
+#define PHONE_LOG_INFO(source, ...)    PHONE_LOG(LogEntry::Info, source, __VA_ARGS__)
+#define PHONE_LOG_SUCCESS(source, ...) PHONE_LOG(LogEntry::Success, source, __VA_ARGS__)
+#define PHONE_LOG_WARNING(source, ...) PHONE_LOG(LogEntry::Warning, source, __VA_ARGS__)
+#define PHONE_LOG_ERROR(source, ...)   PHONE_LOG(LogEntry::Error, source, __VA_ARGS__)
+
+#endif // PHONELOG_H
\ No newline at end of file
@@ -0,0 +1,240 @@
+#include "phonesnapshot.h"
+#include "smartphone.h"
+#include "phonelog.h"
+#include <QSaveFile>
+#include <QByteArray>
+#include <cstring>
+
+namespace {
+
+// On-disk layout, native byte order (little-endian on every supported target)
+struct FileHeader
+{
+    char magic[4];
+    quint32 version;
+    quint32 phoneCount;
+    quint32 recordSize;
+    quint64 fileSize;
+};
+
+struct PhoneRecord
+{
+    qint64 clockNowMs;
+    qint64 playbackPositionMs;
+    quint64 photoIndexOffset;
+    quint64 songPathOffset;
+    quint32 photoIndexCount;
+    quint32 songPathLength;     // UTF-16 code units
+    quint32 flags;
+    qint32 storageUsedMB;
+    qint32 totalStorageMB;
+    qint32 photoCount;
+};
+
+static_assert(sizeof(FileHeader) == 24, "snapshot header layout changed");
+static_assert(sizeof(PhoneRecord) == 56, "snapshot record layout changed");
+static_assert(sizeof(PhotoRecord) == 16, "photo record layout changed");
+
+constexpr char Magic[4] = {'S', 'P', 'H', 'S'};
+constexpr quint32 FlagUnlocked = 1u << 0;
+
+qint64 align8(qint64 offset)
+{
+    return (offset + 7) & ~qint64(7);
+}
+
+} // namespace
+
+bool PhoneSnapshot::save(const QString &path, const QVector<const Smartphone *> &phones)
+{
+    const qint64 recordsStart = sizeof(FileHeader);
+    qint64 payloadSize = 0;
+    for (const Smartphone *phone : phones) {
+        payloadSize = align8(payloadSize) + phone->photoIndex.size() * qint64(sizeof(PhotoRecord));
+        payloadSize = align8(payloadSize) + phone->currentFilePath.size() * qint64(sizeof(char16_t));
+    }
+    qint64 payloadStart = align8(recordsStart + phones.size() * qint64(sizeof(PhoneRecord)));
+
+    QByteArray blob(align8(payloadStart + payloadSize), '\0');
+    char *out = blob.data();
+
+    FileHeader header;
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = FormatVersion;
+    header.phoneCount = quint32(phones.size());
+    header.recordSize = sizeof(PhoneRecord);
+    header.fileSize = quint64(blob.size());
+    std::memcpy(out, &header, sizeof(header));
+
+    qint64 cursor = payloadStart;
+    for (int i = 0; i < phones.size(); ++i) {
+        const Smartphone &phone = *phones[i];
+        PhoneRecord record;
+        std::memset(&record, 0, sizeof(record));
+        record.clockNowMs = phone.clock->now();
+        record.playbackPositionMs = phone.getPlaybackPosition();
+        record.flags = phone.phoneUnlocked ? FlagUnlocked : 0;
+        record.storageUsedMB = phone.storageUsed;
+        record.totalStorageMB = phone.totalStorage;
+        record.photoCount = phone.photoCount;
+
+        cursor = align8(cursor);
+        record.photoIndexOffset = quint64(cursor);
+        record.photoIndexCount = quint32(phone.photoIndex.size());
+        qint64 photoBytes = phone.photoIndex.size() * qint64(sizeof(PhotoRecord));
+        if (photoBytes > 0) {
+            std::memcpy(out + cursor, phone.photoIndex.constData(), size_t(photoBytes));
+        }
+        cursor += photoBytes;
+
+        cursor = align8(cursor);
+        record.songPathOffset = quint64(cursor);
+        record.songPathLength = quint32(phone.currentFilePath.size());
+        qint64 pathBytes = phone.currentFilePath.size() * qint64(sizeof(char16_t));
+        if (pathBytes > 0) {
+            std::memcpy(out + cursor, phone.currentFilePath.utf16(), size_t(pathBytes));
+        }
+        cursor += pathBytes;
+
+        std::memcpy(out + recordsStart + i * qint64(sizeof(PhoneRecord)), &record, sizeof(record));
+    }
+
+    QSaveFile saveFile(path);
+    if (!saveFile.open(QIODevice::WriteOnly)) {
+        PHONE_LOG_ERROR("snapshot", "❌ Cannot write snapshot: %1", path);
+        return false;
+    }
+    saveFile.write(blob);
+    return saveFile.commit();
+}
+
+bool PhoneSnapshot::save(const QString &path, const Smartphone &phone)
+{
+    return save(path, QVector<const Smartphone *>{&phone});
+}
+
+PhoneSnapshot::PhoneSnapshot(const QString &path)
+    : file(path), data(nullptr), size(0)
+{
+    if (!file.open(QIODevice::ReadOnly)) {
+        fail("cannot open " + path);
+        return;
+    }
+    size = file.size();
+    if (size < qint64(sizeof(FileHeader))) {
+        fail("file too small");
+        return;
+    }
+    data = file.map(0, size);
+    if (!data) {
+        fail("mmap failed: " + file.errorString());
+        return;
+    }
+
+    const FileHeader *header = reinterpret_cast<const FileHeader *>(data);
+    if (std::memcmp(header->magic, Magic, sizeof(Magic)) != 0) {
+        fail("not a phone snapshot");
+    } else if (header->version != FormatVersion) {
+        fail(QString("unsupported snapshot version %1").arg(header->version));
+    } else if (header->recordSize < sizeof(PhoneRecord) || header->fileSize != quint64(size)) {
+        fail("corrupt snapshot header");
+    } else if (quint64(sizeof(FileHeader)) + quint64(header->phoneCount) * header->recordSize > quint64(size)) {
+        fail("truncated snapshot");
+    }
+}
+
+PhoneSnapshot::~PhoneSnapshot()
+{
+    if (data) {
+        file.unmap(const_cast<uchar *>(data));
+    }
+}
+
+bool PhoneSnapshot::isValid() const
+{
+    return data && error.isEmpty();
+}
+
+QString PhoneSnapshot::errorString() const
+{
+    return error;
+}
+
+int PhoneSnapshot::phoneCount() const
+{
+    return isValid() ? int(reinterpret_cast<const FileHeader *>(data)->phoneCount) : 0;
+}
+
+bool PhoneSnapshot::restore(int index, Smartphone &phone) const
+{
+    if (index < 0 || index >= phoneCount()) {
+        return false;
+    }
+
+    const FileHeader *header = reinterpret_cast<const FileHeader *>(data);
+    PhoneRecord record;
+    std::memcpy(&record, data + sizeof(FileHeader) + quint64(index) * header->recordSize, sizeof(record));
+
+    quint64 photoBytes = quint64(record.photoIndexCount) * sizeof(PhotoRecord);
+    quint64 pathBytes = quint64(record.songPathLength) * sizeof(char16_t);
+    if (record.photoIndexOffset + photoBytes > quint64(size) || record.songPathOffset + pathBytes > quint64(size)) {
+        PHONE_LOG_ERROR("snapshot", "❌ Snapshot record %1 points outside the file", index);
+        return false;
+    }
+
+    // A RealTime clock keeps following the wall clock; otherwise the
+    // simulation resumes where it was saved
+    if (phone.clock->mode() != SimulationClock::Mode::RealTime) {
+        phone.clock->setCurrentDateTime(QDateTime::fromMSecsSinceEpoch(record.clockNowMs));
+    }
+    const qint64 now = phone.clock->now();
+
+    phone.photoIndex.resize(record.photoIndexCount);
+    if (photoBytes > 0) {
+        std::memcpy(phone.photoIndex.data(), data + record.photoIndexOffset, photoBytes);
+    }
+    phone.photoCount = record.photoCount;
+    phone.lastPhotoPath = phone.photoIndex.isEmpty() ? QString() : phone.photoPathFor(phone.photoIndex.last());
+
+    phone.storageUsed = record.storageUsedMB;
+    phone.totalStorage = record.totalStorageMB;
+    phone.bus->publish(PhoneEvent::StorageChanged, now, phone.storageUsed);
+
+    if (record.songPathLength > 0) {
+        QString songPath = QString::fromUtf16(reinterpret_cast<const char16_t *>(data + record.songPathOffset),
+                                              record.songPathLength);
+        phone.restoreTrack(songPath, record.playbackPositionMs);
+        phone.bus->publish(PhoneEvent::TrackChanged, now, 0, phone.currentSong);
+    }
+    if (!phone.lastPhotoPath.isEmpty()) {
+        phone.bus->publish(PhoneEvent::PhotoCaptured, now, phone.photoCount, phone.lastPhotoPath);
+    }
+    phone.reindexContent();
+
+    if (record.flags & FlagUnlocked) {
+        phone.resumeUnlocked();
+    } else {
+        phone.lockPhone();
+    }
+    phone.persistState();
+    return true;
+}
+
+int PhoneSnapshot::restoreAll(const QVector<Smartphone *> &phones) const
+{
+    int restored = 0;
+    int count = qMin(phoneCount(), int(phones.size()));
+    for (int i = 0; i < count; ++i) {
+        if (restore(i, *phones[i])) {
+            ++restored;
+        }
+    }
+    return restored;
+}
+
+bool PhoneSnapshot::fail(const QString &message)
+{
+    error = message;
+    PHONE_LOG_ERROR("snapshot", "❌ Snapshot error: %1", message);
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#ifndef PHONESNAPSHOT_H
+#define PHONESNAPSHOT_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+class Smartphone;
+
+// Versioned binary checkpoint of complete phone state: lock state, storage
+// counters, photo index, track and position, and the simulation clock.
+// Records are fixed-layout and the photo index and strings are stored in
+// their in-memory form, so a restore maps the file and copies straight out
+// of it with no parsing. One file can hold a whole fleet. A phone whose
+// clock runs in real time keeps the current time when restored.
+class PhoneSnapshot
+{
+public:
+    static constexpr quint32 FormatVersion = 1;
+
+    static bool save(const QString &path, const QVector<const Smartphone *> &phones);
+    static bool save(const QString &path, const Smartphone &phone);
+
+    explicit PhoneSnapshot(const QString &path);
+    ~PhoneSnapshot();
+
+    PhoneSnapshot(const PhoneSnapshot &) = delete;
+    PhoneSnapshot &operator=(const PhoneSnapshot &) = delete;
+
+    bool isValid() const;
+    QString errorString() const;
+    int phoneCount() const;
+
+    bool restore(int index, Smartphone &phone) const;
+    // Restores min(phoneCount(), phones.size()) phones in order
+    int restoreAll(const QVector<Smartphone *> &phones) const;
+
+private:
+    bool fail(const QString &message);
+
+    QFile file;
+    const uchar *data;
+    qint64 size;
+    QString error;
+};
+
+#endif // PHONESNAPSHOT_H
\ No newline at end of file
@@ -0,0 +1,175 @@
+#include "phoneviewmodel.h"
+#include "smartphone.h"
+#include <QTimer>
+
+PhoneViewModel::PhoneViewModel(QObject *parent)
+    : QObject(parent), unlocked(false), music(MusicState::NoTrack), cameraAvailable(true),
+      battery(100), dirty(0), frameTimer(new QTimer(this)), fieldChanges(0), frames(0)
+{
+    frameTimer->setSingleShot(true);
+    frameTimer->setInterval(FrameIntervalMs);
+    connect(frameTimer, &QTimer::timeout, this, &PhoneViewModel::flush);
+}
+
+void PhoneViewModel::apply(const PhoneEvent &event)
+{
+    switch (event.type) {
+    case PhoneEvent::PhoneUnlocked:
+        setUnlocked(true);
+        break;
+    case PhoneEvent::PhoneLocked:
+    case PhoneEvent::UnlockFailed:
+        setUnlocked(false);
+        break;
+    case PhoneEvent::PhotoCaptured:
+        setLastPhoto(event.text);
+        break;
+    case PhoneEvent::TrackChanged:
+        setMusic(music == MusicState::Playing ? MusicState::Playing : MusicState::Loaded, event.text);
+        break;
+    case PhoneEvent::PlaybackChanged:
+        setMusic(event.value ? MusicState::Playing : MusicState::Loaded,
+                 event.text.isEmpty() ? currentSong : event.text);
+        break;
+    case PhoneEvent::BatteryChanged:
+        setBatteryPercent(int(event.value));
+        break;
+    default:
+        break;
+    }
+}
+
+PhoneViewModel::Snapshot PhoneViewModel::capture(const Smartphone &phone)
+{
+    Snapshot snapshot;
+    snapshot.unlocked = phone.isPhoneUnlocked();
+    snapshot.cameraAvailable = phone.isCameraAvailable();
+    snapshot.lastPhoto = phone.getLastPhotoPath();
+    snapshot.battery = int(phone.getBatteryLevel());
+
+    snapshot.song = phone.getCurrentSong();
+    if (phone.isMusicPlaying()) {
+        snapshot.music = MusicState::Playing;
+    } else if (snapshot.song != "None") {
+        snapshot.music = MusicState::Loaded;
+    } else {
+        snapshot.music = MusicState::NoTrack;
+    }
+    return snapshot;
+}
+
+void PhoneViewModel::syncFrom(const Snapshot &snapshot)
+{
+    setUnlocked(snapshot.unlocked);
+    setCameraAvailable(snapshot.cameraAvailable);
+    setLastPhoto(snapshot.lastPhoto);
+    setBatteryPercent(snapshot.battery);
+    setMusic(snapshot.music, snapshot.song);
+}
+
+void PhoneViewModel::setUnlocked(bool value)
+{
+    if (unlocked != value) {
+        unlocked = value;
+        markDirty(LockField);
+    }
+}
+
+void PhoneViewModel::setMusic(MusicState state, const QString &song)
+{
+    if (music != state || currentSong != song) {
+        music = state;
+        currentSong = song;
+        markDirty(MusicField);
+    }
+}
+
+void PhoneViewModel::setLastPhoto(const QString &path)
+{
+    if (lastPhotoPath != path) {
+        lastPhotoPath = path;
+        markDirty(LastPhotoField);
+    }
+}
+
+void PhoneViewModel::setCameraAvailable(bool available)
+{
+    if (cameraAvailable != available) {
+        cameraAvailable = available;
+        markDirty(CameraField);
+    }
+}
+
+void PhoneViewModel::setBatteryPercent(int percent)
+{
+    if (battery != percent) {
+        battery = percent;
+        markDirty(BatteryField);
+    }
+}
+
+bool PhoneViewModel::isUnlocked() const
+{
+    return unlocked;
+}
+
+PhoneViewModel::MusicState PhoneViewModel::musicState() const
+{
+    return music;
+}
+
+QString PhoneViewModel::song() const
+{
+    return currentSong;
+}
+
+QString PhoneViewModel::lastPhoto() const
+{
+    return lastPhotoPath;
+}
+
+bool PhoneViewModel::isCameraAvailable() const
+{
+    return cameraAvailable;
+}
+
+int PhoneViewModel::batteryPercent() const
+{
+    return battery;
+}
+
+quint32 PhoneViewModel::takeDirty()
+{
+    quint32 fields = dirty;
+    dirty = 0;
+    frameTimer->stop();
+    return fields;
+}
+
+quint64 PhoneViewModel::fieldChangeCount() const
+{
+    return fieldChanges;
+}
+
+quint64 PhoneViewModel::frameCount() const
+{
+    return frames;
+}
+
+void PhoneViewModel::markDirty(Field field)
+{
+    fieldChanges++;
+    if (dirty == 0) {
+        frameTimer->start();
+    }
+    dirty |= field;
+}
+
+void PhoneViewModel::flush()
+{
+    quint32 fields = takeDirty();
+    if (fields) {
+        frames++;
+        emit changed(fields);
+    }
+}
\ No newline at end of file
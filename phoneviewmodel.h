@@ -0,0 +1,89 @@
+#ifndef PHONEVIEWMODEL_H
+#define PHONEVIEWMODEL_H
+
+#include <QObject>
+#include <QString>
+#include "eventbus.h"
+
+class QTimer;
+class Smartphone;
+
+// Presentation state of one phone with per-field dirty tracking. Setters
+// only mark a field dirty when its value really changes, and all changes
+// within one frame are coalesced into a single changed() notification.
+class PhoneViewModel : public QObject
+{
+    Q_OBJECT
+public:
+    enum Field : quint32 {
+        LockField       = 1u << 0,
+        MusicField      = 1u << 1,
+        LastPhotoField  = 1u << 2,
+        CameraField     = 1u << 3,
+        BatteryField    = 1u << 4,
+        AllFields       = (1u << 5) - 1
+    };
+    enum class MusicState { NoTrack, Loaded, Playing };
+
+    // Everything the view shows, read from the phone in one go
+    struct Snapshot
+    {
+        bool unlocked = false;
+        MusicState music = MusicState::NoTrack;
+        QString song;
+        QString lastPhoto;
+        bool cameraAvailable = true;
+        int battery = 100;
+    };
+
+    explicit PhoneViewModel(QObject *parent = nullptr);
+
+    // Reads the phone's getters; call it on the thread that owns the phone
+    static Snapshot capture(const Smartphone &phone);
+
+    void apply(const PhoneEvent &event);
+    // Full resync (startup, fallback)
+    void syncFrom(const Snapshot &snapshot);
+
+    void setUnlocked(bool unlocked);
+    void setMusic(MusicState state, const QString &song);
+    void setLastPhoto(const QString &path);
+    void setCameraAvailable(bool available);
+    void setBatteryPercent(int percent);
+
+    bool isUnlocked() const;
+    MusicState musicState() const;
+    QString song() const;
+    QString lastPhoto() const;
+    bool isCameraAvailable() const;
+    int batteryPercent() const;
+
+    // Returns and clears the pending dirty set (cancels the pending frame)
+    quint32 takeDirty();
+
+    quint64 fieldChangeCount() const;
+    quint64 frameCount() const;
+
+    static constexpr int FrameIntervalMs = 16;
+
+signals:
+    void changed(quint32 fields);
+
+private:
+    void markDirty(Field field);
+    void flush();
+
+    bool unlocked;
+    MusicState music;
+    QString currentSong;
+    QString lastPhotoPath;
+    bool cameraAvailable;
+    int battery;
+
+    quint32 dirty;
+    QTimer *frameTimer;
+    quint64 fieldChanges;
+    quint64 frames;
+};
+
+#endif // PHONEVIEWMODEL_H
\ No newline at end of file
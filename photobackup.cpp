@@ -0,0 +1,210 @@
+#include "photobackup.h"
+#include "contentserver.h"
+#include "phonelog.h"
+#include "tracing.h"
+
+double PhotoBackup::Stats::throughputKBps() const
+{
+    return busyMs > 0 ? bytesUploaded / 1024.0 / (busyMs / 1000.0) : 0.0;
+}
+
+QString PhotoBackup::Stats::describe() const
+{
+    return QString("%1 queued (peak %2), %3 uploading; %4 backed up in %5 batches, %6 MB at %7 KB/s; "
+                   "%8 chunks failed")
+        .arg(queued)
+        .arg(peakQueued)
+        .arg(uploading)
+        .arg(backedUp)
+        .arg(batches)
+        .arg(bytesUploaded / (1024.0 * 1024.0), 0, 'f', 1)
+        .arg(throughputKBps(), 0, 'f', 0)
+        .arg(failedChunks);
+}
+
+PhotoBackup::PhotoBackup(SimulationClock *clock, NetworkStack *network, ContentServer *server)
+    : PhotoBackup(clock, network, server, Settings())
+{
+}
+
+PhotoBackup::PhotoBackup(SimulationClock *clock, NetworkStack *network, ContentServer *server,
+                         const Settings &settings)
+    : clock(clock), network(network), server(server), settings(settings), draining(false), batchEvent(0),
+      retryEvent(0), retryDelay(qMax<qint64>(1, settings.retryMs)), busySince(0)
+{
+    this->settings.batchSize = qMax(1, settings.batchSize);
+    this->settings.maxConcurrent = qMax(1, settings.maxConcurrent);
+    this->settings.retryMs = retryDelay;
+}
+
+PhotoBackup::~PhotoBackup()
+{
+    clock->cancel(batchEvent);
+    clock->cancel(retryEvent);
+    // Also drops chunks that finished but whose report is still on the way
+    for (const Item &item : queue) {
+        if (item.transfer != 0) {
+            network->cancel(item.transfer);
+        }
+    }
+}
+
+void PhotoBackup::enqueue(const QString &name, const QByteArray &data)
+{
+    if (find(name)) {
+        return;
+    }
+    queue.push_back(Item{name, data, clock->now(), 0, 0});
+    counters.queued = int(queue.size());
+    counters.peakQueued = qMax(counters.peakQueued, counters.queued);
+
+    if (draining) {
+        // The radio is up already
+        pump();
+    } else if (counters.queued >= settings.batchSize) {
+        startBatch();
+    } else if (batchEvent == 0) {
+        batchEvent = clock->scheduleAfter(settings.batchWindowMs, [this]() {
+            batchEvent = 0;
+            startBatch();
+        });
+    }
+}
+
+int PhotoBackup::queueDepth() const
+{
+    return int(queue.size());
+}
+
+PhotoBackup::Stats PhotoBackup::stats() const
+{
+    Stats stats = counters;
+    if (stats.uploading > 0) {
+        stats.busyMs += clock->now() - busySince;
+    }
+    return stats;
+}
+
+const LatencyHistogram &PhotoBackup::timeToBackup() const
+{
+    return backupTimes;
+}
+
+void PhotoBackup::setChunkSink(std::function<void(qint64 bytes)> sink)
+{
+    chunkSink = std::move(sink);
+}
+
+void PhotoBackup::startBatch()
+{
+    clock->cancel(batchEvent);
+    batchEvent = 0;
+    if (queue.empty()) {
+        return;
+    }
+    draining = true;
+    counters.batches++;
+    PHONE_LOG_INFO("backup", "☁️ Backing up %1 photo(s) over %2", int(queue.size()), network->profile().name);
+    pump();
+}
+
+void PhotoBackup::pump()
+{
+    TRACE_SPAN("PhotoBackup::pump", "network");
+    if (retryEvent != 0) {
+        // Backing off after a failure
+        return;
+    }
+    int uploading = counters.uploading;
+    for (Item &item : queue) {
+        if (uploading >= settings.maxConcurrent) {
+            break;
+        }
+        if (item.transfer == 0) {
+            sendChunk(item);
+            uploading++;
+        }
+    }
+    setUploading(uploading);
+}
+
+// Each chunk is a request of its own, starting from the server's answer
+void PhotoBackup::sendChunk(Item &item)
+{
+    item.transfer = network->upload(item.name, item.data, [this, name = item.name](bool ok) { chunkDone(name, ok); },
+                                    NetworkStack::Priority::Background, settings.chunkBytes);
+}
+
+void PhotoBackup::chunkDone(const QString &name, bool ok)
+{
+    Item *item = find(name);
+    if (!item) {
+        return;
+    }
+    item->transfer = 0;
+
+    // A failed chunk may still have left part of itself on the server
+    const qint64 received = server->receivedBytes(name);
+    const qint64 confirmed = received - item->confirmed;
+    item->confirmed = received;
+    counters.bytesUploaded += confirmed;
+    if (confirmed > 0 && chunkSink) {
+        chunkSink(confirmed);
+    }
+
+    if (!ok) {
+        counters.failedChunks++;
+        setUploading(counters.uploading - 1);
+        if (retryEvent == 0) {
+            PHONE_LOG_WARNING("backup", "Upload of %1 interrupted at %2 KB; retrying in %3 s", name,
+                              received / 1024, retryDelay / 1000.0);
+            retryEvent = clock->scheduleAfter(retryDelay, [this]() {
+                retryEvent = 0;
+                pump();
+            });
+            retryDelay = qMin(MaxRetryMs, retryDelay * 2);
+        }
+        return;
+    }
+
+    retryDelay = settings.retryMs;
+    if (!server->isUploaded(name)) {
+        // The next chunk keeps the photo's slot
+        sendChunk(*item);
+        return;
+    }
+
+    backupTimes.record(clock->now() - item->queuedAt);
+    counters.backedUp++;
+    queue.erase(queue.begin() + (item - queue.data()));
+    counters.queued = int(queue.size());
+    setUploading(counters.uploading - 1);
+    if (queue.empty()) {
+        draining = false;
+        PHONE_LOG_SUCCESS("backup", "☁️ Backup up to date: %1 photos, median %2 s from capture", counters.backedUp,
+                          backupTimes.percentile(50) / 1000.0);
+    } else {
+        pump();
+    }
+}
+
+void PhotoBackup::setUploading(int count)
+{
+    const qint64 now = clock->now();
+    if (counters.uploading == 0 && count > 0) {
+        busySince = now;
+    } else if (counters.uploading > 0 && count == 0) {
+        counters.busyMs += now - busySince;
+    }
+    counters.uploading = count;
+}
+
+PhotoBackup::Item *PhotoBackup::find(const QString &name)
+{
+    for (Item &item : queue) {
+        if (item.name == name) {
+            return &item;
+        }
+    }
+    return nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#ifndef PHOTOBACKUP_H
+#define PHOTOBACKUP_H
+
+#include "simulationclock.h"
+#include "latencyhistogram.h"
+#include "networkstack.h"
+#include <QByteArray>
+#include <QString>
+#include <functional>
+#include <vector>
+
+class ContentServer;
+
+// Uploads captured photos to the backup server in the background. Photos
+// are batched so the radio wakes once for several: a batch starts when
+// enough photos are waiting or the first of them has waited long enough,
+// and photos taken while one is running join it. At most maxConcurrent
+// photos upload at once, each as a run of chunk-sized background
+// transfers, so foreground traffic keeps the link and an interruption
+// costs at most one chunk: after a failure the queue backs off, then
+// every photo resumes from wherever the server's copy ends. enqueue()
+// only appends, and everything else runs in clock events on the phone's
+// thread, so capture never waits for the network.
+class PhotoBackup
+{
+public:
+    struct Settings
+    {
+        int batchSize = 4;                  // waiting photos that start a batch at once
+        qint64 batchWindowMs = 30000;       // longest a photo waits for a batch to fill
+        int maxConcurrent = 2;
+        qint64 chunkBytes = 512 * 1024;
+        qint64 retryMs = 5000;              // first wait after a failure; doubles up to MaxRetryMs
+    };
+
+    struct Stats
+    {
+        int queued = 0;                     // waiting or uploading
+        int peakQueued = 0;
+        int uploading = 0;
+        int backedUp = 0;
+        int batches = 0;
+        int failedChunks = 0;
+        qint64 bytesUploaded = 0;
+        qint64 busyMs = 0;                  // with at least one upload in flight
+
+        // Upload throughput while busy, KB per simulated second
+        double throughputKBps() const;
+        QString describe() const;
+    };
+
+    static constexpr qint64 MaxRetryMs = 60000;
+
+    PhotoBackup(SimulationClock *clock, NetworkStack *network, ContentServer *server);
+    PhotoBackup(SimulationClock *clock, NetworkStack *network, ContentServer *server, const Settings &settings);
+    ~PhotoBackup();
+
+    PhotoBackup(const PhotoBackup &) = delete;
+    PhotoBackup &operator=(const PhotoBackup &) = delete;
+
+    // Queues a photo for upload under name; data is shared, not copied
+    void enqueue(const QString &name, const QByteArray &data);
+
+    int queueDepth() const;
+    Stats stats() const;
+    // Capture to the server holding the whole photo, in ms of simulated time
+    const LatencyHistogram &timeToBackup() const;
+
+    // Told the bytes of every chunk the server confirmed, e.g. to charge
+    // the CPU time spent preparing them
+    void setChunkSink(std::function<void(qint64 bytes)> sink);
+
+private:
+    struct Item
+    {
+        QString name;
+        QByteArray data;
+        qint64 queuedAt;
+        qint64 confirmed;                   // bytes the server said it holds
+        NetworkStack::TransferId transfer;  // 0 while waiting
+    };
+
+    void startBatch();
+    // Fills the free upload slots from the front of the queue
+    void pump();
+    void sendChunk(Item &item);
+    void chunkDone(const QString &name, bool ok);
+    void setUploading(int count);
+    Item *find(const QString &name);
+
+    SimulationClock *clock;
+    NetworkStack *network;
+    ContentServer *server;
+    Settings settings;
+    std::vector<Item> queue;                // in capture order
+    bool draining;                          // a batch is running
+    SimulationClock::EventId batchEvent;
+    SimulationClock::EventId retryEvent;
+    qint64 retryDelay;
+    qint64 busySince;
+    Stats counters;
+    LatencyHistogram backupTimes;
+    std::function<void(qint64)> chunkSink;
+};
+
+#endif // PHOTOBACKUP_H
\ No newline at end of file
@@ -0,0 +1,136 @@
+#include "powermodel.h"
+#include <algorithm>
+
+namespace {
+
+// Lumped thermal model of the handset
+constexpr double AmbientC = 25.0;
+constexpr double HeatCapacityJPerK = 30.0;
+constexpr double ConductanceWPerK = 0.15;
+constexpr double ThrottleStartC = 40.0;
+constexpr double ThrottleFullC = 55.0;
+constexpr double MinThrottle = 0.5;
+
+} // namespace
+
+PowerModel::PowerModel(int deviceCount, double batteryCapacityJ)
+    : capacityJ(batteryCapacityJ), devices(0)
+{
+    resize(deviceCount);
+}
+
+int PowerModel::deviceCount() const
+{
+    return devices;
+}
+
+void PowerModel::resize(int deviceCount)
+{
+    devices = qMax(0, deviceCount);
+    charge.resize(devices, capacityJ);
+    temperature.resize(devices, AmbientC);
+    throttle.resize(devices, 1.0);
+    for (int c = 0; c < ComponentCount; ++c) {
+        power[c].resize(devices, 0.0);
+        energy[c].resize(devices, 0.0);
+    }
+    burstJ.resize(devices, 0.0);
+    tickJ.resize(devices, 0.0);
+}
+
+const PowerModel::Costs &PowerModel::costs() const
+{
+    return energyCosts;
+}
+
+void PowerModel::setComponentPower(int device, PowerComponent component, double watts)
+{
+    power[int(component)][device] = qMax(0.0, watts);
+}
+
+double PowerModel::componentPower(int device, PowerComponent component) const
+{
+    return power[int(component)][device];
+}
+
+void PowerModel::addEnergy(int device, PowerComponent component, double joules)
+{
+    energy[int(component)][device] += joules;
+    charge[device] = qMax(0.0, charge[device] - joules);
+    burstJ[device] += joules;
+}
+
+void PowerModel::tick(double dtSeconds)
+{
+    if (dtSeconds <= 0.0 || devices == 0) {
+        return;
+    }
+
+    const int n = devices;
+    double *drawn = tickJ.data();
+    std::fill(tickJ.begin(), tickJ.end(), 0.0);
+
+    // Plain branch-free loops over contiguous arrays so the compiler can vectorize them
+    for (int c = 0; c < ComponentCount; ++c) {
+        const double *watts = power[c].data();
+        double *joules = energy[c].data();
+        for (int i = 0; i < n; ++i) {
+            double e = watts[i] * dtSeconds;
+            joules[i] += e;
+            drawn[i] += e;
+        }
+    }
+
+    double *chargeJ = charge.data();
+    double *tempC = temperature.data();
+    double *factor = throttle.data();
+    double *burst = burstJ.data();
+    for (int i = 0; i < n; ++i) {
+        // Bursts were already taken from the battery in addEnergy(); here they only add heat
+        chargeJ[i] = std::max(0.0, chargeJ[i] - drawn[i]);
+        double heatJ = drawn[i] + burst[i] - ConductanceWPerK * (tempC[i] - AmbientC) * dtSeconds;
+        tempC[i] += heatJ / HeatCapacityJPerK;
+        burst[i] = 0.0;
+        double over = (tempC[i] - ThrottleStartC) / (ThrottleFullC - ThrottleStartC);
+        factor[i] = 1.0 - (1.0 - MinThrottle) * std::min(1.0, std::max(0.0, over));
+    }
+}
+
+double PowerModel::chargeJ(int device) const
+{
+    return charge[device];
+}
+
+double PowerModel::batteryPercent(int device) const
+{
+    return capacityJ > 0.0 ? 100.0 * charge[device] / capacityJ : 0.0;
+}
+
+double PowerModel::componentEnergyJ(int device, PowerComponent component) const
+{
+    return energy[int(component)][device];
+}
+
+double PowerModel::temperatureC(int device) const
+{
+    return temperature[device];
+}
+
+double PowerModel::throttleFactor(int device) const
+{
+    return throttle[device];
+}
+
+QString PowerModel::componentName(PowerComponent component)
+{
+    switch (component) {
+    case PowerComponent::Screen:  return "Screen";
+    case PowerComponent::Camera:  return "Camera";
+    case PowerComponent::Audio:   return "Audio";
+    case PowerComponent::Storage: return "Storage";
+    case PowerComponent::Cpu:     return "CPU";
+    case PowerComponent::Radio:   return "Radio";
+    case PowerComponent::Count:   break;
+    }
+    return "Unknown";
+}
\ No newline at end of file
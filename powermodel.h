@@ -0,0 +1,68 @@
+#ifndef POWERMODEL_H
+#define POWERMODEL_H
+
+#include <QString>
+#include <vector>
+
+enum class PowerComponent { Screen, Camera, Audio, Storage, Cpu, Radio, Count };
+
+// Battery, energy and thermal state for one or many simulated phones.
+// State is kept as structure-of-arrays so a fleet of thousands of devices
+// is updated with a few flat loops per tick instead of per-object calls.
+class PowerModel
+{
+public:
+    static constexpr int ComponentCount = int(PowerComponent::Count);
+
+    // Energy cost of discrete operations
+    struct Costs
+    {
+        double photoCaptureJ = 2.5;     // sensor + ISP per shot
+        double storageWriteJPerMB = 0.06;
+        double screenOnW = 1.2;
+        double audioDecodeW = 0.25;
+        double cpuIdleW = 0.05;
+        double cpuActiveW = 1.8;
+        double radioActiveW = 0.9;      // while any transfer is in flight
+    };
+
+    explicit PowerModel(int deviceCount = 1, double batteryCapacityJ = 55440.0);
+
+    int deviceCount() const;
+    void resize(int deviceCount);
+    const Costs &costs() const;
+
+    // Continuous draw of one component, in watts
+    void setComponentPower(int device, PowerComponent component, double watts);
+    double componentPower(int device, PowerComponent component) const;
+    // Discrete energy use (e.g. one photo capture)
+    void addEnergy(int device, PowerComponent component, double joules);
+
+    // Advance every device by dt seconds of simulated time
+    void tick(double dtSeconds);
+
+    double chargeJ(int device) const;
+    double batteryPercent(int device) const;
+    double componentEnergyJ(int device, PowerComponent component) const;
+    double temperatureC(int device) const;
+    // Throughput multiplier in [minThrottle, 1] derived from temperature
+    double throttleFactor(int device) const;
+
+    static QString componentName(PowerComponent component);
+
+private:
+    Costs energyCosts;
+    double capacityJ;
+    int devices;
+
+    // One contiguous array per field, indexed by device
+    std::vector<double> charge;
+    std::vector<double> temperature;
+    std::vector<double> throttle;
+    std::vector<double> power[ComponentCount];
+    std::vector<double> energy[ComponentCount];
+    std::vector<double> burstJ;     // discrete energy since the last tick, becomes heat
+    std::vector<double> tickJ;      // scratch: joules drawn in the current tick
+};
+
+#endif // POWERMODEL_H
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include "replayengine.h"
+#include "smartphone.h"
+#include "phonelog.h"
+#include <QTimer>
+
+ReplayEngine::ReplayEngine(Dispatcher dispatcher, QObject *parent)
+    : QObject(parent), target(std::move(dispatcher)), speed(Speed::MaxSpeed), position(0), lastOffsetUs(0),
+      running(false), totalNs(0), timer(new QTimer(this))
+{
+    timer->setSingleShot(true);
+    timer->setTimerType(Qt::PreciseTimer);
+    connect(timer, &QTimer::timeout, this, &ReplayEngine::step);
+}
+
+ReplayEngine::Dispatcher ReplayEngine::phoneDispatcher(Smartphone *phone, const QString &password)
+{
+    return [phone, password](const Interaction &interaction, qint64 gapUs) {
+        SimulationClock *clock = phone->simulationClock();
+        if (clock->mode() == SimulationClock::Mode::AsFastAsPossible) {
+            clock->advanceBy(gapUs / 1000);
+        }
+
+        switch (interaction.action) {
+        case Interaction::Unlock:     phone->unlockPhone(unlockPassword(interaction, password)); break;
+        case Interaction::Lock:       phone->lockPhone(); break;
+        case Interaction::TakePhoto:  phone->takePhoto(); break;
+        case Interaction::PlayMusic:  phone->playMusic(); break;
+        case Interaction::StopMusic:  phone->stopMusic(); break;
+        case Interaction::LoadMusic:  phone->loadMusicFile(interaction.argument); break;
+        case Interaction::GetStorage: phone->getStorageInfo(); break;
+        case Interaction::VoiceMemo: {
+            AudioEncoder::Format format;
+            if (AudioEncoder::formatFromName(interaction.argument, format)) {
+                phone->startVoiceMemo(format);
+            } else {
+                phone->stopVoiceMemo();
+            }
+            break;
+        }
+        case Interaction::ScanCodes:
+            if (interaction.argument.isEmpty()) {
+                phone->stopViewfinder();
+            } else {
+                phone->startViewfinder(interaction.argument.toInt());
+            }
+            break;
+        case Interaction::ActionCount: break;
+        }
+    };
+}
+
+QString ReplayEngine::unlockPassword(const Interaction &interaction, const QString &password)
+{
+    // Appending to it always makes it wrong
+    return interaction.argument == QLatin1String("0") ? password + QLatin1Char('!') : password;
+}
+
+void ReplayEngine::start(const InteractionTrace &newTrace, Speed newSpeed)
+{
+    stop();
+    trace = newTrace;
+    speed = newSpeed;
+    position = 0;
+    lastOffsetUs = 0;
+    latency.reset();
+    running = true;
+    clock.start();
+    PHONE_LOG_INFO("trace", "▶️ Replaying %1 interactions", trace.size());
+    timer->start(0);
+}
+
+void ReplayEngine::stop()
+{
+    timer->stop();
+    running = false;
+}
+
+bool ReplayEngine::isRunning() const
+{
+    return running;
+}
+
+qint64 ReplayEngine::runBlocking(const InteractionTrace &newTrace)
+{
+    stop();
+    trace = newTrace;
+    position = 0;
+    lastOffsetUs = 0;
+    latency.reset();
+    clock.start();
+    for (const Interaction &interaction : trace.entries()) {
+        dispatch(interaction);
+        ++position;
+    }
+    totalNs = clock.nsecsElapsed();
+    return totalNs;
+}
+
+int ReplayEngine::replayedCount() const
+{
+    return position;
+}
+
+qint64 ReplayEngine::elapsedNs() const
+{
+    return running ? clock.nsecsElapsed() : totalNs;
+}
+
+const LatencyHistogram &ReplayEngine::dispatchLatency() const
+{
+    return latency;
+}
+
+void ReplayEngine::step()
+{
+    if (!running) {
+        return;
+    }
+
+    if (speed == Speed::MaxSpeed) {
+        // Run in batches so the event loop (and the GUI) keeps breathing
+        int end = qMin(position + MaxSpeedBatch, trace.size());
+        while (position < end) {
+            dispatch(trace.at(position++));
+        }
+    } else {
+        qint64 nowUs = clock.nsecsElapsed() / 1000;
+        while (position < trace.size() && trace.at(position).offsetUs <= nowUs) {
+            dispatch(trace.at(position++));
+        }
+    }
+
+    if (position >= trace.size()) {
+        running = false;
+        totalNs = clock.nsecsElapsed();
+        PHONE_LOG_INFO("trace", "⏹️ Replay finished: %1 interactions in %2 ms", position, totalNs / 1e6);
+        emit finished(position, totalNs);
+        return;
+    }
+
+    qint64 delayMs = 0;
+    if (speed == Speed::RealTime) {
+        delayMs = qMax<qint64>(0, (trace.at(position).offsetUs - clock.nsecsElapsed() / 1000) / 1000);
+    }
+    timer->start(int(delayMs));
+}
+
+void ReplayEngine::dispatch(const Interaction &interaction)
+{
+    QElapsedTimer sample;
+    sample.start();
+    const qint64 gapUs = qMax<qint64>(0, interaction.offsetUs - lastOffsetUs);
+    lastOffsetUs = interaction.offsetUs;
+    target(interaction, gapUs);
+    latency.record(sample.nsecsElapsed());
+}
\ No newline at end of file
@@ -0,0 +1,67 @@
+#ifndef REPLAYENGINE_H
+#define REPLAYENGINE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <functional>
+#include "interactiontrace.h"
+#include "latencyhistogram.h"
+
+class QTimer;
+class Smartphone;
+
+// Feeds a recorded interaction trace back into a target, either with the
+// original timing (1x) or as fast as possible. The target is a dispatcher
+// so the same engine drives a headless Smartphone or the GUI slots. Traces
+// do not hold passwords: a recorded unlock is replayed with the password
+// given to the dispatcher, or a wrong one if the recorded unlock failed.
+class ReplayEngine : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Speed { RealTime, MaxSpeed };
+    // gapUs: time since the previous interaction of this replay
+    using Dispatcher = std::function<void(const Interaction &interaction, qint64 gapUs)>;
+
+    explicit ReplayEngine(Dispatcher dispatcher, QObject *parent = nullptr);
+
+    // Calls the phone directly; a phone clock in AsFastAsPossible mode is
+    // advanced by the recorded gaps so timed behaviour replays too
+    static Dispatcher phoneDispatcher(Smartphone *phone, const QString &password);
+    // What to unlock with to repeat a recorded unlock's outcome
+    static QString unlockPassword(const Interaction &interaction, const QString &password);
+
+    // Event-loop driven replay; finished() is emitted at the end
+    void start(const InteractionTrace &trace, Speed speed);
+    void stop();
+    bool isRunning() const;
+    // Replays everything at maximum speed before returning; no event loop needed
+    qint64 runBlocking(const InteractionTrace &trace);
+
+    int replayedCount() const;
+    qint64 elapsedNs() const;
+    // Time spent inside the dispatcher per interaction, ns
+    const LatencyHistogram &dispatchLatency() const;
+
+signals:
+    void finished(int replayed, qint64 elapsedNs);
+
+private:
+    void step();
+    void dispatch(const Interaction &interaction);
+
+    static constexpr int MaxSpeedBatch = 256;
+
+    Dispatcher target;
+    InteractionTrace trace;
+    Speed speed;
+    int position;
+    qint64 lastOffsetUs;    // of the interaction dispatched last
+    bool running;
+    QElapsedTimer clock;
+    qint64 totalNs;
+    QTimer *timer;
+    LatencyHistogram latency;
+};
+
+#endif // REPLAYENGINE_H
\ No newline at end of file
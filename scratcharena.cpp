@@ -0,0 +1,126 @@
+#include "scratcharena.h"
+#include <cstdint>
+#include <cstring>
+
+ScratchArena &ScratchArena::forThread()
+{
+    thread_local ScratchArena arena;
+    return arena;
+}
+
+void *ScratchArena::allocate(std::size_t bytes, std::size_t alignment)
+{
+    while (current < blocks.size()) {
+        Block &block = blocks[current];
+        std::size_t start = (offset + alignment - 1) & ~(alignment - 1);
+        if (start + bytes <= block.size) {
+            offset = start + bytes;
+            return block.data.get() + start;
+        }
+        // Blocks left over from earlier, larger operations are reused in order
+        ++current;
+        offset = 0;
+    }
+
+    // Oversized requests get a block of their own; it is kept like any other
+    std::size_t size = qMax(BlockSize, bytes + alignment);
+    blocks.push_back(Block{std::unique_ptr<char[]>(new char[size]), size});
+    current = blocks.size() - 1;
+    char *base = blocks.back().data.get();
+    std::size_t start = (alignment - reinterpret_cast<std::uintptr_t>(base) % alignment) % alignment;
+    offset = start + bytes;
+    return base + start;
+}
+
+ScratchArena::Mark ScratchArena::mark() const
+{
+    return Mark{current, offset};
+}
+
+void ScratchArena::rewind(const Mark &to)
+{
+    current = to.block;
+    offset = to.offset;
+}
+
+std::size_t ScratchArena::capacity() const
+{
+    std::size_t total = 0;
+    for (const Block &block : blocks) {
+        total += block.size;
+    }
+    return total;
+}
+
+std::size_t ScratchArena::blockCount() const
+{
+    return blocks.size();
+}
+
+ScratchString::ScratchString(qsizetype reserve, ScratchArena &arena)
+    : arena(arena), length(0), capacity(qMax<qsizetype>(16, reserve))
+{
+    buffer = static_cast<char16_t *>(arena.allocate(std::size_t(capacity) * sizeof(char16_t), alignof(char16_t)));
+}
+
+char16_t *ScratchString::reserveMore(qsizetype extra)
+{
+    if (length + extra > capacity) {
+        // Monotonic: the old buffer is simply abandoned until the scope rewinds
+        qsizetype grown = qMax(capacity * 2, length + extra);
+        auto *moved = static_cast<char16_t *>(arena.allocate(std::size_t(grown) * sizeof(char16_t),
+                                                             alignof(char16_t)));
+        std::memcpy(moved, buffer, std::size_t(length) * sizeof(char16_t));
+        buffer = moved;
+        capacity = grown;
+    }
+    return buffer + length;
+}
+
+ScratchString &ScratchString::operator<<(QStringView text)
+{
+    std::memcpy(reserveMore(text.size()), text.utf16(), std::size_t(text.size()) * sizeof(char16_t));
+    length += text.size();
+    return *this;
+}
+
+ScratchString &ScratchString::operator<<(QChar c)
+{
+    *reserveMore(1) = c.unicode();
+    ++length;
+    return *this;
+}
+
+ScratchString &ScratchString::appendNumber(qint64 value, int minWidth)
+{
+    char16_t digits[24];
+    int count = 0;
+    quint64 magnitude = value < 0 ? 0 - quint64(value) : quint64(value);
+    do {
+        digits[count++] = char16_t(u'0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    while (count < minWidth && count < 20) {
+        digits[count++] = u'0';
+    }
+    if (value < 0) {
+        digits[count++] = u'-';
+    }
+
+    char16_t *out = reserveMore(count);
+    for (int i = 0; i < count; ++i) {
+        out[i] = digits[count - 1 - i];
+    }
+    length += count;
+    return *this;
+}
+
+void ScratchString::assignTo(QString &target) const
+{
+    if (target.isDetached() && target.capacity() >= length) {
+        target.resize(length);
+        std::memcpy(target.data(), buffer, std::size_t(length) * sizeof(char16_t));
+    } else {
+        target = toString();
+    }
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#ifndef SCRATCHARENA_H
+#define SCRATCHARENA_H
+
+#include <QString>
+#include <QStringView>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Per-thread monotonic arena for the short-lived buffers of one operation.
+// Allocation is a pointer bump; a ScratchScope rewinds everything allocated
+// inside it on exit. Blocks are kept after a rewind, so once an operation
+// has run a few times it no longer touches the heap.
+class ScratchArena
+{
+public:
+    static constexpr std::size_t BlockSize = 64 * 1024;
+
+    struct Mark
+    {
+        std::size_t block;
+        std::size_t offset;
+    };
+
+    static ScratchArena &forThread();
+
+    void *allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t));
+    Mark mark() const;
+    void rewind(const Mark &to);
+
+    std::size_t capacity() const;       // bytes held in blocks
+    std::size_t blockCount() const;
+
+private:
+    struct Block
+    {
+        std::unique_ptr<char[]> data;
+        std::size_t size;
+    };
+
+    std::vector<Block> blocks;
+    std::size_t current = 0;
+    std::size_t offset = 0;
+};
+
+// Rewinds the calling thread's arena when the operation ends
+class ScratchScope
+{
+public:
+    ScratchScope() : arena(ScratchArena::forThread()), start(arena.mark()) {}
+    ~ScratchScope() { arena.rewind(start); }
+
+    ScratchScope(const ScratchScope &) = delete;
+    ScratchScope &operator=(const ScratchScope &) = delete;
+
+private:
+    ScratchArena &arena;
+    ScratchArena::Mark start;
+};
+
+// UTF-16 text built in the arena instead of through QString temporaries.
+// Only valid inside the ScratchScope it was created in; toString() or
+// assignTo() turn the result into a QString with at most one allocation.
+class ScratchString
+{
+public:
+    explicit ScratchString(qsizetype reserve = 128, ScratchArena &arena = ScratchArena::forThread());
+
+    ScratchString &operator<<(QStringView text);
+    ScratchString &operator<<(const char16_t *text) { return *this << QStringView(text); }
+    ScratchString &operator<<(const QString &text) { return *this << QStringView(text); }
+    ScratchString &operator<<(QChar c);
+    ScratchString &operator<<(qint64 value) { return appendNumber(value, 0); }
+    ScratchString &operator<<(int value) { return appendNumber(value, 0); }
+    // Left-padded with zeros to at least minWidth digits
+    ScratchString &appendNumber(qint64 value, int minWidth);
+
+    QStringView view() const { return QStringView(buffer, length); }
+    qsizetype size() const { return length; }
+    QString toString() const { return QString(reinterpret_cast<const QChar *>(buffer), length); }
+    // Writes into target's own buffer when it is unshared and big enough
+    void assignTo(QString &target) const;
+
+private:
+    char16_t *reserveMore(qsizetype extra);
+
+    ScratchArena &arena;
+    char16_t *buffer;
+    qsizetype length;
+    qsizetype capacity;
+};
+
+#endif // SCRATCHARENA_H
\ No newline at end of file
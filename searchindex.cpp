@@ -0,0 +1,308 @@
+#include "searchindex.h"
+#include "tracing.h"
+#include "allocationtracker.h"
+#include <QtAlgorithms>
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+constexpr int MaxWordLength = 32;
+// Rewrite the posting lists once a quarter of the documents are removed ones
+constexpr int MinRemovedForCompaction = 256;
+
+void appendVarint(QByteArray &out, quint32 value)
+{
+    while (value >= 0x80) {
+        out.append(char(value | 0x80));
+        value >>= 7;
+    }
+    out.append(char(value));
+}
+
+// Calls f(word) for every lower-cased run of letters and digits
+template <typename F>
+void forEachWord(QStringView text, QString &word, F f)
+{
+    word.clear();
+    for (QChar c : text) {
+        if (c.isLetterOrNumber()) {
+            if (word.size() < MaxWordLength) {
+                word.append(c.toLower());
+            }
+        } else if (!word.isEmpty()) {
+            f(word);
+            word.clear();
+        }
+    }
+    if (!word.isEmpty()) {
+        f(word);
+        word.clear();
+    }
+}
+
+} // namespace
+
+double SearchIndex::Stats::bytesPerDocument() const
+{
+    return documents > 0 ? double(memoryBytes) / documents : 0.0;
+}
+
+QString SearchIndex::Stats::describe() const
+{
+    return QString("%1 documents (%2 removed), %3 words, %4 postings in %5 KB; ~%6 KB total, %7 bytes per document")
+        .arg(documents)
+        .arg(removed)
+        .arg(terms)
+        .arg(postings)
+        .arg(postingBytes / 1024.0, 0, 'f', 1)
+        .arg(memoryBytes / 1024.0, 0, 'f', 0)
+        .arg(bytesPerDocument(), 0, 'f', 0);
+}
+
+SearchIndex::SearchIndex()
+    : removed(0), postings(0), textBytes(0), compactions(0)
+{
+    std::fill(std::begin(live), std::end(live), 0);
+    std::fill(std::begin(limits), std::end(limits), 0);
+    std::fill(std::begin(oldest), std::end(oldest), size_t(0));
+}
+
+void SearchIndex::add(Kind kind, qint64 timestamp, const QString &title, const QString &detail)
+{
+    ALLOC_SCOPE("SearchIndex::add", "SearchIndex");
+    std::lock_guard<std::mutex> lock(mutex);
+    DocId id = DocId(documents.size());
+    documents.push_back(Document{timestamp, title, detail, kind, true});
+    live[int(kind)]++;
+    textBytes += (title.size() + detail.size()) * qint64(sizeof(QChar));
+
+    QString word;
+    word.reserve(MaxWordLength);
+    indexText(title, id, word);
+    indexText(detail, id, word);
+    enforceLimit(kind);
+}
+
+void SearchIndex::setLimit(Kind kind, int limit)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    limits[int(kind)] = qMax(0, limit);
+    enforceLimit(kind);
+}
+
+void SearchIndex::removeKind(Kind kind)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = oldest[int(kind)]; i < documents.size() && live[int(kind)] > 0; ++i) {
+        if (documents[i].live && documents[i].kind == kind) {
+            remove(DocId(i));
+        }
+    }
+    oldest[int(kind)] = documents.size();
+    compactIfSparse();
+}
+
+void SearchIndex::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    documents.clear();
+    terms.clear();
+    std::fill(std::begin(live), std::end(live), 0);
+    std::fill(std::begin(oldest), std::end(oldest), size_t(0));
+    removed = 0;
+    postings = 0;
+    textBytes = 0;
+}
+
+QVector<SearchIndex::Hit> SearchIndex::search(const QString &query, int limit, KindMask kinds) const
+{
+    TRACE_SPAN("SearchIndex::search", "search");
+    QVector<Hit> hits;
+    QStringList prefixes;
+    QString word;
+    forEachWord(query, word, [&prefixes](const QString &w) { prefixes.append(w); });
+    if (prefixes.isEmpty() || limit <= 0) {
+        return hits;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    // One bit per document: union the lists of each prefix, then intersect
+    // the prefixes; the cost is the postings decoded, not the matches sorted
+    const size_t words = (documents.size() + 63) / 64;
+    std::vector<quint64> matches(words, 0);
+    std::vector<quint64> next;
+    matching(prefixes.first(), matches);
+    for (int i = 1; i < prefixes.size(); ++i) {
+        next.assign(words, 0);
+        matching(prefixes[i], next);
+        for (size_t w = 0; w < words; ++w) {
+            matches[w] &= next[w];
+        }
+    }
+
+    // Document numbers grow with time, so newest first is highest first
+    for (size_t w = words; w-- > 0 && hits.size() < limit;) {
+        quint64 bits = matches[w];
+        while (bits && hits.size() < limit) {
+            int bit = 63 - qCountLeadingZeroBits(bits);
+            bits &= ~(quint64(1) << bit);
+            const Document &document = documents[w * 64 + size_t(bit)];
+            if (document.live && (kindBit(document.kind) & kinds)) {
+                hits.append(Hit{document.kind, document.timestamp, document.title, document.detail});
+            }
+        }
+    }
+    return hits;
+}
+
+SearchIndex::Stats SearchIndex::stats() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats stats;
+    for (int count : live) {
+        stats.documents += count;
+    }
+    stats.removed = removed;
+    stats.terms = int(terms.size());
+    stats.postings = postings;
+    // A map node costs about its pointers, colour and the key and value headers
+    constexpr qint64 NodeBytes = 4 * sizeof(void *) + sizeof(QString) + sizeof(Posting);
+    qint64 dictionaryBytes = 0;
+    for (auto it = terms.cbegin(); it != terms.cend(); ++it) {
+        stats.postingBytes += it.value().gaps.capacity();
+        dictionaryBytes += NodeBytes + it.key().capacity() * qint64(sizeof(QChar));
+    }
+    stats.memoryBytes = qint64(documents.capacity() * sizeof(Document)) + textBytes + dictionaryBytes
+                        + stats.postingBytes;
+    stats.compactions = compactions;
+    return stats;
+}
+
+QString SearchIndex::kindName(Kind kind)
+{
+    switch (kind) {
+    case Kind::Photo:     return "photo";
+    case Kind::Track:     return "track";
+    case Kind::Activity:  return "activity";
+    case Kind::KindCount: break;
+    }
+    return "unknown";
+}
+
+void SearchIndex::indexText(QStringView text, DocId id, QString &word)
+{
+    forEachWord(text, word, [this, id](const QString &w) { append(w, id); });
+}
+
+void SearchIndex::append(const QString &word, DocId id)
+{
+    Posting &posting = terms[word];
+    if (posting.count > 0 && posting.last == id) {
+        return;     // the word appeared earlier in the same document
+    }
+    appendVarint(posting.gaps, posting.count > 0 ? id - posting.last : id);
+    posting.last = id;
+    posting.count++;
+    postings++;
+}
+
+// The document stays in the posting lists until the next compaction
+void SearchIndex::remove(DocId id)
+{
+    Document &document = documents[id];
+    textBytes -= (document.title.size() + document.detail.size()) * qint64(sizeof(QChar));
+    document.live = false;
+    document.title = QString();
+    document.detail = QString();
+    live[int(document.kind)]--;
+    removed++;
+}
+
+void SearchIndex::enforceLimit(Kind kind)
+{
+    const int k = int(kind);
+    if (limits[k] == 0 || live[k] <= limits[k]) {
+        return;
+    }
+    // Documents are in insertion order, so the scan never moves backwards
+    size_t i = oldest[k];
+    while (live[k] > limits[k] && i < documents.size()) {
+        if (documents[i].live && documents[i].kind == kind) {
+            remove(DocId(i));
+        }
+        ++i;
+    }
+    oldest[k] = i;
+    compactIfSparse();
+}
+
+// Renumbers the live documents in order and rewrites every posting list
+void SearchIndex::compactIfSparse()
+{
+    if (removed < MinRemovedForCompaction || size_t(removed) * 4 < documents.size()) {
+        return;
+    }
+    TRACE_SPAN("SearchIndex::compact", "search");
+    const DocId Gone = DocId(-1);
+    std::vector<DocId> renumbered(documents.size(), Gone);
+    std::vector<Document> kept;
+    kept.reserve(documents.size() - size_t(removed));
+    for (size_t i = 0; i < documents.size(); ++i) {
+        if (documents[i].live) {
+            renumbered[i] = DocId(kept.size());
+            kept.push_back(std::move(documents[i]));
+        }
+    }
+    documents.swap(kept);
+
+    postings = 0;
+    for (auto it = terms.begin(); it != terms.end();) {
+        Posting rewritten;
+        forEachDocument(it.value(), [&](DocId id) {
+            DocId mapped = renumbered[id];
+            if (mapped != Gone) {
+                appendVarint(rewritten.gaps, rewritten.count > 0 ? mapped - rewritten.last : mapped);
+                rewritten.last = mapped;
+                rewritten.count++;
+            }
+        });
+        if (rewritten.count == 0) {
+            it = terms.erase(it);
+            continue;
+        }
+        rewritten.gaps.squeeze();
+        postings += rewritten.count;
+        it.value() = std::move(rewritten);
+        ++it;
+    }
+    std::fill(std::begin(oldest), std::end(oldest), size_t(0));
+    removed = 0;
+    compactions++;
+}
+
+void SearchIndex::matching(const QString &prefix, std::vector<quint64> &bitmap) const
+{
+    for (auto it = terms.lowerBound(prefix); it != terms.cend() && it.key().startsWith(prefix); ++it) {
+        forEachDocument(it.value(), [&bitmap](DocId id) { bitmap[id / 64] |= quint64(1) << (id % 64); });
+    }
+}
+
+template <typename F>
+void SearchIndex::forEachDocument(const Posting &posting, F f)
+{
+    const uchar *p = reinterpret_cast<const uchar *>(posting.gaps.constData());
+    DocId id = 0;
+    for (quint32 i = 0; i < posting.count; ++i) {
+        quint32 gap = 0;
+        int shift = 0;
+        uchar byte;
+        do {
+            byte = *p++;
+            gap |= quint32(byte & 0x7F) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+        id = i == 0 ? gap : id + gap;
+        f(id);
+    }
+}
\ No newline at end of file
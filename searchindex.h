@@ -0,0 +1,109 @@
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <QVector>
+#include <mutex>
+#include <vector>
+
+// Full-text index over the phone's content: photos, music tracks and
+// activity log entries. Each word maps to a posting list of document
+// numbers in increasing order, stored as varint gaps, so adding a document
+// only appends to the lists of its words. Removed documents are skipped
+// until enough have piled up, then the lists are rewritten without them.
+// Thread-safe behind one mutex; a call holds it for microseconds.
+class SearchIndex
+{
+public:
+    enum class Kind : quint8 { Photo, Track, Activity, KindCount };
+
+    using KindMask = quint8;
+    static constexpr KindMask kindBit(Kind kind) { return KindMask(1u << int(kind)); }
+    static constexpr KindMask AllKinds = (1u << int(Kind::KindCount)) - 1;
+
+    struct Hit
+    {
+        Kind kind = Kind::Activity;
+        qint64 timestamp = 0;   // ms since epoch
+        QString title;
+        QString detail;
+    };
+
+    struct Stats
+    {
+        int documents = 0;          // live
+        int removed = 0;            // still in the posting lists
+        int terms = 0;
+        qint64 postings = 0;        // (word, document) pairs
+        qint64 postingBytes = 0;    // encoded
+        qint64 memoryBytes = 0;     // estimate: documents, dictionary and postings
+        int compactions = 0;
+
+        double bytesPerDocument() const;
+        QString describe() const;
+    };
+
+    SearchIndex();
+
+    SearchIndex(const SearchIndex &) = delete;
+    SearchIndex &operator=(const SearchIndex &) = delete;
+
+    void add(Kind kind, qint64 timestamp, const QString &title, const QString &detail = QString());
+    // Keeps at most limit documents of a kind by dropping the oldest; 0 keeps all
+    void setLimit(Kind kind, int limit);
+    void removeKind(Kind kind);
+    void clear();
+
+    // Every word of the query must begin a word of the title or detail,
+    // ignoring case; the newest matches come first
+    QVector<Hit> search(const QString &query, int limit = 20, KindMask kinds = AllKinds) const;
+    Stats stats() const;
+
+    static QString kindName(Kind kind);
+
+private:
+    using DocId = quint32;
+
+    struct Document
+    {
+        qint64 timestamp;
+        QString title;
+        QString detail;
+        Kind kind;
+        bool live;
+    };
+
+    struct Posting
+    {
+        QByteArray gaps;        // varint differences between document numbers
+        DocId last = 0;
+        quint32 count = 0;
+    };
+
+    void indexText(QStringView text, DocId id, QString &word);
+    void append(const QString &word, DocId id);
+    void remove(DocId id);
+    void enforceLimit(Kind kind);
+    void compactIfSparse();
+    // Sets the bit of every document with a word that starts with prefix
+    void matching(const QString &prefix, std::vector<quint64> &bitmap) const;
+    template <typename F>
+    static void forEachDocument(const Posting &posting, F f);
+
+    mutable std::mutex mutex;
+    std::vector<Document> documents;    // indexed by DocId
+    QMap<QString, Posting> terms;       // sorted, so a prefix is one range
+    int live[int(Kind::KindCount)];
+    int limits[int(Kind::KindCount)];
+    size_t oldest[int(Kind::KindCount)];    // where the next eviction scan starts
+    int removed;
+    qint64 postings;
+    qint64 textBytes;                   // title and detail of live documents
+    int compactions;
+};
+
+#endif // SEARCHINDEX_H
\ No newline at end of file
@@ -0,0 +1,75 @@
+#ifndef SHAREDCACHE_H
+#define SHAREDCACHE_H
+
+#include <QtGlobal>
+#include <map>
+#include <memory>
+#include <mutex>
+
+// Process-wide cache of resources several phones can use at once. The
+// first acquire() of a key builds the value; later ones get the same
+// object. The cache only holds weak references: a value lives while some
+// phone holds it and is freed with the last holder, so an idle cache costs
+// nothing. Thread-safe; the value is built under the lock, so two phones
+// asking at once never build it twice.
+template <typename Key, typename T>
+class SharedCache
+{
+public:
+    using Handle = std::shared_ptr<T>;
+
+    struct Stats
+    {
+        int entries = 0;        // alive
+        long holders = 0;       // handles to them
+        quint64 hits = 0;
+        quint64 misses = 0;     // values built
+    };
+
+    SharedCache() = default;
+
+    SharedCache(const SharedCache &) = delete;
+    SharedCache &operator=(const SharedCache &) = delete;
+
+    // make() returns a T * the cache takes ownership of
+    template <typename Make>
+    Handle acquire(const Key &key, Make make)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = values.find(key);
+        if (it != values.end()) {
+            if (Handle value = it->second.lock()) {
+                hits++;
+                return value;
+            }
+        }
+        misses++;
+        Handle value(make());
+        values[key] = value;
+        return value;
+    }
+
+    Stats stats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Stats stats;
+        for (const auto &entry : values) {
+            long count = entry.second.use_count();
+            if (count > 0) {
+                stats.entries++;
+                stats.holders += count;
+            }
+        }
+        stats.hits = hits;
+        stats.misses = misses;
+        return stats;
+    }
+
+private:
+    mutable std::mutex mutex;
+    std::map<Key, std::weak_ptr<T>> values;     // expired ones are replaced on the next miss
+    quint64 hits = 0;
+    quint64 misses = 0;
+};
+
+#endif // SHAREDCACHE_H
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "simulationclock.h"
+#include "phonelog.h"
+#include <QTimer>
+#include <algorithm>
+#include <limits>
+
+SimulationClock::SimulationClock(QObject *parent)
+    : QObject(parent), clockMode(Mode::RealTime), scale(1.0),
+      virtualNow(QDateTime::currentMSecsSinceEpoch()), wallAnchorVirtual(virtualNow),
+      driver(new QTimer(this)), staleEntries(0), nextId(1), nextSequence(0), processed(0)
+{
+    wallClock.start();
+    driver->setSingleShot(true);
+    driver->setTimerType(Qt::PreciseTimer);
+    connect(driver, &QTimer::timeout, this, &SimulationClock::onTimer);
+}
+
+SimulationClock::~SimulationClock()
+{
+}
+
+void SimulationClock::setMode(Mode mode)
+{
+    if (mode == clockMode) {
+        return;
+    }
+
+    virtualNow = now();
+    clockMode = mode;
+    rebaseWallClock();
+    armTimer();
+}
+
+SimulationClock::Mode SimulationClock::mode() const
+{
+    return clockMode;
+}
+
+void SimulationClock::setTimeScale(double newScale)
+{
+    if (newScale <= 0.0) {
+        PHONE_LOG_ERROR("clock", "❌ Invalid time scale: %1", newScale);
+        return;
+    }
+
+    virtualNow = now();
+    rebaseWallClock();
+    scale = newScale;
+    armTimer();
+}
+
+double SimulationClock::timeScale() const
+{
+    return scale;
+}
+
+qint64 SimulationClock::now() const
+{
+    return clockMode == Mode::RealTime ? qMax(virtualNow, wallNow()) : virtualNow;
+}
+
+QDateTime SimulationClock::currentDateTime() const
+{
+    return QDateTime::fromMSecsSinceEpoch(now());
+}
+
+void SimulationClock::setCurrentDateTime(const QDateTime &dateTime)
+{
+    const qint64 target = dateTime.toMSecsSinceEpoch();
+    const qint64 shift = target - now();
+    // Absolute events that are now due fire on the next run
+    for (QueuedEvent &event : queue) {
+        auto it = actions.constFind(event.id);
+        if (it == actions.cend() || !it->absolute) {
+            event.time += shift;
+        }
+    }
+    std::make_heap(queue.begin(), queue.end(), std::greater<QueuedEvent>());
+    virtualNow = target;
+    rebaseWallClock();
+    armTimer();
+}
+
+SimulationClock::EventId SimulationClock::scheduleAt(qint64 timeMs, std::function<void()> action)
+{
+    return add(timeMs, 0, true, std::move(action));
+}
+
+SimulationClock::EventId SimulationClock::scheduleAfter(qint64 delayMs, std::function<void()> action)
+{
+    return add(now() + qMax<qint64>(0, delayMs), 0, false, std::move(action));
+}
+
+SimulationClock::EventId SimulationClock::scheduleEvery(qint64 intervalMs, std::function<void()> action)
+{
+    intervalMs = qMax<qint64>(1, intervalMs);
+    return add(now() + intervalMs, intervalMs, false, std::move(action));
+}
+
+bool SimulationClock::cancel(EventId id)
+{
+    // The queue entry stays behind and is skipped when it comes due
+    if (actions.remove(id) == 0) {
+        return false;
+    }
+    ++staleEntries;
+    compactIfStale();
+    return true;
+}
+
+bool SimulationClock::reschedule(EventId id, qint64 timeMs)
+{
+    auto it = actions.find(id);
+    if (it == actions.end()) {
+        return false;
+    }
+    ++staleEntries;
+    push(timeMs, id, *it);
+    compactIfStale();
+    armTimer();
+    return true;
+}
+
+int SimulationClock::pendingEvents() const
+{
+    return actions.size();
+}
+
+int SimulationClock::queuedEntries() const
+{
+    return int(queue.size());
+}
+
+quint64 SimulationClock::processedEvents() const
+{
+    return processed;
+}
+
+int SimulationClock::advanceBy(qint64 deltaMs)
+{
+    return runUntil(now() + qMax<qint64>(0, deltaMs));
+}
+
+int SimulationClock::runUntil(qint64 timeMs)
+{
+    int count = 0;
+    for (skipStale(); !queue.empty() && queue.front().time <= timeMs; skipStale()) {
+        QueuedEvent event = queue.front();
+        popTop();
+        auto it = actions.find(event.id);
+
+        virtualNow = qMax(virtualNow, event.time);
+        // Copy first: the callback may cancel or reschedule itself
+        std::function<void()> callback = it->callback;
+        if (it->interval > 0) {
+            push(event.time + it->interval, event.id, *it);
+        } else {
+            actions.erase(it);
+        }
+
+        callback();
+        ++processed;
+        ++count;
+    }
+
+    virtualNow = qMax(virtualNow, timeMs);
+    rebaseWallClock();
+    armTimer();
+    emit timeAdvanced(virtualNow);
+    return count;
+}
+
+qint64 SimulationClock::wallNow() const
+{
+    return wallAnchorVirtual + qint64(double(wallClock.elapsed()) * scale);
+}
+
+void SimulationClock::rebaseWallClock()
+{
+    wallAnchorVirtual = virtualNow;
+    wallClock.restart();
+}
+
+void SimulationClock::armTimer()
+{
+    skipStale();
+    if (clockMode != Mode::RealTime || queue.empty()) {
+        driver->stop();
+        return;
+    }
+
+    double wallDelay = double(queue.front().time - now()) / scale;
+    int delay = int(qBound(0.0, wallDelay, double(std::numeric_limits<int>::max())));
+    driver->start(delay);
+}
+
+void SimulationClock::onTimer()
+{
+    runUntil(now());
+}
+
+SimulationClock::EventId SimulationClock::add(qint64 timeMs, qint64 interval, bool absolute,
+                                              std::function<void()> action)
+{
+    EventId id = nextId++;
+    push(timeMs, id, *actions.insert(id, Action{std::move(action), interval, absolute, 0}));
+    armTimer();
+    return id;
+}
+
+void SimulationClock::push(qint64 timeMs, EventId id, Action &action)
+{
+    action.sequence = nextSequence++;
+    queue.push_back(QueuedEvent{timeMs, action.sequence, id});
+    std::push_heap(queue.begin(), queue.end(), std::greater<QueuedEvent>());
+}
+
+void SimulationClock::popTop()
+{
+    std::pop_heap(queue.begin(), queue.end(), std::greater<QueuedEvent>());
+    queue.pop_back();
+}
+
+void SimulationClock::skipStale()
+{
+    while (!queue.empty()) {
+        auto it = actions.constFind(queue.front().id);
+        if (it != actions.cend() && it->sequence == queue.front().sequence) {
+            return;
+        }
+        popTop();
+        --staleEntries;
+    }
+}
+
+// Keeps the queue proportional to the pending events when timers are
+// restarted far more often than they fire
+void SimulationClock::compactIfStale()
+{
+    if (queue.size() < CompactMinimum || staleEntries * CompactDivisor < queue.size()) {
+        return;
+    }
+    auto stale = [this](const QueuedEvent &event) {
+        auto it = actions.constFind(event.id);
+        return it == actions.cend() || it->sequence != event.sequence;
+    };
+    queue.erase(std::remove_if(queue.begin(), queue.end(), stale), queue.end());
+    std::make_heap(queue.begin(), queue.end(), std::greater<QueuedEvent>());
+    staleEntries = 0;
+}
\ No newline at end of file
@@ -0,0 +1,110 @@
+#ifndef SIMULATIONCLOCK_H
+#define SIMULATIONCLOCK_H
+
+#include <QObject>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHash>
+#include <functional>
+#include <vector>
+
+class QTimer;
+
+// Discrete-event scheduler with a virtual clock. Time is in milliseconds
+// since the Unix epoch. In RealTime mode the clock follows the wall clock
+// (optionally accelerated); in AsFastAsPossible mode it only moves when
+// advanceBy()/runUntil() jump it from one event to the next. Cancelled and
+// moved events leave stale queue entries behind; once they make up half
+// of the queue it is rebuilt without them.
+class SimulationClock : public QObject
+{
+    Q_OBJECT
+public:
+    enum class Mode { RealTime, AsFastAsPossible };
+    using EventId = quint64;
+
+    explicit SimulationClock(QObject *parent = nullptr);
+    ~SimulationClock();
+
+    void setMode(Mode mode);
+    Mode mode() const;
+    // Wall-clock acceleration in RealTime mode (1.0 = real time)
+    void setTimeScale(double scale);
+    double timeScale() const;
+
+    qint64 now() const;
+    QDateTime currentDateTime() const;
+    // Events from scheduleAfter()/scheduleEvery() move with the clock,
+    // keeping the delay they had left; scheduleAt() events keep their time
+    void setCurrentDateTime(const QDateTime &dateTime);
+
+    // An absolute time, such as an alarm's; it stays put when the clock is set
+    EventId scheduleAt(qint64 timeMs, std::function<void()> action);
+    EventId scheduleAfter(qint64 delayMs, std::function<void()> action);
+    EventId scheduleEvery(qint64 intervalMs, std::function<void()> action);
+    bool cancel(EventId id);
+    // Moves a pending event to timeMs, keeping its id; a periodic event
+    // repeats from there. Returns false when the event is not pending.
+    bool reschedule(EventId id, qint64 timeMs);
+    int pendingEvents() const;
+    // Queue entries, stale ones included
+    int queuedEntries() const;
+    quint64 processedEvents() const;
+
+    // Run every event due up to the target time, then set the clock to it
+    int advanceBy(qint64 deltaMs);
+    int runUntil(qint64 timeMs);
+
+signals:
+    void timeAdvanced(qint64 nowMs);
+
+private:
+    struct QueuedEvent
+    {
+        qint64 time;
+        quint64 sequence;   // FIFO order for events due at the same time; unique
+        EventId id;
+        bool operator>(const QueuedEvent &other) const
+        {
+            return time != other.time ? time > other.time : sequence > other.sequence;
+        }
+    };
+    struct Action
+    {
+        std::function<void()> callback;
+        qint64 interval;    // 0 for one-shot events
+        bool absolute;      // scheduleAt(): not shifted by setCurrentDateTime()
+        quint64 sequence;   // of its live queue entry; others are stale
+    };
+
+    // Stale entries at least this share of the queue trigger a rebuild
+    static constexpr int CompactDivisor = 2;
+    static constexpr size_t CompactMinimum = 64;
+
+    qint64 wallNow() const;
+    void rebaseWallClock();
+    void armTimer();
+    void onTimer();
+    EventId add(qint64 timeMs, qint64 interval, bool absolute, std::function<void()> action);
+    void push(qint64 timeMs, EventId id, Action &action);
+    void popTop();
+    // Drops stale entries from the top, so the earliest live event is first
+    void skipStale();
+    void compactIfStale();
+
+    Mode clockMode;
+    double scale;
+    qint64 virtualNow;
+    qint64 wallAnchorVirtual;
+    QElapsedTimer wallClock;
+    QTimer *driver;
+
+    std::vector<QueuedEvent> queue;     // min-heap by (time, sequence)
+    size_t staleEntries;
+    QHash<EventId, Action> actions;
+    EventId nextId;
+    quint64 nextSequence;
+    quint64 processed;
+};
+
+#endif // SIMULATIONCLOCK_H
\ No newline at end of file
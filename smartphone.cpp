@@ -1,52 +1,203 @@
 #include "smartphone.h"
-#include <QDebug>
+#include "phonelog.h"
+#include "tracing.h"
+#include "allocationtracker.h"
+#include "scratcharena.h"
+#include <QByteArray>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFileInfo>
+#include <QRandomGenerator>
+#include <QStandardPaths>
+#include <QStringList>
+#include <cmath>
+#include <memory>
+
+namespace {
+
+constexpr qint64 PowerTickMs = 1000;
+constexpr double PhotoSizeMB = Camera::PhotoSizeKB / 1024.0;
+
+// Simulated CPU demand of the built-in apps
+constexpr qint64 PhotoProcessingUs = 40000;
+constexpr qint64 MusicDecodePeriodMs = 20;
+constexpr qint64 MusicDecodeUs = 1000;
+constexpr qint64 SyncPeriodMs = 60000;
+constexpr qint64 SyncWorkUs = 150000;
+constexpr qint64 BackupWorkUsPerMB = 20000;
+// Host work done per simulated CPU us by the built-in apps
+constexpr qint64 AppWorkBytesPerUs = 64;
+
+// Stands in for the built-in apps' own work (encoding, decoding, checking
+// what they sync): hashing a buffer in proportion to the CPU time granted
+void runAppWork(qint64 sliceUs)
+{
+    static const QByteArray data(256 * 1024, char(0x5A));
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    for (qint64 left = sliceUs * AppWorkBytesPerUs; left > 0;) {
+        const qint64 length = qMin<qint64>(left, data.size());
+        hash.addData(QByteArrayView(data.constData(), length));
+        left -= length;
+    }
+}
+
+// The simulated microphone: 16 kHz mono, one 20 ms buffer per tick
+constexpr int VoiceSampleRate = 16000;
+constexpr qint64 VoiceInputPeriodMs = 20;
+constexpr int VoiceInputFrames = int(VoiceSampleRate * VoiceInputPeriodMs / 1000);
+
+// The viewfinder runs at 30 fps
+constexpr qint64 ViewfinderPeriodMs = 33;
+
+// Activity entries kept searchable; the oldest drop out first
+constexpr int SearchableActivity = 10000;
+
+constexpr int PasswordSaltBytes = 16;
+
+// State store keys
+const QString PasswordSaltKey = QStringLiteral("security/passwordSalt");
+const QString PasswordHashKey = QStringLiteral("security/passwordHash");
+const QString UnlockedKey = QStringLiteral("security/unlocked");
+const QString StorageUsedKey = QStringLiteral("storage/usedMB");
+const QString StorageTotalKey = QStringLiteral("storage/totalMB");
+const QString InstalledAppsKey = QStringLiteral("apps/installed");
+const QString BackupEnabledKey = QStringLiteral("backup/enabled");
+
+// Whole MB, rounded up, as storage is accounted
+int megabytes(qint64 bytes)
+{
+    return int((bytes + 1024 * 1024 - 1) / (1024 * 1024));
+}
+
+// Simulated photos have no pixels; backups upload this in their place
+const QByteArray &photoContent()
+{
+    static const QByteArray bytes(int(Camera::PhotoSizeKB * 1024), char(0x5A));
+    return bytes;
+}
+
+QByteArray newPasswordSalt()
+{
+    QByteArray salt(PasswordSaltBytes, Qt::Uninitialized);
+    QRandomGenerator::global()->fillRange(reinterpret_cast<quint32 *>(salt.data()),
+                                          PasswordSaltBytes / int(sizeof(quint32)));
+    return salt;
+}
+
+} // namespace
 
 Smartphone::Smartphone() 
-    : Camera(), MusicPlayer(nullptr), password("1234"), 
-      storageUsed(0), totalStorage(256), phoneUnlocked(false)
+    : Camera(), MusicPlayer(nullptr), passwordSalt(newPasswordSalt()),
+      passwordHash(hashPassword(passwordSalt, DefaultPassword)),
+      storageUsed(0), totalStorage(256), phoneUnlocked(false),
+      clock(new SimulationClock(this)), autoLockTimeoutMs(0), autoLockEvent(0),
+      ownPowerModel(1), power(&ownPowerModel), powerSlot(0),
+      apps(nullptr), cameraApp(-1), musicApp(-1), syncService(-1), backupService(-1), musicDecodeEvent(0), syncEvent(0),
+      bus(new EventBus(1024)), lastBatteryPercent(100), search(new SearchIndex()), store(nullptr),
+      server(nullptr), net(nullptr), backup(nullptr),
+      voiceRecorder(nullptr), voiceInput(VoiceSampleRate, 1), voiceInputEvent(0),
+      viewfinder(nullptr), viewfinderEvent(0), codesInView(0), storageInfoUsed(-1), storageInfoTotal(-1)
 {
-    qDebug() << "🔒 Smartphone initialized and LOCKED";
+    power->setComponentPower(powerSlot, PowerComponent::Cpu, power->costs().cpuIdleW);
+    search->setLimit(SearchIndex::Kind::Activity, SearchableActivity);
+    clock->scheduleEvery(PowerTickMs, [this]() {
+        if (power == &ownPowerModel) {
+            ownPowerModel.tick(PowerTickMs / 1000.0);
+        }
+        int percent = int(power->batteryPercent(powerSlot));
+        if (percent != lastBatteryPercent) {
+            lastBatteryPercent = percent;
+            bus->publish(PhoneEvent::BatteryChanged, clock->now(), percent);
+        }
+    });
+
+    PHONE_LOG_INFO("phone", "🔒 Smartphone initialized and LOCKED");
 }
 
 Smartphone::~Smartphone()
 {
-    qDebug() << "Smartphone destroyed";
+    stopVoiceMemo();
+    stopViewfinder();
+    delete viewfinder;
+    // Before the clock it ticks on
+    delete backup;
+    delete net;
+    delete server;
+    clock->cancel(syncEvent);
+    clock->cancel(musicDecodeEvent);
+    delete apps;
+    delete bus;
+    delete search;
+    delete store;
+    PHONE_LOG_DEBUG("phone", "Smartphone destroyed");
 }
 
 bool Smartphone::unlockPhone(const QString &inputPassword)
 {
-    if (inputPassword == password) {
-        phoneUnlocked = true;
-        qDebug() << "🔓 Phone UNLOCKED successfully!";
+    TRACE_SPAN("Smartphone::unlockPhone");
+    ALLOC_SCOPE("Smartphone::unlockPhone", "Smartphone");
+    if (hashPassword(passwordSalt, inputPassword) == passwordHash) {
+        resumeUnlocked();
+        persistState();
+        PHONE_LOG_SUCCESS("security", "🔓 Phone UNLOCKED successfully!");
         return true;
     } else {
         phoneUnlocked = false;
-        qDebug() << "❌ Incorrect password! Phone remains LOCKED";
+        persistState();
+        bus->publish(PhoneEvent::UnlockFailed, clock->now());
+        PHONE_LOG_ERROR("security", "❌ Incorrect password! Phone remains LOCKED");
+        return false;
+    }
+}
+
+bool Smartphone::changePassword(const QString &currentPassword, const QString &newPassword)
+{
+    TRACE_SPAN("Smartphone::changePassword");
+    if (!phoneUnlocked || hashPassword(passwordSalt, currentPassword) != passwordHash) {
+        PHONE_LOG_ERROR("security", "❌ Incorrect password! Password not changed");
+        return false;
+    }
+    if (newPassword.isEmpty()) {
+        PHONE_LOG_ERROR("security", "❌ The new password is empty");
         return false;
     }
+    passwordSalt = newPasswordSalt();
+    passwordHash = hashPassword(passwordSalt, newPassword);
+    persistState();
+    // Unlike the other state, a lost password change locks the user out
+    if (store) {
+        store->sync();
+    }
+    restartAutoLockTimer();
+    PHONE_LOG_SUCCESS("security", "🔑 Password changed");
+    return true;
 }
 
 QString Smartphone::getStorageInfo()
 {
+    ALLOC_SCOPE("Smartphone::getStorageInfo", "Smartphone");
     if (!phoneUnlocked) {
-        return "Phone is locked! Cannot access storage info.";
+        return QStringLiteral("Phone is locked! Cannot access storage info.");
     }
     
     int availableStorage = totalStorage - storageUsed;
     int usagePercentage = (storageUsed * 100) / totalStorage;
     
-    QString info = QString("📊 Storage Info:\n"
-                           "Total Storage: %1 MB\n"
-                           "Used: %2 MB\n"
-                           "Available: %3 MB\n"
-                           "Usage: %4%")
-                           .arg(totalStorage)
-                           .arg(storageUsed)
-                           .arg(availableStorage)
-                           .arg(usagePercentage);
-    
-    qDebug() << info;
-    return info;
+    // Reformatted only when the numbers change; callers share the cached text
+    if (storageInfoUsed != storageUsed || storageInfoTotal != totalStorage) {
+        ScratchScope scratch;
+        ScratchString info(160);
+        info << u"📊 Storage Info:\nTotal Storage: " << totalStorage
+             << u" MB\nUsed: " << storageUsed
+             << u" MB\nAvailable: " << availableStorage
+             << u" MB\nUsage: " << usagePercentage << u"%";
+        info.assignTo(storageInfoText);
+        storageInfoUsed = storageUsed;
+        storageInfoTotal = totalStorage;
+    }
+    
+    PHONE_LOG_DEBUG("storage", "Storage: %1 of %2 MB used (%3%)", storageUsed, totalStorage, usagePercentage);
+    return storageInfoText;
 }
 
 bool Smartphone::isPhoneUnlocked() const
@@ -56,8 +207,14 @@ bool Smartphone::isPhoneUnlocked() const
 
 void Smartphone::lockPhone()
 {
+    ALLOC_SCOPE("Smartphone::lockPhone", "Smartphone");
     phoneUnlocked = false;
-    qDebug() << "🔒 Phone LOCKED";
+    power->setComponentPower(powerSlot, PowerComponent::Screen, 0.0);
+    clock->cancel(autoLockEvent);
+    autoLockEvent = 0;
+    persistState();
+    bus->publish(PhoneEvent::PhoneLocked, clock->now());
+    PHONE_LOG_INFO("security", "🔒 Phone LOCKED");
 }
 
 bool Smartphone::isCameraAvailable() const
@@ -67,7 +224,24 @@ bool Smartphone::isCameraAvailable() const
 
 bool Smartphone::takePhoto()
 {
-    return Camera::takePhoto();
+    ALLOC_SCOPE("Smartphone::takePhoto", "Smartphone");
+    restartAutoLockTimer();
+    if (!Camera::takePhoto()) {
+        return false;
+    }
+    
+    power->addEnergy(powerSlot, PowerComponent::Camera, power->costs().photoCaptureJ);
+    power->addEnergy(powerSlot, PowerComponent::Storage, PhotoSizeMB * power->costs().storageWriteJPerMB);
+    bus->publish(PhoneEvent::PhotoCaptured, clock->now(), photoCount, lastPhotoPath);
+    indexPhoto(photoIndex.last(), lastPhotoPath);
+    if (backup) {
+        backup->enqueue(QFileInfo(lastPhotoPath).fileName(), photoContent());
+    }
+    if (apps) {
+        apps->setForeground(cameraApp);
+        apps->wake(cameraApp, PhotoProcessingUs);
+    }
+    return true;
 }
 
 QString Smartphone::getLastPhotoPath() const
@@ -77,17 +251,43 @@ QString Smartphone::getLastPhotoPath() const
 
 bool Smartphone::loadMusicFile(const QString &filePath)
 {
-    return MusicPlayer::loadMusic(filePath);
+    if (!MusicPlayer::loadMusic(filePath)) {
+        return false;
+    }
+    
+    if (apps) {
+        apps->setForeground(musicApp);
+    }
+    bus->publish(PhoneEvent::TrackChanged, clock->now(), 0, currentSong);
+    if (!indexedTracks.contains(currentFilePath)) {
+        indexedTracks.insert(currentFilePath);
+        search->add(SearchIndex::Kind::Track, clock->now(), currentSong, currentFilePath);
+    }
+    return true;
 }
 
 bool Smartphone::playMusic()
 {
-    return MusicPlayer::playMusic();
+    restartAutoLockTimer();
+    if (!MusicPlayer::playMusic()) {
+        return false;
+    }
+    
+    power->setComponentPower(powerSlot, PowerComponent::Audio, power->costs().audioDecodeW);
+    if (apps && musicDecodeEvent == 0) {
+        musicDecodeEvent = clock->scheduleEvery(MusicDecodePeriodMs, [this]() {
+            apps->wake(musicApp, MusicDecodeUs);
+        });
+    }
+    return true;
 }
 
 void Smartphone::stopMusic()
 {
     MusicPlayer::stopMusic();
+    power->setComponentPower(powerSlot, PowerComponent::Audio, 0.0);
+    clock->cancel(musicDecodeEvent);
+    musicDecodeEvent = 0;
 }
 
 bool Smartphone::isMusicPlaying() const
@@ -98,4 +298,528 @@ bool Smartphone::isMusicPlaying() const
 QString Smartphone::getCurrentSong() const
 {
     return MusicPlayer::getCurrentSong();
+}
+
+bool Smartphone::startVoiceMemo(AudioEncoder::Format format, bool realMicrophone)
+{
+    TRACE_SPAN("Smartphone::startVoiceMemo");
+    if (!phoneUnlocked) {
+        PHONE_LOG_ERROR("recorder", "❌ Phone is locked! Cannot record.");
+        return false;
+    }
+    if (voiceRecorder && voiceRecorder->isRecording()) {
+        return false;
+    }
+    
+    QString folder = QStandardPaths::writableLocation(QStandardPaths::MusicLocation) + "/Recordings";
+    if (!QDir().mkpath(folder)) {
+        PHONE_LOG_ERROR("recorder", "❌ Cannot create %1", folder);
+        return false;
+    }
+    QString path = QString("%1/memo_%2.%3").arg(folder)
+                       .arg(currentDateTime().toString("yyyy-MM-dd_hh-mm-ss"))
+                       .arg(AudioEncoder::formatName(format));
+    if (!voiceRecorder) {
+        voiceRecorder = new VoiceRecorder(this);
+    }
+    
+    restartAutoLockTimer();
+    if (realMicrophone) {
+        return voiceRecorder->startMicrophone(path, format);
+    }
+    if (!voiceRecorder->start(path, format, voiceInput.sampleRate(), voiceInput.channelCount())) {
+        return false;
+    }
+    // Simulated time may outrun the encoder; the input waits rather than drop samples
+    voiceInputEvent = clock->scheduleEvery(VoiceInputPeriodMs, [this]() {
+        qint16 samples[VoiceInputFrames];
+        voiceInput.read(samples, VoiceInputFrames);
+        voiceRecorder->write(samples, VoiceInputFrames, true);
+    });
+    return true;
+}
+
+VoiceRecorder::Summary Smartphone::stopVoiceMemo()
+{
+    TRACE_SPAN("Smartphone::stopVoiceMemo");
+    if (!voiceRecorder || !voiceRecorder->isRecording()) {
+        return VoiceRecorder::Summary();
+    }
+    clock->cancel(voiceInputEvent);
+    voiceInputEvent = 0;
+    
+    VoiceRecorder::Summary memo = voiceRecorder->stop();
+    if (memo.ok) {
+        // Storage is accounted in whole MB, rounded up
+        double sizeMB = memo.bytes / (1024.0 * 1024.0);
+        storageUsed = qMin(totalStorage, storageUsed + int(std::ceil(sizeMB)));
+        persistState();
+        power->addEnergy(powerSlot, PowerComponent::Storage, sizeMB * power->costs().storageWriteJPerMB);
+        bus->publish(PhoneEvent::StorageChanged, clock->now(), storageUsed);
+    }
+    return memo;
+}
+
+bool Smartphone::isRecordingVoiceMemo() const
+{
+    return voiceRecorder && voiceRecorder->isRecording();
+}
+
+bool Smartphone::startViewfinder(int analysisThreads)
+{
+    TRACE_SPAN("Smartphone::startViewfinder");
+    if (!phoneUnlocked) {
+        PHONE_LOG_ERROR("camera", "❌ Phone is locked! Cannot open the viewfinder.");
+        return false;
+    }
+    if (!isCameraAvailable()) {
+        PHONE_LOG_ERROR("camera", "❌ Camera not available!");
+        return false;
+    }
+    if (viewfinderEvent) {
+        return false;
+    }
+    
+    setFrameAnalysisThreads(analysisThreads);
+    if (!viewfinder) {
+        viewfinder = new SimulatedViewfinder();
+    }
+    codesInView = 0;
+    restartAutoLockTimer();
+    if (apps) {
+        apps->setForeground(cameraApp);
+    }
+    viewfinderEvent = clock->scheduleEvery(ViewfinderPeriodMs, [this]() {
+        FrameAnalysis analysis = analyzeFrame(viewfinder->nextFrame());
+        if (apps) {
+            apps->wake(cameraApp, analysis.timings.totalNs / 1000);
+        }
+        if (analysis.codes.size() == codesInView) {
+            return;
+        }
+        codesInView = int(analysis.codes.size());
+        QStringList found;
+        for (const DetectedCode &code : analysis.codes) {
+            found << code.describe();
+        }
+        bus->publish(PhoneEvent::CodeDetected, clock->now(), codesInView, found.join("; "));
+    });
+    PHONE_LOG_INFO("camera", "📷 Viewfinder on, scanning for codes");
+    return true;
+}
+
+void Smartphone::stopViewfinder()
+{
+    if (!viewfinderEvent) {
+        return;
+    }
+    clock->cancel(viewfinderEvent);
+    viewfinderEvent = 0;
+    if (codesInView > 0) {
+        codesInView = 0;
+        bus->publish(PhoneEvent::CodeDetected, clock->now(), 0);
+    }
+    PHONE_LOG_INFO("camera", "📷 Viewfinder off after %1 frames: %2", analyzedFrameCount(),
+                   frameAnalysisTimings().describe());
+}
+
+bool Smartphone::isViewfinderRunning() const
+{
+    return viewfinderEvent != 0;
+}
+
+SimulationClock *Smartphone::simulationClock() const
+{
+    return clock;
+}
+
+void Smartphone::setAutoLockTimeout(qint64 timeoutMs)
+{
+    autoLockTimeoutMs = qMax<qint64>(0, timeoutMs);
+    restartAutoLockTimer();
+}
+
+qint64 Smartphone::getAutoLockTimeout() const
+{
+    return autoLockTimeoutMs;
+}
+
+SimulationClock::EventId Smartphone::scheduleAlarm(const QDateTime &when, const QString &label)
+{
+    return clock->scheduleAt(when.toMSecsSinceEpoch(), [this, label]() {
+        PHONE_LOG_WARNING("clock", "⏰ Alarm: %1", label);
+        bus->publish(PhoneEvent::AlarmFired, clock->now(), 0, label);
+    });
+}
+
+bool Smartphone::cancelAlarm(SimulationClock::EventId alarmId)
+{
+    return clock->cancel(alarmId);
+}
+
+QString Smartphone::getBatteryInfo() const
+{
+    QString info = QString("🔋 Battery: %1% (%2 °C, throughput x%3)")
+                       .arg(power->batteryPercent(powerSlot), 0, 'f', 1)
+                       .arg(power->temperatureC(powerSlot), 0, 'f', 1)
+                       .arg(power->throttleFactor(powerSlot), 0, 'f', 2);
+    for (int c = 0; c < PowerModel::ComponentCount; ++c) {
+        PowerComponent component = PowerComponent(c);
+        info += QString("\n  %1: %2 J").arg(PowerModel::componentName(component))
+                                        .arg(power->componentEnergyJ(powerSlot, component), 0, 'f', 1);
+    }
+    return info;
+}
+
+double Smartphone::getBatteryLevel() const
+{
+    return power->batteryPercent(powerSlot);
+}
+
+PowerModel *Smartphone::powerModel() const
+{
+    return power;
+}
+
+int Smartphone::powerModelSlot() const
+{
+    return powerSlot;
+}
+
+void Smartphone::attachPowerModel(PowerModel *sharedModel, int slot)
+{
+    if (!sharedModel || slot < 0 || slot >= sharedModel->deviceCount()) {
+        PHONE_LOG_ERROR("power", "❌ Invalid power model slot: %1", slot);
+        return;
+    }
+    
+    // Carry the current continuous draws over to the new slot
+    for (int c = 0; c < PowerModel::ComponentCount; ++c) {
+        PowerComponent component = PowerComponent(c);
+        sharedModel->setComponentPower(slot, component, power->componentPower(powerSlot, component));
+    }
+    power = sharedModel;
+    powerSlot = slot;
+}
+
+AppScheduler *Smartphone::appScheduler()
+{
+    if (apps) {
+        return apps;
+    }
+    
+    apps = new AppScheduler(clock);
+    cameraApp = apps->spawn("camera", AppScheduler::Interactive, runAppWork);
+    musicApp = apps->spawn("music", AppScheduler::Normal, runAppWork);
+    syncService = apps->spawn("sync", AppScheduler::Background, runAppWork);
+    backupService = apps->spawn("backup", AppScheduler::Background, runAppWork);
+    
+    apps->setThrottleSource([this]() { return power->throttleFactor(powerSlot); });
+    apps->setUtilizationSink([this](double busy) {
+        const PowerModel::Costs &costs = power->costs();
+        power->setComponentPower(powerSlot, PowerComponent::Cpu,
+                                 costs.cpuIdleW + (costs.cpuActiveW - costs.cpuIdleW) * busy);
+    });
+    
+    syncEvent = clock->scheduleEvery(SyncPeriodMs, [this]() {
+        apps->wake(syncService, SyncWorkUs);
+        if (net) {
+            net->download(ContentServer::SyncManifest, NetworkStack::ChunkSink());
+        }
+    });
+    if (MusicPlayer::isPlaying && musicDecodeEvent == 0) {
+        musicDecodeEvent = clock->scheduleEvery(MusicDecodePeriodMs, [this]() {
+            apps->wake(musicApp, MusicDecodeUs);
+        });
+    }
+    PHONE_LOG_INFO("scheduler", "⚙️ App scheduler started with %1 simulated cores", apps->coreCount());
+    return apps;
+}
+
+EventBus *Smartphone::eventBus() const
+{
+    return bus;
+}
+
+SearchIndex *Smartphone::searchIndex() const
+{
+    return search;
+}
+
+void Smartphone::indexActivity(const QVector<LogEntry> &entries)
+{
+    for (const LogEntry &entry : entries) {
+        search->add(SearchIndex::Kind::Activity, entry.timestamp, entry.message, entry.source);
+    }
+}
+
+bool Smartphone::openStateStore(const QString &directory)
+{
+    TRACE_SPAN("Smartphone::openStateStore");
+    if (store) {
+        return false;
+    }
+    store = new KeyValueStore();
+    if (!store->open(directory)) {
+        delete store;
+        store = nullptr;
+        return false;
+    }
+    
+    // A new store starts from the phone's current state
+    if (store->contains(PasswordHashKey)) {
+        passwordSalt = store->value(PasswordSaltKey);
+        passwordHash = store->value(PasswordHashKey);
+        totalStorage = qMax(1, int(store->intValue(StorageTotalKey, totalStorage)));
+        storageUsed = qBound(0, int(store->intValue(StorageUsedKey, storageUsed)), totalStorage);
+        const QStringList names = QString::fromUtf8(store->value(InstalledAppsKey)).split(',', Qt::SkipEmptyParts);
+        installed = QSet<QString>(names.cbegin(), names.cend());
+        const bool backupWasOn = store->intValue(BackupEnabledKey) != 0;
+        bus->publish(PhoneEvent::StorageChanged, clock->now(), storageUsed);
+        if (store->intValue(UnlockedKey) != 0) {
+            resumeUnlocked();
+        } else if (phoneUnlocked) {
+            lockPhone();
+        }
+        setPhotoBackupEnabled(backupWasOn);
+    }
+    persistState();
+    PHONE_LOG_INFO("storage", "💾 Phone state kept in %1", directory);
+    return true;
+}
+
+KeyValueStore *Smartphone::stateStore() const
+{
+    return store;
+}
+
+NetworkStack *Smartphone::network()
+{
+    if (net) {
+        return net;
+    }
+    
+    server = new ContentServer();
+    net = new NetworkStack(clock, server, QRandomGenerator::global()->generate());
+    net->setActivitySink([this](bool busy) {
+        power->setComponentPower(powerSlot, PowerComponent::Radio, busy ? power->costs().radioActiveW : 0.0);
+    });
+    PHONE_LOG_INFO("network", "📶 Network up: %1", net->profile().describe());
+    return net;
+}
+
+ContentServer *Smartphone::contentServer()
+{
+    network();
+    return server;
+}
+
+bool Smartphone::setNetworkProfile(const QString &name)
+{
+    NetworkProfile profile;
+    if (!NetworkProfile::fromName(name, profile)) {
+        PHONE_LOG_ERROR("network", "❌ Unknown network profile: %1 (try %2)", name, NetworkProfile::names().join(", "));
+        return false;
+    }
+    network()->setProfile(profile);
+    PHONE_LOG_INFO("network", "📶 Network: %1", profile.describe());
+    return true;
+}
+
+bool Smartphone::installApp(const QString &name)
+{
+    TRACE_SPAN("Smartphone::installApp");
+    if (!phoneUnlocked) {
+        PHONE_LOG_ERROR("apps", "❌ Phone is locked! Cannot install apps.");
+        return false;
+    }
+    const qint64 bytes = contentServer()->size(name);
+    if (bytes < 0) {
+        PHONE_LOG_ERROR("apps", "❌ No app called %1 in the store (try %2)", name, server->catalog().join(", "));
+        return false;
+    }
+    if (installed.contains(name) || installing.contains(name)) {
+        PHONE_LOG_WARNING("apps", "%1 is already installed or installing", name);
+        return false;
+    }
+    if (megabytes(bytes) > totalStorage - storageUsed) {
+        PHONE_LOG_ERROR("apps", "❌ Not enough storage for %1 (%2 MB)", name, megabytes(bytes));
+        return false;
+    }
+    
+    restartAutoLockTimer();
+    installing.insert(name);
+    // The chunks are views into the server's buffer; only the hash sees them
+    auto hash = std::make_shared<QCryptographicHash>(QCryptographicHash::Sha256);
+    const qint64 requestedAt = clock->now();
+    net->download(name, [hash](QByteArrayView chunk) { hash->addData(chunk); },
+                  [this, name, bytes, hash, requestedAt](bool ok) {
+        installing.remove(name);
+        if (!ok) {
+            PHONE_LOG_ERROR("apps", "❌ Download of %1 failed", name);
+            return;
+        }
+        if (hash->result() != server->digest(name)) {
+            PHONE_LOG_ERROR("apps", "❌ %1 is corrupt; not installed", name);
+            return;
+        }
+        installed.insert(name);
+        storageUsed = qMin(totalStorage, storageUsed + megabytes(bytes));
+        persistState();
+        power->addEnergy(powerSlot, PowerComponent::Storage,
+                         bytes / (1024.0 * 1024.0) * power->costs().storageWriteJPerMB);
+        bus->publish(PhoneEvent::StorageChanged, clock->now(), storageUsed);
+        PHONE_LOG_SUCCESS("apps", "📲 Installed %1 (%2 MB) in %3 s", name, megabytes(bytes),
+                          (clock->now() - requestedAt) / 1000.0);
+    });
+    PHONE_LOG_INFO("apps", "⬇️ Installing %1 (%2 MB) over %3", name, megabytes(bytes), net->profile().name);
+    return true;
+}
+
+QStringList Smartphone::installedApps() const
+{
+    QStringList names(installed.cbegin(), installed.cend());
+    names.sort();
+    return names;
+}
+
+QString Smartphone::networkState() const
+{
+    if (!net) {
+        return QString("down");
+    }
+    return QString("%1: %2").arg(net->profile().name, net->stats().describe());
+}
+
+void Smartphone::setPhotoBackupEnabled(bool enabled)
+{
+    if (enabled == (backup != nullptr)) {
+        return;
+    }
+    if (enabled) {
+        backup = new PhotoBackup(clock, network(), server);
+        // Preparing each chunk is background work for the CPU
+        backup->setChunkSink([this](qint64 bytes) {
+            if (apps) {
+                apps->wake(backupService, bytes * BackupWorkUsPerMB / (1024 * 1024));
+            }
+        });
+        PHONE_LOG_INFO("backup", "☁️ Photo backup on");
+    } else {
+        const int dropped = backup->queueDepth();
+        delete backup;
+        backup = nullptr;
+        PHONE_LOG_INFO("backup", "☁️ Photo backup off; %1 photo(s) not backed up", dropped);
+    }
+    persistState();
+}
+
+bool Smartphone::isPhotoBackupEnabled() const
+{
+    return backup != nullptr;
+}
+
+PhotoBackup *Smartphone::photoBackup() const
+{
+    return backup;
+}
+
+QString Smartphone::photoBackupState() const
+{
+    if (!backup) {
+        return QString("off");
+    }
+    const LatencyHistogram &times = backup->timeToBackup();
+    return QString("%1; capture to backup p50 %2 s, p99 %3 s")
+        .arg(backup->stats().describe())
+        .arg(times.percentile(50) / 1000.0, 0, 'f', 1)
+        .arg(times.percentile(99) / 1000.0, 0, 'f', 1);
+}
+
+void Smartphone::playbackStateChanged(bool playing)
+{
+    if (!playing) {
+        power->setComponentPower(powerSlot, PowerComponent::Audio, 0.0);
+        clock->cancel(musicDecodeEvent);
+        musicDecodeEvent = 0;
+    }
+    bus->publish(PhoneEvent::PlaybackChanged, clock->now(), playing ? 1 : 0, currentSong);
+}
+
+QDateTime Smartphone::currentDateTime() const
+{
+    return clock->currentDateTime();
+}
+
+// Any user activity while unlocked pushes the auto-lock deadline back
+void Smartphone::restartAutoLockTimer()
+{
+    if (!phoneUnlocked || autoLockTimeoutMs <= 0) {
+        clock->cancel(autoLockEvent);
+        autoLockEvent = 0;
+        return;
+    }
+    // Every photo or play restarts it: move the pending event, don't add one
+    if (autoLockEvent != 0 && clock->reschedule(autoLockEvent, clock->now() + autoLockTimeoutMs)) {
+        return;
+    }
+    
+    autoLockEvent = clock->scheduleAfter(autoLockTimeoutMs, [this]() {
+        autoLockEvent = 0;
+        PHONE_LOG_INFO("security", "⏲️ Auto-lock timeout reached");
+        lockPhone();
+    });
+}
+
+// Unlocked without a password check: after one, or when restoring state
+void Smartphone::resumeUnlocked()
+{
+    phoneUnlocked = true;
+    power->setComponentPower(powerSlot, PowerComponent::Screen, power->costs().screenOnW);
+    restartAutoLockTimer();
+    bus->publish(PhoneEvent::PhoneUnlocked, clock->now());
+}
+
+// Unchanged values are not rewritten, so this is a few hash lookups when
+// nothing moved; the store's commit thread makes the rest durable
+void Smartphone::persistState()
+{
+    if (!store) {
+        return;
+    }
+    store->put(PasswordSaltKey, passwordSalt);
+    store->put(PasswordHashKey, passwordHash);
+    store->putInt(UnlockedKey, phoneUnlocked ? 1 : 0);
+    store->putInt(StorageUsedKey, storageUsed);
+    store->putInt(StorageTotalKey, totalStorage);
+    store->put(InstalledAppsKey, installedApps().join(',').toUtf8());
+    store->putInt(BackupEnabledKey, backup ? 1 : 0);
+}
+
+QByteArray Smartphone::hashPassword(const QByteArray &salt, const QString &password)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(salt);
+    hash.addData(password.toUtf8());
+    return hash.result();
+}
+
+void Smartphone::indexPhoto(const PhotoRecord &record, const QString &path)
+{
+    search->add(SearchIndex::Kind::Photo, record.capturedAt, QFileInfo(path).fileName(), path);
+}
+
+// After a restore the photos and track come from the snapshot
+void Smartphone::reindexContent()
+{
+    search->removeKind(SearchIndex::Kind::Photo);
+    search->removeKind(SearchIndex::Kind::Track);
+    indexedTracks.clear();
+    for (const PhotoRecord &record : photoIndex) {
+        indexPhoto(record, photoPathFor(record));
+    }
+    if (!currentFilePath.isEmpty()) {
+        indexedTracks.insert(currentFilePath);
+        search->add(SearchIndex::Kind::Track, clock->now(), currentSong, currentFilePath);
+    }
 }
\ No newline at end of file
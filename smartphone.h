@@ -3,16 +3,36 @@
 
 #include "camera.h"
 #include "musicplayer.h"
+#include "simulationclock.h"
+#include "powermodel.h"
+#include "appscheduler.h"
+#include "eventbus.h"
+#include "voicerecorder.h"
+#include "searchindex.h"
+#include "kvstore.h"
+#include "networkstack.h"
+#include "contentserver.h"
+#include "photobackup.h"
+#include "phonelog.h"
+#include <QByteArray>
+#include <QSet>
 #include <QString>
 
 class Smartphone : public Camera, public MusicPlayer
 {
+    // Checkpoints read and restore the private state directly
+    friend class PhoneSnapshot;
+    
 public:
+    // Until changePassword(); also what a replay unlocks with by default
+    static constexpr char DefaultPassword[] = "1234";
+    
     Smartphone();
     ~Smartphone();
     
     // Public methods to access private data
     bool unlockPhone(const QString &inputPassword);
+    bool changePassword(const QString &currentPassword, const QString &newPassword);
     QString getStorageInfo();
     bool isPhoneUnlocked() const;
     void lockPhone();
@@ -25,12 +45,135 @@ public:
     bool isMusicPlaying() const;
     QString getCurrentSong() const;
     
+    // Voice memos in Music/Recordings, from the simulated microphone (fed on
+    // the simulation clock) or a real input device; saved memos count
+    // against storage
+    bool startVoiceMemo(AudioEncoder::Format format, bool realMicrophone = false);
+    VoiceRecorder::Summary stopVoiceMemo();
+    bool isRecordingVoiceMemo() const;
+    
+    // Code scanning: the simulated viewfinder delivers a frame every 33 ms of
+    // simulation time to the camera's frame analysis; CodeDetected is
+    // published when the codes in view change
+    bool startViewfinder(int analysisThreads = 2);
+    void stopViewfinder();
+    bool isViewfinderRunning() const;
+    
+    // Simulated time: timed behaviours are scheduled on this clock
+    SimulationClock *simulationClock() const;
+    void setAutoLockTimeout(qint64 timeoutMs);   // 0 disables auto-lock
+    qint64 getAutoLockTimeout() const;
+    SimulationClock::EventId scheduleAlarm(const QDateTime &when, const QString &label);
+    bool cancelAlarm(SimulationClock::EventId alarmId);
+    
+    // Battery and energy accounting
+    QString getBatteryInfo() const;
+    double getBatteryLevel() const;
+    PowerModel *powerModel() const;
+    int powerModelSlot() const;
+    // Move this phone into one slot of a fleet-wide model; the fleet driver ticks it
+    void attachPowerModel(PowerModel *sharedModel, int slot);
+    
+    // Simulated app processes (camera, music, background sync), created on first use
+    AppScheduler *appScheduler();
+    
+    // State changes are published here instead of being polled
+    EventBus *eventBus() const;
+    
+    // One index over photos, tracks and activity; photos and tracks are
+    // added as they are captured or loaded, activity entries by whoever
+    // owns the log. Thread-safe, so queries need not go through the
+    // phone's thread.
+    SearchIndex *searchIndex() const;
+    void indexActivity(const QVector<LogEntry> &entries);
+    
+    // Password, storage counters and lock state survive restarts in a
+    // key-value store in directory: opening it restores what was saved,
+    // and every later change is logged to it as it happens
+    bool openStateStore(const QString &directory);
+    KeyValueStore *stateStore() const;
+    
+    // Simulated network to an in-process app store and backup server,
+    // created on first use; transfers move with the simulation clock
+    NetworkStack *network();
+    ContentServer *contentServer();
+    bool setNetworkProfile(const QString &name);
+    // Streams the package from the app store into storage, checking its
+    // SHA-256 on the way; installed once the clock has run long enough
+    bool installApp(const QString &name);
+    QStringList installedApps() const;
+    // Profile and transfer counters, without bringing the network up
+    QString networkState() const;
+    
+    // Photos taken while backup is on are uploaded to the backup server in
+    // the background; turning it off drops the ones not yet uploaded
+    void setPhotoBackupEnabled(bool enabled);
+    bool isPhotoBackupEnabled() const;
+    PhotoBackup *photoBackup() const;   // null while off
+    QString photoBackupState() const;
+    
+protected:
+    QDateTime currentDateTime() const override;
+    void playbackStateChanged(bool playing) override;
+    
 private:
-    // Private members - sensitive data
-    QString password;
+    void restartAutoLockTimer();
+    void indexPhoto(const PhotoRecord &record, const QString &path);
+    void reindexContent();
+    void resumeUnlocked();
+    void persistState();
+    static QByteArray hashPassword(const QByteArray &salt, const QString &password);
+    
+
+    // Private members - sensitive data; only a salted hash of the password is kept
+    QByteArray passwordSalt;
+    QByteArray passwordHash;
     int storageUsed;      // in MB
     int totalStorage;     // in MB
     bool phoneUnlocked;
+    
+    SimulationClock *clock;
+    qint64 autoLockTimeoutMs;
+    SimulationClock::EventId autoLockEvent;
+    
+    PowerModel ownPowerModel;
+    PowerModel *power;
+    int powerSlot;
+    
+    AppScheduler *apps;
+    AppScheduler::ProcessId cameraApp;
+    AppScheduler::ProcessId musicApp;
+    AppScheduler::ProcessId syncService;
+    AppScheduler::ProcessId backupService;
+    SimulationClock::EventId musicDecodeEvent;
+    SimulationClock::EventId syncEvent;
+    
+    EventBus *bus;
+    int lastBatteryPercent;
+    
+    SearchIndex *search;
+    QSet<QString> indexedTracks;        // file paths
+    
+    KeyValueStore *store;               // null until openStateStore()
+    
+    ContentServer *server;              // created with the network
+    NetworkStack *net;                  // created on first use
+    QSet<QString> installed;            // app names
+    QSet<QString> installing;
+    PhotoBackup *backup;                // null while backup is off
+    
+    VoiceRecorder *voiceRecorder;       // created on first use
+    SimulatedMicrophone voiceInput;
+    SimulationClock::EventId voiceInputEvent;
+    
+    SimulatedViewfinder *viewfinder;    // created on first use
+    SimulationClock::EventId viewfinderEvent;
+    int codesInView;
+    
+    // getStorageInfo() text and the numbers it was formatted from
+    QString storageInfoText;
+    int storageInfoUsed;
+    int storageInfoTotal;
 };
 
 #endif // SMARTPHONE_H
\ No newline at end of file
@@ -0,0 +1,139 @@
+#include "startupprofiler.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QFile>
+#include <QByteArray>
+#include <QList>
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct Phase
+{
+    const char *name;
+    qint64 endNs;
+};
+
+// Time spent between exec() and static initialization of this binary
+// (dynamic loading, relocations). Only measurable on Linux.
+qint64 measurePreMainNs()
+{
+#ifdef Q_OS_LINUX
+    QFile statFile("/proc/self/stat");
+    QFile uptimeFile("/proc/uptime");
+    if (!statFile.open(QIODevice::ReadOnly) || !uptimeFile.open(QIODevice::ReadOnly))
+        return -1;
+
+    // Field 22 (starttime) follows the parenthesised command name
+    QByteArray stat = statFile.readAll();
+    int close = stat.lastIndexOf(')');
+    if (close < 0)
+        return -1;
+    QList<QByteArray> fields = stat.mid(close + 2).split(' ');
+    if (fields.size() < 20)
+        return -1;
+    double startTicks = fields.at(19).toDouble();
+    double uptimeSec = uptimeFile.readAll().split(' ').value(0).toDouble();
+    double startSec = startTicks / double(sysconf(_SC_CLK_TCK));
+    return qint64((uptimeSec - startSec) * 1e9);
+#else
+    return -1;
+#endif
+}
+
+struct ProfilerState
+{
+    ProfilerState() : enabled(qEnvironmentVariableIntValue("SMARTPHONE_PROFILE_STARTUP") != 0),
+                      finished(false), firstFrameNs(-1)
+    {
+        timer.start();
+        preMainNs = measurePreMainNs();
+        phases.reserve(16);
+    }
+
+    QElapsedTimer timer;
+    bool enabled;
+    bool finished;
+    qint64 preMainNs;
+    qint64 firstFrameNs;
+    QVector<Phase> phases;
+};
+
+ProfilerState &state()
+{
+    static ProfilerState s;
+    return s;
+}
+
+// Start the clock during static initialization rather than on first use
+const ProfilerState &startupAnchor = state();
+
+} // namespace
+
+void StartupProfiler::setEnabled(bool enabled)
+{
+    state().enabled = enabled;
+}
+
+bool StartupProfiler::isEnabled()
+{
+    return state().enabled;
+}
+
+void StartupProfiler::mark(const char *phase)
+{
+    ProfilerState &s = state();
+    if (s.finished)
+        return;
+    s.phases.append({phase, s.timer.nsecsElapsed()});
+}
+
+void StartupProfiler::finishFirstFrame()
+{
+    ProfilerState &s = state();
+    if (s.finished)
+        return;
+    s.phases.append({"first frame", s.timer.nsecsElapsed()});
+    s.firstFrameNs = s.phases.last().endNs;
+    s.finished = true;
+
+    if (s.enabled)
+        qDebug().noquote() << report();
+}
+
+bool StartupProfiler::isFinished()
+{
+    return state().finished;
+}
+
+qint64 StartupProfiler::elapsedSinceStartNs()
+{
+    return state().timer.nsecsElapsed();
+}
+
+QString StartupProfiler::report()
+{
+    const ProfilerState &s = state();
+    QString out = "⏱️ Startup profile\n";
+    qint64 preMain = qMax<qint64>(0, s.preMainNs);
+    if (s.preMainNs >= 0)
+        out += QString("  %1 %2 ms\n").arg(QStringLiteral("pre-main"), -24).arg(preMain / 1e6, 8, 'f', 2);
+
+    qint64 previous = 0;
+    for (const Phase &phase : s.phases) {
+        out += QString("  %1 %2 ms\n").arg(QString::fromUtf8(phase.name), -24)
+                                      .arg((phase.endNs - previous) / 1e6, 8, 'f', 2);
+        previous = phase.endNs;
+    }
+
+    if (s.finished)
+        out += QString("  %1 %2 ms").arg(QStringLiteral("total to first frame"), -24)
+                                    .arg((preMain + s.firstFrameNs) / 1e6, 8, 'f', 2);
+    else
+        out += "  (first frame not reached yet)";
+    return out;
+}
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+#include <QString>
+
+// Records named startup phases from process start until the first frame is
+// presented. Marks are cheap and always taken; the report is only printed
+// when profiling is enabled (--profile-startup or SMARTPHONE_PROFILE_STARTUP=1).
+class StartupProfiler
+{
+public:
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+
+    // Close the phase that started at the previous mark
+    static void mark(const char *phase);
+    // Called once when the first frame has been painted
+    static void finishFirstFrame();
+    static bool isFinished();
+
+    static qint64 elapsedSinceStartNs();
+    static QString report();
+
+private:
+    StartupProfiler() = delete;
+};
+
+#endif // STARTUPPROFILER_H
\ No newline at end of file
@@ -0,0 +1,12 @@
+include(../../phonecore.pri)
+
+QT += testlib
+
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_activitylogmodel
+TEMPLATE = app
+
+SOURCES += \
+    tst_activitylogmodel.cpp
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include <QtTest>
+#include "activitylogmodel.h"
+
+class ActivityLogModelTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void unfilteredEvictionThenFilter();
+    void filteredEviction();
+    void batchLargerThanCapacity();
+
+private:
+    // Every third entry is a warning from "camera", the rest info from "music"
+    static void fill(ActivityLogModel &model, int first, int count);
+};
+
+void ActivityLogModelTest::fill(ActivityLogModel &model, int first, int count)
+{
+    for (int i = first; i < first + count; ++i) {
+        bool warning = i % 3 == 0;
+        model.append(warning ? LogEntry::Warning : LogEntry::Info, warning ? "camera" : "music",
+                     QString::number(i));
+    }
+    model.flush();
+}
+
+void ActivityLogModelTest::unfilteredEvictionThenFilter()
+{
+    ActivityLogModel model(8);
+    fill(model, 0, 5);
+    fill(model, 5, 15);
+
+    QCOMPARE(model.storedCount(), 8);
+    QCOMPARE(model.rowCount(), 8);
+    QCOMPARE(model.evictedCount(), quint64(12));
+    QCOMPARE(model.entryAt(0).message, QString("12"));
+    QCOMPARE(model.entryAt(7).message, QString("19"));
+
+    // 12, 15 and 18 are the warnings still stored
+    model.setFilter(levelBit(LogEntry::Warning));
+    QCOMPARE(model.rowCount(), 3);
+    QCOMPARE(model.entryAt(0).message, QString("12"));
+    QCOMPARE(model.entryAt(2).message, QString("18"));
+
+    model.setFilter(AllLogLevels);
+    QCOMPARE(model.rowCount(), 8);
+    model.clear();
+    QCOMPARE(model.rowCount(), 0);
+}
+
+void ActivityLogModelTest::filteredEviction()
+{
+    ActivityLogModel model(8);
+    model.setFilter(AllLogLevels, "camera");
+    fill(model, 0, 8);
+    QCOMPARE(model.rowCount(), 3);
+
+    // Evicts 0..5, which holds two of the visible rows
+    fill(model, 8, 6);
+    QCOMPARE(model.storedCount(), 8);
+    QCOMPARE(model.rowCount(), 3);
+    QCOMPARE(model.entryAt(0).message, QString("6"));
+    QCOMPARE(model.entryAt(2).message, QString("12"));
+
+    model.setFilter(AllLogLevels);
+    QCOMPARE(model.rowCount(), 8);
+    QCOMPARE(model.entryAt(0).message, QString("6"));
+}
+
+void ActivityLogModelTest::batchLargerThanCapacity()
+{
+    ActivityLogModel model(4);
+    fill(model, 0, 3);
+    fill(model, 3, 10);
+
+    QCOMPARE(model.storedCount(), 4);
+    QCOMPARE(model.rowCount(), 4);
+    QCOMPARE(model.evictedCount(), quint64(9));
+    QCOMPARE(model.entryAt(0).message, QString("9"));
+
+    model.setFilter(levelBit(LogEntry::Warning));
+    QCOMPARE(model.rowCount(), 2);
+    QCOMPARE(model.entryAt(0).message, QString("9"));
+    QCOMPARE(model.entryAt(1).message, QString("12"));
+}
+
+QTEST_GUILESS_MAIN(ActivityLogModelTest)
+#include "tst_activitylogmodel.moc"
\ No newline at end of file
@@ -0,0 +1,15 @@
+# Counts allocations, so the zero-allocation paths can be checked
+CONFIG += alloc_tracking
+
+include(../../phonecore.pri)
+
+QT += testlib
+
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_allocationtracker
+TEMPLATE = app
+
+SOURCES += \
+    tst_allocationtracker.cpp
\ No newline at end of file
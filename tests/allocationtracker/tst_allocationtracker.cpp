@@ -0,0 +1,121 @@
+#include <QtTest>
+#include <QStandardPaths>
+#include "allocationtracker.h"
+#include "camera.h"
+#include "phonelog.h"
+#include "scratcharena.h"
+#include "smartphone.h"
+
+// Checks that the paths documented as allocation-free stay that way once
+// warm. Only the calling thread's allocations are counted.
+class AllocationTrackerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void countsAllocations();
+    void storageInfoSteadyState();
+    void photoPathInScratchArena();
+    void logWriteSteadyState();
+
+private:
+    static constexpr int Calls = 200;
+};
+
+namespace {
+
+// Reaches the protected path formatting
+class TestCamera : public Camera
+{
+public:
+    using Camera::photoPathFor;
+    using Camera::photoIndex;
+    using Camera::writePhotoPath;
+};
+
+} // namespace
+
+void AllocationTrackerTest::initTestCase()
+{
+    if (!AllocationTracker::isSupported()) {
+        QSKIP("allocation tracking is not built in (glibc only)");
+    }
+    QStandardPaths::setTestModeEnabled(true);
+    PhoneLog::setConsoleOutput(false);
+}
+
+void AllocationTrackerTest::countsAllocations()
+{
+    AllocationTracker::Measurement measurement;
+    QByteArray bytes(4096, 'x');
+    AllocationTracker::Usage usage = measurement.stop();
+    QVERIFY(usage.allocations >= 1);
+    QVERIFY(usage.bytes >= 4096);
+    QCOMPARE(bytes.size(), 4096);
+}
+
+void AllocationTrackerTest::storageInfoSteadyState()
+{
+    Smartphone phone;
+    QVERIFY(phone.unlockPhone(Smartphone::DefaultPassword));
+    QString first = phone.getStorageInfo();
+    PhoneLog::flush();
+
+    AllocationTracker::Measurement measurement;
+    for (int i = 0; i < Calls; ++i) {
+        phone.getStorageInfo();
+    }
+    AllocationTracker::Usage usage = measurement.stop();
+    QCOMPARE(usage.allocations, quint64(0));
+    QCOMPARE(phone.getStorageInfo(), first);
+}
+
+void AllocationTrackerTest::photoPathInScratchArena()
+{
+    TestCamera camera;
+    QVERIFY(camera.takePhoto());
+    const PhotoRecord record = camera.photoIndex.last();
+    const QString expected = camera.photoPathFor(record);
+    QCOMPARE(expected, camera.getLastPhotoPath());
+    {
+        ScratchScope scratch;
+        ScratchString path(expected.size());
+        camera.writePhotoPath(path, record);
+    }
+
+    int matches = 0;
+    AllocationTracker::Measurement measurement;
+    for (int i = 0; i < Calls; ++i) {
+        ScratchScope scratch;
+        ScratchString path(expected.size());
+        camera.writePhotoPath(path, record);
+        matches += path.view() == expected;
+    }
+    AllocationTracker::Usage usage = measurement.stop();
+    QCOMPARE(usage.allocations, quint64(0));
+    QCOMPARE(matches, Calls);
+}
+
+void AllocationTrackerTest::logWriteSteadyState()
+{
+    const QString name = QStringLiteral("photo_0001.jpg");
+    PhoneLog::setLevel(LogEntry::Debug);
+    PHONE_LOG_INFO("test", "Saved %1 (%2 KB)", name, 0);
+    PhoneLog::flush();
+    quint64 dropped = PhoneLog::droppedCount();
+
+    // Fewer than half a ring, so every write takes a slot and none waits
+    const int writes = qMin(Calls, PhoneLog::ThreadBufferCapacity / 4);
+    AllocationTracker::Measurement measurement;
+    for (int i = 0; i < writes; ++i) {
+        PHONE_LOG_INFO("test", "Saved %1 (%2 KB)", name, i);
+    }
+    AllocationTracker::Usage usage = measurement.stop();
+    QCOMPARE(usage.allocations, quint64(0));
+    QCOMPARE(PhoneLog::droppedCount(), dropped);
+    PhoneLog::flush();
+}
+
+QTEST_GUILESS_MAIN(AllocationTrackerTest)
+#include "tst_allocationtracker.moc"
\ No newline at end of file
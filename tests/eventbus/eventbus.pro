@@ -0,0 +1,12 @@
+include(../../phonecore.pri)
+
+QT += testlib
+
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_eventbus
+TEMPLATE = app
+
+SOURCES += \
+    tst_eventbus.cpp
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include <QtTest>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "eventbus.h"
+
+class EventBusTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void batchesForContext();
+    void filtersByMask();
+    void fullQueueReportsDrops();
+    void unsubscribeDiscardsQueuedDelivery();
+    void deleteBusWithQueuedDelivery();
+    void concurrentPublishers();
+};
+
+void EventBusTest::batchesForContext()
+{
+    EventBus bus(64);
+    QObject context;
+    int batches = 0;
+    QVector<qint64> values;
+    bus.subscribe(AllPhoneEvents, &context, [&](const QVector<PhoneEvent> &batch) {
+        ++batches;
+        for (const PhoneEvent &event : batch)
+            values << event.value;
+    });
+
+    for (int i = 0; i < 10; ++i)
+        bus.publish(PhoneEvent::StorageChanged, i, i);
+    QCOMPARE(batches, 0);
+
+    QCoreApplication::processEvents();
+    QCOMPARE(batches, 1);
+    QCOMPARE(values, QVector<qint64>({0, 1, 2, 3, 4, 5, 6, 7, 8, 9}));
+}
+
+void EventBusTest::filtersByMask()
+{
+    EventBus bus(64);
+    QVector<PhoneEvent::Type> types;
+    EventBus::SubscriberId id = bus.subscribe(eventBit(PhoneEvent::PhotoCaptured) | eventBit(PhoneEvent::PhoneLocked),
+                                              nullptr, [&](const QVector<PhoneEvent> &batch) {
+        for (const PhoneEvent &event : batch)
+            types << event.type;
+    });
+
+    bus.publish(PhoneEvent::PhotoCaptured, 1);
+    bus.publish(PhoneEvent::StorageChanged, 2);
+    bus.publish(PhoneEvent::PhoneLocked, 3);
+    bus.publish(PhoneEvent::TrackChanged, 4);
+
+    QCOMPARE(bus.drain(id), 2);
+    QCOMPARE(types, QVector<PhoneEvent::Type>({PhoneEvent::PhotoCaptured, PhoneEvent::PhoneLocked}));
+    QCOMPARE(bus.publishedCount(), quint64(4));
+}
+
+void EventBusTest::fullQueueReportsDrops()
+{
+    EventBus bus(4);
+    QVector<PhoneEvent> received;
+    EventBus::SubscriberId id = bus.subscribe(AllPhoneEvents, nullptr, [&](const QVector<PhoneEvent> &batch) {
+        received += batch;
+    });
+
+    for (int i = 0; i < 10; ++i)
+        bus.publish(PhoneEvent::StorageChanged, i, i);
+
+    // The four that fit, then one event saying how many were lost
+    QCOMPARE(bus.drain(id), 5);
+    QCOMPARE(received.size(), 5);
+    for (int i = 0; i < 4; ++i)
+        QCOMPARE(received[i].value, qint64(i));
+    QCOMPARE(received.last().type, PhoneEvent::EventsDropped);
+    QCOMPARE(received.last().value, qint64(6));
+    QCOMPARE(bus.droppedCount(), quint64(6));
+
+    // The count is reported once
+    received.clear();
+    bus.publish(PhoneEvent::StorageChanged, 20, 20);
+    QCOMPARE(bus.drain(id), 1);
+    QCOMPARE(received.last().type, PhoneEvent::StorageChanged);
+}
+
+void EventBusTest::unsubscribeDiscardsQueuedDelivery()
+{
+    EventBus bus(64);
+    QObject context;
+    int batches = 0;
+    EventBus::SubscriberId id = bus.subscribe(AllPhoneEvents, &context, [&](const QVector<PhoneEvent> &) {
+        ++batches;
+    });
+
+    bus.publish(PhoneEvent::PhotoCaptured, 1);
+    bus.unsubscribe(id);
+    QCoreApplication::processEvents();
+    QCOMPARE(batches, 0);
+}
+
+void EventBusTest::deleteBusWithQueuedDelivery()
+{
+    QObject context;
+    int batches = 0;
+    auto *bus = new EventBus(64);
+    bus->subscribe(AllPhoneEvents, &context, [&](const QVector<PhoneEvent> &) { ++batches; });
+
+    bus->publish(PhoneEvent::PhotoCaptured, 1);
+    delete bus;
+    QCoreApplication::processEvents();
+    QCOMPARE(batches, 0);
+}
+
+void EventBusTest::concurrentPublishers()
+{
+    const int threads = 4;
+    const int perThread = 10000;
+    EventBus bus(threads * perThread);
+    int received = 0;
+    EventBus::SubscriberId id = bus.subscribe(AllPhoneEvents, nullptr, [&](const QVector<PhoneEvent> &batch) {
+        received += batch.size();
+    });
+
+    // Another thread keeps subscribing and unsubscribing while the publishers run
+    QObject context;
+    std::atomic<bool> stop(false);
+    std::thread churn([&]() {
+        while (!stop.load()) {
+            EventBus::SubscriberId other = bus.subscribe(AllPhoneEvents, &context, [](const QVector<PhoneEvent> &) {});
+            bus.unsubscribe(other);
+        }
+    });
+
+    std::vector<std::thread> publishers;
+    for (int t = 0; t < threads; ++t) {
+        publishers.emplace_back([&bus, t]() {
+            for (int i = 0; i < perThread; ++i)
+                bus.publish(PhoneEvent::PhotoCaptured, i, t);
+        });
+    }
+    for (std::thread &publisher : publishers)
+        publisher.join();
+    stop.store(true);
+    churn.join();
+
+    bus.drain(id);
+    QCOMPARE(received, threads * perThread);
+    QCOMPARE(bus.droppedCount(), quint64(0));
+    QCoreApplication::processEvents();
+}
+
+QTEST_GUILESS_MAIN(EventBusTest)
+#include "tst_eventbus.moc"
\ No newline at end of file
@@ -0,0 +1,12 @@
+include(../../phonecore.pri)
+
+QT += testlib
+
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_kvstore
+TEMPLATE = app
+
+SOURCES += \
+    tst_kvstore.cpp
\ No newline at end of file
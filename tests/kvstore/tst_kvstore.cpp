@@ -0,0 +1,204 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include <thread>
+#include <vector>
+#include "kvstore.h"
+
+class KeyValueStoreTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void reopensWhatWasWritten();
+    void dropsTornTail_data();
+    void dropsTornTail();
+    void ignoresLogFromOlderGeneration();
+    void groupsConcurrentChanges();
+
+private:
+    static QByteArray readFile(const QString &path);
+    static void writeFile(const QString &path, const QByteArray &data);
+};
+
+QByteArray KeyValueStoreTest::readFile(const QString &path)
+{
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+void KeyValueStoreTest::writeFile(const QString &path, const QByteArray &data)
+{
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QCOMPARE(file.write(data), qint64(data.size()));
+}
+
+void KeyValueStoreTest::reopensWhatWasWritten()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    {
+        KeyValueStore store;
+        QVERIFY(store.open(dir.path()));
+        QVERIFY(store.put("name", "phone"));
+        QVERIFY(store.putInt("storage", 1234));
+        QVERIFY(store.put("gone", "soon"));
+        QVERIFY(store.remove("gone"));
+        // An unchanged value is not logged again
+        QVERIFY(store.put("name", "phone"));
+        QCOMPARE(store.stats().writes, qint64(4));
+    }
+
+    KeyValueStore store;
+    QVERIFY(store.open(dir.path()));
+    QCOMPARE(store.value("name"), QByteArray("phone"));
+    QCOMPARE(store.intValue("storage"), qint64(1234));
+    QVERIFY(!store.contains("gone"));
+    QCOMPARE(store.stats().recoveredRecords, 4);
+    QCOMPARE(store.stats().discardedBytes, qint64(0));
+}
+
+void KeyValueStoreTest::dropsTornTail_data()
+{
+    QTest::addColumn<int>("cut");
+    QTest::addColumn<int>("flip");
+
+    // The last record is put("c", "3"): 8 header bytes, 3 payload header bytes, key, value
+    QTest::newRow("short payload") << 3 << -1;
+    QTest::newRow("short header") << 8 << -1;
+    QTest::newRow("bad checksum") << 0 << 1;
+}
+
+void KeyValueStoreTest::dropsTornTail()
+{
+    QFETCH(int, cut);
+    QFETCH(int, flip);
+    const int lastRecordBytes = 8 + 3 + 1 + 1;
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    {
+        KeyValueStore store;
+        QVERIFY(store.open(dir.path()));
+        QVERIFY(store.put("a", "1"));
+        QVERIFY(store.put("b", "2"));
+        QVERIFY(store.put("c", "3"));
+    }
+
+    const QString logPath = dir.filePath("state.wal");
+    QByteArray log = readFile(logPath);
+    const qsizetype intact = log.size() - lastRecordBytes;
+    log.chop(cut);
+    if (flip >= 0) {
+        log[log.size() - 1 - flip] = char(log[log.size() - 1 - flip] ^ 0x40);
+    }
+    writeFile(logPath, log);
+
+    {
+        KeyValueStore store;
+        QVERIFY(store.open(dir.path()));
+        QCOMPARE(store.value("a"), QByteArray("1"));
+        QCOMPARE(store.value("b"), QByteArray("2"));
+        QVERIFY(!store.contains("c"));
+        KeyValueStore::Stats stats = store.stats();
+        QCOMPARE(stats.recoveredRecords, 2);
+        QCOMPARE(stats.discardedBytes, qint64(lastRecordBytes - cut));
+        QCOMPARE(stats.walBytes, qint64(intact));
+        QCOMPARE(QFileInfo(logPath).size(), qint64(intact));
+
+        // New changes follow the last intact record
+        QVERIFY(store.put("d", "4"));
+    }
+
+    KeyValueStore store;
+    QVERIFY(store.open(dir.path()));
+    QCOMPARE(store.keys().size(), 3);
+    QCOMPARE(store.value("d"), QByteArray("4"));
+    QCOMPARE(store.stats().discardedBytes, qint64(0));
+}
+
+void KeyValueStoreTest::ignoresLogFromOlderGeneration()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString logPath = dir.filePath("state.wal");
+    {
+        KeyValueStore store;
+        QVERIFY(store.open(dir.path()));
+        QVERIFY(store.put("mode", "old"));
+    }
+    const QByteArray staleLog = readFile(logPath);
+    {
+        KeyValueStore store;
+        QVERIFY(store.open(dir.path()));
+        QVERIFY(store.put("mode", "new"));
+        QVERIFY(store.compact());
+        QCOMPARE(store.stats().compactions, 1);
+    }
+
+    // As after a crash between writing the snapshot and restarting the log:
+    // replaying the old log would bring back the old value
+    writeFile(logPath, staleLog);
+    {
+        KeyValueStore store;
+        QVERIFY(store.open(dir.path()));
+        QCOMPARE(store.value("mode"), QByteArray("new"));
+        QCOMPARE(store.stats().recoveredRecords, 0);
+        QVERIFY(store.put("extra", "1"));
+    }
+
+    // The restarted log carries the snapshot's generation and is replayed
+    KeyValueStore store;
+    QVERIFY(store.open(dir.path()));
+    QCOMPARE(store.value("mode"), QByteArray("new"));
+    QCOMPARE(store.value("extra"), QByteArray("1"));
+    QCOMPARE(store.stats().recoveredRecords, 1);
+}
+
+void KeyValueStoreTest::groupsConcurrentChanges()
+{
+    const int threads = 4;
+    const int perThread = 250;
+    const int total = threads * perThread;
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    {
+        KeyValueStore store;
+        QVERIFY(store.open(dir.path()));
+        std::vector<std::thread> writers;
+        for (int t = 0; t < threads; ++t) {
+            writers.emplace_back([&, t]() {
+                for (int i = 0; i < perThread; ++i) {
+                    store.putInt(QString("key.%1.%2").arg(t).arg(i), i);
+                }
+            });
+        }
+        for (std::thread &writer : writers) {
+            writer.join();
+        }
+        QVERIFY(store.sync());
+
+        KeyValueStore::Stats stats = store.stats();
+        QCOMPARE(stats.writes, qint64(total));
+        QCOMPARE(stats.keys, total);
+        QVERIFY(stats.commits >= 1);
+        QVERIFY2(stats.commits < stats.writes, qPrintable(stats.describe()));
+        QVERIFY(stats.writesPerCommit() > 1.0);
+        QCOMPARE(stats.compactions, 0);
+
+        // Nothing queued: returns without another commit
+        QVERIFY(store.sync());
+        QCOMPARE(store.stats().commits, stats.commits);
+    }
+
+    KeyValueStore store;
+    QVERIFY(store.open(dir.path()));
+    QCOMPARE(store.stats().recoveredRecords, total);
+    for (int t = 0; t < threads; ++t) {
+        QCOMPARE(store.intValue(QString("key.%1.%2").arg(t).arg(perThread - 1), -1), qint64(perThread - 1));
+    }
+}
+
+QTEST_GUILESS_MAIN(KeyValueStoreTest)
+#include "tst_kvstore.moc"
\ No newline at end of file
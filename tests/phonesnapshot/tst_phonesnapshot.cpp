@@ -0,0 +1,151 @@
+#include <QtTest>
+#include <QTemporaryDir>
+#include "phonesnapshot.h"
+#include "smartphone.h"
+
+class PhoneSnapshotTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void roundTrip();
+    void rejectsCorruptHeader_data();
+    void rejectsCorruptHeader();
+    void rejectsRecordOutsideFile();
+
+private:
+    static void startClock(Smartphone &phone, qint64 nowMs);
+    static QString savedFleet(const QTemporaryDir &dir);
+    static void patch(const QString &path, qint64 offset, const QByteArray &bytes);
+};
+
+void PhoneSnapshotTest::startClock(Smartphone &phone, qint64 nowMs)
+{
+    phone.simulationClock()->setMode(SimulationClock::Mode::AsFastAsPossible);
+    phone.simulationClock()->setCurrentDateTime(QDateTime::fromMSecsSinceEpoch(nowMs));
+}
+
+QString PhoneSnapshotTest::savedFleet(const QTemporaryDir &dir)
+{
+    Smartphone first;
+    Smartphone second;
+    startClock(first, 1000000);
+    startClock(second, 2000000);
+    first.takePhoto();
+    QString path = dir.filePath("fleet.snap");
+    return PhoneSnapshot::save(path, {&first, &second}) ? path : QString();
+}
+
+void PhoneSnapshotTest::patch(const QString &path, qint64 offset, const QByteArray &bytes)
+{
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.seek(offset));
+    QCOMPARE(file.write(bytes), qint64(bytes.size()));
+}
+
+void PhoneSnapshotTest::roundTrip()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString path = dir.filePath("phones.snap");
+
+    Smartphone first;
+    Smartphone second;
+    startClock(first, 1000000);
+    startClock(second, 5000000);
+    QVERIFY(first.unlockPhone(Smartphone::DefaultPassword));
+    for (int i = 0; i < 3; ++i) {
+        QVERIFY(first.takePhoto());
+        first.simulationClock()->advanceBy(1000);
+    }
+    QVERIFY(PhoneSnapshot::save(path, {&first, &second}));
+
+    PhoneSnapshot snapshot(path);
+    QVERIFY2(snapshot.isValid(), qPrintable(snapshot.errorString()));
+    QCOMPARE(snapshot.phoneCount(), 2);
+
+    Smartphone restoredFirst;
+    Smartphone restoredSecond;
+    startClock(restoredFirst, 0);
+    startClock(restoredSecond, 0);
+    QCOMPARE(snapshot.restoreAll({&restoredFirst, &restoredSecond}), 2);
+
+    QCOMPARE(restoredFirst.simulationClock()->now(), first.simulationClock()->now());
+    QCOMPARE(restoredFirst.isPhoneUnlocked(), true);
+    QCOMPARE(restoredFirst.getStorageInfo(), first.getStorageInfo());
+    QCOMPARE(restoredFirst.getLastPhotoPath(), first.getLastPhotoPath());
+    const QVector<PhotoRecord> &saved = first.getPhotoIndex();
+    const QVector<PhotoRecord> &restored = restoredFirst.getPhotoIndex();
+    QCOMPARE(restored.size(), saved.size());
+    for (int i = 0; i < saved.size(); ++i) {
+        QCOMPARE(restored[i].capturedAt, saved[i].capturedAt);
+        QCOMPARE(restored[i].number, saved[i].number);
+        QCOMPARE(restored[i].sizeKB, saved[i].sizeKB);
+    }
+
+    QCOMPARE(restoredSecond.simulationClock()->now(), qint64(5000000));
+    QCOMPARE(restoredSecond.isPhoneUnlocked(), false);
+    QVERIFY(restoredSecond.getPhotoIndex().isEmpty());
+    QVERIFY(restoredSecond.getLastPhotoPath().isEmpty());
+
+    // Out-of-range indexes are refused
+    QVERIFY(!snapshot.restore(2, restoredSecond));
+    QVERIFY(!snapshot.restore(-1, restoredSecond));
+}
+
+void PhoneSnapshotTest::rejectsCorruptHeader_data()
+{
+    QTest::addColumn<qint64>("offset");
+    QTest::addColumn<QByteArray>("bytes");
+    QTest::addColumn<QString>("error");
+
+    // Header: magic[4], version, phoneCount, recordSize (quint32 each), fileSize (quint64)
+    QTest::newRow("magic") << qint64(0) << QByteArray("XXXX") << QString("not a phone snapshot");
+    QTest::newRow("version") << qint64(4) << QByteArray("\x63\0\0\0", 4) << QString("unsupported snapshot version 99");
+    QTest::newRow("record size") << qint64(12) << QByteArray("\x08\0\0\0", 4) << QString("corrupt snapshot header");
+    QTest::newRow("file size") << qint64(16) << QByteArray("\x01\0\0\0\0\0\0\0", 8) << QString("corrupt snapshot header");
+    QTest::newRow("phone count") << qint64(8) << QByteArray("\xff\xff\0\0", 4) << QString("truncated snapshot");
+}
+
+void PhoneSnapshotTest::rejectsCorruptHeader()
+{
+    QFETCH(qint64, offset);
+    QFETCH(QByteArray, bytes);
+    QFETCH(QString, error);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString path = savedFleet(dir);
+    QVERIFY(!path.isEmpty());
+    patch(path, offset, bytes);
+
+    PhoneSnapshot snapshot(path);
+    QVERIFY(!snapshot.isValid());
+    QCOMPARE(snapshot.errorString(), error);
+    QCOMPARE(snapshot.phoneCount(), 0);
+
+    Smartphone phone;
+    QVERIFY(!snapshot.restore(0, phone));
+}
+
+void PhoneSnapshotTest::rejectsRecordOutsideFile()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString path = savedFleet(dir);
+    QVERIFY(!path.isEmpty());
+
+    // First record's photo index offset (after the 24-byte header and two qint64 fields)
+    patch(path, 24 + 16, QByteArray("\0\0\0\0\0\0\0\x40", 8));
+
+    PhoneSnapshot snapshot(path);
+    QVERIFY(snapshot.isValid());
+    Smartphone phone;
+    QVERIFY(!snapshot.restore(0, phone));
+    // The second record is untouched
+    QVERIFY(snapshot.restore(1, phone));
+}
+
+QTEST_GUILESS_MAIN(PhoneSnapshotTest)
+#include "tst_phonesnapshot.moc"
\ No newline at end of file
@@ -0,0 +1,12 @@
+include(../../phonecore.pri)
+
+QT += testlib
+
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_searchindex
+TEMPLATE = app
+
+SOURCES += \
+    tst_searchindex.cpp
\ No newline at end of file
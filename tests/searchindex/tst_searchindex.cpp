@@ -0,0 +1,126 @@
+#include <QtTest>
+#include "searchindex.h"
+
+class SearchIndexTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void matchesWordPrefixes();
+    void intersectsQueryWords();
+    void filtersByKindAndLimit();
+    void compactionRenumbersDocuments();
+
+private:
+    static QStringList titles(const QVector<SearchIndex::Hit> &hits);
+    static void fillSample(SearchIndex &index);
+};
+
+QStringList SearchIndexTest::titles(const QVector<SearchIndex::Hit> &hits)
+{
+    QStringList list;
+    for (const SearchIndex::Hit &hit : hits) {
+        list << hit.title;
+    }
+    return list;
+}
+
+void SearchIndexTest::fillSample(SearchIndex &index)
+{
+    index.add(SearchIndex::Kind::Photo, 1000, "Sunset at the beach", "/pictures/holiday_001.jpg");
+    index.add(SearchIndex::Kind::Track, 2000, "Beach Boys - Surfin", "/music/surfin.mp3");
+    index.add(SearchIndex::Kind::Activity, 3000, "Phone unlocked");
+    index.add(SearchIndex::Kind::Photo, 4000, "Concert", "/pictures/holiday_002.jpg");
+}
+
+void SearchIndexTest::matchesWordPrefixes()
+{
+    SearchIndex index;
+    fillSample(index);
+
+    // Newest first, ignoring case, in the title or the detail
+    QCOMPARE(titles(index.search("bea")), QStringList({"Beach Boys - Surfin", "Sunset at the beach"}));
+    QCOMPARE(titles(index.search("BEACH")), QStringList({"Beach Boys - Surfin", "Sunset at the beach"}));
+    QCOMPARE(titles(index.search("holiday")), QStringList({"Concert", "Sunset at the beach"}));
+    QCOMPARE(titles(index.search("surf")), QStringList({"Beach Boys - Surfin"}));
+
+    // A word must start with the prefix, not merely contain it
+    QVERIFY(index.search("each").isEmpty());
+    QVERIFY(index.search("nlocked").isEmpty());
+    QVERIFY(index.search("").isEmpty());
+    QVERIFY(index.search(" - ").isEmpty());
+
+    const QVector<SearchIndex::Hit> hits = index.search("unlock");
+    QCOMPARE(hits.size(), 1);
+    QCOMPARE(hits[0].kind, SearchIndex::Kind::Activity);
+    QCOMPARE(hits[0].timestamp, qint64(3000));
+}
+
+void SearchIndexTest::intersectsQueryWords()
+{
+    SearchIndex index;
+    fillSample(index);
+
+    QCOMPARE(titles(index.search("sunset beach")), QStringList({"Sunset at the beach"}));
+    QCOMPARE(titles(index.search("beach su")), QStringList({"Beach Boys - Surfin", "Sunset at the beach"}));
+    QCOMPARE(titles(index.search("boys surfin mp3")), QStringList({"Beach Boys - Surfin"}));
+    QCOMPARE(titles(index.search("pictures jpg")), QStringList({"Concert", "Sunset at the beach"}));
+    QVERIFY(index.search("sunset surfin").isEmpty());
+    QVERIFY(index.search("beach nowhere").isEmpty());
+}
+
+void SearchIndexTest::filtersByKindAndLimit()
+{
+    SearchIndex index;
+    fillSample(index);
+
+    QCOMPARE(titles(index.search("beach", 20, SearchIndex::kindBit(SearchIndex::Kind::Photo))),
+             QStringList({"Sunset at the beach"}));
+    QCOMPARE(titles(index.search("beach", 1)), QStringList({"Beach Boys - Surfin"}));
+    QVERIFY(index.search("beach", 0).isEmpty());
+
+    index.removeKind(SearchIndex::Kind::Track);
+    QCOMPARE(titles(index.search("beach")), QStringList({"Sunset at the beach"}));
+    QCOMPARE(index.stats().documents, 3);
+    QCOMPARE(index.stats().removed, 1);
+}
+
+void SearchIndexTest::compactionRenumbersDocuments()
+{
+    const int kept = 100;
+    const int added = 2000;
+    SearchIndex index;
+    index.add(SearchIndex::Kind::Photo, 0, "Sunset", "/pictures/first.jpg");
+    index.setLimit(SearchIndex::Kind::Activity, kept);
+    for (int i = 0; i < added; ++i) {
+        index.add(SearchIndex::Kind::Activity, 1 + i, QString("entry %1 common").arg(i));
+    }
+
+    SearchIndex::Stats stats = index.stats();
+    QCOMPARE(stats.documents, kept + 1);
+    QVERIFY(stats.compactions >= 1);
+    QVERIFY(stats.removed < added - kept);
+
+    // Survivors keep their order after being renumbered
+    QVector<SearchIndex::Hit> hits = index.search("common", 1000);
+    QCOMPARE(hits.size(), kept);
+    for (int i = 0; i < kept; ++i) {
+        QCOMPARE(hits[i].title, QString("entry %1 common").arg(added - 1 - i));
+        QCOMPARE(hits[i].timestamp, qint64(added - i));
+    }
+    QCOMPARE(titles(index.search(QString::number(added - 1))), QStringList({QString("entry %1 common").arg(added - 1)}));
+    QVERIFY(index.search(QString::number(added - kept - 1)).isEmpty());
+
+    // The document added before every compaction is still found, and only by its own words
+    QCOMPARE(titles(index.search("sunset first")), QStringList({"Sunset"}));
+    QVERIFY(index.search("sunset common").isEmpty());
+
+    // Words only evicted documents had are gone from the dictionary
+    QVERIFY(stats.terms < added);
+    index.add(SearchIndex::Kind::Activity, added + 1, "entry late common");
+    QCOMPARE(titles(index.search("late common")), QStringList({"entry late common"}));
+    QCOMPARE(index.search("common", 1000).size(), kept);
+}
+
+QTEST_GUILESS_MAIN(SearchIndexTest)
+#include "tst_searchindex.moc"
\ No newline at end of file
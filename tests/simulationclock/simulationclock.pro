@@ -0,0 +1,12 @@
+include(../../phonecore.pri)
+
+QT += testlib
+
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+TARGET = tst_simulationclock
+TEMPLATE = app
+
+SOURCES += \
+    tst_simulationclock.cpp
\ No newline at end of file
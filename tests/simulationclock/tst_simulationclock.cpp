@@ -0,0 +1,126 @@
+#include <QtTest>
+#include "simulationclock.h"
+
+class SimulationClockTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void ordersByTimeThenSubmission();
+    void cancelAndReschedule();
+    void compactsStaleEntries();
+    void setTimeKeepsAbsoluteEvents();
+    void setTimeBackKeepsDelays();
+
+private:
+    static void runAsFastAsPossible(SimulationClock &clock);
+};
+
+void SimulationClockTest::runAsFastAsPossible(SimulationClock &clock)
+{
+    clock.setMode(SimulationClock::Mode::AsFastAsPossible);
+    clock.setCurrentDateTime(QDateTime::fromMSecsSinceEpoch(1000000));
+}
+
+void SimulationClockTest::ordersByTimeThenSubmission()
+{
+    SimulationClock clock;
+    runAsFastAsPossible(clock);
+    QStringList fired;
+    clock.scheduleAfter(300, [&]() { fired << "c"; });
+    clock.scheduleAfter(100, [&]() { fired << "a1"; });
+    clock.scheduleAt(clock.now() + 100, [&]() { fired << "a2"; });
+    clock.scheduleAfter(200, [&]() { fired << "b"; });
+    clock.scheduleAfter(100, [&]() { fired << "a3"; });
+
+    QCOMPARE(clock.advanceBy(250), 4);
+    QCOMPARE(fired, QStringList({"a1", "a2", "a3", "b"}));
+    QCOMPARE(clock.now(), qint64(1000250));
+    QCOMPARE(clock.advanceBy(50), 1);
+    QCOMPARE(clock.pendingEvents(), 0);
+}
+
+void SimulationClockTest::cancelAndReschedule()
+{
+    SimulationClock clock;
+    runAsFastAsPossible(clock);
+    qint64 firedAt = -1;
+    int cancelledRuns = 0;
+    SimulationClock::EventId moved = clock.scheduleAfter(100, [&]() { firedAt = clock.now(); });
+    SimulationClock::EventId cancelled = clock.scheduleAfter(50, [&]() { ++cancelledRuns; });
+
+    QVERIFY(clock.cancel(cancelled));
+    QVERIFY(!clock.cancel(cancelled));
+    QVERIFY(clock.reschedule(moved, clock.now() + 500));
+    clock.advanceBy(1000);
+    QCOMPARE(cancelledRuns, 0);
+    QCOMPARE(firedAt, qint64(1000500));
+    QVERIFY(!clock.reschedule(moved, clock.now() + 10));
+}
+
+void SimulationClockTest::compactsStaleEntries()
+{
+    SimulationClock clock;
+    runAsFastAsPossible(clock);
+    int runs = 0;
+    // An earlier live event keeps the stale entries off the top of the queue
+    clock.scheduleAfter(1, [&]() { ++runs; });
+    SimulationClock::EventId restarted = clock.scheduleAfter(60000, [&]() { runs += 10; });
+
+    int largest = 0;
+    for (int i = 0; i < 1000; ++i) {
+        QVERIFY(clock.reschedule(restarted, clock.now() + 60000 + i));
+        largest = qMax(largest, clock.queuedEntries());
+    }
+    QCOMPARE(clock.pendingEvents(), 2);
+    QVERIFY2(largest < 128, qPrintable(QString::number(largest)));
+
+    clock.advanceBy(120000);
+    QCOMPARE(runs, 11);
+    QCOMPARE(clock.queuedEntries(), 0);
+}
+
+void SimulationClockTest::setTimeKeepsAbsoluteEvents()
+{
+    SimulationClock clock;
+    runAsFastAsPossible(clock);
+    const qint64 start = clock.now();
+    qint64 alarmAt = -1;
+    qint64 timerAt = -1;
+    clock.scheduleAt(start + 10000, [&]() { alarmAt = clock.now(); });
+    clock.scheduleAfter(10000, [&]() { timerAt = clock.now(); });
+
+    clock.setCurrentDateTime(QDateTime::fromMSecsSinceEpoch(start + 5000));
+    clock.advanceBy(5000);
+    QCOMPARE(alarmAt, start + 10000);
+    QCOMPARE(timerAt, qint64(-1));
+    clock.advanceBy(5000);
+    QCOMPARE(timerAt, start + 15000);
+
+    // Setting the clock past an alarm makes it due straight away
+    bool late = false;
+    clock.scheduleAt(clock.now() + 100, [&]() { late = true; });
+    clock.setCurrentDateTime(clock.currentDateTime().addSecs(60));
+    clock.advanceBy(0);
+    QVERIFY(late);
+}
+
+void SimulationClockTest::setTimeBackKeepsDelays()
+{
+    SimulationClock clock;
+    runAsFastAsPossible(clock);
+    int ticks = 0;
+    clock.scheduleEvery(1000, [&]() { ++ticks; });
+    clock.advanceBy(500);
+
+    clock.setCurrentDateTime(clock.currentDateTime().addDays(-1));
+    clock.advanceBy(499);
+    QCOMPARE(ticks, 0);
+    clock.advanceBy(1);
+    QCOMPARE(ticks, 1);
+    clock.advanceBy(1000);
+    QCOMPARE(ticks, 2);
+}
+
+QTEST_GUILESS_MAIN(SimulationClockTest)
+#include "tst_simulationclock.moc"
\ No newline at end of file
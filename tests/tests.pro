@@ -0,0 +1,11 @@
+# Build and run every test: qmake tests.pro && make && make check
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    activitylogmodel \
+    allocationtracker \
+    eventbus \
+    kvstore \
+    phonesnapshot \
+    searchindex \
+    simulationclock
\ No newline at end of file
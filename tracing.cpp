@@ -0,0 +1,207 @@
+#include "tracing.h"
+#include <QCoreApplication>
+#include <QSaveFile>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct TraceEvent
+{
+    const char *name;
+    const char *category;
+    qint64 startNs;
+    qint64 durationNs;      // -1 for instant events
+};
+
+// Written by the owning thread only; count and next are published with
+// release so an exporting thread can read a consistent prefix
+struct Chunk
+{
+    static constexpr int Capacity = 4096;
+
+    TraceEvent events[Capacity];
+    std::atomic<int> count{0};
+    std::atomic<Chunk *> next{nullptr};
+};
+
+// Chunks are only allocated once the thread records something, so naming
+// a thread while tracing is off costs no trace memory
+struct ThreadTrace
+{
+    ThreadTrace(int tid) : tid(tid), current(nullptr), total(0) {}
+    ~ThreadTrace()
+    {
+        Chunk *chunk = first.load(std::memory_order_relaxed);
+        while (chunk) {
+            Chunk *next = chunk->next.load(std::memory_order_relaxed);
+            delete chunk;
+            chunk = next;
+        }
+    }
+
+    const int tid;
+    QString name;           // guarded by the registry mutex
+    std::atomic<Chunk *> first{nullptr};
+    Chunk *current;         // owning thread only; null until the first event
+    int total;              // owning thread only
+};
+
+struct Registry
+{
+    std::mutex mutex;
+    // Kept after their threads exit so finished workers still show up
+    std::vector<std::shared_ptr<ThreadTrace>> threads;
+    int nextTid = 1;
+    std::atomic<quint64> events{0};
+    std::atomic<quint64> dropped{0};
+    std::atomic<qint64> chunks{0};
+    const qint64 baseNs = Tracer::nowNs();
+};
+
+Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+thread_local std::shared_ptr<ThreadTrace> threadTrace;
+
+ThreadTrace &currentThread()
+{
+    if (!threadTrace) {
+        Registry &reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        threadTrace = std::make_shared<ThreadTrace>(reg.nextTid++);
+        reg.threads.push_back(threadTrace);
+    }
+    return *threadTrace;
+}
+
+void appendEscaped(QByteArray &json, const char *text)
+{
+    for (const char *p = text; *p; ++p) {
+        if (*p == '"' || *p == '\\') {
+            json += '\\';
+        }
+        json += *p;
+    }
+}
+
+} // namespace
+
+std::atomic<bool> Tracer::enabled{false};
+
+void Tracer::setEnabled(bool on)
+{
+    registry();     // pin the time base before the first span
+    enabled.store(on, std::memory_order_relaxed);
+}
+
+void Tracer::setThreadName(const QString &name)
+{
+    ThreadTrace &thread = currentThread();
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    thread.name = name;
+}
+
+void Tracer::instant(const char *name, const char *category)
+{
+    if (isEnabled()) {
+        record(name, category, nowNs(), -1);
+    }
+}
+
+void Tracer::record(const char *name, const char *category, qint64 startNs, qint64 durationNs)
+{
+    ThreadTrace &thread = currentThread();
+    if (thread.total >= MaxEventsPerThread) {
+        registry().dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Chunk *chunk = thread.current;
+    int index = chunk ? chunk->count.load(std::memory_order_relaxed) : Chunk::Capacity;
+    if (index == Chunk::Capacity) {
+        Chunk *fresh = new Chunk;
+        registry().chunks.fetch_add(1, std::memory_order_relaxed);
+        (chunk ? chunk->next : thread.first).store(fresh, std::memory_order_release);
+        thread.current = chunk = fresh;
+        index = 0;
+    }
+    chunk->events[index] = TraceEvent{name, category, startNs, durationNs};
+    chunk->count.store(index + 1, std::memory_order_release);
+    thread.total++;
+    registry().events.fetch_add(1, std::memory_order_relaxed);
+}
+
+QByteArray Tracer::toChromeJson()
+{
+    Registry &reg = registry();
+    QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+    QByteArray json;
+    json.reserve(int(qMin<quint64>(eventCount() * 110 + 256, 512u << 20)));
+    json += "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    json += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + pid
+            + ",\"tid\":0,\"args\":{\"name\":\"SmartphoneSimulator\"}}";
+
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (const std::shared_ptr<ThreadTrace> &thread : reg.threads) {
+        QByteArray tid = QByteArray::number(thread->tid);
+        if (!thread->name.isEmpty()) {
+            json += ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"tid\":" + tid
+                    + ",\"args\":{\"name\":\"";
+            appendEscaped(json, thread->name.toUtf8().constData());
+            json += "\"}}";
+        }
+
+        for (Chunk *chunk = thread->first.load(std::memory_order_acquire); chunk;
+             chunk = chunk->next.load(std::memory_order_acquire)) {
+            int count = chunk->count.load(std::memory_order_acquire);
+            for (int i = 0; i < count; ++i) {
+                const TraceEvent &event = chunk->events[i];
+                json += ",\n{\"name\":\"";
+                appendEscaped(json, event.name);
+                json += "\",\"cat\":\"";
+                appendEscaped(json, event.category);
+                json += "\",\"pid\":" + pid + ",\"tid\":" + tid + ",\"ts\":";
+                json += QByteArray::number((event.startNs - reg.baseNs) / 1000.0, 'f', 3);
+                if (event.durationNs < 0) {
+                    json += ",\"ph\":\"i\",\"s\":\"t\"}";
+                } else {
+                    json += ",\"ph\":\"X\",\"dur\":";
+                    json += QByteArray::number(event.durationNs / 1000.0, 'f', 3);
+                    json += '}';
+                }
+            }
+        }
+    }
+    json += "\n]}\n";
+    return json;
+}
+
+bool Tracer::exportChromeTrace(const QString &path)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(toChromeJson());
+    return file.commit();
+}
+
+quint64 Tracer::eventCount()
+{
+    return registry().events.load(std::memory_order_relaxed);
+}
+
+quint64 Tracer::droppedCount()
+{
+    return registry().dropped.load(std::memory_order_relaxed);
+}
+
+qint64 Tracer::memoryUsage()
+{
+    return registry().chunks.load(std::memory_order_relaxed) * qint64(sizeof(Chunk));
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <QByteArray>
+#include <QString>
+#include <atomic>
+#include <chrono>
+
+// Scoped trace spans for building a timeline of a session or replay. Each
+// thread appends completed spans to its own chunked buffer, so recording
+// never takes a lock; toChromeJson() produces the Chrome trace event format
+// (chrome://tracing, ui.perfetto.dev). While tracing is off a span costs
+// one relaxed load. Names and categories must be string literals.
+class Tracer
+{
+public:
+    static void setEnabled(bool enabled);
+    static bool isEnabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    // Label the calling thread in exported traces
+    static void setThreadName(const QString &name);
+    static void instant(const char *name, const char *category = "phone");
+
+    static QByteArray toChromeJson();
+    static bool exportChromeTrace(const QString &path);
+
+    static quint64 eventCount();
+    static quint64 droppedCount();
+    static qint64 memoryUsage();
+
+    static qint64 nowNs()
+    {
+        return std::chrono::steady_clock::now().time_since_epoch().count();
+    }
+
+    // Per-thread cap; later spans are counted as dropped
+    static constexpr int MaxEventsPerThread = 1 << 20;
+
+private:
+    friend class TraceSpan;
+
+    Tracer() = delete;
+    static void record(const char *name, const char *category, qint64 startNs, qint64 durationNs);
+
+    static std::atomic<bool> enabled;
+};
+
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char *name, const char *category = "phone")
+        : name(name), category(category), startNs(Tracer::isEnabled() ? Tracer::nowNs() : -1)
+    {
+    }
+
+    ~TraceSpan()
+    {
+        if (startNs >= 0) {
+            Tracer::record(name, category, startNs, Tracer::nowNs() - startNs);
+        }
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+    const char *name;
+    const char *category;
+    qint64 startNs;     // -1: tracing was off when the span opened
+};
+
+#define TRACE_SPAN_CONCAT2(a, b) a##b
+#define TRACE_SPAN_CONCAT(a, b) TRACE_SPAN_CONCAT2(a, b)
+#define TRACE_SPAN(...) TraceSpan TRACE_SPAN_CONCAT(traceSpan, __LINE__)(__VA_ARGS__)
+
+#endif // TRACING_H
\ No newline at end of file
@@ -0,0 +1,327 @@
+#include "voicerecorder.h"
+#include "phonelog.h"
+#include "tracing.h"
+#include <QAudioDevice>
+#include <QAudioFormat>
+#include <QAudioSource>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMediaDevices>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr double Pi = 3.14159265358979323846;
+
+} // namespace
+
+SimulatedMicrophone::SimulatedMicrophone(int sampleRate, int channels)
+    : rate(sampleRate), channels(channels), position(0), phase(0.0), noise(0x2545F491u)
+{
+}
+
+int SimulatedMicrophone::sampleRate() const
+{
+    return rate;
+}
+
+int SimulatedMicrophone::channelCount() const
+{
+    return channels;
+}
+
+void SimulatedMicrophone::read(qint16 *samples, int frames)
+{
+    const quint64 syllableFrames = quint64(rate / 4);
+    for (int i = 0; i < frames; ++i, ++position) {
+        double t = double(position) / rate;
+        // 250 ms syllables; every fourth one is a pause
+        bool voiced = (position / syllableFrames) % 4 != 3;
+        double envelope = voiced ? std::sin(Pi * double(position % syllableFrames) / double(syllableFrames)) : 0.0;
+        double pitch = 150.0 + 40.0 * std::sin(2.0 * Pi * 0.7 * t);
+        phase += 2.0 * Pi * pitch / rate;
+        if (phase > 2.0 * Pi) {
+            phase -= 2.0 * Pi;
+        }
+        double voice = 0.0;
+        for (int harmonic = 1; harmonic <= 5; ++harmonic) {
+            voice += std::sin(harmonic * phase) / harmonic;
+        }
+        noise = noise * 1664525u + 1013904223u;
+        double hiss = (double(noise >> 16) - 32768.0) / 32768.0 * 0.005;
+        double value = (0.3 * envelope * voice + hiss) * 32767.0;
+        qint16 sample = qint16(qBound(-32768.0, value, 32767.0));
+        for (int c = 0; c < channels; ++c) {
+            samples[i * channels + c] = sample;
+        }
+    }
+}
+
+double VoiceRecorder::Summary::durationSeconds() const
+{
+    return sampleRate > 0 ? double(frames) / sampleRate : 0.0;
+}
+
+double VoiceRecorder::Summary::realTimeFactor() const
+{
+    return encodeNs > 0 ? durationSeconds() * 1e9 / double(encodeNs) : 0.0;
+}
+
+double VoiceRecorder::Summary::writeMBps() const
+{
+    return writeNs > 0 ? double(bytes) / (1024.0 * 1024.0) * 1e9 / double(writeNs) : 0.0;
+}
+
+QString VoiceRecorder::Summary::describe() const
+{
+    QString text = QString("%1: %2 s at %3 Hz x%4, %5 KB %6; encoded at %7x real time, "
+                           "written at %8 MB/s in %9 writes")
+                       .arg(QFileInfo(path).fileName())
+                       .arg(durationSeconds(), 0, 'f', 1)
+                       .arg(sampleRate)
+                       .arg(channels)
+                       .arg(bytes / 1024)
+                       .arg(AudioEncoder::formatName(format).toUpper())
+                       .arg(realTimeFactor(), 0, 'f', 0)
+                       .arg(writeMBps(), 0, 'f', 1)
+                       .arg(writes);
+    if (droppedFrames > 0) {
+        text += QString(", %1 frames dropped").arg(droppedFrames);
+    }
+    return text;
+}
+
+VoiceRecorder::VoiceRecorder(QObject *parent)
+    : QObject(parent), filling(nullptr), finishing(false), recording(false), captured(0), dropped(0),
+      microphone(nullptr), microphoneInput(nullptr)
+{
+}
+
+VoiceRecorder::~VoiceRecorder()
+{
+    stop();
+}
+
+bool VoiceRecorder::start(const QString &path, AudioEncoder::Format format, int sampleRate, int channels)
+{
+    if (recording) {
+        PHONE_LOG_ERROR("recorder", "❌ Already recording to %1", current.path);
+        return false;
+    }
+    encoder = AudioEncoder::create(format, sampleRate, channels);
+    if (!encoder) {
+        PHONE_LOG_ERROR("recorder", "❌ Unsupported recording format: %1 Hz, %2 channels", sampleRate, channels);
+        return false;
+    }
+    // Unbuffered: the write buffer already batches everything into large writes
+    file.reset(new QFile(path));
+    if (!file->open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+        PHONE_LOG_ERROR("recorder", "❌ Cannot write %1", path);
+        encoder.reset();
+        file.reset();
+        return false;
+    }
+    if (!ring) {
+        ring.reset(new SpscRing<Chunk>(RingChunks));
+    }
+
+    current = Summary();
+    current.path = path;
+    current.format = format;
+    current.sampleRate = sampleRate;
+    current.channels = channels;
+    current.ok = true;
+    filling = nullptr;
+    captured = 0;
+    dropped = 0;
+    finishing = false;
+    recording = true;
+    worker = std::thread([this]() { encodeLoop(); });
+    PHONE_LOG_INFO("recorder", "🎙️ Recording to %1", path);
+    return true;
+}
+
+bool VoiceRecorder::startMicrophone(const QString &path, AudioEncoder::Format format)
+{
+    QAudioDevice device = QMediaDevices::defaultAudioInput();
+    if (device.isNull()) {
+        PHONE_LOG_ERROR("recorder", "❌ No audio input device");
+        return false;
+    }
+    QAudioFormat audioFormat = device.preferredFormat();
+    audioFormat.setSampleFormat(QAudioFormat::Int16);
+    audioFormat.setChannelCount(qMin(audioFormat.channelCount(), int(AudioEncoder::MaxChannels)));
+    if (!device.isFormatSupported(audioFormat)
+        || !start(path, format, audioFormat.sampleRate(), audioFormat.channelCount())) {
+        return false;
+    }
+
+    microphone = new QAudioSource(device, audioFormat, this);
+    microphoneInput = microphone->start();
+    if (!microphoneInput) {
+        PHONE_LOG_ERROR("recorder", "❌ Cannot open %1", device.description());
+        stop();
+        return false;
+    }
+    // The device delivers whole frames; a full ring drops them rather than stall capture
+    connect(microphoneInput, &QIODevice::readyRead, this, [this]() {
+        qint16 buffer[ChunkFrames * AudioEncoder::MaxChannels];
+        qint64 frameBytes = qint64(sizeof(qint16)) * current.channels;
+        qint64 bytes;
+        while ((bytes = microphoneInput->read(reinterpret_cast<char *>(buffer), sizeof(buffer))) > 0) {
+            write(buffer, int(bytes / frameBytes), false);
+        }
+    });
+    return true;
+}
+
+int VoiceRecorder::write(const qint16 *samples, int frames, bool wait)
+{
+    if (!recording) {
+        return 0;
+    }
+    const int channels = current.channels;
+    int written = 0;
+    while (written < frames) {
+        if (!filling) {
+            filling = ring->reserve();
+            if (!filling) {
+                if (!wait) {
+                    dropped += quint64(frames - written);
+                    break;
+                }
+                std::unique_lock<std::mutex> lock(mutex);
+                drained.wait_for(lock, std::chrono::milliseconds(1));
+                continue;
+            }
+            filling->frames = 0;
+        }
+        int count = qMin(frames - written, ChunkFrames - filling->frames);
+        std::memcpy(filling->samples + filling->frames * channels, samples + written * channels,
+                    size_t(count) * size_t(channels) * sizeof(qint16));
+        filling->frames += count;
+        written += count;
+        if (filling->frames == ChunkFrames) {
+            commitChunk();
+        }
+    }
+    captured += quint64(written);
+    return written;
+}
+
+VoiceRecorder::Summary VoiceRecorder::stop()
+{
+    if (!recording) {
+        return Summary();
+    }
+    if (microphone) {
+        microphone->stop();
+        delete microphone;
+        microphone = nullptr;
+        microphoneInput = nullptr;
+    }
+    if (filling && filling->frames > 0) {
+        commitChunk();
+    }
+    filling = nullptr;
+    recording = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        finishing = true;
+    }
+    wake.notify_all();
+    worker.join();
+
+    // The sizes in the header are only known now
+    QByteArray header = encoder->header();
+    if (!file->seek(0) || file->write(header) != header.size()) {
+        current.ok = false;
+    }
+    current.bytes = file->size();
+    file->close();
+    current.frames = encoder->encodedFrames();
+    current.droppedFrames = dropped;
+    encoder.reset();
+    file.reset();
+
+    if (current.ok) {
+        PHONE_LOG_SUCCESS("recorder", "✓ Recording saved: %1", current.describe());
+    } else {
+        PHONE_LOG_ERROR("recorder", "❌ Recording incomplete, write failed: %1", current.path);
+    }
+    return current;
+}
+
+bool VoiceRecorder::isRecording() const
+{
+    return recording;
+}
+
+quint64 VoiceRecorder::capturedFrames() const
+{
+    return captured;
+}
+
+void VoiceRecorder::commitChunk()
+{
+    ring->commit();
+    filling = nullptr;
+    wake.notify_one();
+}
+
+void VoiceRecorder::encodeLoop()
+{
+    Tracer::setThreadName("recorder");
+    QByteArray buffer;
+    buffer.reserve(WriteBufferBytes + int(sizeof(Chunk)) * 2);
+    encoder->begin(buffer);
+
+    QElapsedTimer timer;
+    for (;;) {
+        Chunk *chunk = ring->front();
+        if (!chunk) {
+            std::unique_lock<std::mutex> lock(mutex);
+            if (finishing) {
+                // The capture side committed its last chunk before finishing was set
+                if (!ring->front()) {
+                    break;
+                }
+                continue;
+            }
+            // A missed notify costs at most one wait interval
+            wake.wait_for(lock, std::chrono::milliseconds(20));
+            continue;
+        }
+
+        timer.start();
+        encoder->encode(chunk->samples, chunk->frames, buffer);
+        current.encodeNs += timer.nsecsElapsed();
+        ring->release();
+        drained.notify_one();
+
+        if (buffer.size() >= WriteBufferBytes) {
+            writeOut(buffer);
+        }
+    }
+    writeOut(buffer);
+}
+
+void VoiceRecorder::writeOut(QByteArray &buffer)
+{
+    if (buffer.isEmpty()) {
+        return;
+    }
+    TRACE_SPAN("VoiceRecorder::writeOut", "recorder");
+    QElapsedTimer timer;
+    timer.start();
+    if (file->write(buffer) != buffer.size()) {
+        current.ok = false;
+    }
+    current.writeNs += timer.nsecsElapsed();
+    current.writes++;
+    // resize() keeps the capacity, so the buffer is allocated once per recording
+    buffer.resize(0);
+}
\ No newline at end of file
@@ -0,0 +1,117 @@
+#ifndef VOICERECORDER_H
+#define VOICERECORDER_H
+
+#include "audioencoder.h"
+#include "lockfreequeue.h"
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+class QAudioSource;
+class QFile;
+class QIODevice;
+
+// Deterministic speech-like test input: a gliding voice with a few
+// harmonics, cut into syllables with pauses, over faint noise
+class SimulatedMicrophone
+{
+public:
+    explicit SimulatedMicrophone(int sampleRate = 16000, int channels = 1);
+
+    int sampleRate() const;
+    int channelCount() const;
+    // Fills frames interleaved frames
+    void read(qint16 *samples, int frames);
+
+private:
+    int rate;
+    int channels;
+    quint64 position;
+    double phase;
+    quint32 noise;
+};
+
+// Records 16-bit PCM to a WAV or FLAC file while it is being captured. The
+// capture side copies samples into fixed-size chunks of a lock-free ring;
+// an encoder thread encodes each chunk and writes the file in large
+// sequential writes. Memory is bounded by the ring and one write buffer,
+// so a recording can run as long as the disk allows.
+class VoiceRecorder : public QObject
+{
+    Q_OBJECT
+public:
+    struct Summary
+    {
+        QString path;
+        AudioEncoder::Format format = AudioEncoder::Format::Wav;
+        int sampleRate = 0;
+        int channels = 0;
+        quint64 frames = 0;
+        quint64 droppedFrames = 0;  // lost to a full ring (real-time input only)
+        qint64 bytes = 0;           // file size
+        qint64 encodeNs = 0;        // encoder thread time spent encoding
+        qint64 writeNs = 0;         // ... and writing
+        int writes = 0;
+        bool ok = false;
+
+        double durationSeconds() const;
+        // Seconds of audio encoded per second of encoding
+        double realTimeFactor() const;
+        double writeMBps() const;
+        QString describe() const;
+    };
+
+    static constexpr int ChunkFrames = AudioEncoder::MaxBlockFrames;
+    static constexpr int RingChunks = 64;
+    static constexpr int WriteBufferBytes = 1 << 20;
+
+    explicit VoiceRecorder(QObject *parent = nullptr);
+    ~VoiceRecorder();
+
+    bool start(const QString &path, AudioEncoder::Format format, int sampleRate, int channels);
+    // Records the default input device through Qt Multimedia
+    bool startMicrophone(const QString &path, AudioEncoder::Format format);
+    // Capture side, one thread at a time; samples are interleaved. When the
+    // ring is full, wait blocks until the encoder catches up, otherwise the
+    // rest is dropped and counted, as a real-time input has to.
+    int write(const qint16 *samples, int frames, bool wait);
+    // Drains the ring, finishes the file and fixes up its header
+    Summary stop();
+
+    bool isRecording() const;
+    quint64 capturedFrames() const;
+
+private:
+    struct Chunk
+    {
+        int frames;
+        qint16 samples[ChunkFrames * AudioEncoder::MaxChannels];
+    };
+
+    void commitChunk();
+    void encodeLoop();
+    void writeOut(QByteArray &buffer);
+
+    std::unique_ptr<SpscRing<Chunk>> ring;     // created on first start, then reused
+    Chunk *filling;                             // capture side's uncommitted chunk
+    std::unique_ptr<AudioEncoder> encoder;
+    std::unique_ptr<QFile> file;
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;               // a chunk is ready, or finishing
+    std::condition_variable drained;            // a chunk was freed
+    bool finishing;
+    bool recording;
+    quint64 captured;
+    quint64 dropped;
+    Summary current;                            // encoder fields written by the worker only
+
+    QAudioSource *microphone;
+    QIODevice *microphoneInput;
+};
+
+#endif // VOICERECORDER_H
\ No newline at end of file
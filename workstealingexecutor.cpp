@@ -0,0 +1,148 @@
+#include "workstealingexecutor.h"
+#include "tracing.h"
+
+namespace {
+
+thread_local const WorkStealingExecutor *currentExecutor = nullptr;
+thread_local int currentWorker = -1;
+
+} // namespace
+
+WorkStealingExecutor::WorkStealingExecutor(int threadCount)
+    : pending(0), inFlight(0), nextWorker(0), executed(0), steals(0), stopping(false)
+{
+    if (threadCount <= 0) {
+        threadCount = qMax(1, int(std::thread::hardware_concurrency()));
+    }
+
+    for (int i = 0; i < threadCount; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (int i = 0; i < threadCount; ++i) {
+        threads.emplace_back([this, i]() { run(i); });
+    }
+}
+
+WorkStealingExecutor::~WorkStealingExecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+WorkStealingExecutor &WorkStealingExecutor::shared()
+{
+    static WorkStealingExecutor executor;
+    return executor;
+}
+
+void WorkStealingExecutor::submit(Task task)
+{
+    // Tasks spawned by a worker stay on its own deque; others are spread round-robin
+    int target = (currentExecutor == this && currentWorker >= 0)
+                     ? currentWorker
+                     : int(nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size());
+
+    inFlight.fetch_add(1, std::memory_order_relaxed);
+    pending.fetch_add(1, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(workers[target]->mutex);
+        workers[target]->tasks.push_back(std::move(task));
+    }
+    {
+        // Taking the mutex orders the push before a sleeping worker re-checks
+        std::lock_guard<std::mutex> lock(idleMutex);
+    }
+    wakeup.notify_one();
+}
+
+void WorkStealingExecutor::waitIdle()
+{
+    std::unique_lock<std::mutex> lock(idleMutex);
+    idle.wait(lock, [this]() { return inFlight.load(std::memory_order_acquire) == 0; });
+}
+
+int WorkStealingExecutor::threadCount() const
+{
+    return int(threads.size());
+}
+
+int WorkStealingExecutor::queueDepth() const
+{
+    return qMax(0, pending.load(std::memory_order_relaxed));
+}
+
+quint64 WorkStealingExecutor::executedCount() const
+{
+    return executed.load(std::memory_order_relaxed);
+}
+
+quint64 WorkStealingExecutor::stealCount() const
+{
+    return steals.load(std::memory_order_relaxed);
+}
+
+void WorkStealingExecutor::run(int index)
+{
+    currentExecutor = this;
+    currentWorker = index;
+    Tracer::setThreadName(QString("worker %1").arg(index));
+
+    for (;;) {
+        Task task;
+        if (popLocal(index, task) || steal(index, task)) {
+            pending.fetch_sub(1, std::memory_order_relaxed);
+            {
+                TRACE_SPAN("task", "executor");
+                task();
+            }
+            executed.fetch_add(1, std::memory_order_relaxed);
+            if (inFlight.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> lock(idleMutex);
+                idle.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(idleMutex);
+        wakeup.wait(lock, [this]() {
+            return stopping || pending.load(std::memory_order_acquire) > 0;
+        });
+        if (stopping && pending.load(std::memory_order_acquire) <= 0) {
+            return;
+        }
+    }
+}
+
+bool WorkStealingExecutor::popLocal(int index, Task &task)
+{
+    Worker &worker = *workers[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.tasks.empty()) {
+        return false;
+    }
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool WorkStealingExecutor::steal(int thief, Task &task)
+{
+    const int count = int(workers.size());
+    for (int offset = 1; offset < count; ++offset) {
+        Worker &victim = *workers[(thief + offset) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
\ No newline at end of file
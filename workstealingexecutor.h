@@ -0,0 +1,64 @@
+#ifndef WORKSTEALINGEXECUTOR_H
+#define WORKSTEALINGEXECUTOR_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Thread pool with one deque per worker. Workers pop their own newest task
+// (cache-warm, LIFO) and steal the oldest task from a sibling when idle, so
+// bursts submitted from one thread still spread across all host cores.
+class WorkStealingExecutor
+{
+public:
+    using Task = std::function<void()>;
+
+    explicit WorkStealingExecutor(int threadCount = 0);   // 0 = hardware concurrency
+    ~WorkStealingExecutor();
+
+    WorkStealingExecutor(const WorkStealingExecutor &) = delete;
+    WorkStealingExecutor &operator=(const WorkStealingExecutor &) = delete;
+
+    // Process-wide pool, created on first use
+    static WorkStealingExecutor &shared();
+
+    void submit(Task task);
+    // Block until every submitted task has finished
+    void waitIdle();
+
+    int threadCount() const;
+    int queueDepth() const;
+    quint64 executedCount() const;
+    quint64 stealCount() const;
+
+private:
+    struct Worker
+    {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    void run(int index);
+    bool popLocal(int index, Task &task);
+    bool steal(int thief, Task &task);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::mutex idleMutex;
+    std::condition_variable wakeup;
+    std::condition_variable idle;
+    std::atomic<int> pending;       // queued, not yet started
+    std::atomic<int> inFlight;      // queued or running
+    std::atomic<unsigned> nextWorker;
+    std::atomic<quint64> executed;
+    std::atomic<quint64> steals;
+    bool stopping;
+};
+
+#endif // WORKSTEALINGEXECUTOR_H
\ No newline at end of file